@@ -32,15 +32,15 @@ static inline void arch_atomic_init(atomic_t *a, int32_t value)
 	arch_atomic_set(a, value);
 }
 
-/* use gcc atomic built-ins for host library */
+/* use gcc atomic built-ins for host library, return new value like xtensa */
 static inline int32_t arch_atomic_add(atomic_t *a, int32_t value)
 {
-	return __sync_fetch_and_add(&a->value, value);
+	return __sync_add_and_fetch(&a->value, value);
 }
 
 static inline int32_t arch_atomic_sub(atomic_t *a, int32_t value)
 {
-	return __sync_fetch_and_sub(&a->value, value);
+	return __sync_sub_and_fetch(&a->value, value);
 }
 
 #endif /* __ARCH_ATOMIC_H__ */
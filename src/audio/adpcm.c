@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/audio/adpcm.h>
+#include <sof/audio/format.h>
+#include <sof/math/numbers.h>
+#include <stdint.h>
+
+#define ADPCM_INDEX_MAX		88
+
+static const int16_t adpcm_step_table[ADPCM_INDEX_MAX + 1] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t adpcm_index_table[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/* Reconstructs the sample of code and advances the state, the encoder
+ * uses the same reconstruction to stay in sync with the decoder.
+ */
+static inline void adpcm_update(struct adpcm_state *state, int code)
+{
+	int step = adpcm_step_table[state->index];
+	int32_t diff = step >> 3;
+	int index;
+
+	if (code & 4)
+		diff += step;
+	if (code & 2)
+		diff += step >> 1;
+	if (code & 1)
+		diff += step >> 2;
+
+	if (code & 8)
+		state->predictor = sat_int16(state->predictor - diff);
+	else
+		state->predictor = sat_int16(state->predictor + diff);
+
+	index = state->index + adpcm_index_table[code];
+	state->index = MIN(MAX(index, 0), ADPCM_INDEX_MAX);
+}
+
+static inline int adpcm_encode_sample(struct adpcm_state *state,
+				      int16_t sample)
+{
+	int step = adpcm_step_table[state->index];
+	int32_t diff = sample - state->predictor;
+	int code = 0;
+
+	if (diff < 0) {
+		code = 8;
+		diff = -diff;
+	}
+
+	if (diff >= step) {
+		code |= 4;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step) {
+		code |= 2;
+		diff -= step;
+	}
+	step >>= 1;
+	if (diff >= step)
+		code |= 1;
+
+	adpcm_update(state, code);
+	return code;
+}
+
+static inline int16_t adpcm_get_sample(const void *src, int sample_width,
+				       int i)
+{
+	int32_t x;
+
+	switch (sample_width) {
+	case 16:
+		return ((const int16_t *)src)[i];
+	case 24:
+		x = sign_extend_s24(((const int32_t *)src)[i]);
+		return sat_int16(Q_SHIFT_RND(x, 23, 15));
+	default:
+		x = ((const int32_t *)src)[i];
+		return sat_int16(Q_SHIFT_RND(x, 31, 15));
+	}
+}
+
+static inline void adpcm_put_sample(void *dst, int sample_width, int i,
+				    int16_t sample)
+{
+	switch (sample_width) {
+	case 16:
+		((int16_t *)dst)[i] = sample;
+		break;
+	case 24:
+		((int32_t *)dst)[i] = (int32_t)sample << 8;
+		break;
+	default:
+		((int32_t *)dst)[i] = (int32_t)sample << 16;
+		break;
+	}
+}
+
+void adpcm_encode_block(struct adpcm_state *state, const void *src,
+			int sample_width, int channels, uint8_t *block)
+{
+	uint8_t *code = block + channels * ADPCM_HEADER_BYTES;
+	int16_t s0;
+	int16_t s1;
+	int code_l;
+	int code_h;
+	int ch;
+	int i;
+
+	for (ch = 0; ch < channels; ch++) {
+		/* the state before the first frame starts the decoder */
+		block[0] = (uint16_t)state[ch].predictor & 0xff;
+		block[1] = (uint16_t)state[ch].predictor >> 8;
+		block[2] = state[ch].index;
+		block[3] = 0;
+		block += ADPCM_HEADER_BYTES;
+
+		for (i = 0; i < ADPCM_BLOCK_FRAMES; i += 2) {
+			s0 = adpcm_get_sample(src, sample_width,
+					      i * channels + ch);
+			s1 = adpcm_get_sample(src, sample_width,
+					      (i + 1) * channels + ch);
+			code_l = adpcm_encode_sample(&state[ch], s0);
+			code_h = adpcm_encode_sample(&state[ch], s1);
+			*code++ = code_l | code_h << 4;
+		}
+	}
+}
+
+void adpcm_decode_block(const uint8_t *block, int sample_width,
+			int channels, void *dst)
+{
+	const uint8_t *code = block + channels * ADPCM_HEADER_BYTES;
+	struct adpcm_state state;
+	int ch;
+	int i;
+
+	for (ch = 0; ch < channels; ch++) {
+		state.predictor = (int16_t)(block[0] | block[1] << 8);
+		state.index = MIN(block[2], ADPCM_INDEX_MAX);
+		block += ADPCM_HEADER_BYTES;
+
+		for (i = 0; i < ADPCM_BLOCK_FRAMES; i += 2) {
+			adpcm_update(&state, *code & 0xf);
+			adpcm_put_sample(dst, sample_width, i * channels + ch,
+					 state.predictor);
+			adpcm_update(&state, *code++ >> 4);
+			adpcm_put_sample(dst, sample_width,
+					 (i + 1) * channels + ch,
+					 state.predictor);
+		}
+	}
+}
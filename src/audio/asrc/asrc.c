@@ -2,8 +2,10 @@
 //
 // Copyright(c) 2019 Intel Corporation. All rights reserved.
 
+#include <sof/audio/asrc/asrc_config.h>
 #include <sof/audio/asrc/asrc_farrow.h>
 #include <sof/audio/buffer.h>
+#include <sof/audio/coef_cache.h>
 #include <sof/audio/component.h>
 #include <sof/audio/format.h>
 #include <sof/audio/pipeline.h>
@@ -96,6 +98,54 @@ static inline void src_inc_wrap_s16(int16_t **ptr, int16_t *end, size_t size)
 		*ptr = (int16_t *)((uint8_t *)*ptr - size);
 }
 
+/* Runs ASRC for the frames in ibuf. The block kernels are used with
+ * the generic code, the HiFi3 kernels process a frame at a time.
+ */
+static int asrc_run(struct comp_dev *dev, struct comp_data *cd, int *frames)
+{
+	int idx = 0;
+
+#if ASRC_GENERIC
+	if (cd->mode == ASRC_OM_PUSH)
+		return asrc_process_push_block(dev, cd->asrc_obj,
+					       (void **)cd->ibuf,
+					       cd->source_frames,
+					       (void **)cd->obuf, frames,
+					       &idx, 0);
+
+	return asrc_process_pull_block(dev, cd->asrc_obj, (void **)cd->ibuf,
+				       frames, (void **)cd->obuf,
+				       cd->sink_frames, cd->source_frames,
+				       &idx);
+#else
+	if (cd->asrc_obj->bit_depth == 32) {
+		if (cd->mode == ASRC_OM_PUSH)
+			return asrc_process_push32(dev, cd->asrc_obj,
+						   (int32_t **)cd->ibuf,
+						   cd->source_frames,
+						   (int32_t **)cd->obuf,
+						   frames, &idx, 0);
+
+		return asrc_process_pull32(dev, cd->asrc_obj,
+					   (int32_t **)cd->ibuf, frames,
+					   (int32_t **)cd->obuf,
+					   cd->sink_frames, cd->source_frames,
+					   &idx);
+	}
+
+	if (cd->mode == ASRC_OM_PUSH)
+		return asrc_process_push16(dev, cd->asrc_obj,
+					   (int16_t **)cd->ibuf,
+					   cd->source_frames,
+					   (int16_t **)cd->obuf, frames,
+					   &idx, 0);
+
+	return asrc_process_pull16(dev, cd->asrc_obj, (int16_t **)cd->ibuf,
+				   frames, (int16_t **)cd->obuf,
+				   cd->sink_frames, cd->source_frames, &idx);
+#endif
+}
+
 /* A fast copy function for same in and out rate */
 static void src_copy_s32(struct comp_dev *dev,
 			 const struct audio_stream *source,
@@ -113,7 +163,6 @@ static void src_copy_s32(struct comp_dev *dev,
 	int ret;
 	int i;
 	int frames = 0;
-	int idx = 0;
 
 	/* TODO: Optimize buffer size by circular write to snk directly */
 	/* TODO: S24_4LE handling */
@@ -133,21 +182,11 @@ static void src_copy_s32(struct comp_dev *dev,
 	}
 
 	/* Run ASRC */
-	if (cd->mode == ASRC_OM_PUSH) {
-		ret = asrc_process_push32(dev,
-					  cd->asrc_obj, (int32_t **)cd->ibuf,
-					  cd->source_frames,
-					  (int32_t **)cd->obuf, &frames,
-					  &idx, 0);
+	ret = asrc_run(dev, cd, &frames);
+	if (cd->mode == ASRC_OM_PUSH)
 		n = frames * sink->channels;
-	} else {
-		ret = asrc_process_pull32(dev, cd->asrc_obj,
-					  (int32_t **)cd->ibuf,
-					  &frames, (int32_t **)cd->obuf,
-					  cd->sink_frames, cd->source_frames,
-					  &idx);
+	else
 		n = cd->sink_frames * sink->channels;
-	}
 
 	if (ret)
 		comp_err(dev, "src_copy_s32(), error %d", ret);
@@ -189,7 +228,6 @@ static void src_copy_s16(struct comp_dev *dev,
 	int ret;
 	int n;
 	int frames = 0;
-	int idx = 0;
 
 	/* TODO: Optimize buffer size by circular write to snk directly */
 
@@ -211,21 +249,11 @@ static void src_copy_s16(struct comp_dev *dev,
 	}
 
 	/* Run ASRC */
-	if (cd->mode == ASRC_OM_PUSH) {
-		ret = asrc_process_push16(dev,
-					  cd->asrc_obj, (int16_t **)cd->ibuf,
-					  cd->source_frames,
-					  (int16_t **)cd->obuf, &frames,
-					  &idx, 0);
+	ret = asrc_run(dev, cd, &frames);
+	if (cd->mode == ASRC_OM_PUSH)
 		n = frames * sink->channels;
-	} else {
-		ret = asrc_process_pull16(dev,
-					  cd->asrc_obj, (int16_t **)cd->ibuf,
-					  &frames, (int16_t **)cd->obuf,
-					  cd->sink_frames, cd->source_frames,
-					  &idx);
+	else
 		n = cd->sink_frames * sink->channels;
-	}
 
 	if (ret)
 		comp_err(dev, "src_copy_s16(), error %d", ret);
@@ -316,6 +344,7 @@ static void asrc_free(struct comp_dev *dev)
 	comp_info(dev, "asrc_free()");
 
 	rfree(cd->buf);
+	asrc_release(cd->asrc_obj);
 	rfree(cd->asrc_obj);
 	rfree(cd);
 	rfree(dev);
@@ -715,6 +744,7 @@ static int asrc_prepare(struct comp_dev *dev)
 	return 0;
 
 err_free_asrc:
+	asrc_release(cd->asrc_obj);
 	rfree(cd->asrc_obj);
 	cd->asrc_obj = NULL;
 
@@ -799,8 +829,10 @@ static void asrc_process(struct comp_dev *dev, struct comp_buffer *source,
 	int consumed = 0;
 	int produced = 0;
 
-	/* consumed bytes are not known at this point */
-	buffer_invalidate(source, source->stream.size);
+	/* consumption varies but is at most source_frames */
+	buffer_invalidate(source,
+			  audio_stream_get_readable_bytes(&source->stream,
+							  cd->source_frames));
 	cd->asrc_func(dev, &source->stream, &sink->stream, &consumed,
 		      &produced);
 	buffer_writeback(sink, produced *
@@ -887,6 +919,7 @@ static int asrc_reset(struct comp_dev *dev)
 		asrc_dai_stop_timestamp(cd);
 
 	/* Free the allocations those were done in prepare() */
+	asrc_release(cd->asrc_obj);
 	rfree(cd->asrc_obj);
 	rfree(cd->buf);
 	cd->asrc_obj = NULL;
@@ -918,6 +951,7 @@ static SHARED_DATA struct comp_driver_info comp_asrc_info = {
 
 static void sys_comp_asrc_init(void)
 {
+	coef_cache_init();
 	comp_register(platform_shared_get(&comp_asrc_info,
 					  sizeof(comp_asrc_info)));
 }
@@ -4,8 +4,10 @@
 
 /* @brief    Implementation of the sample rate converter. */
 
+#include <sof/audio/coef_cache.h>
 #include <sof/common.h>
 #include <sof/debug/panic.h>
+#include <sof/lib/alloc.h>
 #include <sof/math/numbers.h>
 #include <sof/platform.h>
 #include <sof/string.h>
@@ -14,6 +16,7 @@
 #include <user/trace.h>
 #include <sof/audio/asrc/asrc_config.h>
 #include <sof/audio/asrc/asrc_farrow.h>
+#include <stddef.h>
 
 #define CONVERT_COEFF(x) ((int32_t)(x))
 
@@ -238,7 +241,7 @@ enum asrc_error_code asrc_get_required_size(struct comp_dev *dev,
 					    int bit_depth)
 {
 	int filter_length = 128;
-	int buffer_length = 256;
+	int buffer_length = (filter_length + ASRC_BLOCK_FRAMES) * 2;
 	int size;
 
 	/* check for parameter errors */
@@ -276,8 +279,8 @@ enum asrc_error_code asrc_get_required_size(struct comp_dev *dev,
 	size += sizeof(int32_t *) * num_channels; /* pointers the the buffers */
 	/* size of the ring buffers */
 	size += buffer_length * num_channels * (bit_depth / 8);
-	/* size of the impulse response */
-	size += filter_length * sizeof(int32_t);
+	/* size of the impulse responses of a block */
+	size += filter_length * ASRC_BLOCK_FRAMES * sizeof(int32_t);
 
 	*required_size = size;
 
@@ -347,6 +350,7 @@ enum asrc_error_code asrc_initialise(struct comp_dev *dev,
 		src_obj->fs_sec;    /* stored as Q5.27 fixed point value */
 	src_obj->fs_ratio_inv = ((int64_t)ONE_Q27 * src_obj->fs_sec) /
 		src_obj->fs_prim; /* stored as Q5.27 fixed point value */
+	src_obj->ramp_frames = 0;
 	src_obj->time_value = 0;
 	src_obj->time_value_pull = 0;
 	src_obj->control_mode = control_mode;
@@ -401,26 +405,6 @@ enum asrc_error_code asrc_initialise(struct comp_dev *dev,
 		return error_code;
 	}
 
-	/*
-	 * Set the pointer for the impulse response.
-	 * &m_impulse_response[0] = ring_buffers_x
-	 * + num_channels * (1 + buffer_length);
-	 * Here ring_buffer_x already points to the memory just behind
-	 * the src_obj.  The offset results from the number of pointers
-	 * pointing to each channel and each channels buffer data.
-	 */
-	if (src_obj->bit_depth == 32) {
-		src_obj->impulse_response =
-			(int32_t *)(src_obj->ring_buffers32 +
-				    src_obj->num_channels *
-				    (1 + src_obj->buffer_length));
-	} else if (src_obj->bit_depth == 16) {
-		src_obj->impulse_response =
-			(int32_t *)(src_obj->ring_buffers16 +
-				    src_obj->num_channels *
-				    (1 + src_obj->buffer_length / 2));
-	}
-
 	/* return ok, if everything worked out */
 	src_obj->is_initialised = true;
 	return ASRC_EC_OK;
@@ -464,6 +448,7 @@ enum asrc_error_code asrc_set_fs_ratio(struct comp_dev *dev,
 		src_obj->fs_sec;
 	src_obj->fs_ratio_inv = ((int64_t)ONE_Q27 * src_obj->fs_sec) /
 		src_obj->fs_prim;
+	src_obj->ramp_frames = 0;
 
 	/* check conversion ratios */
 	if (src_obj->fs_ratio == 0 || src_obj->fs_ratio_inv == 0) {
@@ -493,18 +478,6 @@ enum asrc_error_code asrc_set_fs_ratio(struct comp_dev *dev,
 		return error_code;
 	}
 
-	/* Set the pointer for the impulse response */
-	if (src_obj->bit_depth == 32) {
-		src_obj->impulse_response =
-			(int32_t *)(src_obj->ring_buffers32 +
-			src_obj->num_channels * (1 + src_obj->buffer_length));
-	} else if (src_obj->bit_depth == 16) {
-		src_obj->impulse_response =
-			(int32_t *)(src_obj->ring_buffers16 +
-				    src_obj->num_channels *
-				    (1 + src_obj->buffer_length / 2));
-	}
-
 	return ASRC_EC_OK;
 }
 
@@ -564,17 +537,21 @@ static enum asrc_error_code initialise_buffer(struct asrc_farrow *src_obj)
 	if (src_obj->bit_depth == 32)
 		buffer = (uint8_t *)(src_obj->ring_buffers32 +
 			src_obj->num_channels);
-	else if (src_obj->bit_depth == 16)
+	else
 		buffer = (uint8_t *)(src_obj->ring_buffers16 +
 			src_obj->num_channels);
 
 	/*
-	 * set buffer_length to filter_length * 2 to compensate for
+	 * set buffer_length to twice the filter_length to compensate for
 	 * missing element wise wrap around while loading but allowing
-	 * aligned loads.
+	 * aligned loads. The extra ASRC_BLOCK_FRAMES of history keep the
+	 * input of the pending block frames.
 	 */
-	src_obj->buffer_length = src_obj->filter_length * 2;
-	src_obj->buffer_write_position = src_obj->filter_length;
+	src_obj->buffer_length = (src_obj->filter_length +
+				  ASRC_BLOCK_FRAMES) * 2;
+	src_obj->buffer_write_position = src_obj->buffer_length >> 1;
+	src_obj->block_count = 0;
+	src_obj->block_writes = 0;
 
 	/* set the base addresses for every channel and initialise the
 	 * buffers to zero
@@ -599,15 +576,51 @@ static enum asrc_error_code initialise_buffer(struct asrc_farrow *src_obj)
 		}
 	}
 
+	/* The impulse response follows the ring buffers */
+	src_obj->impulse_response = (int32_t *)(buffer +
+		src_obj->num_channels * src_obj->buffer_length *
+		(src_obj->bit_depth / 8));
+
 	return ASRC_EC_OK;
 }
 
 /*
  * FILTER FUNCTIONS
  */
+
+/* Copies the selected filter to coef_cache memory */
+static void *asrc_filter_create(const struct coef_cache_key *key, void *arg,
+				size_t *size)
+{
+	struct asrc_farrow *src_obj = arg;
+	int32_t *filter;
+
+	*size = src_obj->filter_length * src_obj->num_filters *
+		sizeof(int32_t);
+	filter = coef_cache_alloc(*size);
+	if (filter && memcpy_s(filter, *size, src_obj->polyphase_filters,
+			       *size) < 0) {
+		rfree(filter);
+		filter = NULL;
+	}
+
+	return filter;
+}
+
+void asrc_release(struct asrc_farrow *src_obj)
+{
+	if (!src_obj)
+		return;
+
+	coef_cache_put(src_obj->polyphase_filters);
+	src_obj->polyphase_filters = NULL;
+}
+
 static enum asrc_error_code initialise_filter(struct comp_dev *dev,
 					      struct asrc_farrow *src_obj)
 {
+	struct coef_cache_key key = { .type = COEF_CACHE_ASRC };
+	const int32_t *filter;
 	int fs_in;
 	int fs_out;
 
@@ -626,9 +639,9 @@ static enum asrc_error_code initialise_filter(struct comp_dev *dev,
 	 */
 
 	/* Reset coefficients for possible exit with error. */
+	asrc_release(src_obj);
 	src_obj->filter_length = 0;
 	src_obj->num_filters = 0;
-	src_obj->polyphase_filters = NULL;
 
 	if (fs_in == 0 || fs_out == 0) {
 		/* Avoid possible divisions by zero. */
@@ -786,6 +799,16 @@ static enum asrc_error_code initialise_filter(struct comp_dev *dev,
 		return ASRC_EC_INVALID_CONVERSION_RATIO;
 	}
 
+	/* Instances of the same conversion share one copy of the filter
+	 * in fast memory, the constant table is used if the copy fails.
+	 */
+	key.fs_in = fs_in;
+	key.fs_out = fs_out;
+	key.quality = src_obj->filter_length;
+	filter = coef_cache_get(&key, asrc_filter_create, src_obj);
+	if (filter)
+		src_obj->polyphase_filters = filter;
+
 	return ASRC_EC_OK;
 }
 
@@ -826,14 +849,26 @@ enum asrc_error_code asrc_update_drift(struct comp_dev *dev,
 		src_obj->fs_prim;
 
 	/* Q5.27 x Q2.30 -> Q7.57, shift right by 30 to get Q5.27 */
-	src_obj->fs_ratio = (uint32_t)(((uint64_t)fs_ratio * clock_skew) >> 30);
+	fs_ratio = (uint32_t)(((uint64_t)fs_ratio * clock_skew) >> 30);
 
 	/* Scale Q5.27 to Q5.54, scale Q2.30 to Q2.27,
 	 * then Q5.54 / Q2.27 -> Q5.27
 	 */
-	src_obj->fs_ratio_inv = (uint32_t)(((uint64_t)fs_ratio_inv << 27) /
+	fs_ratio_inv = (uint32_t)(((uint64_t)fs_ratio_inv << 27) /
 		(uint64_t)(clock_skew >> 3));
 
+	/* Ramp the ratios to the new values during the next output frames
+	 * to avoid a step in the time values.
+	 */
+	src_obj->fs_ratio_target = fs_ratio;
+	src_obj->fs_ratio_inv_target = fs_ratio_inv;
+	src_obj->fs_ratio_step = ((int64_t)fs_ratio - src_obj->fs_ratio) /
+		ASRC_DRIFT_RAMP_FRAMES;
+	src_obj->fs_ratio_inv_step = ((int64_t)fs_ratio_inv -
+				      src_obj->fs_ratio_inv) /
+		ASRC_DRIFT_RAMP_FRAMES;
+	src_obj->ramp_frames = ASRC_DRIFT_RAMP_FRAMES;
+
 	return ASRC_EC_OK;
 }
 
@@ -888,6 +923,21 @@ enum asrc_error_code asrc_update_fs_ratio(struct comp_dev *dev,
 	return ASRC_EC_OK;
 }
 
+/* Advances the ratios ramp by one output frame */
+static inline void asrc_ramp_ratio(struct asrc_farrow *src_obj)
+{
+	if (!src_obj->ramp_frames)
+		return;
+
+	if (--src_obj->ramp_frames) {
+		src_obj->fs_ratio += src_obj->fs_ratio_step;
+		src_obj->fs_ratio_inv += src_obj->fs_ratio_inv_step;
+	} else {
+		src_obj->fs_ratio = src_obj->fs_ratio_target;
+		src_obj->fs_ratio_inv = src_obj->fs_ratio_inv_target;
+	}
+}
+
 void asrc_write_to_ring_buffer16(struct asrc_farrow  *src_obj,
 				 int16_t **input_buffers, int index_input_frame)
 {
@@ -1027,6 +1077,7 @@ enum asrc_error_code asrc_process_push16(struct comp_dev *dev,
 
 				/* Update time and buffer index */
 				src_obj->time_value += src_obj->fs_ratio;
+				asrc_ramp_ratio(src_obj);
 				src_obj->io_buffer_idx++;
 				if (src_obj->io_buffer_idx >=
 				    src_obj->io_buffer_length &&
@@ -1138,6 +1189,7 @@ enum asrc_error_code asrc_process_push32(struct comp_dev *dev,
 
 				/* Update time and index */
 				src_obj->time_value += src_obj->fs_ratio;
+				asrc_ramp_ratio(src_obj);
 				src_obj->io_buffer_idx++;
 
 				/* Wrap around */
@@ -1264,6 +1316,7 @@ enum asrc_error_code asrc_process_pull16(struct comp_dev *dev,
 			/* Update time and index */
 			src_obj->time_value += src_obj->fs_ratio_inv;
 			src_obj->time_value_pull -= TIME_VALUE_ONE;
+			asrc_ramp_ratio(src_obj);
 			index_output_frame++;
 		}
 	}
@@ -1367,6 +1420,7 @@ enum asrc_error_code asrc_process_pull32(struct comp_dev *dev,
 			/* Update time and index */
 			src_obj->time_value += src_obj->fs_ratio_inv;
 			src_obj->time_value_pull -= TIME_VALUE_ONE;
+			asrc_ramp_ratio(src_obj);
 			index_output_frame++;
 		}
 	}
@@ -1403,3 +1457,212 @@ enum asrc_error_code asrc_process_pull32(struct comp_dev *dev,
 
 	return ASRC_EC_OK;
 }
+
+#if ASRC_GENERIC
+
+/* Computes the pending output frames of the block */
+static void asrc_block_flush(struct asrc_farrow *src_obj,
+			     void **output_buffers)
+{
+	if (!src_obj->block_count)
+		return;
+
+	asrc_calc_impulse_response_block(src_obj);
+	if (src_obj->bit_depth == 32)
+		asrc_fir_filter32_block(src_obj, (int32_t **)output_buffers);
+	else
+		asrc_fir_filter16_block(src_obj, (int16_t **)output_buffers);
+
+	src_obj->block_count = 0;
+	src_obj->block_writes = 0;
+}
+
+/* Defers the output frame at the current time and input position */
+static void asrc_block_add(struct asrc_farrow *src_obj,
+			   void **output_buffers, int index_output_frame)
+{
+	int k = src_obj->block_count++;
+
+	src_obj->block_time[k] = src_obj->time_value;
+	src_obj->block_pos[k] = src_obj->buffer_write_position;
+	src_obj->block_out[k] = index_output_frame;
+	if (src_obj->block_count == ASRC_BLOCK_FRAMES)
+		asrc_block_flush(src_obj, output_buffers);
+}
+
+/* Writes an input frame, the ring buffers keep the input of the pending
+ * frames for ASRC_BLOCK_FRAMES writes.
+ */
+static void asrc_block_write(struct asrc_farrow *src_obj,
+			     void **input_buffers, void **output_buffers,
+			     int index_input_frame)
+{
+	if (src_obj->block_count) {
+		if (src_obj->block_writes == ASRC_BLOCK_FRAMES)
+			asrc_block_flush(src_obj, output_buffers);
+		else
+			src_obj->block_writes++;
+	}
+
+	if (src_obj->bit_depth == 32)
+		asrc_write_to_ring_buffer32(src_obj, (int32_t **)input_buffers,
+					    index_input_frame);
+	else
+		asrc_write_to_ring_buffer16(src_obj, (int16_t **)input_buffers,
+					    index_input_frame);
+}
+
+enum asrc_error_code asrc_process_push_block(struct comp_dev *dev,
+					     struct asrc_farrow *src_obj,
+					     void **__restrict input_buffers,
+					     int input_num_frames,
+					     void **__restrict output_buffers,
+					     int *output_num_frames,
+					     int *write_index,
+					     int read_index)
+{
+	/* See 'process_push16' for a more detailed description of the
+	 * algorithm
+	 */
+	int index_input_frame;
+	int max_num_free_frames;
+
+	/* parameter error handling */
+	if (!src_obj || !input_buffers || !output_buffers ||
+	    !output_num_frames || !write_index)
+		return ASRC_EC_INVALID_POINTER;
+
+	if (!src_obj->is_initialised)
+		return ASRC_EC_INIT_FAILED;
+
+	if (src_obj->control_mode != ASRC_CM_FEEDBACK)
+		return ASRC_EC_INVALID_CONTROL_MODE;
+
+	if (src_obj->io_buffer_mode == ASRC_BM_LINEAR) {
+		src_obj->io_buffer_idx = 0;
+		max_num_free_frames = src_obj->io_buffer_length;
+	} else {
+		if (read_index > *write_index)
+			max_num_free_frames = read_index - *write_index;
+		else
+			max_num_free_frames = src_obj->io_buffer_length +
+				read_index - *write_index;
+	}
+
+	*output_num_frames = 0;
+	index_input_frame = 0;
+	while (index_input_frame < input_num_frames) {
+		if (src_obj->time_value < TIME_VALUE_ONE) {
+			if (*output_num_frames < max_num_free_frames) {
+				/* Defer the output frame to the block */
+				asrc_block_add(src_obj, output_buffers,
+					       src_obj->io_buffer_idx);
+
+				/* Update time and index */
+				src_obj->time_value += src_obj->fs_ratio;
+				asrc_ramp_ratio(src_obj);
+				src_obj->io_buffer_idx++;
+
+				/* Wrap around */
+				if (src_obj->io_buffer_mode ==
+				    ASRC_BM_CIRCULAR &&
+				    src_obj->io_buffer_idx >=
+				    src_obj->io_buffer_length)
+					src_obj->io_buffer_idx = 0;
+
+				(*output_num_frames)++;
+			} else {
+				comp_err(dev, "error onf=%d, max=%d",
+					 *output_num_frames,
+					 max_num_free_frames);
+				break;
+			}
+		} else {
+			/* Consume input sample */
+			asrc_block_write(src_obj, input_buffers,
+					 output_buffers, index_input_frame);
+			index_input_frame++;
+
+			/* Update time */
+			src_obj->time_value -= TIME_VALUE_ONE;
+		}
+	}
+
+	asrc_block_flush(src_obj, output_buffers);
+	*write_index = src_obj->io_buffer_idx;
+	return ASRC_EC_OK;
+}
+
+enum asrc_error_code asrc_process_pull_block(struct comp_dev *dev,
+					     struct asrc_farrow *src_obj,
+					     void **__restrict input_buffers,
+					     int *input_num_frames,
+					     void **__restrict output_buffers,
+					     int output_num_frames,
+					     int write_index,
+					     int *read_index)
+{
+	/* See 'process_pull16' for a more detailed description of the
+	 * algorithm
+	 */
+	int index_output_frame = 0;
+
+	/* parameter error handling */
+	if (!src_obj || !input_buffers || !output_buffers ||
+	    !input_num_frames || !read_index)
+		return ASRC_EC_INVALID_POINTER;
+
+	if (!src_obj->is_initialised)
+		return ASRC_EC_INIT_FAILED;
+
+	if (src_obj->control_mode != ASRC_CM_FEEDBACK)
+		return ASRC_EC_INVALID_CONTROL_MODE;
+
+	if (src_obj->io_buffer_mode == ASRC_BM_CIRCULAR)
+		src_obj->io_buffer_idx = *read_index;
+	else
+		src_obj->io_buffer_idx = 0;
+
+	*input_num_frames = 0;
+	while (index_output_frame < output_num_frames) {
+		if (src_obj->time_value_pull < TIME_VALUE_ONE) {
+			/* Consume input sample */
+			if (src_obj->io_buffer_idx != write_index) {
+				asrc_block_write(src_obj, input_buffers,
+						 output_buffers,
+						 src_obj->io_buffer_idx);
+				src_obj->io_buffer_idx++;
+
+				/* Wrap around */
+				if (src_obj->io_buffer_idx >=
+				    src_obj->io_buffer_length &&
+				    src_obj->io_buffer_mode == ASRC_BM_CIRCULAR)
+					src_obj->io_buffer_idx = 0;
+
+				(*input_num_frames)++;
+			}
+
+			/* Update time as Q5.27 */
+			src_obj->time_value = (((int64_t)TIME_VALUE_ONE -
+						src_obj->time_value_pull) *
+					       src_obj->fs_ratio_inv) >> 27;
+			src_obj->time_value_pull += src_obj->fs_ratio;
+		} else {
+			/* Defer the output frame to the block */
+			asrc_block_add(src_obj, output_buffers,
+				       index_output_frame);
+
+			/* Update time and index */
+			src_obj->time_value += src_obj->fs_ratio_inv;
+			src_obj->time_value_pull -= TIME_VALUE_ONE;
+			asrc_ramp_ratio(src_obj);
+			index_output_frame++;
+		}
+	}
+
+	asrc_block_flush(src_obj, output_buffers);
+	*read_index = src_obj->io_buffer_idx;
+	return ASRC_EC_OK;
+}
+
+#endif /* ASRC_GENERIC */
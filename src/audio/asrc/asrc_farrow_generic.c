@@ -109,6 +109,86 @@ void asrc_fir_filter32(struct asrc_farrow *src_obj, int32_t **output_buffers,
 	}
 }
 
+/* Output buffer index of the pending block frame k */
+static inline int asrc_block_out_index(struct asrc_farrow *src_obj, int k)
+{
+	if (src_obj->output_format == ASRC_IOF_INTERLEAVED)
+		return src_obj->num_channels * src_obj->block_out[k];
+
+	return src_obj->block_out[k];
+}
+
+void asrc_fir_filter16_block(struct asrc_farrow *src_obj,
+			     int16_t **output_buffers)
+{
+	int64_t prod[ASRC_BLOCK_FRAMES];
+	const int32_t *filter_p;
+	int16_t *buffer_p;
+	int32_t prod32;
+	int count = src_obj->block_count;
+	int ch;
+	int n;
+	int k;
+
+	for (ch = 0; ch < src_obj->num_channels; ch++) {
+		buffer_p = src_obj->ring_buffers16[ch];
+		filter_p = &src_obj->impulse_response[0];
+		for (k = 0; k < count; k++)
+			prod[k] = 0;
+
+		/* Each tap is applied to all frames of the block, see
+		 * asrc_fir_filter16() for the data format.
+		 */
+		for (n = 0; n < src_obj->filter_length; n++) {
+			for (k = 0; k < count; k++)
+				prod[k] += (int64_t)filter_p[k] *
+					buffer_p[src_obj->block_pos[k] - n];
+
+			filter_p += ASRC_BLOCK_FRAMES;
+		}
+
+		for (k = 0; k < count; k++) {
+			prod32 = sat_int32(Q_SHIFT(prod[k], 45, 31));
+			output_buffers[ch][asrc_block_out_index(src_obj, k)] =
+				sat_int16(Q_SHIFT_RND(prod32, 31, 15));
+		}
+	}
+}
+
+void asrc_fir_filter32_block(struct asrc_farrow *src_obj,
+			     int32_t **output_buffers)
+{
+	int64_t prod[ASRC_BLOCK_FRAMES];
+	const int32_t *filter_p;
+	int32_t *buffer_p;
+	int count = src_obj->block_count;
+	int ch;
+	int n;
+	int k;
+
+	for (ch = 0; ch < src_obj->num_channels; ch++) {
+		buffer_p = src_obj->ring_buffers32[ch];
+		filter_p = &src_obj->impulse_response[0];
+		for (k = 0; k < count; k++)
+			prod[k] = 0;
+
+		/* Each tap is applied to all frames of the block, see
+		 * asrc_fir_filter32() for the data format.
+		 */
+		for (n = 0; n < src_obj->filter_length; n++) {
+			for (k = 0; k < count; k++)
+				prod[k] += (int64_t)(filter_p[k] >> 8) *
+					buffer_p[src_obj->block_pos[k] - n];
+
+			filter_p += ASRC_BLOCK_FRAMES;
+		}
+
+		for (k = 0; k < count; k++)
+			output_buffers[ch][asrc_block_out_index(src_obj, k)] =
+				sat_int32(Q_SHIFT(prod[k], 53, 31));
+	}
+}
+
 /* + ALGORITHM SPECIFIC FUNCTIONS */
 
 void asrc_calc_impulse_response_n4(struct asrc_farrow *src_obj)
@@ -358,4 +438,61 @@ void asrc_calc_impulse_response_n7(struct asrc_farrow *src_obj)
 	}
 }
 
+void asrc_calc_impulse_response_block(struct asrc_farrow *src_obj)
+{
+	/*
+	 * See 'calc_impulse_response_n4' for the Horner's method and the
+	 * storage of the polyphase filters. Each loaded coefficient pair
+	 * is used for all frames of the block.
+	 */
+	int32_t time[ASRC_BLOCK_FRAMES];
+	int32_t accuml[ASRC_BLOCK_FRAMES];
+	int32_t accumh[ASRC_BLOCK_FRAMES];
+	const int32_t *filter_P;
+	int32_t *result_P;
+	int32_t coefl;
+	int32_t coefh;
+	int count = src_obj->block_count;
+	int index_filter;
+	int index_limit;
+	int n;
+	int k;
+
+	for (k = 0; k < count; k++)
+		time[k] = sat_int32(((int64_t)src_obj->block_time[k]) << 4);
+
+	filter_P = &src_obj->polyphase_filters[0];
+	result_P = &src_obj->impulse_response[0];
+
+	index_limit = src_obj->filter_length >> 1;
+	for (index_filter = 0; index_filter < index_limit; index_filter++) {
+		coefl = *filter_P++;
+		coefh = *filter_P++;
+		for (k = 0; k < count; k++) {
+			accuml[k] = coefl;
+			accumh[k] = coefh;
+		}
+
+		for (n = 1; n < src_obj->num_filters; n++) {
+			coefl = *filter_P++;
+			coefh = *filter_P++;
+			for (k = 0; k < count; k++) {
+				accuml[k] = coefl +
+					q_multsr_sat_32x32(accuml[k], time[k],
+							   62 - 31);
+				accumh[k] = coefh +
+					q_multsr_sat_32x32(accumh[k], time[k],
+							   62 - 31);
+			}
+		}
+
+		for (k = 0; k < count; k++) {
+			result_P[k] = accuml[k];
+			result_P[ASRC_BLOCK_FRAMES + k] = accumh[k];
+		}
+
+		result_P += 2 * ASRC_BLOCK_FRAMES;
+	}
+}
+
 #endif /* ASRC_GENERIC */
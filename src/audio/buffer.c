@@ -109,6 +109,14 @@ int buffer_set_size(struct comp_buffer *buffer, uint32_t size)
 		return -EINVAL;
 	}
 
+	/* the span helpers need whole frames up to the wrap */
+	if (buffer->hw_params_configured &&
+	    size % audio_stream_frame_bytes(&buffer->stream)) {
+		buf_err(buffer, "resize size = %u is not a multiple of frame size %u",
+			size, audio_stream_frame_bytes(&buffer->stream));
+		return -EINVAL;
+	}
+
 	if (size == buffer->stream.size)
 		return 0;
 
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/audio/coef_cache.h>
+#include <sof/common.h>
+#include <sof/lib/alloc.h>
+#include <sof/lib/cache.h>
+#include <sof/lib/memory.h>
+#include <sof/list.h>
+#include <sof/spinlock.h>
+#include <ipc/topology.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Cached coefficients of one key */
+struct coef_cache_entry {
+	struct list_item list;
+	struct coef_cache_key key;
+	uint32_t refs;		/* number of users */
+	size_t size;		/* size of data in bytes */
+	void *data;
+};
+
+struct coef_cache {
+	struct list_item list;	/* list of coef_cache_entry */
+	spinlock_t lock;	/* protects list and refs */
+	bool init;
+};
+
+static SHARED_DATA struct coef_cache coef_cache;
+
+static struct coef_cache *coef_cache_get_data(void)
+{
+	return platform_shared_get(&coef_cache, sizeof(coef_cache));
+}
+
+void coef_cache_init(void)
+{
+	struct coef_cache *cache = coef_cache_get_data();
+
+	if (!cache->init) {
+		list_init(&cache->list);
+		spinlock_init(&cache->lock);
+		cache->init = true;
+	}
+
+	platform_shared_commit(cache, sizeof(*cache));
+}
+
+static bool coef_cache_key_match(const struct coef_cache_key *a,
+				 const struct coef_cache_key *b)
+{
+	return a->type == b->type && a->fs_in == b->fs_in &&
+		a->fs_out == b->fs_out && a->quality == b->quality;
+}
+
+/* Finds and pins the entry of key, must be called with the lock held */
+static void *coef_cache_find(struct coef_cache *cache,
+			     const struct coef_cache_key *key)
+{
+	struct coef_cache_entry *e;
+	struct list_item *clist;
+	void *data = NULL;
+
+	list_for_item(clist, &cache->list) {
+		e = container_of(clist, struct coef_cache_entry, list);
+		if (coef_cache_key_match(&e->key, key)) {
+			e->refs++;
+			data = e->data;
+			/* coefficients may be stale in the local cache */
+			dcache_invalidate_region(data, e->size);
+			platform_shared_commit(e, sizeof(*e));
+			break;
+		}
+
+		platform_shared_commit(e, sizeof(*e));
+	}
+
+	return data;
+}
+
+void *coef_cache_get(const struct coef_cache_key *key,
+		     coef_cache_create create, void *arg)
+{
+	struct coef_cache *cache = coef_cache_get_data();
+	struct coef_cache_entry *e;
+	uint32_t flags;
+	size_t size = 0;
+	void *data;
+
+	spin_lock_irq(&cache->lock, flags);
+	data = coef_cache_find(cache, key);
+	spin_unlock_irq(&cache->lock, flags);
+
+	if (data)
+		goto out;
+
+	/* The coefficients are created without the lock held since the
+	 * design can take long. A concurrent request of the same key
+	 * is resolved by dropping the copy of the later one.
+	 */
+	e = rzalloc(SOF_MEM_ZONE_RUNTIME, SOF_MEM_FLAG_SHARED,
+		    SOF_MEM_CAPS_RAM, sizeof(*e));
+	if (!e)
+		goto out;
+
+	e->data = create(key, arg, &size);
+	if (!e->data) {
+		rfree(e);
+		goto out;
+	}
+
+	/* other cores read the coefficients through their caches */
+	dcache_writeback_region(e->data, size);
+	e->key = *key;
+	e->refs = 1;
+	e->size = size;
+
+	spin_lock_irq(&cache->lock, flags);
+	data = coef_cache_find(cache, key);
+	if (!data) {
+		data = e->data;
+		list_item_append(&e->list, &cache->list);
+		platform_shared_commit(e, sizeof(*e));
+	}
+	spin_unlock_irq(&cache->lock, flags);
+
+	if (data != e->data) {
+		rfree(e->data);
+		rfree(e);
+	}
+
+out:
+	platform_shared_commit(cache, sizeof(*cache));
+	return data;
+}
+
+void coef_cache_put(const void *data)
+{
+	struct coef_cache *cache = coef_cache_get_data();
+	struct coef_cache_entry *e;
+	struct coef_cache_entry *found = NULL;
+	struct list_item *clist;
+	uint32_t flags;
+
+	if (!data)
+		goto out;
+
+	spin_lock_irq(&cache->lock, flags);
+
+	list_for_item(clist, &cache->list) {
+		e = container_of(clist, struct coef_cache_entry, list);
+		if (e->data == data) {
+			if (!--e->refs) {
+				list_item_del(&e->list);
+				found = e;
+			}
+
+			platform_shared_commit(e, sizeof(*e));
+			break;
+		}
+
+		platform_shared_commit(e, sizeof(*e));
+	}
+
+	spin_unlock_irq(&cache->lock, flags);
+
+	/* last user is gone, unpin the coefficients */
+	if (found) {
+		rfree(found->data);
+		rfree(found);
+	}
+
+out:
+	platform_shared_commit(cache, sizeof(*cache));
+}
+
+void *coef_cache_alloc(size_t bytes)
+{
+	void *data;
+
+	/* fastest memory first, any runtime memory otherwise */
+	data = rballoc(0, SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_HP, bytes);
+	if (!data)
+		data = rballoc(0, SOF_MEM_CAPS_RAM, bytes);
+
+	return data;
+}
@@ -251,6 +251,7 @@ int comp_verify_params(struct comp_dev *dev, uint32_t flag,
 	struct comp_buffer *buf;
 	int dir = dev->direction;
 	uint32_t flags = 0;
+	int ret;
 
 	if (!params) {
 		comp_err(dev, "comp_verify_params(): !params");
@@ -283,7 +284,12 @@ int comp_verify_params(struct comp_dev *dev, uint32_t flag,
 		/* overwrite buffer parameters with modified pcm
 		 * parameters
 		 */
-		buffer_set_params(buf, params, BUFFER_UPDATE_FORCE);
+		ret = buffer_set_params(buf, params, BUFFER_UPDATE_FORCE);
+		if (ret < 0) {
+			buffer_unlock(buf, flags);
+			comp_err(dev, "comp_verify_params(): buffer_set_params() failed");
+			return ret;
+		}
 
 		/* set component period frames */
 		component_set_period_frames(dev, buf->stream.rate);
@@ -307,9 +313,15 @@ int comp_verify_params(struct comp_dev *dev, uint32_t flag,
 
 			comp_update_params(flag, params, buf);
 
-			buffer_set_params(buf, params, BUFFER_UPDATE_FORCE);
+			ret = buffer_set_params(buf, params,
+						BUFFER_UPDATE_FORCE);
 
 			buffer_unlock(buf, flags);
+
+			if (ret < 0) {
+				comp_err(dev, "comp_verify_params(): buffer_set_params() failed");
+				return ret;
+			}
 		}
 
 		/* fetch sink buffer in order to calculate period frames */
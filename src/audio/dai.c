@@ -23,6 +23,7 @@
 #include <sof/lib/notifier.h>
 #include <sof/lib/uuid.h>
 #include <sof/list.h>
+#include <sof/math/numbers.h>
 #include <sof/string.h>
 #include <sof/trace/trace.h>
 #include <ipc/dai.h>
@@ -380,6 +381,7 @@ static int dai_capture_params(struct comp_dev *dev, uint32_t period_bytes,
 static int dai_params(struct comp_dev *dev,
 		      struct sof_ipc_stream_params *params)
 {
+	struct sof_ipc_stream_params dma_params;
 	struct dai_data *dd = comp_get_drvdata(dev);
 	uint32_t frame_size;
 	uint32_t period_count;
@@ -455,11 +457,14 @@ static int dai_params(struct comp_dev *dev,
 
 	dd->period_bytes = period_bytes;
 
-	/* calculate DMA buffer size */
-	buffer_size = ALIGN_UP(period_count * period_bytes, align);
+	/* calculate DMA buffer size, in whole frames up to the wrap */
+	buffer_size = ALIGN_UP(period_count * period_bytes,
+			       align / gcd(align, frame_size) * frame_size);
 
 	/* alloc DMA buffer or change its size if exists */
 	if (dd->dma_buffer) {
+		/* the new size is checked against the new params below */
+		buffer_reset_params(dd->dma_buffer, NULL);
 		err = buffer_set_size(dd->dma_buffer, buffer_size);
 		if (err < 0) {
 			comp_err(dev, "dai_params(): buffer_set_size() failed, buffer_size = %u",
@@ -475,6 +480,19 @@ static int dai_params(struct comp_dev *dev,
 		}
 	}
 
+	/* the pcm converter strides the dma buffer by its stream params,
+	 * so they have to describe the DAI format and not the host one
+	 */
+	dma_params = *params;
+	dma_params.frame_fmt = dd->frame_fmt;
+	err = buffer_set_params(dd->dma_buffer, &dma_params,
+				BUFFER_UPDATE_FORCE);
+	if (err < 0) {
+		comp_err(dev, "dai_params(): buffer_set_params() failed for dma buffer, buffer_size = %u",
+			 buffer_size);
+		return err;
+	}
+
 	return dev->direction == SOF_IPC_STREAM_PLAYBACK ?
 		dai_playback_params(dev, period_bytes, period_count) :
 		dai_capture_params(dev, period_bytes, period_count);
@@ -9,6 +9,7 @@
 #include <sof/audio/buffer.h>
 #include <sof/audio/component.h>
 #include <sof/audio/eq_fir/fir_config.h>
+#include <sof/audio/eq_fir/fir_fft.h>
 #include <sof/audio/pipeline.h>
 #include <sof/common.h>
 #include <sof/debug/panic.h>
@@ -53,17 +54,24 @@ DECLARE_TR_CTX(eq_fir_tr, SOF_UUID(eq_fir_uuid), LOG_LEVEL_INFO);
 /* src component private data */
 struct comp_data {
 	struct fir_state_32x16 fir[PLATFORM_MAX_CHANNELS]; /**< filters state */
+	struct fir_fft_state fft[PLATFORM_MAX_CHANNELS]; /**< FFT conv. state */
 	struct sof_eq_fir_config *config;	/**< pointer to setup blob */
 	struct sof_eq_fir_config *config_new;	/**< pointer to new setup */
 	enum sof_ipc_frame source_format;	/**< source frame format */
 	enum sof_ipc_frame sink_format;		/**< sink frame format */
 	int32_t *fir_delay;			/**< pointer to allocated RAM */
 	size_t fir_delay_size;			/**< allocated size */
+	struct fir_fft_work *fft_work;		/**< FFT conv. allocated RAM */
+	size_t fft_work_size;			/**< allocated size */
 	bool config_ready;			/**< set when fully received */
 	void (*eq_fir_func)(struct fir_state_32x16 fir[],
 			    const struct audio_stream *source,
 			    struct audio_stream *sink,
 			    int frames, int nch);
+	void (*eq_fir_fft_func)(struct fir_fft_state fft[],
+				struct fir_fft_work *work,
+				struct audio_stream *sink,
+				int frames, int nch);
 };
 
 /*
@@ -244,13 +252,24 @@ static void eq_fir_free_delaylines(struct comp_data *cd)
 	cd->fir_delay_size = 0;
 	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
 		fir[i].delay = NULL;
+
+	/* The FFT convolution spectra and delay lines are in one chunk */
+	rfree(cd->fft_work);
+	cd->fft_work = NULL;
+	cd->fft_work_size = 0;
+	cd->eq_fir_fft_func = NULL;
+	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
+		fir_fft_reset(&cd->fft[i]);
 }
 
 static int eq_fir_init_coef(struct sof_eq_fir_config *config,
-			    struct fir_state_32x16 *fir, int nch)
+			    struct fir_state_32x16 *fir,
+			    struct fir_fft_state *fft, int nch,
+			    int *fft_size)
 {
 	struct sof_eq_fir_coef_data *lookup[SOF_EQ_FIR_MAX_RESPONSES];
 	struct sof_eq_fir_coef_data *eq;
+	bool fft_coef[SOF_EQ_FIR_MAX_RESPONSES] = { false };
 	int16_t *assign_response;
 	int16_t *coef_data;
 	size_t size_sum = 0;
@@ -301,6 +320,7 @@ static int eq_fir_init_coef(struct sof_eq_fir_config *config,
 		if (i < config->channels_in_config)
 			resp = assign_response[i];
 
+		fir_fft_reset(&fft[i]);
 		if (resp < 0) {
 			/* Initialize EQ channel to bypass and continue with
 			 * next channel response.
@@ -317,8 +337,34 @@ static int eq_fir_init_coef(struct sof_eq_fir_config *config,
 			return -EINVAL;
 		}
 
-		/* Initialize EQ coefficients. */
+		/* A long response is set up for FFT convolution. The direct
+		 * form FIR passes the channel through and the FFT convolution
+		 * is run in place for sink. Channels with the same response
+		 * share the response spectra.
+		 */
 		eq = lookup[resp];
+		if (eq->flags & SOF_EQ_FIR_FLAG_FFT) {
+			s = fir_fft_delay_size(eq);
+			if (s < 0) {
+				comp_cl_err(&comp_eq_fir, "eq_fir_init_coef(), FFT FIR length %d is invalid",
+					    eq->length);
+				return -EINVAL;
+			}
+
+			*fft_size += s;
+			if (!fft_coef[resp]) {
+				*fft_size += fir_fft_coef_size(eq);
+				fft_coef[resp] = true;
+			}
+
+			fir_reset(&fir[i]);
+			fft[i].config = eq;
+			comp_cl_info(&comp_eq_fir, "eq_fir_init_coef(), ch %d is set to FFT response = %d",
+				     i, resp);
+			continue;
+		}
+
+		/* Initialize EQ coefficients. */
 		s = fir_delay_size(eq);
 		if (s > 0) {
 			size_sum += s;
@@ -357,18 +403,95 @@ static void eq_fir_init_delay(struct fir_state_32x16 *fir,
 	}
 }
 
+static int eq_fir_setup_fft(struct comp_data *cd, int nch, int fft_size)
+{
+	struct fir_fft_state *fft = cd->fft;
+	void *data;
+	size_t size = sizeof(struct fir_fft_work) + fft_size;
+	int i;
+	int j;
+
+	/* Allocate the work area, response spectra and delay lines of all
+	 * FFT convolution channels in a big chunk and clear it.
+	 */
+	cd->fft_work = rballoc(0, SOF_MEM_CAPS_RAM, size);
+	if (!cd->fft_work) {
+		comp_cl_err(&comp_eq_fir, "eq_fir_setup_fft(), allocation failed for size %d",
+			    size);
+		return -ENOMEM;
+	}
+
+	memset(cd->fft_work, 0, size);
+	cd->fft_work_size = size;
+	fir_fft_init_work(cd->fft_work);
+	data = cd->fft_work + 1;
+
+	for (i = 0; i < nch; i++) {
+		if (!fft[i].config)
+			continue;
+
+		for (j = 0; j < i; j++) {
+			if (fft[j].config == fft[i].config)
+				break;
+		}
+
+		if (j < i)
+			fir_fft_share_coef(&fft[i], &fft[j]);
+		else
+			fir_fft_init_coef(&fft[i], cd->fft_work, fft[i].config,
+					  &data);
+	}
+
+	for (i = 0; i < nch; i++) {
+		if (fft[i].partitions)
+			fir_fft_init_delay(&fft[i], &data);
+	}
+
+	switch (cd->source_format) {
+#if CONFIG_FORMAT_S16LE
+	case SOF_IPC_FRAME_S16_LE:
+		cd->eq_fir_fft_func = eq_fir_fft_s16;
+		break;
+#endif /* CONFIG_FORMAT_S16LE */
+#if CONFIG_FORMAT_S24LE
+	case SOF_IPC_FRAME_S24_4LE:
+		cd->eq_fir_fft_func = eq_fir_fft_s24;
+		break;
+#endif /* CONFIG_FORMAT_S24LE */
+#if CONFIG_FORMAT_S32LE
+	case SOF_IPC_FRAME_S32_LE:
+		cd->eq_fir_fft_func = eq_fir_fft_s32;
+		break;
+#endif /* CONFIG_FORMAT_S32LE */
+	default:
+		comp_cl_err(&comp_eq_fir, "eq_fir_setup_fft(), invalid frame_fmt");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int eq_fir_setup(struct comp_data *cd, int nch)
 {
 	int delay_size;
+	int fft_size = 0;
+	int ret;
 
 	/* Free existing FIR channels data if it was allocated */
 	eq_fir_free_delaylines(cd);
 
 	/* Set coefficients for each channel EQ from coefficient blob */
-	delay_size = eq_fir_init_coef(cd->config, cd->fir, nch);
+	delay_size = eq_fir_init_coef(cd->config, cd->fir, cd->fft, nch,
+				      &fft_size);
 	if (delay_size < 0)
 		return delay_size; /* Contains error code */
 
+	if (fft_size) {
+		ret = eq_fir_setup_fft(cd, nch, fft_size);
+		if (ret < 0)
+			return ret;
+	}
+
 	/* If all channels were set to bypass there's no need to
 	 * allocate delay. Just return with success.
 	 */
@@ -436,11 +559,14 @@ static struct comp_dev *eq_fir_new(const struct comp_driver *drv,
 	comp_set_drvdata(dev, cd);
 
 	cd->eq_fir_func = NULL;
+	cd->eq_fir_fft_func = NULL;
 	cd->config = NULL;
 	cd->config_new = NULL;
 	cd->config_ready = false;
 	cd->fir_delay = NULL;
 	cd->fir_delay_size = 0;
+	cd->fft_work = NULL;
+	cd->fft_work_size = 0;
 
 	/* Allocate and make a copy of the coefficients blob and reset FIR. If
 	 * the EQ is configured later in run-time the size is zero.
@@ -458,8 +584,10 @@ static struct comp_dev *eq_fir_new(const struct comp_driver *drv,
 		cd->config_ready = true;
 	}
 
-	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
+	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++) {
 		fir_reset(&cd->fir[i]);
+		fir_fft_reset(&cd->fft[i]);
+	}
 
 	dev->state = COMP_STATE_READY;
 	return dev;
@@ -669,6 +797,11 @@ static void eq_fir_process(struct comp_dev *dev, struct comp_buffer *source,
 	cd->eq_fir_func(cd->fir, &source->stream, &sink->stream, frames,
 			source->stream.channels);
 
+	/* Run FFT convolution channels in place */
+	if (cd->eq_fir_fft_func)
+		cd->eq_fir_fft_func(cd->fft, cd->fft_work, &sink->stream,
+				    frames, source->stream.channels);
+
 	buffer_writeback(sink, sink_bytes);
 
 	/* calc new free and available */
@@ -14,6 +14,8 @@
 #include <sof/audio/buffer.h>
 #include <sof/audio/eq_fir/fir.h>
 #include <sof/audio/format.h>
+#include <sof/math/numbers.h>
+#include <sof/platform.h>
 #include <user/eq.h>
 #include <errno.h>
 #include <stddef.h>
@@ -42,7 +44,7 @@ int fir_delay_size(struct sof_eq_fir_coef_data *config)
 	if (config->length > SOF_EQ_FIR_MAX_LENGTH || config->length < 1)
 		return -EINVAL;
 
-	return config->length * sizeof(int32_t);
+	return (config->length - 1 + FIR_DELAY_SPACE) * sizeof(int32_t);
 }
 
 int fir_init_coef(struct fir_state_32x16 *fir,
@@ -59,31 +61,93 @@ int fir_init_coef(struct fir_state_32x16 *fir,
 void fir_init_delay(struct fir_state_32x16 *fir, int32_t **data)
 {
 	fir->delay = *data;
-	*data += fir->length; /* Point to next delay line start */
+	*data += fir->length - 1 + FIR_DELAY_SPACE; /* Next delay line start */
+}
+
+/* Per block pointers to channel inputs and the channel outputs. Channels
+ * in bypass use the output as input.
+ */
+struct fir_block {
+	int32_t *in[PLATFORM_MAX_CHANNELS];
+	int32_t out[PLATFORM_MAX_CHANNELS][FIR_BLOCK_FRAMES];
+};
+
+static void fir_block_setup(struct fir_state_32x16 fir[],
+			    struct fir_block *blk, int nch, int n)
+{
+	int ch;
+
+	for (ch = 0; ch < nch; ch++)
+		blk->in[ch] = fir[ch].length ?
+			fir_block_input(&fir[ch], n) : blk->out[ch];
+}
+
+static void fir_block_run(struct fir_state_32x16 fir[],
+			  struct fir_block *blk, int nch, int n)
+{
+	int ch;
+
+	for (ch = 0; ch < nch; ch++) {
+		if (fir[ch].length)
+			fir_32x16_block(&fir[ch], blk->out[ch], n);
+	}
 }
 
 #if CONFIG_FORMAT_S16LE
 void eq_fir_s16(struct fir_state_32x16 fir[], const struct audio_stream *source,
 		struct audio_stream *sink, int frames, int nch)
 {
-	struct fir_state_32x16 *filter;
-	int16_t *x;
-	int16_t *y;
+	struct fir_block blk;
+	int16_t *x = source->r_ptr;
+	int16_t *y = sink->w_ptr;
 	int32_t z;
-	int idx;
 	int ch;
+	int b;
 	int i;
+	int m;
+	int n;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s16(source, idx);
-			y = audio_stream_write_frag_s16(sink, idx);
-			z = fir_32x16(filter, *x << 16);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+	while (frames) {
+		n = MIN(frames, FIR_BLOCK_FRAMES);
+		fir_block_setup(fir, &blk, nch, n);
+
+		/* Load interleaved block to channel delay lines */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(source, x));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++)
+					blk.in[ch][i] = (int32_t)x[ch] << 16;
+
+				x += nch;
+			}
+
+			x = audio_stream_wrap(source, x);
+		}
+
+		fir_block_run(fir, &blk, nch, n);
+
+		/* Store channel outputs interleaved */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(sink, y));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++) {
+					z = Q_SHIFT_RND(blk.out[ch][i], 31, 15);
+					y[ch] = sat_int16(z);
+				}
+
+				y += nch;
+			}
+
+			y = audio_stream_wrap(sink, y);
 		}
+
+		frames -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
@@ -92,24 +156,57 @@ void eq_fir_s16(struct fir_state_32x16 fir[], const struct audio_stream *source,
 void eq_fir_s24(struct fir_state_32x16 fir[], const struct audio_stream *source,
 		struct audio_stream *sink, int frames, int nch)
 {
-	struct fir_state_32x16 *filter;
-	int32_t *x;
-	int32_t *y;
+	struct fir_block blk;
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
 	int32_t z;
-	int idx;
 	int ch;
+	int b;
 	int i;
+	int m;
+	int n;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s32(sink, idx);
-			z = fir_32x16(filter, *x << 8);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
+	while (frames) {
+		n = MIN(frames, FIR_BLOCK_FRAMES);
+		fir_block_setup(fir, &blk, nch, n);
+
+		/* Load interleaved block to channel delay lines */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(source, x));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++)
+					blk.in[ch][i] = x[ch] << 8;
+
+				x += nch;
+			}
+
+			x = audio_stream_wrap(source, x);
+		}
+
+		fir_block_run(fir, &blk, nch, n);
+
+		/* Store channel outputs interleaved */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(sink, y));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++) {
+					z = Q_SHIFT_RND(blk.out[ch][i], 31, 23);
+					y[ch] = sat_int24(z);
+				}
+
+				y += nch;
+			}
+
+			y = audio_stream_wrap(sink, y);
 		}
+
+		frames -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE */
@@ -118,22 +215,54 @@ void eq_fir_s24(struct fir_state_32x16 fir[], const struct audio_stream *source,
 void eq_fir_s32(struct fir_state_32x16 fir[], const struct audio_stream *source,
 		struct audio_stream *sink, int frames, int nch)
 {
-	struct fir_state_32x16 *filter;
-	int32_t *x;
-	int32_t *y;
-	int idx;
+	struct fir_block blk;
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
 	int ch;
+	int b;
 	int i;
+	int m;
+	int n;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &fir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s32(sink, idx);
-			*y = fir_32x16(filter, *x);
-			idx += nch;
+	while (frames) {
+		n = MIN(frames, FIR_BLOCK_FRAMES);
+		fir_block_setup(fir, &blk, nch, n);
+
+		/* Load interleaved block to channel delay lines */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(source, x));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++)
+					blk.in[ch][i] = x[ch];
+
+				x += nch;
+			}
+
+			x = audio_stream_wrap(source, x);
 		}
+
+		fir_block_run(fir, &blk, nch, n);
+
+		/* Store channel outputs interleaved */
+		for (b = 0; b < n; b += m) {
+			m = MIN(n - b,
+				audio_stream_frames_without_wrap(sink, y));
+			if (!m)
+				return;
+			for (i = b; i < b + m; i++) {
+				for (ch = 0; ch < nch; ch++)
+					y[ch] = blk.out[ch][i];
+
+				y += nch;
+			}
+
+			y = audio_stream_wrap(sink, y);
+		}
+
+		frames -= n;
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE */
@@ -0,0 +1,544 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/audio/buffer.h>
+#include <sof/audio/eq_fir/fir_fft.h>
+#include <sof/audio/format.h>
+#include <sof/common.h>
+#include <sof/math/numbers.h>
+#include <sof/math/trig.h>
+#include <user/eq.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Uniformly partitioned overlap-save FFT convolution
+ *
+ * Every block of FIR_FFT_BLOCK_SIZE input samples is transformed together
+ * with the previous block with a FFT of size FIR_FFT_SIZE and stored into a
+ * frequency domain delay line (FDL). The output block spectrum is the sum of
+ * the FDL spectra multiplied with the spectra of the response partitions. The
+ * latter half of its inverse FFT is the filtered output block.
+ *
+ * Only the bins from DC to Nyquist are stored and multiplied since the
+ * spectra of real signals are conjugate symmetric.
+ */
+
+#if FIR_FFT_FLOAT
+
+/* Floating point, the forward FFT is not scaled and the inverse FFT is
+ * scaled with 1/N at output conversion.
+ */
+
+#define FIR_FFT_Q31_TO_FLOAT	(1.0f / 2147483648.0f)
+#define FIR_FFT_Q15_TO_FLOAT	(1.0f / 32768.0f)
+
+static inline void fir_fft_butterfly(struct fir_fft_complex *a,
+				     struct fir_fft_complex *b,
+				     const struct fir_fft_complex *w,
+				     bool inverse)
+{
+	float wi = inverse ? -w->imag : w->imag;
+	float tr = b->real * w->real - b->imag * wi;
+	float ti = b->real * wi + b->imag * w->real;
+
+	b->real = a->real - tr;
+	b->imag = a->imag - ti;
+	a->real += tr;
+	a->imag += ti;
+}
+
+static inline void fir_fft_set_twiddle(struct fir_fft_complex *w, int32_t c,
+				       int32_t s)
+{
+	w->real = c * FIR_FFT_Q31_TO_FLOAT;
+	w->imag = -s * FIR_FFT_Q31_TO_FLOAT;
+}
+
+static inline void fir_fft_set_sample(struct fir_fft_complex *x, int32_t v)
+{
+	x->real = v * FIR_FFT_Q31_TO_FLOAT;
+	x->imag = 0;
+}
+
+static inline void fir_fft_set_coef(struct fir_fft_complex *x, int16_t v)
+{
+	x->real = v * FIR_FFT_Q15_TO_FLOAT;
+	x->imag = 0;
+}
+
+static inline void fir_fft_mac(struct fir_fft_acc *acc,
+			       const struct fir_fft_complex *x,
+			       const struct fir_fft_complex *h)
+{
+	int k;
+
+	for (k = 0; k < FIR_FFT_BINS; k++) {
+		acc[k].real += x[k].real * h[k].real - x[k].imag * h[k].imag;
+		acc[k].imag += x[k].real * h[k].imag + x[k].imag * h[k].real;
+	}
+}
+
+static inline void fir_fft_acc_get(struct fir_fft_complex *y,
+				   const struct fir_fft_acc *acc)
+{
+	y->real = acc->real;
+	y->imag = acc->imag;
+}
+
+static inline int32_t fir_fft_get_sample(struct fir_fft_state *fft,
+					 const struct fir_fft_complex *y)
+{
+	float v = y->real * fft->scale;
+
+	if (v >= (float)INT32_MAX)
+		return INT32_MAX;
+
+	if (v <= (float)INT32_MIN)
+		return INT32_MIN;
+
+	return (int32_t)v;
+}
+
+/* Response spectra are not normalized, output is scaled to Q1.31 with 1/N
+ * inverse FFT scale and the response output shift.
+ */
+static void fir_fft_normalize(struct fir_fft_state *fft)
+{
+	if (fft->out_shift >= 0)
+		fft->scale = 2147483648.0f /
+			(FIR_FFT_SIZE << fft->out_shift);
+	else
+		fft->scale = 2147483648.0f * (1 << -fft->out_shift) /
+			FIR_FFT_SIZE;
+}
+
+#else
+
+/* Fixed point, every FFT stage is scaled by 1/2 to prevent overflow so both
+ * the forward and inverse FFT scale by 1/N. The response spectra are
+ * normalized to use the full Q1.31 range and the output is shifted back with
+ * the sum of all scaling.
+ */
+
+static inline void fir_fft_butterfly(struct fir_fft_complex *a,
+				     struct fir_fft_complex *b,
+				     const struct fir_fft_complex *w,
+				     bool inverse)
+{
+	int32_t wi = inverse ? -w->imag : w->imag;
+	int64_t tr;
+	int64_t ti;
+
+	/* Q1.31 x Q1.31 -> Q2.62, shift to Q2.31 */
+	tr = ((int64_t)b->real * w->real - (int64_t)b->imag * wi) >> 31;
+	ti = ((int64_t)b->real * wi + (int64_t)b->imag * w->real) >> 31;
+
+	b->real = (a->real - tr) >> 1;
+	b->imag = (a->imag - ti) >> 1;
+	a->real = (a->real + tr) >> 1;
+	a->imag = (a->imag + ti) >> 1;
+}
+
+static inline void fir_fft_set_twiddle(struct fir_fft_complex *w, int32_t c,
+				       int32_t s)
+{
+	w->real = c;
+	w->imag = -s;
+}
+
+static inline void fir_fft_set_sample(struct fir_fft_complex *x, int32_t v)
+{
+	x->real = v;
+	x->imag = 0;
+}
+
+static inline void fir_fft_set_coef(struct fir_fft_complex *x, int16_t v)
+{
+	x->real = (int32_t)v << 16;
+	x->imag = 0;
+}
+
+static inline void fir_fft_mac(struct fir_fft_acc *acc,
+			       const struct fir_fft_complex *x,
+			       const struct fir_fft_complex *h)
+{
+	int k;
+
+	/* Q1.31 x Q1.31 -> Q2.62, accumulate as Q33.31 */
+	for (k = 0; k < FIR_FFT_BINS; k++) {
+		acc[k].real += ((int64_t)x[k].real * h[k].real >> 31) -
+			((int64_t)x[k].imag * h[k].imag >> 31);
+		acc[k].imag += ((int64_t)x[k].real * h[k].imag >> 31) +
+			((int64_t)x[k].imag * h[k].real >> 31);
+	}
+}
+
+static inline void fir_fft_acc_get(struct fir_fft_complex *y,
+				   const struct fir_fft_acc *acc)
+{
+	/* One bit of headroom for the inverse FFT */
+	y->real = sat_int32(acc->real >> 1);
+	y->imag = sat_int32(acc->imag >> 1);
+}
+
+static inline int32_t fir_fft_get_sample(struct fir_fft_state *fft,
+					 const struct fir_fft_complex *y)
+{
+	if (fft->shift >= 0)
+		return sat_int32((int64_t)y->real << fft->shift);
+
+	return sat_int32(Q_SHIFT_RND((int64_t)y->real, 31 - fft->shift, 31));
+}
+
+/* Normalize the response spectra and compute the output shift. The input
+ * and response spectra are scaled by 1/N, the response is then scaled up by
+ * 2^s, the accumulated spectrum by 1/2 and the inverse FFT by 1/N.
+ */
+static void fir_fft_normalize(struct fir_fft_state *fft)
+{
+	int32_t amax = 0;
+	int32_t a;
+	int s;
+	int i;
+
+	for (i = 0; i < fft->partitions * FIR_FFT_BINS; i++) {
+		a = ABS(fft->coef[i].real);
+		amax = MAX(amax, a);
+		a = ABS(fft->coef[i].imag);
+		amax = MAX(amax, a);
+	}
+
+	s = amax ? norm_int32(amax) : 0;
+	for (i = 0; i < fft->partitions * FIR_FFT_BINS; i++) {
+		fft->coef[i].real <<= s;
+		fft->coef[i].imag <<= s;
+	}
+
+	fft->shift = 2 * FIR_FFT_SIZE_LOG2 + 1 - s - fft->out_shift;
+}
+
+#endif /* FIR_FFT_FLOAT */
+
+static inline int fir_fft_partitions(struct sof_eq_fir_coef_data *config)
+{
+	return (config->length + FIR_FFT_BLOCK_SIZE - 1) >>
+		FIR_FFT_BLOCK_SIZE_LOG2;
+}
+
+static void fir_fft_bit_reverse(struct fir_fft_complex *x)
+{
+	struct fir_fft_complex tmp;
+	int i;
+	int j = 0;
+	int k;
+
+	for (i = 0; i < FIR_FFT_SIZE - 1; i++) {
+		if (i < j) {
+			tmp = x[i];
+			x[i] = x[j];
+			x[j] = tmp;
+		}
+
+		k = FIR_FFT_SIZE >> 1;
+		while (k <= j) {
+			j -= k;
+			k >>= 1;
+		}
+
+		j += k;
+	}
+}
+
+/* In-place radix-2 decimation in time FFT */
+static void fir_fft_execute(struct fir_fft_complex *x,
+			    const struct fir_fft_complex *twiddle,
+			    bool inverse)
+{
+	int half;
+	int step;
+	int i;
+	int k;
+
+	fir_fft_bit_reverse(x);
+
+	for (half = 1, step = FIR_FFT_SIZE >> 1; half < FIR_FFT_SIZE;
+	     half <<= 1, step >>= 1) {
+		for (i = 0; i < FIR_FFT_SIZE; i += 2 * half) {
+			for (k = 0; k < half; k++)
+				fir_fft_butterfly(&x[i + k], &x[i + k + half],
+						  &twiddle[k * step], inverse);
+		}
+	}
+}
+
+void fir_fft_reset(struct fir_fft_state *fft)
+{
+	fft->pos = 0;
+	fft->partitions = 0;
+	fft->fdl_idx = 0;
+	fft->out_shift = 0;
+	fft->config = NULL;
+	fft->coef = NULL;
+	fft->fdl = NULL;
+	fft->in = NULL;
+	fft->out = NULL;
+}
+
+int fir_fft_coef_size(struct sof_eq_fir_coef_data *config)
+{
+	if (config->length > SOF_EQ_FIR_MAX_LENGTH_FFT || config->length < 1)
+		return -EINVAL;
+
+	return fir_fft_partitions(config) * FIR_FFT_BINS *
+		sizeof(struct fir_fft_complex);
+}
+
+int fir_fft_delay_size(struct sof_eq_fir_coef_data *config)
+{
+	if (config->length > SOF_EQ_FIR_MAX_LENGTH_FFT || config->length < 1)
+		return -EINVAL;
+
+	/* Frequency delay line, two input blocks and one output block */
+	return fir_fft_partitions(config) * FIR_FFT_BINS *
+		sizeof(struct fir_fft_complex) +
+		(FIR_FFT_SIZE + FIR_FFT_BLOCK_SIZE) * sizeof(int32_t);
+}
+
+void fir_fft_init_work(struct fir_fft_work *work)
+{
+	int32_t w;
+	int k;
+
+	/* exp(-j * 2 * pi * k / N) for k = 0 .. N / 2 - 1 */
+	for (k = 0; k < FIR_FFT_SIZE / 2; k++) {
+		w = (int32_t)(((int64_t)PI_MUL2_Q4_28 * k) >>
+			      FIR_FFT_SIZE_LOG2);
+		fir_fft_set_twiddle(&work->twiddle[k],
+				    sin_fixed(w + PI_DIV2_Q4_28),
+				    sin_fixed(w));
+	}
+}
+
+void fir_fft_init_coef(struct fir_fft_state *fft, struct fir_fft_work *work,
+		       struct sof_eq_fir_coef_data *config, void **data)
+{
+	struct fir_fft_complex *buf = work->buf;
+	struct fir_fft_complex *h;
+	int16_t *coef = ASSUME_ALIGNED(&config->coef[0], 4);
+	int n;
+	int p;
+	int k;
+
+	fft->partitions = fir_fft_partitions(config);
+	fft->out_shift = config->out_shift;
+	fft->config = config;
+	fft->coef = *data;
+
+	for (p = 0; p < fft->partitions; p++) {
+		/* Partition is zero padded to FFT size */
+		for (k = 0; k < FIR_FFT_SIZE; k++) {
+			n = p * FIR_FFT_BLOCK_SIZE + k;
+			if (k < FIR_FFT_BLOCK_SIZE && n < config->length)
+				fir_fft_set_coef(&buf[k], coef[n]);
+			else
+				fir_fft_set_coef(&buf[k], 0);
+		}
+
+		fir_fft_execute(buf, work->twiddle, false);
+
+		h = &fft->coef[p * FIR_FFT_BINS];
+		for (k = 0; k < FIR_FFT_BINS; k++)
+			h[k] = buf[k];
+	}
+
+	fir_fft_normalize(fft);
+	*data = fft->coef + fft->partitions * FIR_FFT_BINS;
+}
+
+void fir_fft_share_coef(struct fir_fft_state *fft,
+			const struct fir_fft_state *src)
+{
+	fft->partitions = src->partitions;
+	fft->out_shift = src->out_shift;
+	fft->config = src->config;
+	fft->coef = src->coef;
+#if FIR_FFT_FLOAT
+	fft->scale = src->scale;
+#else
+	fft->shift = src->shift;
+#endif
+}
+
+void fir_fft_init_delay(struct fir_fft_state *fft, void **data)
+{
+	fft->pos = 0;
+	fft->fdl_idx = 0;
+	fft->fdl = *data;
+	fft->in = (int32_t *)(fft->fdl + fft->partitions * FIR_FFT_BINS);
+	fft->out = fft->in + FIR_FFT_SIZE;
+	*data = fft->out + FIR_FFT_BLOCK_SIZE;
+}
+
+void fir_fft_block(struct fir_fft_state *fft, struct fir_fft_work *work)
+{
+	struct fir_fft_complex *buf = work->buf;
+	struct fir_fft_complex *x;
+	int idx;
+	int p;
+	int k;
+
+	/* Spectrum of the previous and current input block */
+	for (k = 0; k < FIR_FFT_SIZE; k++)
+		fir_fft_set_sample(&buf[k], fft->in[k]);
+
+	fir_fft_execute(buf, work->twiddle, false);
+
+	/* Store into the delay line over the oldest spectrum */
+	fft->fdl_idx = fft->fdl_idx ? fft->fdl_idx - 1 : fft->partitions - 1;
+	x = &fft->fdl[fft->fdl_idx * FIR_FFT_BINS];
+	for (k = 0; k < FIR_FFT_BINS; k++)
+		x[k] = buf[k];
+
+	/* Multiply-accumulate partition p with input from p blocks ago */
+	for (k = 0; k < FIR_FFT_BINS; k++) {
+		work->acc[k].real = 0;
+		work->acc[k].imag = 0;
+	}
+
+	idx = fft->fdl_idx;
+	for (p = 0; p < fft->partitions; p++) {
+		fir_fft_mac(work->acc, &fft->fdl[idx * FIR_FFT_BINS],
+			    &fft->coef[p * FIR_FFT_BINS]);
+		if (++idx == fft->partitions)
+			idx = 0;
+	}
+
+	/* Complete the conjugate symmetric spectrum and transform back */
+	for (k = 0; k < FIR_FFT_BINS; k++)
+		fir_fft_acc_get(&buf[k], &work->acc[k]);
+
+	for (k = 1; k < FIR_FFT_BLOCK_SIZE; k++) {
+		buf[FIR_FFT_SIZE - k].real = buf[k].real;
+		buf[FIR_FFT_SIZE - k].imag = -buf[k].imag;
+	}
+
+	fir_fft_execute(buf, work->twiddle, true);
+
+	/* The latter half is free of circular convolution aliasing */
+	for (k = 0; k < FIR_FFT_BLOCK_SIZE; k++) {
+		fft->out[k] = fir_fft_get_sample(fft,
+						 &buf[FIR_FFT_BLOCK_SIZE + k]);
+		fft->in[k] = fft->in[FIR_FFT_BLOCK_SIZE + k];
+	}
+}
+
+/* The FFT convolution is run in place for the channels that have it set up.
+ * The direct form FIR passes these channels through to sink.
+ */
+
+#if CONFIG_FORMAT_S16LE
+void eq_fir_fft_s16(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int16_t *y0 = sink->w_ptr;
+	int16_t *y;
+	int32_t z;
+	int ch;
+	int i;
+	int n;
+
+	while (frames) {
+		n = MIN(audio_stream_frames_without_wrap(sink, y0), frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &fft[ch];
+			if (!filter->partitions)
+				continue;
+
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = fir_fft_32(filter, work, *y << 16);
+				*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
+				y += nch;
+			}
+		}
+
+		frames -= n;
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
+	}
+}
+#endif /* CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S24LE
+void eq_fir_fft_s24(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int32_t *y0 = sink->w_ptr;
+	int32_t *y;
+	int32_t z;
+	int ch;
+	int i;
+	int n;
+
+	while (frames) {
+		n = MIN(audio_stream_frames_without_wrap(sink, y0), frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &fft[ch];
+			if (!filter->partitions)
+				continue;
+
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = fir_fft_32(filter, work, *y << 8);
+				*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
+				y += nch;
+			}
+		}
+
+		frames -= n;
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
+	}
+}
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+void eq_fir_fft_s32(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch)
+{
+	struct fir_fft_state *filter;
+	int32_t *y0 = sink->w_ptr;
+	int32_t *y;
+	int ch;
+	int i;
+	int n;
+
+	while (frames) {
+		n = MIN(audio_stream_frames_without_wrap(sink, y0), frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &fft[ch];
+			if (!filter->partitions)
+				continue;
+
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				*y = fir_fft_32(filter, work, *y);
+				y += nch;
+			}
+		}
+
+		frames -= n;
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE */
@@ -12,6 +12,7 @@
 #include <sof/audio/eq_iir/iir.h>
 #include <sof/audio/format.h>
 #include <sof/audio/pipeline.h>
+#include <sof/bit.h>
 #include <sof/common.h>
 #include <sof/debug/panic.h>
 #include <sof/drivers/ipc.h>
@@ -19,6 +20,7 @@
 #include <sof/lib/memory.h>
 #include <sof/lib/uuid.h>
 #include <sof/list.h>
+#include <sof/math/numbers.h>
 #include <sof/platform.h>
 #include <sof/string.h>
 #include <sof/trace/trace.h>
@@ -50,13 +52,313 @@ struct comp_data {
 	size_t iir_delay_size;			/**< allocated size */
 	bool config_ready;			/**< set when fully received */
 	eq_iir_func eq_iir_func;		/**< processing function */
+#if IIR_GENERIC
+	struct iir_batch_df2t batch[PLATFORM_MAX_CHANNELS]; /**< batches */
+	int batch_ch[PLATFORM_MAX_CHANNELS];	/**< channels of lanes */
+	int num_batches;			/**< number of batches */
+#endif
 };
 
-#if CONFIG_FORMAT_S16LE
 /*
  * EQ IIR algorithm code
  */
 
+#if IIR_GENERIC
+/* The channels are processed in blocks of IIR_BATCH_FRAMES frames. The
+ * block is converted to Q1.31 and filtered in place by the channel
+ * batches. The channels in bypass are passed unchanged.
+ */
+static void eq_iir_block(struct comp_data *cd, int32_t *blk, int frames,
+			 int nch)
+{
+	int32_t lanes_blk[IIR_BATCH_FRAMES * IIR_BATCH_MAX_LANES];
+	struct iir_batch_df2t *batch;
+	int32_t *x;
+	int *ch = cd->batch_ch;
+	int lanes;
+	int b;
+	int i;
+	int l;
+
+	for (b = 0; b < cd->num_batches; b++) {
+		batch = &cd->batch[b];
+		lanes = batch->lanes;
+
+		/* All channels in stream order share the response */
+		if (lanes == nch) {
+			iir_batch_df2t(batch, blk, frames);
+			return;
+		}
+
+		x = lanes_blk;
+		for (i = 0; i < frames; i++) {
+			for (l = 0; l < lanes; l++)
+				x[l] = blk[i * nch + ch[l]];
+
+			x += lanes;
+		}
+
+		iir_batch_df2t(batch, lanes_blk, frames);
+
+		x = lanes_blk;
+		for (i = 0; i < frames; i++) {
+			for (l = 0; l < lanes; l++)
+				blk[i * nch + ch[l]] = x[l];
+
+			x += lanes;
+		}
+
+		ch += lanes;
+	}
+}
+
+#if CONFIG_FORMAT_S16LE
+static int16_t *eq_iir_load_s16(const struct audio_stream *source,
+				int16_t *x, int32_t *blk, int samples)
+{
+	int i;
+	int n;
+
+	while (samples) {
+		n = audio_stream_samples_without_wrap_s16(source, x);
+		n = MIN(samples, n);
+		if (!n)
+			break;
+		for (i = 0; i < n; i++)
+			blk[i] = (int32_t)x[i] << 16;
+
+		samples -= n;
+		blk += n;
+		x = audio_stream_wrap(source, x + n);
+	}
+
+	return x;
+}
+
+static int16_t *eq_iir_store_s16(const struct audio_stream *sink,
+				 int16_t *y, const int32_t *blk, int samples)
+{
+	int i;
+	int n;
+
+	while (samples) {
+		n = audio_stream_samples_without_wrap_s16(sink, y);
+		n = MIN(samples, n);
+		if (!n)
+			break;
+		for (i = 0; i < n; i++)
+			y[i] = sat_int16(Q_SHIFT_RND(blk[i], 31, 15));
+
+		samples -= n;
+		blk += n;
+		y = audio_stream_wrap(sink, y + n);
+	}
+
+	return y;
+}
+#endif /* CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+static int32_t *eq_iir_load_s32(const struct audio_stream *source,
+				int32_t *x, int32_t *blk, int samples,
+				int shift)
+{
+	int i;
+	int n;
+
+	while (samples) {
+		n = audio_stream_samples_without_wrap_s32(source, x);
+		n = MIN(samples, n);
+		if (!n)
+			break;
+		for (i = 0; i < n; i++)
+			blk[i] = x[i] << shift;
+
+		samples -= n;
+		blk += n;
+		x = audio_stream_wrap(source, x + n);
+	}
+
+	return x;
+}
+#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
+
+#if CONFIG_FORMAT_S24LE
+static int32_t *eq_iir_store_s24(const struct audio_stream *sink,
+				 int32_t *y, const int32_t *blk, int samples)
+{
+	int i;
+	int n;
+
+	while (samples) {
+		n = audio_stream_samples_without_wrap_s32(sink, y);
+		n = MIN(samples, n);
+		if (!n)
+			break;
+		for (i = 0; i < n; i++)
+			y[i] = sat_int24(Q_SHIFT_RND(blk[i], 31, 23));
+
+		samples -= n;
+		blk += n;
+		y = audio_stream_wrap(sink, y + n);
+	}
+
+	return y;
+}
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+static int32_t *eq_iir_store_s32(const struct audio_stream *sink,
+				 int32_t *y, const int32_t *blk, int samples)
+{
+	int i;
+	int n;
+
+	while (samples) {
+		n = audio_stream_samples_without_wrap_s32(sink, y);
+		n = MIN(samples, n);
+		if (!n)
+			break;
+		for (i = 0; i < n; i++)
+			y[i] = blk[i];
+
+		samples -= n;
+		blk += n;
+		y = audio_stream_wrap(sink, y + n);
+	}
+
+	return y;
+}
+#endif /* CONFIG_FORMAT_S32LE */
+
+#if CONFIG_FORMAT_S16LE
+static void eq_iir_s16_default(const struct comp_dev *dev,
+			       const struct audio_stream *source,
+			       struct audio_stream *sink,
+			       uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t blk[IIR_BATCH_FRAMES * PLATFORM_MAX_CHANNELS];
+	int16_t *x = source->r_ptr;
+	int16_t *y = sink->w_ptr;
+	int nch = source->channels;
+	int samples;
+	int n;
+
+	while (frames) {
+		n = MIN(frames, IIR_BATCH_FRAMES);
+		samples = n * nch;
+		x = eq_iir_load_s16(source, x, blk, samples);
+		eq_iir_block(cd, blk, n, nch);
+		y = eq_iir_store_s16(sink, y, blk, samples);
+		frames -= n;
+	}
+}
+#endif /* CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S24LE
+static void eq_iir_s24_default(const struct comp_dev *dev,
+			       const struct audio_stream *source,
+			       struct audio_stream *sink,
+			       uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t blk[IIR_BATCH_FRAMES * PLATFORM_MAX_CHANNELS];
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
+	int nch = source->channels;
+	int samples;
+	int n;
+
+	while (frames) {
+		n = MIN(frames, IIR_BATCH_FRAMES);
+		samples = n * nch;
+		x = eq_iir_load_s32(source, x, blk, samples, 8);
+		eq_iir_block(cd, blk, n, nch);
+		y = eq_iir_store_s24(sink, y, blk, samples);
+		frames -= n;
+	}
+}
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+static void eq_iir_s32_default(const struct comp_dev *dev,
+			       const struct audio_stream *source,
+			       struct audio_stream *sink,
+			       uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t blk[IIR_BATCH_FRAMES * PLATFORM_MAX_CHANNELS];
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
+	int nch = source->channels;
+	int samples;
+	int n;
+
+	while (frames) {
+		n = MIN(frames, IIR_BATCH_FRAMES);
+		samples = n * nch;
+		x = eq_iir_load_s32(source, x, blk, samples, 0);
+		eq_iir_block(cd, blk, n, nch);
+		y = eq_iir_store_s32(sink, y, blk, samples);
+		frames -= n;
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE */
+
+#if CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S16LE
+static void eq_iir_s32_16_default(const struct comp_dev *dev,
+				  const struct audio_stream *source,
+				  struct audio_stream *sink,
+				  uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t blk[IIR_BATCH_FRAMES * PLATFORM_MAX_CHANNELS];
+	int32_t *x = source->r_ptr;
+	int16_t *y = sink->w_ptr;
+	int nch = source->channels;
+	int samples;
+	int n;
+
+	while (frames) {
+		n = MIN(frames, IIR_BATCH_FRAMES);
+		samples = n * nch;
+		x = eq_iir_load_s32(source, x, blk, samples, 0);
+		eq_iir_block(cd, blk, n, nch);
+		y = eq_iir_store_s16(sink, y, blk, samples);
+		frames -= n;
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S24LE
+static void eq_iir_s32_24_default(const struct comp_dev *dev,
+				  const struct audio_stream *source,
+				  struct audio_stream *sink,
+				  uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t blk[IIR_BATCH_FRAMES * PLATFORM_MAX_CHANNELS];
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
+	int nch = source->channels;
+	int samples;
+	int n;
+
+	while (frames) {
+		n = MIN(frames, IIR_BATCH_FRAMES);
+		samples = n * nch;
+		x = eq_iir_load_s32(source, x, blk, samples, 0);
+		eq_iir_block(cd, blk, n, nch);
+		y = eq_iir_store_s24(sink, y, blk, samples);
+		frames -= n;
+	}
+}
+#endif /* CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S24LE */
+
+#else
+
+#if CONFIG_FORMAT_S16LE
 static void eq_iir_s16_default(const struct comp_dev *dev,
 			       const struct audio_stream *source,
 			       struct audio_stream *sink,
@@ -65,24 +367,35 @@ static void eq_iir_s16_default(const struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *filter;
+	int16_t *x0 = source->r_ptr;
+	int16_t *y0 = sink->w_ptr;
 	int16_t *x;
 	int16_t *y;
 	int32_t z;
 	int ch;
 	int i;
-	int idx;
+	int n;
 	int nch = source->channels;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s16(source, idx);
-			y = audio_stream_write_frag_s16(sink, idx);
-			z = iir_df2t(filter, *x << 16);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+	while (frames) {
+		n = audio_stream_span_frames(source, x0, sink, y0, frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &cd->iir[ch];
+			x = x0 + ch;
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = iir_df2t(filter, *x << 16);
+				*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
+				x += nch;
+				y += nch;
+			}
 		}
+
+		frames -= n;
+		x0 = audio_stream_wrap(source, x0 + n * nch);
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
@@ -96,24 +409,35 @@ static void eq_iir_s24_default(const struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *filter;
+	int32_t *x0 = source->r_ptr;
+	int32_t *y0 = sink->w_ptr;
 	int32_t *x;
 	int32_t *y;
 	int32_t z;
-	int idx;
 	int ch;
 	int i;
+	int n;
 	int nch = source->channels;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s32(sink, idx);
-			z = iir_df2t(filter, *x << 8);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
+	while (frames) {
+		n = audio_stream_span_frames(source, x0, sink, y0, frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &cd->iir[ch];
+			x = x0 + ch;
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = iir_df2t(filter, *x << 8);
+				*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
+				x += nch;
+				y += nch;
+			}
 		}
+
+		frames -= n;
+		x0 = audio_stream_wrap(source, x0 + n * nch);
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE */
@@ -127,22 +451,33 @@ static void eq_iir_s32_default(const struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *filter;
+	int32_t *x0 = source->r_ptr;
+	int32_t *y0 = sink->w_ptr;
 	int32_t *x;
 	int32_t *y;
-	int idx;
 	int ch;
 	int i;
+	int n;
 	int nch = source->channels;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s32(sink, idx);
-			*y = iir_df2t(filter, *x);
-			idx += nch;
+	while (frames) {
+		n = audio_stream_span_frames(source, x0, sink, y0, frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &cd->iir[ch];
+			x = x0 + ch;
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				*y = iir_df2t(filter, *x);
+				x += nch;
+				y += nch;
+			}
 		}
+
+		frames -= n;
+		x0 = audio_stream_wrap(source, x0 + n * nch);
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE */
@@ -156,24 +491,35 @@ static void eq_iir_s32_16_default(const struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *filter;
+	int32_t *x0 = source->r_ptr;
+	int16_t *y0 = sink->w_ptr;
 	int32_t *x;
 	int16_t *y;
 	int32_t z;
-	int idx;
 	int ch;
 	int i;
+	int n;
 	int nch = source->channels;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s16(sink, idx);
-			z = iir_df2t(filter, *x);
-			*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
-			idx += nch;
+	while (frames) {
+		n = audio_stream_span_frames(source, x0, sink, y0, frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &cd->iir[ch];
+			x = x0 + ch;
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = iir_df2t(filter, *x);
+				*y = sat_int16(Q_SHIFT_RND(z, 31, 15));
+				x += nch;
+				y += nch;
+			}
 		}
+
+		frames -= n;
+		x0 = audio_stream_wrap(source, x0 + n * nch);
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S16LE */
@@ -187,28 +533,41 @@ static void eq_iir_s32_24_default(const struct comp_dev *dev,
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
 	struct iir_state_df2t *filter;
+	int32_t *x0 = source->r_ptr;
+	int32_t *y0 = sink->w_ptr;
 	int32_t *x;
 	int32_t *y;
 	int32_t z;
-	int idx;
 	int ch;
 	int i;
+	int n;
 	int nch = source->channels;
 
-	for (ch = 0; ch < nch; ch++) {
-		filter = &cd->iir[ch];
-		idx = ch;
-		for (i = 0; i < frames; i++) {
-			x = audio_stream_read_frag_s32(source, idx);
-			y = audio_stream_write_frag_s32(sink, idx);
-			z = iir_df2t(filter, *x);
-			*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
-			idx += nch;
+	while (frames) {
+		n = audio_stream_span_frames(source, x0, sink, y0, frames);
+		if (!n)
+			return;
+		for (ch = 0; ch < nch; ch++) {
+			filter = &cd->iir[ch];
+			x = x0 + ch;
+			y = y0 + ch;
+			for (i = 0; i < n; i++) {
+				z = iir_df2t(filter, *x);
+				*y = sat_int24(Q_SHIFT_RND(z, 31, 23));
+				x += nch;
+				y += nch;
+			}
 		}
+
+		frames -= n;
+		x0 = audio_stream_wrap(source, x0 + n * nch);
+		y0 = audio_stream_wrap(sink, y0 + n * nch);
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE && CONFIG_FORMAT_S24LE */
 
+#endif /* IIR_GENERIC */
+
 #if CONFIG_FORMAT_S16LE
 static void eq_iir_s16_pass(const struct comp_dev *dev,
 			    const struct audio_stream *source,
@@ -235,15 +594,22 @@ static void eq_iir_s32_s16_pass(const struct comp_dev *dev,
 				struct audio_stream *sink,
 				uint32_t frames)
 {
-	int32_t *x;
-	int16_t *y;
+	int32_t *x = source->r_ptr;
+	int16_t *y = sink->w_ptr;
 	int i;
-	int n = frames * source->channels;
-
-	for (i = 0; i < n; i++) {
-		x = audio_stream_read_frag_s32(source, i);
-		y = audio_stream_write_frag_s16(sink, i);
-		*y = sat_int16(Q_SHIFT_RND(*x, 31, 15));
+	int n;
+	int samples = frames * source->channels;
+
+	while (samples) {
+		n = audio_stream_span_samples(source, x, sink, y, samples);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++)
+			y[i] = sat_int16(Q_SHIFT_RND(x[i], 31, 15));
+
+		samples -= n;
+		x = audio_stream_wrap(source, x + n);
+		y = audio_stream_wrap(sink, y + n);
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE && CONFIG_FORMAT_S32LE */
@@ -254,15 +620,22 @@ static void eq_iir_s32_s24_pass(const struct comp_dev *dev,
 				struct audio_stream *sink,
 				uint32_t frames)
 {
-	int32_t *x;
-	int32_t *y;
+	int32_t *x = source->r_ptr;
+	int32_t *y = sink->w_ptr;
 	int i;
-	int n = frames * source->channels;
-
-	for (i = 0; i < n; i++) {
-		x = audio_stream_read_frag_s32(source, i);
-		y = audio_stream_write_frag_s16(sink, i);
-		*y = sat_int24(Q_SHIFT_RND(*x, 31, 23));
+	int n;
+	int samples = frames * source->channels;
+
+	while (samples) {
+		n = audio_stream_span_samples(source, x, sink, y, samples);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++)
+			y[i] = sat_int24(Q_SHIFT_RND(x[i], 31, 23));
+
+		samples -= n;
+		x = audio_stream_wrap(source, x + n);
+		y = audio_stream_wrap(sink, y + n);
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE && CONFIG_FORMAT_S32LE */
@@ -356,6 +729,10 @@ static void eq_iir_free_delaylines(struct comp_data *cd)
 	cd->iir_delay_size = 0;
 	for (i = 0; i < PLATFORM_MAX_CHANNELS; i++)
 		iir[i].delay = NULL;
+
+#if IIR_GENERIC
+	cd->num_batches = 0;
+#endif
 }
 
 static int eq_iir_init_coef(struct sof_eq_iir_config *config,
@@ -449,6 +826,51 @@ static int eq_iir_init_coef(struct sof_eq_iir_config *config,
 	return size_sum;
 }
 
+#if IIR_GENERIC
+static int eq_iir_init_batches(struct comp_data *cd, int64_t *delay_start,
+			       int nch)
+{
+	struct iir_state_df2t *iir = cd->iir;
+	struct iir_batch_df2t *batch;
+	int64_t *delay = delay_start;
+	uint32_t assigned = 0;
+	int lanes = 0;
+	int first;
+	int ret;
+	int i;
+	int j;
+
+	/* Group the channels with the same response into batches. The
+	 * batch lanes are in ascending channel order and the lanes of all
+	 * batches are stored consecutively in batch_ch[].
+	 */
+	cd->num_batches = 0;
+	for (i = 0; i < nch; i++) {
+		if (!iir[i].biquads || (assigned & BIT(i)))
+			continue;
+
+		first = lanes;
+		for (j = i; j < nch; j++) {
+			if (iir[j].coef == iir[i].coef) {
+				cd->batch_ch[lanes++] = j;
+				assigned |= BIT(j);
+			}
+		}
+
+		batch = &cd->batch[cd->num_batches++];
+		ret = iir_batch_init_df2t(batch, &iir[i], lanes - first);
+		if (ret < 0)
+			return ret;
+
+		iir_batch_init_delay_df2t(batch, &delay);
+		comp_cl_info(&comp_eq_iir, "eq_iir_init_batches(), batch %d has %d channels",
+			     cd->num_batches - 1, lanes - first);
+	}
+
+	return 0;
+}
+#else
+
 static void eq_iir_init_delay(struct iir_state_df2t *iir,
 			      int64_t *delay_start, int nch)
 {
@@ -463,6 +885,7 @@ static void eq_iir_init_delay(struct iir_state_df2t *iir,
 			iir_init_delay_df2t(&iir[i], &delay);
 	}
 }
+#endif /* IIR_GENERIC */
 
 static int eq_iir_setup(struct comp_data *cd, int nch)
 {
@@ -494,8 +917,12 @@ static int eq_iir_setup(struct comp_data *cd, int nch)
 	cd->iir_delay_size = delay_size;
 
 	/* Assign delay line to each channel EQ */
+#if IIR_GENERIC
+	return eq_iir_init_batches(cd, cd->iir_delay, nch);
+#else
 	eq_iir_init_delay(cd->iir, cd->iir_delay, nch);
 	return 0;
+#endif
 }
 
 /*
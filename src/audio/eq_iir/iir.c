@@ -55,3 +55,25 @@ void iir_reset_df2t(struct iir_state_df2t *iir)
 	 */
 }
 
+int iir_batch_init_df2t(struct iir_batch_df2t *iir,
+			struct iir_state_df2t *src, int lanes)
+{
+	if (lanes < 1 || lanes > IIR_BATCH_MAX_LANES)
+		return -EINVAL;
+
+	iir->lanes = lanes;
+	iir->biquads = src->biquads;
+	iir->biquads_in_series = src->biquads_in_series;
+	iir->coef = src->coef;
+
+	return 0;
+}
+
+void iir_batch_init_delay_df2t(struct iir_batch_df2t *iir, int64_t **delay)
+{
+	/* The delay line size is the same as for the lanes filtered one
+	 * by one.
+	 */
+	iir->delay = *delay;
+	*delay += 2 * iir->biquads * iir->lanes;
+}
@@ -104,5 +104,81 @@ int32_t iir_df2t(struct iir_state_df2t *iir, int32_t x)
 	return out;
 }
 
+/* Batched series DF2T IIR
+ *
+ * The data is a block of frames with one sample per lane. The computation
+ * is the same as in iir_df2t() for each lane. Delay element k of biquad j
+ * of a lane is in delay[(2 * j + k) * lanes + lane].
+ */
+
+void iir_batch_df2t(struct iir_batch_df2t *iir, int32_t *data, int frames)
+{
+	int32_t in[IIR_BATCH_MAX_LANES];
+	int32_t out[IIR_BATCH_MAX_LANES];
+	int32_t *x = data;
+	int64_t *d0;
+	int64_t *d1;
+	int64_t acc;
+	int32_t tmp;
+	int32_t *c;
+	int lanes = iir->lanes;
+	int f;
+	int i;
+	int j;
+	int l;
+
+	/* Bypass is set with number of biquads set to zero. */
+	if (!iir->biquads)
+		return;
+
+	for (f = 0; f < frames; f++) {
+		for (l = 0; l < lanes; l++) {
+			in[l] = x[l];
+			out[l] = 0;
+		}
+
+		c = iir->coef;
+		d0 = iir->delay;
+		for (j = 0; j < iir->biquads; j += iir->biquads_in_series) {
+			for (i = 0; i < iir->biquads_in_series; i++) {
+				/* Coefficients order in c[] is
+				 * {a2, a1, b2, b1, b0, shift, gain}
+				 */
+				d1 = d0 + lanes;
+				for (l = 0; l < lanes; l++) {
+					/* Q2.30 x Q1.31 + Q3.61 -> Q3.31 */
+					acc = (int64_t)c[4] * in[l] + d0[l];
+					tmp = (int32_t)Q_SHIFT_RND(acc, 61, 31);
+
+					/* Update delays */
+					d0[l] = d1[l] + (int64_t)c[3] * in[l] +
+						(int64_t)c[1] * tmp;
+					d1[l] = (int64_t)c[2] * in[l] +
+						(int64_t)c[0] * tmp;
+
+					/* Gain Q2.14 x Q1.31 -> Q3.45, shift
+					 * to Q1.31 for the next biquad.
+					 */
+					acc = (int64_t)c[6] * tmp;
+					acc = Q_SHIFT_RND(acc, 45 + c[5], 31);
+					in[l] = sat_int32(acc);
+				}
+
+				c += SOF_EQ_IIR_NBIQUAD_DF2T;
+				d0 += IIR_DF2T_NUM_DELAYS * lanes;
+			}
+
+			/* Output of previous section is in in[] */
+			for (l = 0; l < lanes; l++)
+				out[l] = sat_int32((int64_t)out[l] + in[l]);
+		}
+
+		for (l = 0; l < lanes; l++)
+			x[l] = out[l];
+
+		x += lanes;
+	}
+}
+
 #endif
 
@@ -625,6 +625,7 @@ static int host_params(struct comp_dev *dev,
 	uint32_t period_count;
 	uint32_t period_bytes;
 	uint32_t buffer_size;
+	uint32_t frame_size;
 	uint32_t addr_align;
 	uint32_t align;
 	int err;
@@ -703,11 +704,15 @@ static int host_params(struct comp_dev *dev,
 		period_count = 1;
 	}
 
-	/* calculate DMA buffer size */
-	buffer_size = ALIGN_UP(period_count * period_bytes, align);
+	/* calculate DMA buffer size, in whole frames up to the wrap */
+	frame_size = audio_stream_frame_bytes(&hd->local_buffer->stream);
+	buffer_size = ALIGN_UP(period_count * period_bytes,
+			       align / gcd(align, frame_size) * frame_size);
 
 	/* alloc DMA buffer or change its size if exists */
 	if (hd->dma_buffer) {
+		/* the new size is checked against the new params below */
+		buffer_reset_params(hd->dma_buffer, NULL);
 		err = buffer_set_size(hd->dma_buffer, buffer_size);
 		if (err < 0) {
 			comp_err(dev, "host_params(): buffer_set_size() failed, buffer_size = %u",
@@ -723,6 +728,14 @@ static int host_params(struct comp_dev *dev,
 		}
 	}
 
+	/* the pcm converter strides the dma buffer by its stream params */
+	err = buffer_set_params(hd->dma_buffer, params, BUFFER_UPDATE_FORCE);
+	if (err < 0) {
+		comp_err(dev, "host_params(): buffer_set_params() failed for dma buffer, buffer_size = %u",
+			 buffer_size);
+		return err;
+	}
+
 	/* create SG DMA elems for local DMA buffer */
 	err = create_local_elems(dev, period_count, buffer_size / period_count);
 	if (err < 0)
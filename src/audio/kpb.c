@@ -63,6 +63,7 @@ struct comp_data {
 	spinlock_t lock; /**< locking mechanism for read pointer calculations */
 	struct sof_kpb_config config;   /**< component configuration data */
 	struct history_data hd; /** data related to history buffer */
+	struct kpb_codec codec; /**< history buffer codec */
 	struct task draining_task;
 	struct draining_data draining_task_data;
 	struct kpb_client clients[KPB_MAX_NO_OF_CLIENTS];
@@ -84,20 +85,35 @@ static int kpb_register_client(struct comp_data *kpb, struct kpb_client *cli);
 static void kpb_init_draining(struct comp_dev *dev, struct kpb_client *cli);
 static enum task_state kpb_draining_task(void *arg);
 static int kpb_buffer_data(struct comp_dev *dev,
-			   const struct comp_buffer *source, size_t size);
+			   const struct comp_buffer *source, size_t size,
+			   size_t *stored);
+static int kpb_history_write(struct comp_dev *dev,
+			     const struct audio_stream *source,
+			     const void *linear, size_t size);
+static void kpb_history_read(struct history_buffer **buff, void *dst,
+			     size_t size);
+static int kpb_encode_data(struct comp_dev *dev,
+			   const struct audio_stream *source, size_t size,
+			   size_t *stored);
+static int kpb_codec_prepare(struct comp_data *kpb);
+static void kpb_codec_reset(struct comp_data *kpb);
+static size_t kpb_history_space(struct comp_data *kpb);
+static size_t kpb_history_bytes(struct comp_data *kpb, size_t size);
+static size_t kpb_drain_block(struct comp_data *kpb,
+			      struct history_buffer **buff,
+			      struct audio_stream *sink, size_t *produced);
+static bool kpb_drain_staged(struct comp_data *kpb, struct comp_buffer *sink);
 static size_t kpb_allocate_history_buffer(struct comp_data *kpb,
 					  size_t hb_size_req);
 static void kpb_clear_history_buffer(struct history_buffer *buff);
 static void kpb_free_history_buffer(struct history_buffer *buff);
 static inline bool kpb_is_sample_width_supported(uint32_t sampling_width);
 static void kpb_copy_samples(struct comp_buffer *sink,
-			     struct comp_buffer *source, size_t size,
-			     size_t sample_width);
+			     struct comp_buffer *source, size_t size);
 static void kpb_drain_samples(void *source, struct audio_stream *sink,
-			      size_t size, size_t sample_width);
+			      size_t size);
 static void kpb_buffer_samples(const struct audio_stream *source,
-			       uint32_t start, void *sink, size_t size,
-			       size_t sample_width);
+			       uint32_t start, void *sink, size_t size);
 static void kpb_reset_history_buffer(struct history_buffer *buff);
 static inline bool validate_host_params(struct comp_dev *dev,
 					size_t host_period_size,
@@ -172,6 +188,16 @@ static struct comp_dev *kpb_new(const struct comp_driver *drv,
 		return NULL;
 	}
 
+	if (kpb->config.codec != SOF_KPB_CODEC_NONE &&
+	    kpb->config.codec != SOF_KPB_CODEC_ADPCM) {
+		comp_err(dev, "kpb_new(): requested codec %d not supported",
+			 kpb->config.codec);
+		rfree(dev);
+		return NULL;
+	}
+
+	spinlock_init(&kpb->lock);
+
 	/* Initialize draining task */
 	schedule_task_init_edf(&kpb->draining_task, /* task structure */
 			       SOF_UUID(kpb_task_uuid), /* task uuid */
@@ -344,6 +370,10 @@ static void kpb_free(struct comp_dev *dev)
 	kpb->hd.c_hb = NULL;
 	kpb->hd.buffer_size = 0;
 
+	/* Reclaim memory of codec */
+	rfree(kpb->codec.pcm);
+	kpb->codec.pcm = NULL;
+
 	/* remove scheduling */
 	schedule_task_free(&kpb->draining_task);
 
@@ -407,9 +437,23 @@ static int kpb_params(struct comp_dev *dev,
 		return -EINVAL;
 	}
 
+	if (!params->channels ||
+	    params->channels > KPB_MAX_SUPPORTED_CHANNELS) {
+		comp_err(dev, "kpb_params(): no of channels %d not supported",
+			 params->channels);
+		return -EINVAL;
+	}
+
 	kpb->host_buffer_size = params->buffer.size;
 	kpb->host_period_size = params->host_period_bytes;
 	kpb->config.sampling_width = params->sample_container_bytes * 8;
+	kpb->config.channels = params->channels;
+
+	/* The codec keeps the valid bits of samples */
+	if (params->frame_fmt == SOF_IPC_FRAME_S24_4LE)
+		kpb->codec.sample_width = 24;
+	else
+		kpb->codec.sample_width = kpb->config.sampling_width;
 
 	return 0;
 }
@@ -429,7 +473,8 @@ static int kpb_prepare(struct comp_dev *dev)
 	int i;
 	struct list_item *blist;
 	struct comp_buffer *sink;
-	size_t hb_size_req = KPB_MAX_BUFFER_SIZE(kpb->config.sampling_width);
+	size_t hb_size_req = KPB_MAX_BUFFER_SIZE(kpb->config.sampling_width,
+						 kpb->config.channels);
 
 	comp_info(dev, "kpb_prepare()");
 
@@ -485,6 +530,12 @@ static int kpb_prepare(struct comp_dev *dev)
 	kpb_reset_history_buffer(kpb->hd.c_hb);
 	kpb->hd.free = kpb->hd.buffer_size;
 
+	ret = kpb_codec_prepare(kpb);
+	if (ret < 0) {
+		comp_err(dev, "kpb_prepare(): failed to allocate codec buffers");
+		return ret;
+	}
+
 	/* Initialize clients data */
 	for (i = 0; i < KPB_MAX_NO_OF_CLIENTS; i++) {
 		kpb->clients[i].state = KPB_CLIENT_UNREGISTERED;
@@ -584,6 +635,8 @@ static int kpb_reset(struct comp_dev *dev)
 			kpb_reset_history_buffer(kpb->hd.c_hb);
 		}
 
+		kpb_codec_reset(kpb);
+
 		/* Unregister KPB from notifications */
 		notifier_unregister(dev, NULL, NOTIFIER_ID_KPB_CLIENT_EVT);
 		/* Finally KPB is ready after reset */
@@ -614,7 +667,7 @@ static int kpb_copy(struct comp_dev *dev)
 	struct comp_buffer *source = NULL;
 	struct comp_buffer *sink = NULL;
 	size_t copy_bytes = 0;
-	size_t sample_width = kpb->config.sampling_width;
+	size_t stored = 0;
 	uint32_t flags = 0;
 	struct draining_data *dd = &kpb->draining_task_data;
 
@@ -673,13 +726,14 @@ static int kpb_copy(struct comp_dev *dev)
 			goto out;
 		}
 
-		kpb_copy_samples(sink, source, copy_bytes, sample_width);
+		kpb_copy_samples(sink, source, copy_bytes);
 
 		/* Buffer source data internally in history buffer for future
 		 * use by clients.
 		 */
 		if (source->stream.avail <= kpb->hd.buffer_size) {
-			ret = kpb_buffer_data(dev, source, copy_bytes);
+			ret = kpb_buffer_data(dev, source, copy_bytes,
+					      &stored);
 			if (ret) {
 				comp_err(dev, "kpb_copy(): internal buffering failed.");
 				goto out;
@@ -690,7 +744,7 @@ static int kpb_copy(struct comp_dev *dev)
 			 */
 			kpb->hd.buffered += MIN(kpb->hd.buffer_size -
 						kpb->hd.buffered,
-						copy_bytes);
+						stored);
 		} else {
 			comp_err(dev, "kpb_copy(): too much data to buffer.");
 		}
@@ -722,6 +776,15 @@ static int kpb_copy(struct comp_dev *dev)
 
 		buffer_unlock(sink, flags);
 
+		/* Frames staged for the codec when draining finished are
+		 * older than the real time stream. Whatever does not fit to
+		 * the sink stays staged for the next copy.
+		 */
+		if (kpb->codec.pcm_bytes && !kpb_drain_staged(kpb, sink)) {
+			ret = 0;
+			goto out;
+		}
+
 		copy_bytes = MIN(sink->stream.free, source->stream.avail);
 		if (!copy_bytes) {
 			comp_err(dev, "kpb_copy(): nothing to copy sink->free %d source->avail %d",
@@ -730,7 +793,7 @@ static int kpb_copy(struct comp_dev *dev)
 			goto out;
 		}
 
-		kpb_copy_samples(sink, source, copy_bytes, sample_width);
+		kpb_copy_samples(sink, source, copy_bytes);
 
 		comp_update_buffer_produce(sink, copy_bytes);
 		comp_update_buffer_consume(source, copy_bytes);
@@ -742,11 +805,19 @@ static int kpb_copy(struct comp_dev *dev)
 		 * the internal history buffer.
 		 */
 
-		copy_bytes = MIN(source->stream.avail, kpb->hd.free);
+		copy_bytes = MIN(source->stream.avail, kpb_history_space(kpb));
 		if (copy_bytes) {
 			buffer_invalidate(source, copy_bytes);
-			ret = kpb_buffer_data(dev, source, copy_bytes);
-			dd->buffered_while_draining += copy_bytes;
+
+			/* The draining task picks up the data stored meanwhile
+			 * when it finishes.
+			 */
+			ret = kpb_buffer_data(dev, source, copy_bytes, &stored);
+
+			spin_lock_irq(&kpb->lock, flags);
+			dd->buffered_while_draining += stored;
+			kpb->hd.free -= stored;
+			spin_unlock_irq(&kpb->lock, flags);
 
 			if (ret) {
 				comp_err(dev, "kpb_copy(): internal buffering failed.");
@@ -778,25 +849,22 @@ out:
  *
  * \param[in] kpb - KPB component data pointer.
  * \param[in] source pointer to the buffer source.
+ * \param[in] size - size of the data in bytes.
+ * \param[out] stored - size of the data stored in history buffer.
  *
  */
 static int kpb_buffer_data(struct comp_dev *dev,
-			   const struct comp_buffer *source, size_t size)
+			   const struct comp_buffer *source, size_t size,
+			   size_t *stored)
 {
 	int ret = 0;
-	size_t size_to_copy = size;
-	size_t space_avail;
 	struct comp_data *kpb = comp_get_drvdata(dev);
-	struct history_buffer *buff = kpb->hd.c_hb;
-	uint32_t offset = 0;
-	uint64_t timeout = 0;
-	uint64_t current_time;
 	enum kpb_state state_preserved = kpb->state;
-	size_t sample_width = kpb->config.sampling_width;
-	struct timer *timer = timer_get();
 
 	comp_dbg(dev, "kpb_buffer_data()");
 
+	*stored = 0;
+
 	/* We are allowed to buffer data in internal history buffer
 	 * only in KPB_STATE_RUN, KPB_STATE_DRAINING or KPB_STATE_INIT_DRAINING
 	 * states.
@@ -811,6 +879,95 @@ static int kpb_buffer_data(struct comp_dev *dev,
 
 	kpb_change_state(kpb, KPB_STATE_BUFFERING);
 
+	if (kpb->config.codec == SOF_KPB_CODEC_NONE) {
+		ret = kpb_history_write(dev, &source->stream, NULL, size);
+		if (ret)
+			return ret;
+
+		*stored = size;
+	} else {
+		ret = kpb_encode_data(dev, &source->stream, size, stored);
+		if (ret)
+			return ret;
+	}
+
+	kpb_change_state(kpb, state_preserved);
+	return ret;
+}
+
+/**
+ * \brief Stage frames for the codec and store the coded blocks.
+ *
+ * \param[in] dev - kpb component device pointer.
+ * \param[in] source - pointer to source stream.
+ * \param[in] size - size of the frames in bytes.
+ * \param[out] stored - size of the blocks stored in history buffer.
+ *
+ * \return 0 on success, error code otherwise.
+ */
+static int kpb_encode_data(struct comp_dev *dev,
+			   const struct audio_stream *source, size_t size,
+			   size_t *stored)
+{
+	struct comp_data *kpb = comp_get_drvdata(dev);
+	struct kpb_codec *codec = &kpb->codec;
+	uint32_t offset = 0;
+	size_t copy_bytes;
+	int ret;
+
+	while (size) {
+		copy_bytes = MIN(size, codec->frames_bytes - codec->pcm_bytes);
+		kpb_buffer_samples(source, offset,
+				   (char *)codec->pcm + codec->pcm_bytes,
+				   copy_bytes);
+		codec->pcm_bytes += copy_bytes;
+		offset += copy_bytes;
+		size -= copy_bytes;
+
+		/* Wait for a full block of frames */
+		if (codec->pcm_bytes < codec->frames_bytes)
+			break;
+
+		adpcm_encode_block(codec->state, codec->pcm,
+				   codec->sample_width, kpb->config.channels,
+				   codec->block);
+		codec->pcm_bytes = 0;
+
+		ret = kpb_history_write(dev, NULL, codec->block,
+					codec->block_bytes);
+		if (ret)
+			return ret;
+
+		*stored += codec->block_bytes;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Write data to the history buffer.
+ *
+ * \param[in] dev - kpb component device pointer.
+ * \param[in] source - pointer to source stream or NULL.
+ * \param[in] linear - pointer to the data if source is NULL.
+ * \param[in] size - size of the data in bytes.
+ *
+ * \return 0 on success, error code otherwise.
+ */
+static int kpb_history_write(struct comp_dev *dev,
+			     const struct audio_stream *source,
+			     const void *linear, size_t size)
+{
+	size_t size_to_copy = size;
+	size_t space_avail;
+	struct comp_data *kpb = comp_get_drvdata(dev);
+	struct history_buffer *buff = kpb->hd.c_hb;
+	uint32_t offset = 0;
+	uint64_t timeout = 0;
+	uint64_t current_time;
+	struct timer *timer = timer_get();
+	int ret;
+
 	timeout = platform_timer_get(timer) +
 		  clock_ms_to_ticks(PLATFORM_DEFAULT_CLOCK, 1);
 	/* Let's store audio stream data in internal history buffer */
@@ -833,35 +990,30 @@ static int kpb_buffer_data(struct comp_dev *dev,
 			return -ETIME;
 		}
 
-		/* Check how much space there is in current write buffer */
+		/* Check how much space there is in current write buffer,
+		 * copy what's available and continue with next buffer if
+		 * there is more data to copy.
+		 */
 		space_avail = (uint32_t)buff->end_addr - (uint32_t)buff->w_ptr;
+		space_avail = MIN(space_avail, size_to_copy);
 
-		if (size_to_copy > space_avail) {
-			/* We have more data to copy than available space
-			 * in this buffer, copy what's available and continue
-			 * with next buffer.
-			 */
-			kpb_buffer_samples(&source->stream, offset, buff->w_ptr,
-					   space_avail, sample_width);
-			/* Update write pointer & requested copy size */
-			buff->w_ptr = (char *)buff->w_ptr + space_avail;
-			size_to_copy = size_to_copy - space_avail;
-			/* Update read pointer's offset before continuing
-			 * with next buffer.
-			 */
-			offset += space_avail;
+		if (source) {
+			kpb_buffer_samples(source, offset, buff->w_ptr,
+					   space_avail);
 		} else {
-			/* Requested size is smaller or equal to the space
-			 * available in this buffer. In this scenario simply
-			 * copy what was requested.
-			 */
-			kpb_buffer_samples(&source->stream, offset, buff->w_ptr,
-					   size_to_copy, sample_width);
-			/* Update write pointer & requested copy size */
-			buff->w_ptr = (char *)buff->w_ptr + size_to_copy;
-			/* Reset requested copy size */
-			size_to_copy = 0;
+			ret = memcpy_s(buff->w_ptr, space_avail,
+				       (const char *)linear + offset,
+				       space_avail);
+			assert(!ret);
 		}
+
+		/* Update write pointer, requested copy size and read
+		 * pointer's offset.
+		 */
+		buff->w_ptr = (char *)buff->w_ptr + space_avail;
+		size_to_copy -= space_avail;
+		offset += space_avail;
+
 		/* Have we filled whole buffer? */
 		if (buff->w_ptr == buff->end_addr) {
 			/* Reset write pointer back to the beginning
@@ -888,8 +1040,41 @@ static int kpb_buffer_data(struct comp_dev *dev,
 		}
 	}
 
-	kpb_change_state(kpb, state_preserved);
-	return ret;
+	return 0;
+}
+
+/**
+ * \brief Read data from the history buffer.
+ *
+ * \param[in,out] buff - current read buffer, updated when it is read up.
+ * \param[out] dst - pointer to the destination.
+ * \param[in] size - size of the data in bytes.
+ */
+static void kpb_history_read(struct history_buffer **buff, void *dst,
+			     size_t size)
+{
+	struct history_buffer *hb = *buff;
+	size_t size_to_read;
+	int ret;
+
+	while (size) {
+		size_to_read = MIN((char *)hb->end_addr - (char *)hb->r_ptr,
+				   size);
+
+		ret = memcpy_s(dst, size, hb->r_ptr, size_to_read);
+		assert(!ret);
+
+		hb->r_ptr = (char *)hb->r_ptr + size_to_read;
+		dst = (char *)dst + size_to_read;
+		size -= size_to_read;
+
+		if (hb->r_ptr == hb->end_addr) {
+			hb->r_ptr = hb->start_addr;
+			hb = hb->next;
+		}
+	}
+
+	*buff = hb;
 }
 
 /**
@@ -1004,6 +1189,9 @@ static void kpb_init_draining(struct comp_dev *dev, struct kpb_client *cli)
 	comp_info(dev, "kpb_init_draining(): requested draining of %d [ms] from history buffer",
 		  cli->history_depth);
 
+	/* Size of the requested history in the history buffer */
+	history_depth = kpb_history_bytes(kpb, history_depth);
+
 	if (kpb->state != KPB_STATE_RUN) {
 		comp_err(dev, "kpb_init_draining(): wrong KPB state");
 	} else if (cli->id > KPB_MAX_NO_OF_CLIENTS) {
@@ -1140,7 +1328,6 @@ static enum task_state kpb_draining_task(void *arg)
 	struct comp_buffer *sink = draining_data->sink;
 	struct history_buffer *buff = draining_data->hb;
 	size_t history_depth = draining_data->history_depth;
-	size_t sample_width = draining_data->sample_width;
 	size_t size_to_read;
 	size_t size_to_copy;
 	bool move_buffer = false;
@@ -1159,6 +1346,8 @@ static enum task_state kpb_draining_task(void *arg)
 	size_t *rt_stream_update = &draining_data->buffered_while_draining;
 	struct comp_data *kpb = comp_get_drvdata(draining_data->dev);
 	bool sync_mode_on = &draining_data->sync_mode_on;
+	size_t produced;
+	uint32_t flags;
 
 	comp_cl_info(&comp_kpb, "kpb_draining_task(), start.");
 
@@ -1188,42 +1377,58 @@ static enum task_state kpb_draining_task(void *arg)
 			period_copy_start = platform_timer_get(timer);
 		}
 
-		size_to_read = (uint32_t)buff->end_addr - (uint32_t)buff->r_ptr;
-
-		if (size_to_read > sink->stream.free) {
-			if (sink->stream.free >= history_depth)
-				size_to_copy = history_depth;
-			else
-				size_to_copy = sink->stream.free;
+		if (kpb->config.codec != SOF_KPB_CODEC_NONE) {
+			size_to_copy = kpb_drain_block(kpb, &buff,
+						       &sink->stream,
+						       &produced);
 		} else {
-			if (size_to_read > history_depth) {
-				size_to_copy = history_depth;
+			size_to_read = (uint32_t)buff->end_addr -
+				       (uint32_t)buff->r_ptr;
+
+			if (size_to_read > sink->stream.free) {
+				if (sink->stream.free >= history_depth)
+					size_to_copy = history_depth;
+				else
+					size_to_copy = sink->stream.free;
 			} else {
-				size_to_copy = size_to_read;
-				move_buffer = true;
+				if (size_to_read > history_depth) {
+					size_to_copy = history_depth;
+				} else {
+					size_to_copy = size_to_read;
+					move_buffer = true;
+				}
 			}
-		}
 
-		kpb_drain_samples(buff->r_ptr, &sink->stream, size_to_copy,
-				  sample_width);
+			kpb_drain_samples(buff->r_ptr, &sink->stream,
+					  size_to_copy);
+
+			buff->r_ptr = (char *)buff->r_ptr +
+				      (uint32_t)size_to_copy;
+			produced = size_to_copy;
+
+			if (move_buffer) {
+				buff->r_ptr = buff->start_addr;
+				buff = buff->next;
+				move_buffer = false;
+			}
+		}
 
-		buff->r_ptr = (char *)buff->r_ptr + (uint32_t)size_to_copy;
+		/* The host period is in stream bytes, the history buffer
+		 * may hold coded ones.
+		 */
 		history_depth -= size_to_copy;
-		drained += size_to_copy;
-		period_bytes += size_to_copy;
+		drained += produced;
+		period_bytes += produced;
+
+		spin_lock_irq(&kpb->lock, flags);
 		kpb->hd.free += MIN(kpb->hd.buffer_size -
 				    kpb->hd.free, size_to_copy);
+		spin_unlock_irq(&kpb->lock, flags);
 
-		if (move_buffer) {
-			buff->r_ptr = buff->start_addr;
-			buff = buff->next;
-			move_buffer = false;
-		}
-
-		if (size_to_copy) {
-			comp_update_buffer_produce(sink, size_to_copy);
+		if (produced) {
+			comp_update_buffer_produce(sink, produced);
 			comp_copy(sink->sink);
-		} else if (!sink->stream.free) {
+		} else {
 			/* There is no free space in sink buffer.
 			 * Call .copy() on sink component so it can
 			 * process its data further.
@@ -1243,10 +1448,18 @@ static enum task_state kpb_draining_task(void *arg)
 		 * while we were draining real time stream could provided
 		 * new data which needs to be copy to host.
 		 */
+			spin_lock_irq(&kpb->lock, flags);
 			comp_cl_info(&comp_kpb, "kpb: update history_depth by %d",
 				     *rt_stream_update);
 			history_depth += *rt_stream_update;
 			*rt_stream_update = 0;
+
+			/* Nothing new was stored, kpb_copy() drains the
+			 * staged frames before the real time stream.
+			 */
+			if (!history_depth)
+				kpb_change_state(kpb, KPB_STATE_HOST_COPY);
+			spin_unlock_irq(&kpb->lock, flags);
 		}
 	}
 out:
@@ -1279,97 +1492,35 @@ out:
 }
 
 /**
- * \brief Drain data samples safe, according to configuration.
+ * \brief Drain data from the history buffer to the sink.
  *
- * \param[in] dev - kpb component device pointer
- * \param[in] sink - pointer to sink buffer.
- * \param[in] source - pointer to source buffer.
+ * \param[in] source - pointer to history buffer read position.
+ * \param[in] sink - pointer to sink stream.
  * \param[in] size - requested copy size in bytes.
  *
+ * The history buffer keeps the samples in the stream format, so whole
+ * frames of any channel count and sample width are copied as bytes in
+ * spans up to the sink wrap.
+ *
  * \return none.
  */
 static void kpb_drain_samples(void *source, struct audio_stream *sink,
-			      size_t size, size_t sample_width)
+			      size_t size)
 {
-#if CONFIG_FORMAT_S16LE || CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-	void *dst;
-	void *src = source;
-#endif
-	size_t i;
-	size_t j = 0;
-	size_t channel;
-	size_t frames = KPB_BYTES_TO_FRAMES(size, sample_width);
-
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < KPB_NUM_OF_CHANNELS; channel++) {
-			switch (sample_width) {
-#if CONFIG_FORMAT_S16LE
-			case 16:
-				dst = audio_stream_write_frag_s16(sink, j);
-				*((int16_t *)dst) = *((int16_t *)src);
-				src = ((int16_t *)src) + 1;
-				break;
-#endif /* CONFIG_FORMAT_S16LE */
-#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-			case 24:
-			case 32:
-				dst = audio_stream_write_frag_s32(sink, j);
-				*((int32_t *)dst) = *((int32_t *)src);
-				src = ((int32_t *)src) + 1;
-				break;
-#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
-			default:
-				comp_cl_err(&comp_kpb, "KPB: An attempt to copy not supported format!");
-				return;
-			}
-			j++;
-		}
-	}
+	audio_stream_copy_from_linear(source, sink, 0, size);
 }
 
 /**
- * \brief Buffers data samples safe, according to configuration.
+ * \brief Buffers data into the history buffer.
  * \param[in,out] source Pointer to source buffer.
  * \param[in] start Start offset of source buffer in bytes.
- * \param[in,out] sink Pointer to sink buffer.
+ * \param[in,out] sink Pointer to history buffer write position.
  * \param[in] size Requested copy size in bytes.
- * \param[in] sample_width Sample size.
  */
 static void kpb_buffer_samples(const struct audio_stream *source,
-			       uint32_t start, void *sink, size_t size,
-			       size_t sample_width)
+			       uint32_t start, void *sink, size_t size)
 {
-	void *src;
-	void *dst = sink;
-	size_t i;
-	size_t j = start /
-		(sample_width == 16 ? sizeof(int16_t) : sizeof(int32_t));
-	size_t channel;
-	size_t frames = KPB_BYTES_TO_FRAMES(size, sample_width);
-
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < KPB_NUM_OF_CHANNELS; channel++) {
-			switch (sample_width) {
-			case 16:
-				src = audio_stream_read_frag_s16(source, j);
-				*((int16_t *)dst) = *((int16_t *)src);
-				dst = ((int16_t *)dst) + 1;
-				break;
-#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-			case 24:
-			case 32:
-				src = audio_stream_read_frag_s32(source, j);
-				*((int32_t *)dst) = *((int32_t *)src);
-				dst = ((int32_t *)dst) + 1;
-				break;
-#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE*/
-			default:
-				comp_cl_err(&comp_kpb, "KPB: An attempt to copy not supported format!");
-				return;
-			}
-			j++;
-		}
-	}
+	audio_stream_copy_to_linear(source, start, sink, size);
 }
 
 /**
@@ -1423,9 +1574,8 @@ static inline bool kpb_is_sample_width_supported(uint32_t sampling_width)
 }
 
 /**
- * \brief Copy data samples safe, according to configuration.
+ * \brief Copy real time data from source to sink.
  *
- * \param[in] dev - kpb component device pointer
  * \param[in] sink - pointer to sink buffer.
  * \param[in] source - pointer to source buffer.
  * \param[in] size - requested copy size in bytes.
@@ -1433,48 +1583,11 @@ static inline bool kpb_is_sample_width_supported(uint32_t sampling_width)
  * \return none.
  */
 static void kpb_copy_samples(struct comp_buffer *sink,
-			     struct comp_buffer *source, size_t size,
-			     size_t sample_width)
+			     struct comp_buffer *source, size_t size)
 {
-#if CONFIG_FORMAT_S16LE || CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-	void *dst;
-	void *src;
-#endif
-	size_t i;
-	size_t j = 0;
-	size_t channel;
-	size_t frames = KPB_BYTES_TO_FRAMES(size, sample_width);
-	struct audio_stream *istream = &source->stream;
-	struct audio_stream *ostream = &sink->stream;
-
 	buffer_invalidate(source, size);
 
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < KPB_NUM_OF_CHANNELS; channel++) {
-			switch (sample_width) {
-#if CONFIG_FORMAT_S16LE
-			case 16:
-				dst = audio_stream_write_frag_s16(ostream, j);
-				src = audio_stream_read_frag_s16(istream, j);
-				*((int16_t *)dst) = *((int16_t *)src);
-				break;
-#endif /* CONFIG_FORMAT_S16LE */
-#if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
-			case 24:
-				/* FALLTHROUGH */
-			case 32:
-				dst = audio_stream_write_frag_s32(ostream, j);
-				src = audio_stream_read_frag_s32(istream, j);
-				*((int32_t *)dst) = *((int32_t *)src);
-				break;
-#endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE*/
-			default:
-				comp_cl_err(&comp_kpb, "KPB: An attempt to copy not supported format!");
-				return;
-			}
-			j++;
-		}
-	}
+	audio_stream_copy(&source->stream, 0, &sink->stream, 0, size);
 
 	buffer_writeback(sink, size);
 }
@@ -1555,6 +1668,162 @@ static inline bool validate_host_params(struct comp_dev *dev,
 	return true;
 }
 
+/**
+ * \brief Allocate codec buffers for the current stream params.
+ * \param[in] kpb - KPB component data pointer.
+ *
+ * \return 0 on success, error code otherwise.
+ */
+static int kpb_codec_prepare(struct comp_data *kpb)
+{
+	struct kpb_codec *codec = &kpb->codec;
+	size_t sample_bytes =
+		KPB_SAMPLE_CONTAINER_SIZE(kpb->config.sampling_width) / 8;
+
+	kpb_codec_reset(kpb);
+
+	if (kpb->config.codec == SOF_KPB_CODEC_NONE)
+		return 0;
+
+	codec->frames_bytes = ADPCM_BLOCK_FRAMES * kpb->config.channels *
+			      sample_bytes;
+	codec->block_bytes = ADPCM_BLOCK_BYTES(kpb->config.channels);
+
+	/* Staged frames, drained frames and the coded blocks of the
+	 * encoder and the draining task, the LL copy may encode while
+	 * a block is being decoded.
+	 */
+	rfree(codec->pcm);
+	codec->pcm = rballoc(0, SOF_MEM_CAPS_RAM,
+			     2 * codec->frames_bytes + 2 * codec->block_bytes);
+	if (!codec->pcm)
+		return -ENOMEM;
+
+	codec->pcm_out = (char *)codec->pcm + codec->frames_bytes;
+	codec->block = (uint8_t *)codec->pcm_out + codec->frames_bytes;
+	codec->drain_block = codec->block + codec->block_bytes;
+
+	return 0;
+}
+
+/**
+ * \brief Drop staged frames and restart the encoder.
+ * \param[in] kpb - KPB component data pointer.
+ */
+static void kpb_codec_reset(struct comp_data *kpb)
+{
+	kpb->codec.pcm_bytes = 0;
+	kpb->codec.pcm_drained = 0;
+	bzero(kpb->codec.state, sizeof(kpb->codec.state));
+}
+
+/**
+ * \brief Calculate how much stream data fits to free history buffer.
+ * \param[in] kpb - KPB component data pointer.
+ *
+ * \return size of stream data in bytes.
+ */
+static size_t kpb_history_space(struct comp_data *kpb)
+{
+	struct kpb_codec *codec = &kpb->codec;
+	size_t space;
+
+	if (kpb->config.codec == SOF_KPB_CODEC_NONE)
+		return kpb->hd.free;
+
+	/* Only whole blocks are stored, the staged frames are part
+	 * of the first one.
+	 */
+	space = kpb->hd.free / codec->block_bytes * codec->frames_bytes;
+
+	return space > codec->pcm_bytes ? space - codec->pcm_bytes : 0;
+}
+
+/**
+ * \brief Calculate history buffer size of the newest stream data.
+ * \param[in] kpb - KPB component data pointer.
+ * \param[in] size - size of stream data in bytes.
+ *
+ * \return size in history buffer in bytes, whole blocks for a codec.
+ */
+static size_t kpb_history_bytes(struct comp_data *kpb, size_t size)
+{
+	struct kpb_codec *codec = &kpb->codec;
+
+	if (kpb->config.codec == SOF_KPB_CODEC_NONE)
+		return size;
+
+	/* The staged frames are drained at the end of draining */
+	if (size <= codec->pcm_bytes)
+		return 0;
+
+	return ceil_divide(size - codec->pcm_bytes, codec->frames_bytes) *
+		codec->block_bytes;
+}
+
+/**
+ * \brief Drain one coded block from the history buffer.
+ * \param[in] kpb - KPB component data pointer.
+ * \param[in,out] buff - current read buffer.
+ * \param[in] sink - pointer to sink stream.
+ * \param[out] produced - size of the frames written to sink.
+ *
+ * \return size read from history buffer, 0 if sink has no space.
+ */
+static size_t kpb_drain_block(struct comp_data *kpb,
+			      struct history_buffer **buff,
+			      struct audio_stream *sink, size_t *produced)
+{
+	struct kpb_codec *codec = &kpb->codec;
+
+	if (sink->free < codec->frames_bytes) {
+		*produced = 0;
+		return 0;
+	}
+
+	kpb_history_read(buff, codec->drain_block, codec->block_bytes);
+	adpcm_decode_block(codec->drain_block, codec->sample_width,
+			   kpb->config.channels, codec->pcm_out);
+	kpb_drain_samples(codec->pcm_out, sink, codec->frames_bytes);
+
+	*produced = codec->frames_bytes;
+	return codec->block_bytes;
+}
+
+/**
+ * \brief Drain frames staged for the codec.
+ * \param[in] kpb - KPB component data pointer.
+ * \param[in] sink - pointer to sink buffer.
+ *
+ * The staged frames are newer than the history buffer and older than
+ * the real time stream copied to host after draining.
+ *
+ * \return true if all staged frames were drained, false if some are left
+ *	    for the next call.
+ */
+static bool kpb_drain_staged(struct comp_data *kpb, struct comp_buffer *sink)
+{
+	struct kpb_codec *codec = &kpb->codec;
+	size_t size = MIN(codec->pcm_bytes - codec->pcm_drained,
+			  audio_stream_get_free_frames(&sink->stream) *
+			  audio_stream_frame_bytes(&sink->stream));
+
+	if (size) {
+		kpb_drain_samples((char *)codec->pcm + codec->pcm_drained,
+				  &sink->stream, size);
+		comp_update_buffer_produce(sink, size);
+		codec->pcm_drained += size;
+	}
+
+	if (codec->pcm_drained < codec->pcm_bytes)
+		return false;
+
+	codec->pcm_bytes = 0;
+	codec->pcm_drained = 0;
+
+	return true;
+}
+
 /**
  * \brief Change KPB state and log this change internally.
  * \param[in] kpb - KPB component data pointer.
@@ -22,9 +22,11 @@
 #include <sof/string.h>
 #include <sof/trace/trace.h>
 #include <sof/ut.h>
+#include <ipc/control.h>
 #include <ipc/stream.h>
 #include <ipc/topology.h>
 #include <user/trace.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -36,79 +38,192 @@ DECLARE_SOF_RT_UUID("mixer", mixer_uuid, 0xbc06c037, 0x12aa, 0x417c,
 
 DECLARE_TR_CTX(mixer_tr, SOF_UUID(mixer_uuid), LOG_LEVEL_INFO);
 
+/* number of samples mixed per pass over the sources */
+#define MIXER_BLOCK_SAMPLES	128
+
+/* per-source gain is Q1.16, only attenuation is supported */
+#define MIXER_GAIN_FRAC_BITS	16
+#define MIXER_GAIN_UNITY	(1 << MIXER_GAIN_FRAC_BITS)
+
 /* mixer component private data */
 struct mixer_data {
 	void (*mix_func)(struct comp_dev *dev, struct audio_stream *sink,
-			 const struct audio_stream **sources, uint32_t count,
+			 const struct audio_stream **sources,
+			 const int32_t *gains, uint32_t count,
 			 uint32_t frames);
+
+	/* gain for each source, indexed by its position in bsource_list */
+	int32_t gain[PLATFORM_MAX_STREAMS];
+
+	/* accumulator for one block, sources are added one at a time */
+	union {
+		int32_t s32[MIXER_BLOCK_SAMPLES];
+		int64_t s64[MIXER_BLOCK_SAMPLES];
+	} acc;
 };
 
+/* Get the number of frames every source and the sink can process without
+ * wrap from the current span positions.
+ */
+static uint32_t mix_span_frames(const struct audio_stream *sink, void *dest,
+				const struct audio_stream **sources,
+				void **src, uint32_t num_sources,
+				uint32_t frames)
+{
+	uint32_t n = MIN(frames, audio_stream_frames_without_wrap(sink, dest));
+	int j;
+
+	for (j = 0; j < num_sources; j++)
+		n = MIN(n, audio_stream_frames_without_wrap(sources[j],
+							    src[j]));
+
+	return n;
+}
+
 #if CONFIG_FORMAT_S16LE
+/* Accumulate one 16 bit source block, the first source initializes acc */
+static void mix_acc_s16(int32_t *acc, const int16_t *src, int32_t gain,
+			int samples, bool first)
+{
+	int i;
+
+	if (gain == MIXER_GAIN_UNITY) {
+		if (first)
+			for (i = 0; i < samples; i++)
+				acc[i] = src[i];
+		else
+			for (i = 0; i < samples; i++)
+				acc[i] += src[i];
+		return;
+	}
+
+	if (first)
+		for (i = 0; i < samples; i++)
+			acc[i] = 0;
+
+	for (i = 0; i < samples; i++)
+		acc[i] += Q_SHIFT_RND(src[i] * gain, 31, 15);
+}
+
 /* Mix n 16 bit PCM source streams to one sink stream */
 static void mix_n_s16(struct comp_dev *dev, struct audio_stream *sink,
-		      const struct audio_stream **sources, uint32_t num_sources,
+		      const struct audio_stream **sources,
+		      const int32_t *gains, uint32_t num_sources,
 		      uint32_t frames)
 {
-	int16_t *src;
-	int16_t *dest;
-	int32_t val;
+	struct mixer_data *md = comp_get_drvdata(dev);
+	int32_t *acc = md->acc.s32;
+	int16_t *src[PLATFORM_MAX_STREAMS];
+	int16_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int samples;
+	int m;
+	int b;
 	int i;
 	int j;
-	int channel;
-	uint32_t frag = 0;
+	uint32_t n;
 
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < sink->channels; channel++) {
-			val = 0;
+	for (j = 0; j < num_sources; j++)
+		src[j] = sources[j]->r_ptr;
 
-			for (j = 0; j < num_sources; j++) {
-				src = audio_stream_read_frag_s16(sources[j],
-								 frag);
-				val += *src;
-			}
+	while (frames) {
+		n = mix_span_frames(sink, dest, sources, (void **)src,
+				    num_sources, frames);
+		if (!n)
+			return;
+		samples = n * nch;
 
-			dest = audio_stream_write_frag_s16(sink, frag);
+		for (b = 0; b < samples; b += m) {
+			m = MIN(samples - b, MIXER_BLOCK_SAMPLES);
 
-			/* Saturate to 16 bits */
-			*dest = sat_int16(val);
+			for (j = 0; j < num_sources; j++)
+				mix_acc_s16(acc, src[j] + b, gains[j], m,
+					    j == 0);
 
-			frag++;
+			/* Saturate to 16 bits */
+			for (i = 0; i < m; i++)
+				dest[b + i] = sat_int16(acc[i]);
 		}
+
+		frames -= n;
+		dest = audio_stream_wrap(sink, dest + samples);
+		for (j = 0; j < num_sources; j++)
+			src[j] = audio_stream_wrap(sources[j],
+						   src[j] + samples);
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
 
 #if CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE
+/* Accumulate one 32 bit source block, the first source initializes acc */
+static void mix_acc_s32(int64_t *acc, const int32_t *src, int32_t gain,
+			int samples, bool first)
+{
+	int i;
+
+	if (gain == MIXER_GAIN_UNITY) {
+		if (first)
+			for (i = 0; i < samples; i++)
+				acc[i] = src[i];
+		else
+			for (i = 0; i < samples; i++)
+				acc[i] += src[i];
+		return;
+	}
+
+	if (first)
+		for (i = 0; i < samples; i++)
+			acc[i] = 0;
+
+	for (i = 0; i < samples; i++)
+		acc[i] += Q_SHIFT_RND((int64_t)src[i] * gain, 47, 31);
+}
+
 /* Mix n 32 bit PCM source streams to one sink stream */
 static void mix_n_s32(struct comp_dev *dev, struct audio_stream *sink,
-		      const struct audio_stream **sources, uint32_t num_sources,
+		      const struct audio_stream **sources,
+		      const int32_t *gains, uint32_t num_sources,
 		      uint32_t frames)
 {
-	int32_t *src;
-	int32_t *dest;
-	int64_t val;
+	struct mixer_data *md = comp_get_drvdata(dev);
+	int64_t *acc = md->acc.s64;
+	int32_t *src[PLATFORM_MAX_STREAMS];
+	int32_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int samples;
+	int m;
+	int b;
 	int i;
 	int j;
-	int channel;
-	uint32_t frag = 0;
+	uint32_t n;
 
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < sink->channels; channel++) {
-			val = 0;
+	for (j = 0; j < num_sources; j++)
+		src[j] = sources[j]->r_ptr;
 
-			for (j = 0; j < num_sources; j++) {
-				src = audio_stream_read_frag_s32(sources[j],
-								 frag);
-				val += *src;
-			}
+	while (frames) {
+		n = mix_span_frames(sink, dest, sources, (void **)src,
+				    num_sources, frames);
+		if (!n)
+			return;
+		samples = n * nch;
 
-			dest = audio_stream_write_frag_s32(sink, frag);
+		for (b = 0; b < samples; b += m) {
+			m = MIN(samples - b, MIXER_BLOCK_SAMPLES);
 
-			/* Saturate to 32 bits */
-			*dest = sat_int32(val);
+			for (j = 0; j < num_sources; j++)
+				mix_acc_s32(acc, src[j] + b, gains[j], m,
+					    j == 0);
 
-			frag++;
+			/* Saturate to 32 bits */
+			for (i = 0; i < m; i++)
+				dest[b + i] = sat_int32(acc[i]);
 		}
+
+		frames -= n;
+		dest = audio_stream_wrap(sink, dest + samples);
+		for (j = 0; j < num_sources; j++)
+			src[j] = audio_stream_wrap(sources[j],
+						   src[j] + samples);
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE || CONFIG_FORMAT_S32LE */
@@ -122,6 +237,7 @@ static struct comp_dev *mixer_new(const struct comp_driver *drv,
 		(struct sof_ipc_comp_mixer *)comp;
 	struct mixer_data *md;
 	int ret;
+	int i;
 
 	comp_cl_dbg(&comp_mixer, "mixer_new()");
 
@@ -141,6 +257,9 @@ static struct comp_dev *mixer_new(const struct comp_driver *drv,
 		return NULL;
 	}
 
+	for (i = 0; i < PLATFORM_MAX_STREAMS; i++)
+		md->gain[i] = MIXER_GAIN_UNITY;
+
 	comp_set_drvdata(dev, md);
 	dev->state = COMP_STATE_READY;
 	return dev;
@@ -274,9 +393,11 @@ static int mixer_copy(struct comp_dev *dev)
 	struct comp_buffer *sink;
 	struct comp_buffer *sources[PLATFORM_MAX_STREAMS];
 	const struct audio_stream *sources_stream[PLATFORM_MAX_STREAMS];
+	int32_t gains[PLATFORM_MAX_STREAMS];
 	struct comp_buffer *source;
 	struct list_item *blist;
 	int32_t i = 0;
+	int32_t source_idx = 0;
 	int32_t num_mix_sources = 0;
 	uint32_t frames = INT32_MAX;
 	uint32_t source_bytes;
@@ -298,9 +419,14 @@ static int mixer_copy(struct comp_dev *dev)
 		if (source->source->state == dev->state) {
 			sources[num_mix_sources] = source;
 			sources_stream[num_mix_sources] = &source->stream;
+			gains[num_mix_sources] =
+				source_idx < PLATFORM_MAX_STREAMS ?
+				md->gain[source_idx] : MIXER_GAIN_UNITY;
 			num_mix_sources++;
 		}
 
+		source_idx++;
+
 		/* too many sources ? */
 		if (num_mix_sources == PLATFORM_MAX_STREAMS - 1)
 			return 0;
@@ -335,8 +461,8 @@ static int mixer_copy(struct comp_dev *dev)
 	/* mix streams */
 	for (i = num_mix_sources - 1; i >= 0; i--)
 		buffer_invalidate(sources[i], source_bytes);
-	md->mix_func(dev, &sink->stream, sources_stream, num_mix_sources,
-		     frames);
+	md->mix_func(dev, &sink->stream, sources_stream, gains,
+		     num_mix_sources, frames);
 	buffer_writeback(sink, sink_bytes);
 
 	/* update source buffer pointers */
@@ -349,6 +475,85 @@ static int mixer_copy(struct comp_dev *dev)
 	return 0;
 }
 
+/* per-source gain control, chanv[].channel is the source index */
+static int mixer_ctrl_set_cmd(struct comp_dev *dev,
+			      struct sof_ipc_ctrl_data *cdata)
+{
+	struct mixer_data *md = comp_get_drvdata(dev);
+	uint32_t val;
+	int src;
+	int j;
+
+	if (cdata->cmd != SOF_CTRL_CMD_VOLUME) {
+		comp_err(dev, "mixer_ctrl_set_cmd(): invalid cdata->cmd");
+		return -EINVAL;
+	}
+
+	if (cdata->num_elems == 0 || cdata->num_elems > PLATFORM_MAX_STREAMS) {
+		comp_err(dev, "mixer_ctrl_set_cmd(): invalid cdata->num_elems");
+		return -EINVAL;
+	}
+
+	for (j = 0; j < cdata->num_elems; j++) {
+		src = cdata->chanv[j].channel;
+		val = cdata->chanv[j].value;
+		comp_info(dev, "mixer_ctrl_set_cmd(), source = %d, value = %u",
+			  src, val);
+		if (src < 0 || src >= PLATFORM_MAX_STREAMS) {
+			comp_err(dev, "mixer_ctrl_set_cmd(), illegal source = %d",
+				 src);
+			return -EINVAL;
+		}
+
+		md->gain[src] = MIN(val, MIXER_GAIN_UNITY);
+	}
+
+	return 0;
+}
+
+static int mixer_ctrl_get_cmd(struct comp_dev *dev,
+			      struct sof_ipc_ctrl_data *cdata, int size)
+{
+	struct mixer_data *md = comp_get_drvdata(dev);
+	int j;
+
+	if (cdata->cmd != SOF_CTRL_CMD_VOLUME) {
+		comp_err(dev, "mixer_ctrl_get_cmd(): invalid cdata->cmd");
+		return -EINVAL;
+	}
+
+	if (cdata->num_elems == 0 || cdata->num_elems > PLATFORM_MAX_STREAMS) {
+		comp_err(dev, "mixer_ctrl_get_cmd(): invalid cdata->num_elems %u",
+			 cdata->num_elems);
+		return -EINVAL;
+	}
+
+	for (j = 0; j < cdata->num_elems; j++) {
+		cdata->chanv[j].channel = j;
+		cdata->chanv[j].value = md->gain[j];
+	}
+
+	return 0;
+}
+
+/* used to pass standard and bespoke commands (with data) to component */
+static int mixer_cmd(struct comp_dev *dev, int cmd, void *data,
+		     int max_data_size)
+{
+	struct sof_ipc_ctrl_data *cdata = data;
+
+	comp_dbg(dev, "mixer_cmd()");
+
+	switch (cmd) {
+	case COMP_CMD_SET_VALUE:
+		return mixer_ctrl_set_cmd(dev, cdata);
+	case COMP_CMD_GET_VALUE:
+		return mixer_ctrl_get_cmd(dev, cdata, max_data_size);
+	default:
+		return -EINVAL;
+	}
+}
+
 static int mixer_reset(struct comp_dev *dev)
 {
 	struct list_item *blist;
@@ -447,6 +652,7 @@ static const struct comp_driver comp_mixer = {
 		.params		= mixer_params,
 		.prepare	= mixer_prepare,
 		.trigger	= mixer_trigger,
+		.cmd		= mixer_cmd,
 		.copy		= mixer_copy,
 		.reset		= mixer_reset,
 	},
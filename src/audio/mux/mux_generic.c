@@ -18,35 +18,74 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/*
+ * \brief Get number of frames sink and all connected sources can process
+ *	  without wrap from the given positions.
+ * \param[in] sink Destination buffer.
+ * \param[in] dst Current write position in sink.
+ * \param[in] sources Array of source buffers, unconnected ones are NULL.
+ * \param[in] src Current read positions in sources.
+ * \param[in] frames Number of frames still to be processed.
+ */
+static uint32_t mux_span_frames(const struct audio_stream *sink,
+				const void *dst,
+				const struct audio_stream **sources,
+				const void **src, uint32_t frames)
+{
+	uint32_t n = MIN(frames, audio_stream_frames_without_wrap(sink, dst));
+	uint8_t j;
+
+	for (j = 0; j < MUX_MAX_STREAMS; j++) {
+		if (!sources[j])
+			continue;
+
+		n = MIN(n, audio_stream_frames_without_wrap(sources[j],
+							    src[j]));
+	}
+
+	return n;
+}
+
 #if CONFIG_FORMAT_S16LE
 /*
- * \brief Fetch 16b samples from source buffer and perform routing operations
- *	  based on mask provided.
- * \param[in,out] source Source buffer.
- * \param[in] offset Offset in source buffer.
+ * \brief Perform routing operations on a single 16b frame based on mask
+ *	  provided.
+ * \param[in] frame Pointer to the first sample of the frame.
+ * \param[in] nch Number of channels in the frame.
  * \param[in] mask Routing bitmask for calculating output sample.
  */
-UT_STATIC inline int32_t calc_sample_s16le(const struct audio_stream *source,
-					   uint32_t offset, uint8_t mask)
+static inline int32_t mux_frame_sum_s16le(const int16_t *frame, int nch,
+					  uint8_t mask)
 {
 	int32_t sample = 0;
-	int16_t *src;
-	int8_t in_ch;
+	int in_ch;
 
 	if (mask == 0)
 		return 0;
 
-	for (in_ch = 0; in_ch < source->channels; in_ch++) {
-		if (mask & BIT(in_ch)) {
-			src = audio_stream_read_frag_s16(source,
-							 offset + in_ch);
-			sample += *src;
-		}
+	for (in_ch = 0; in_ch < nch; in_ch++) {
+		if (mask & BIT(in_ch))
+			sample += frame[in_ch];
 	}
 
 	return sample;
 }
 
+/*
+ * \brief Fetch 16b samples from source buffer and perform routing operations
+ *	  based on mask provided.
+ * \param[in,out] source Source buffer.
+ * \param[in] offset Offset in source buffer.
+ * \param[in] mask Routing bitmask for calculating output sample.
+ */
+UT_STATIC inline int32_t calc_sample_s16le(const struct audio_stream *source,
+					   uint32_t offset, uint8_t mask)
+{
+	const int16_t *frame = audio_stream_read_frag_s16(source, offset);
+
+	return mux_frame_sum_s16le(frame, source->channels, mask);
+}
+
 /* \brief Demuxing 16 bit streams.
  *
  * Source stream is routed to sink with regard to routing bitmasks from
@@ -62,23 +101,30 @@ static void demux_s16le(struct audio_stream *sink,
 			const struct audio_stream *source, uint32_t frames,
 			struct mux_stream_data *data)
 {
-	int32_t sample;
-	int16_t *dst;
-	uint32_t dst_idx;
-	uint8_t i;
+	const int16_t *src = source->r_ptr;
+	int16_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t out_ch;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = calc_sample_s16le(source,
-						   i * source->channels,
-						   data->mask[out_ch]);
-
-			/* saturate to 16 bits */
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s16(sink, dst_idx);
-			*dst = sat_int16(sample);
+	while (frames) {
+		n = audio_stream_span_frames(source, src, sink, dst, frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++)
+				/* saturate to 16 bits */
+				dst[out_ch] = sat_int16(mux_frame_sum_s16le
+					(src, source->channels,
+					 data->mask[out_ch]));
+
+			src += source->channels;
+			dst += sink->channels;
 		}
+
+		frames -= n;
+		src = audio_stream_wrap(source, (void *)src);
+		dst = audio_stream_wrap(sink, dst);
 	}
 }
 
@@ -99,30 +145,49 @@ static void mux_s16le(struct audio_stream *sink,
 		      const struct audio_stream **sources, uint32_t frames,
 		      struct mux_stream_data *data)
 {
-	const struct audio_stream *source;
-	uint8_t i;
+	const int16_t *src[MUX_MAX_STREAMS];
+	int16_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t j;
 	uint8_t out_ch;
-	int16_t *dst;
-	uint32_t dst_idx;
 	int32_t sample;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = 0;
+	for (j = 0; j < MUX_MAX_STREAMS; j++)
+		src[j] = sources[j] ? sources[j]->r_ptr : NULL;
+
+	while (frames) {
+		n = mux_span_frames(sink, dst, sources, (const void **)src,
+				    frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++) {
+				sample = 0;
+				for (j = 0; j < MUX_MAX_STREAMS; j++) {
+					if (!src[j])
+						continue;
+
+					sample += mux_frame_sum_s16le
+						(src[j], sources[j]->channels,
+						 data[j].mask[out_ch]);
+				}
+				dst[out_ch] = sat_int16(sample);
+			}
 
 			for (j = 0; j < MUX_MAX_STREAMS; j++) {
-				source = sources[j];
-				if (!source)
-					continue;
-
-				sample += calc_sample_s16le(source,
-						i * source->channels,
-						data[j].mask[out_ch]);
+				if (src[j])
+					src[j] += sources[j]->channels;
 			}
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s16(sink, dst_idx);
-			*dst = sat_int16(sample);
+			dst += sink->channels;
+		}
+
+		frames -= n;
+		dst = audio_stream_wrap(sink, dst);
+		for (j = 0; j < MUX_MAX_STREAMS; j++) {
+			if (src[j])
+				src[j] = audio_stream_wrap(sources[j],
+							   (void *)src[j]);
 		}
 	}
 }
@@ -130,33 +195,44 @@ static void mux_s16le(struct audio_stream *sink,
 
 #if CONFIG_FORMAT_S24LE
 /*
- * \brief Fetch 24b samples from source buffer and perform routing operations
- *	  based on mask provided.
- * \param[in,out] source Source buffer.
- * \param[in] offset Offset in source buffer.
+ * \brief Perform routing operations on a single 24b frame based on mask
+ *	  provided.
+ * \param[in] frame Pointer to the first sample of the frame.
+ * \param[in] nch Number of channels in the frame.
  * \param[in] mask Routing bitmask for calculating output sample.
  */
-UT_STATIC inline int32_t calc_sample_s24le(const struct audio_stream *source,
-					   uint32_t offset, uint8_t mask)
+static inline int32_t mux_frame_sum_s24le(const int32_t *frame, int nch,
+					  uint8_t mask)
 {
 	int32_t sample = 0;
-	int32_t *src;
-	int8_t in_ch;
+	int in_ch;
 
 	if (mask == 0)
 		return 0;
 
-	for (in_ch = 0; in_ch < source->channels; in_ch++) {
-		if (mask & BIT(in_ch)) {
-			src = audio_stream_read_frag_s32(source,
-							 offset + in_ch);
-			sample += sign_extend_s24(*src);
-		}
+	for (in_ch = 0; in_ch < nch; in_ch++) {
+		if (mask & BIT(in_ch))
+			sample += sign_extend_s24(frame[in_ch]);
 	}
 
 	return sample;
 }
 
+/*
+ * \brief Fetch 24b samples from source buffer and perform routing operations
+ *	  based on mask provided.
+ * \param[in,out] source Source buffer.
+ * \param[in] offset Offset in source buffer.
+ * \param[in] mask Routing bitmask for calculating output sample.
+ */
+UT_STATIC inline int32_t calc_sample_s24le(const struct audio_stream *source,
+					   uint32_t offset, uint8_t mask)
+{
+	const int32_t *frame = audio_stream_read_frag_s32(source, offset);
+
+	return mux_frame_sum_s24le(frame, source->channels, mask);
+}
+
 /* \brief Demuxing 24 bit streams.
  *
  * Source stream is routed to sink with regard to routing bitmasks from
@@ -172,23 +248,30 @@ static void demux_s24le(struct audio_stream *sink,
 			const struct audio_stream *source, uint32_t frames,
 			struct mux_stream_data *data)
 {
-	int32_t sample;
-	int32_t *dst;
-	uint32_t dst_idx;
-	uint8_t i;
+	const int32_t *src = source->r_ptr;
+	int32_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t out_ch;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = calc_sample_s24le(source,
-						   i * source->channels,
-						   data->mask[out_ch]);
-
-			/* saturate to 24 bits */
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s32(sink, dst_idx);
-			*dst = sat_int24(sample);
+	while (frames) {
+		n = audio_stream_span_frames(source, src, sink, dst, frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++)
+				/* saturate to 24 bits */
+				dst[out_ch] = sat_int24(mux_frame_sum_s24le
+					(src, source->channels,
+					 data->mask[out_ch]));
+
+			src += source->channels;
+			dst += sink->channels;
 		}
+
+		frames -= n;
+		src = audio_stream_wrap(source, (void *)src);
+		dst = audio_stream_wrap(sink, dst);
 	}
 }
 
@@ -209,29 +292,49 @@ static void mux_s24le(struct audio_stream *sink,
 		      const struct audio_stream **sources, uint32_t frames,
 		      struct mux_stream_data *data)
 {
-	const struct audio_stream *source;
-	uint8_t i;
+	const int32_t *src[MUX_MAX_STREAMS];
+	int32_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t j;
 	uint8_t out_ch;
-	int32_t *dst;
-	uint32_t dst_idx;
 	int32_t sample;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = 0;
-			for (j = 0; j < MUX_MAX_STREAMS; j++) {
-				source = sources[j];
-				if (!source)
-					continue;
+	for (j = 0; j < MUX_MAX_STREAMS; j++)
+		src[j] = sources[j] ? sources[j]->r_ptr : NULL;
+
+	while (frames) {
+		n = mux_span_frames(sink, dst, sources, (const void **)src,
+				    frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++) {
+				sample = 0;
+				for (j = 0; j < MUX_MAX_STREAMS; j++) {
+					if (!src[j])
+						continue;
+
+					sample += mux_frame_sum_s24le
+						(src[j], sources[j]->channels,
+						 data[j].mask[out_ch]);
+				}
+				dst[out_ch] = sat_int24(sample);
+			}
 
-				sample += calc_sample_s24le(source,
-						i * source->channels,
-						data[j].mask[out_ch]);
+			for (j = 0; j < MUX_MAX_STREAMS; j++) {
+				if (src[j])
+					src[j] += sources[j]->channels;
 			}
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s32(sink, dst_idx);
-			*dst = sat_int24(sample);
+			dst += sink->channels;
+		}
+
+		frames -= n;
+		dst = audio_stream_wrap(sink, dst);
+		for (j = 0; j < MUX_MAX_STREAMS; j++) {
+			if (src[j])
+				src[j] = audio_stream_wrap(sources[j],
+							   (void *)src[j]);
 		}
 	}
 }
@@ -239,33 +342,44 @@ static void mux_s24le(struct audio_stream *sink,
 
 #if CONFIG_FORMAT_S32LE
 /*
- * \brief Fetch 32b samples from source buffer and perform routing operations
- *	  based on mask provided.
- * \param[in,out] source Source buffer.
- * \param[in] offset Offset in source buffer.
+ * \brief Perform routing operations on a single 32b frame based on mask
+ *	  provided.
+ * \param[in] frame Pointer to the first sample of the frame.
+ * \param[in] nch Number of channels in the frame.
  * \param[in] mask Routing bitmask for calculating output sample.
  */
-UT_STATIC inline int64_t calc_sample_s32le(const struct audio_stream *source,
-					   uint32_t offset, uint8_t mask)
+static inline int64_t mux_frame_sum_s32le(const int32_t *frame, int nch,
+					  uint8_t mask)
 {
 	int64_t sample = 0;
-	int32_t *src;
-	int8_t in_ch;
+	int in_ch;
 
 	if (mask == 0)
 		return 0;
 
-	for (in_ch = 0; in_ch < source->channels; in_ch++) {
-		if (mask & BIT(in_ch)) {
-			src = audio_stream_read_frag_s32(source,
-							 offset + in_ch);
-			sample += *src;
-		}
+	for (in_ch = 0; in_ch < nch; in_ch++) {
+		if (mask & BIT(in_ch))
+			sample += frame[in_ch];
 	}
 
 	return sample;
 }
 
+/*
+ * \brief Fetch 32b samples from source buffer and perform routing operations
+ *	  based on mask provided.
+ * \param[in,out] source Source buffer.
+ * \param[in] offset Offset in source buffer.
+ * \param[in] mask Routing bitmask for calculating output sample.
+ */
+UT_STATIC inline int64_t calc_sample_s32le(const struct audio_stream *source,
+					   uint32_t offset, uint8_t mask)
+{
+	const int32_t *frame = audio_stream_read_frag_s32(source, offset);
+
+	return mux_frame_sum_s32le(frame, source->channels, mask);
+}
+
 /* \brief Demuxing 32 bit streams.
  *
  * Source stream is routed to sink with regard to routing bitmasks from
@@ -281,23 +395,30 @@ static void demux_s32le(struct audio_stream *sink,
 			const struct audio_stream *source, uint32_t frames,
 			struct mux_stream_data *data)
 {
-	int64_t sample;
-	int32_t *dst;
-	uint32_t dst_idx;
-	uint8_t i;
+	const int32_t *src = source->r_ptr;
+	int32_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t out_ch;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = calc_sample_s32le(source,
-						   i * source->channels,
-						   data->mask[out_ch]);
-
-			/* saturate to 32 bits */
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s32(sink, dst_idx);
-			*dst = sat_int32(sample);
+	while (frames) {
+		n = audio_stream_span_frames(source, src, sink, dst, frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++)
+				/* saturate to 32 bits */
+				dst[out_ch] = sat_int32(mux_frame_sum_s32le
+					(src, source->channels,
+					 data->mask[out_ch]));
+
+			src += source->channels;
+			dst += sink->channels;
 		}
+
+		frames -= n;
+		src = audio_stream_wrap(source, (void *)src);
+		dst = audio_stream_wrap(sink, dst);
 	}
 }
 
@@ -318,29 +439,49 @@ static void mux_s32le(struct audio_stream *sink,
 		      const struct audio_stream **sources, uint32_t frames,
 		      struct mux_stream_data *data)
 {
-	const struct audio_stream *source;
-	uint8_t i;
+	const int32_t *src[MUX_MAX_STREAMS];
+	int32_t *dst = sink->w_ptr;
+	uint32_t i;
+	uint32_t n;
 	uint8_t j;
 	uint8_t out_ch;
-	int32_t *dst;
-	uint32_t dst_idx;
 	int64_t sample;
 
-	for (i = 0; i < frames; i++) {
-		for (out_ch = 0; out_ch < sink->channels; out_ch++) {
-			sample = 0;
-			for (j = 0; j < MUX_MAX_STREAMS; j++) {
-				source = sources[j];
-				if (!source)
-					continue;
+	for (j = 0; j < MUX_MAX_STREAMS; j++)
+		src[j] = sources[j] ? sources[j]->r_ptr : NULL;
+
+	while (frames) {
+		n = mux_span_frames(sink, dst, sources, (const void **)src,
+				    frames);
+		if (!n)
+			return;
+		for (i = 0; i < n; i++) {
+			for (out_ch = 0; out_ch < sink->channels; out_ch++) {
+				sample = 0;
+				for (j = 0; j < MUX_MAX_STREAMS; j++) {
+					if (!src[j])
+						continue;
+
+					sample += mux_frame_sum_s32le
+						(src[j], sources[j]->channels,
+						 data[j].mask[out_ch]);
+				}
+				dst[out_ch] = sat_int32(sample);
+			}
 
-				sample += calc_sample_s32le(source,
-						i * source->channels,
-						data[j].mask[out_ch]);
+			for (j = 0; j < MUX_MAX_STREAMS; j++) {
+				if (src[j])
+					src[j] += sources[j]->channels;
 			}
-			dst_idx = i * sink->channels + out_ch;
-			dst = audio_stream_write_frag_s32(sink, dst_idx);
-			*dst = sat_int32(sample);
+			dst += sink->channels;
+		}
+
+		frames -= n;
+		dst = audio_stream_wrap(sink, dst);
+		for (j = 0; j < MUX_MAX_STREAMS; j++) {
+			if (src[j])
+				src[j] = audio_stream_wrap(sources[j],
+							   (void *)src[j]);
 		}
 	}
 }
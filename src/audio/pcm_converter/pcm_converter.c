@@ -24,19 +24,18 @@ void pcm_convert_as_linear(const struct audio_stream *source, uint32_t ioffset,
 					    s_size_in);
 	char *w_ptr = audio_stream_get_frag(sink, sink->w_ptr, ooffset,
 					    s_size_out);
-	int i = 0;
-	int chunk;
-	int N1, N2;
+	uint32_t i = 0;
+	uint32_t chunk;
 
 	assert(audio_stream_get_avail_samples(source) >= samples + ioffset);
 	assert(audio_stream_get_free_samples(sink) >= samples + ooffset);
 
 	while (i < samples) {
 		/* calculate chunk size */
-		N1 = audio_stream_bytes_without_wrap(source, r_ptr);
-		N2 = audio_stream_bytes_without_wrap(sink, w_ptr);
-		chunk = MIN(N1, N2) * s_size_out;
-		chunk = MIN(chunk, samples - i);
+		chunk = audio_stream_span_samples(source, r_ptr, sink, w_ptr,
+						  samples - i);
+		if (!chunk)
+			return;
 
 		/* run conversion on linear memory region */
 		converter(r_ptr, w_ptr, chunk);
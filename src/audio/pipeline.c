@@ -367,9 +367,13 @@ static int pipeline_comp_hw_params(struct comp_dev *current,
 	/* set buffer parameters */
 	if (calling_buf) {
 		buffer_lock(calling_buf, &flags);
-		buffer_set_params(calling_buf, &ppl_data->params->params,
-				  BUFFER_UPDATE_IF_UNSET);
+		ret = buffer_set_params(calling_buf, &ppl_data->params->params,
+					BUFFER_UPDATE_IF_UNSET);
 		buffer_unlock(calling_buf, flags);
+		if (ret < 0) {
+			pipe_cl_err("pipeline_comp_hw_params(): buffer_set_params() error.");
+			return ret;
+		}
 	}
 
 	return 0;
@@ -881,16 +885,19 @@ static int pipeline_comp_copy(struct comp_dev *current,
 	int is_single_ppl = comp_is_single_pipeline(current, ppl_data->start);
 	int err;
 
-	pipe_cl_dbg("pipeline_comp_copy(), current->comp.id = %u, dir = %u",
-		    dev_comp_id(current), dir);
+	pipe_cl_dbg_ratelimited(
+		"pipeline_comp_copy(), current->comp.id = %u, dir = %u",
+		dev_comp_id(current), dir);
 
 	if (!is_single_ppl) {
-		pipe_cl_dbg("pipeline_comp_copy(), current is from another pipeline and can't be scheduled together");
+		pipe_cl_dbg_ratelimited(
+			"pipeline_comp_copy(), current is from another pipeline and can't be scheduled together");
 		return 0;
 	}
 
 	if (!comp_is_active(current)) {
-		pipe_cl_dbg("pipeline_comp_copy(), current is not active");
+		pipe_cl_dbg_ratelimited(
+			"pipeline_comp_copy(), current is not active");
 		return 0;
 	}
 
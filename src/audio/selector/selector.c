@@ -107,6 +107,7 @@ static int selector_verify_params(struct comp_dev *dev,
 	uint32_t in_channels;
 	uint32_t out_channels;
 	uint32_t flags = 0;
+	int ret;
 
 	comp_dbg(dev, "selector_verify_params()");
 
@@ -164,7 +165,12 @@ static int selector_verify_params(struct comp_dev *dev,
 	}
 
 	/* Set buffer params */
-	buffer_set_params(buffer, params, BUFFER_UPDATE_FORCE);
+	ret = buffer_set_params(buffer, params, BUFFER_UPDATE_FORCE);
+	if (ret < 0) {
+		buffer_unlock(buffer, flags);
+		comp_err(dev, "selector_verify_params(): buffer_set_params() failed");
+		return ret;
+	}
 
 	/* set component period frames */
 	component_set_period_frames(dev, sinkb->stream.rate);
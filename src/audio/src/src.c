@@ -8,9 +8,11 @@
 
 #include <sof/common.h>
 #include <sof/audio/buffer.h>
+#include <sof/audio/coef_cache.h>
 #include <sof/audio/component.h>
 #include <sof/audio/pipeline.h>
 #include <sof/audio/src/src.h>
+#include <sof/audio/src/src_coef_gen.h>
 #include <sof/audio/src/src_config.h>
 #include <sof/debug/panic.h>
 #include <sof/drivers/ipc.h>
@@ -27,6 +29,7 @@
 #include <ipc/topology.h>
 #include <user/trace.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -44,6 +47,17 @@
 #endif
 #endif
 
+/* Passband of the designed filters as fraction of the lower rate times
+ * 1e4, it also keys the coefficients in coef_cache.
+ */
+#if SRC_SHORT
+#define SRC_QUALITY	1814
+#define SRC_COEF_SIZE	sizeof(int16_t)
+#else
+#define SRC_QUALITY	4535
+#define SRC_COEF_SIZE	sizeof(int32_t)
+#endif
+
 /* The FIR maximum lengths are per channel so need to multiply them */
 #define MAX_FIR_DELAY_SIZE_XNCH (PLATFORM_MAX_CHANNELS * MAX_FIR_DELAY_SIZE)
 #define MAX_OUT_DELAY_SIZE_XNCH (PLATFORM_MAX_CHANNELS * MAX_OUT_DELAY_SIZE)
@@ -105,10 +119,83 @@ static int src_find_fs(int fs_list[], int list_length, int fs)
 	return -EINVAL;
 }
 
+/* Copies a stage and its coefficients to the plan memory */
+static int src_plan_copy_stage(struct src_stage *dst, void *coefs,
+			       const struct src_stage *src)
+{
+	size_t bytes = src->filter_length * SRC_COEF_SIZE;
+
+	*dst = *src;
+	dst->coefs = coefs;
+
+	return memcpy_s(coefs, bytes, src->coefs, bytes);
+}
+
+/* Creates the plan of a coef_cache key from the precomputed stages or
+ * from the designed ones if the rates have no precomputed coefficients.
+ */
+static void *src_plan_create(const struct coef_cache_key *key, void *arg,
+			     size_t *size)
+{
+	struct src_param *a = arg;
+	struct src_stage *stage1 = a->stage1;
+	struct src_stage *stage2 = a->stage2;
+	struct src_plan *plan = NULL;
+	int8_t *coefs;
+	bool design = !stage1 || stage1->filter_length < 1;
+
+#if CONFIG_COMP_SRC_COEF_GEN
+	if (design && src_coef_gen_design(key->fs_in, key->fs_out,
+					  key->quality, &stage1, &stage2) < 0)
+		return NULL;
+#else
+	if (design)
+		return NULL;
+#endif
+
+	*size = sizeof(*plan) + (stage1->filter_length +
+				 stage2->filter_length) * SRC_COEF_SIZE;
+	plan = coef_cache_alloc(*size);
+	if (!plan)
+		goto out;
+
+	coefs = (int8_t *)(plan + 1);
+	if (src_plan_copy_stage(&plan->stage1, coefs, stage1) < 0 ||
+	    src_plan_copy_stage(&plan->stage2, coefs + stage1->filter_length *
+				SRC_COEF_SIZE, stage2) < 0) {
+		rfree(plan);
+		plan = NULL;
+	}
+
+out:
+#if CONFIG_COMP_SRC_COEF_GEN
+	if (design) {
+		src_coef_gen_free(stage1);
+		src_coef_gen_free(stage2);
+	}
+#endif
+	return plan;
+}
+
+/* Releases the plan of the previous rates */
+static void src_plan_put(struct src_param *a)
+{
+	coef_cache_put(a->plan);
+	a->plan = NULL;
+	a->stage1 = NULL;
+	a->stage2 = NULL;
+}
+
 /* Calculates buffers to allocate for a SRC mode */
 int src_buffer_lengths(struct src_param *a, int fs_in, int fs_out, int nch,
 		       int source_frames)
 {
+	struct coef_cache_key key = {
+		.type = COEF_CACHE_SRC,
+		.fs_in = fs_in,
+		.fs_out = fs_out,
+		.quality = SRC_QUALITY,
+	};
 	struct src_stage *stage1;
 	struct src_stage *stage2;
 	int r1;
@@ -120,19 +207,42 @@ int src_buffer_lengths(struct src_param *a, int fs_in, int fs_out, int nch,
 		return -EINVAL;
 	}
 
+	src_plan_put(a);
 	a->nch = nch;
 	a->idx_in = src_find_fs(src_in_fs, NUM_IN_FS, fs_in);
 	a->idx_out = src_find_fs(src_out_fs, NUM_OUT_FS, fs_out);
+	if (a->idx_in >= 0 && a->idx_out >= 0) {
+		a->stage1 = src_table1[a->idx_out][a->idx_in];
+		a->stage2 = src_table2[a->idx_out][a->idx_in];
+	}
+
+	/* Instances of the same rates share one copy of the stages. The
+	 * precomputed stages are used in place if the copy fails.
+	 */
+	a->plan = coef_cache_get(&key, src_plan_create, a);
+	if (a->plan) {
+		a->stage1 = &a->plan->stage1;
+		a->stage2 = &a->plan->stage2;
+	}
+
+#if CONFIG_COMP_SRC_COEF_GEN
+	/* Design of the filters failed if there is no precomputed set */
+	if (!a->plan && (!a->stage1 || a->stage1->filter_length < 1)) {
+		comp_cl_err(&comp_src, "src_buffer_lengths(): filter design failed, fs_in: %u, fs_out: %u",
+			    fs_in, fs_out);
+		return -EINVAL;
+	}
+#endif
 
 	/* Check that both in and out rates are supported */
-	if (a->idx_in < 0 || a->idx_out < 0) {
+	if (!a->stage1) {
 		comp_cl_err(&comp_src, "src_buffer_lengths(): rates not supported, fs_in: %u, fs_out: %u",
 			    fs_in, fs_out);
 		return -EINVAL;
 	}
 
-	stage1 = src_table1[a->idx_out][a->idx_in];
-	stage2 = src_table2[a->idx_out][a->idx_in];
+	stage1 = a->stage1;
+	stage2 = a->stage2;
 
 	/* Check from stage1 parameter for a deleted in/out rate combination.*/
 	if (stage1->filter_length < 1) {
@@ -264,29 +374,25 @@ void src_polyphase_reset(struct polyphase_src *src)
 int src_polyphase_init(struct polyphase_src *src, struct src_param *p,
 		       int32_t *delay_lines_start)
 {
-	struct src_stage *stage1;
-	struct src_stage *stage2;
 	int n_stages;
 	int ret;
 
-	if (p->idx_in < 0 || p->idx_out < 0)
+	if (!p->stage1 || !p->stage2)
 		return -EINVAL;
 
 	/* Get setup for 2 stage conversion */
-	stage1 = src_table1[p->idx_out][p->idx_in];
-	stage2 = src_table2[p->idx_out][p->idx_in];
-	ret = init_stages(stage1, stage2, src, p, 2, delay_lines_start);
+	ret = init_stages(p->stage1, p->stage2, src, p, 2, delay_lines_start);
 	if (ret < 0)
 		return -EINVAL;
 
 	/* Get number of stages used for optimize opportunity. 2nd
 	 * stage length is one if conversion needs only one stage.
-	 * If input and output rate is the same return 0 to
-	 * use a simple copy function instead of 1 stage FIR with one
-	 * tap.
+	 * If input and output rate is the same the 1st stage is also
+	 * one tap. Return 0 to use a simple copy function instead of 1
+	 * stage FIR with one tap.
 	 */
 	n_stages = (src->stage2->filter_length == 1) ? 1 : 2;
-	if (p->idx_in == p->idx_out)
+	if (src->stage1->filter_length == 1)
 		n_stages = 0;
 
 	/* If filter length for first stage is zero this is a deleted
@@ -512,6 +618,7 @@ static void src_free(struct comp_dev *dev)
 	if (cd->delay_lines)
 		rfree(cd->delay_lines);
 
+	src_plan_put(&cd->param);
 	rfree(cd);
 	rfree(dev);
 }
@@ -750,8 +857,12 @@ static void src_process(struct comp_dev *dev, struct comp_buffer *source,
 	int consumed = 0;
 	int produced = 0;
 
-	/* consumed bytes are not known at this point */
-	buffer_invalidate(source, source->stream.size);
+	/* The stages read at most the blk_in frames from the copy limits,
+	 * the filter history is kept in the delay lines.
+	 */
+	buffer_invalidate(source,
+			  audio_stream_get_readable_bytes(&source->stream,
+							  cd->param.blk_in));
 	cd->src_func(dev, &source->stream, &sink->stream, &consumed, &produced);
 	buffer_writeback(sink, produced *
 			 audio_stream_frame_bytes(&sink->stream));
@@ -907,6 +1018,7 @@ static int src_reset(struct comp_dev *dev)
 
 	cd->src_func = src_fallback;
 	src_polyphase_reset(&cd->src);
+	src_plan_put(&cd->param);
 
 	comp_set_state(dev, COMP_TRIGGER_RESET);
 	return 0;
@@ -934,6 +1046,7 @@ static SHARED_DATA struct comp_driver_info comp_src_info = {
 
 static void sys_comp_src_init(void)
 {
+	coef_cache_init();
 	comp_register(platform_shared_get(&comp_src_info,
 					  sizeof(comp_src_info)));
 }
@@ -0,0 +1,432 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+/* Runtime design of the SRC polyphase filters. This is a fixed point
+ * version of the Kaiser window design of tools/tune/src/src_get.m that
+ * is used for the rates that have no precomputed coefficients.
+ */
+
+#include <sof/common.h>
+#include <sof/audio/format.h>
+#include <sof/audio/src/src.h>
+#include <sof/audio/src/src_coef_gen.h>
+#include <sof/audio/src/src_config.h>
+#include <sof/lib/alloc.h>
+#include <sof/lib/memory.h>
+#include <sof/math/decibels.h>
+#include <sof/math/numbers.h>
+#include <sof/math/trig.h>
+#include <ipc/topology.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Coefficients are Q1.15 or Q1.31 as in the precomputed sets */
+#if SRC_SHORT
+#define SRC_GEN_COEF_QY		15
+#define SRC_GEN_COEF_SIZE	sizeof(int16_t)
+#else
+#define SRC_GEN_COEF_QY		31
+#define SRC_GEN_COEF_SIZE	sizeof(int32_t)
+#endif
+
+/* Quality is the passband as fraction of the lower rate times 1e4 */
+#define SRC_GEN_QUALITY_ONE	10000
+
+/* Passband is 24 kHz for rates above 80 kHz, stopband starts at fs/2 */
+#define SRC_GEN_HIGH_FS		80000
+#define SRC_GEN_HIGH_F_PB	24000
+
+/* Kaiser window for 70 dB stopband, beta = 0.1102 * (70 - 8.7) */
+#define SRC_GEN_BETA2_Q20	Q_CONVERT_FLOAT(11.408378, 20) /* (beta/2)^2 */
+
+/* Kaiser filter order is (70 - 7.95) / (2.285 * 2 * pi) * fs / df */
+#define SRC_GEN_ORDER_Q16	Q_CONVERT_FLOAT(4.321910, 16)
+
+/* Total gain at 0 Hz */
+#define SRC_GEN_GAIN_DB_Q24	Q_CONVERT_FLOAT(-1.0, 24)
+
+/* Subfilter length must be a multiple of 4 for the FIR cores */
+#define SRC_GEN_SUBFILTER_MULT	4
+
+#define SRC_GEN_I0_MAX_TERMS	50
+
+/* Polyphase filter design parameters of one stage */
+struct src_gen_param {
+	int fs1;
+	int fs2;
+	int f_pb; /* Hz */
+	int f_sb; /* Hz */
+	int32_t gain_db; /* Q8.24 */
+};
+
+/* Windowed sinc prototype */
+struct src_gen_fir {
+	int nfir; /* filter order */
+	int64_t nfir2;
+	uint32_t fc4; /* cutoff as fraction of 4 * fs, Q0.32 */
+};
+
+/* Stage for 1:1 and the second stage of single stage conversions */
+#if SRC_SHORT
+static const int16_t src_gen_fir_one = 16384;
+#else
+static const int32_t src_gen_fir_one = 1073741824;
+#endif
+static struct src_stage src_gen_one = {
+	0, 0, 1, 1, 1, 1, 1, 0, -1, &src_gen_fir_one
+};
+
+static int src_gen_bits(uint64_t x)
+{
+	int n = 0;
+
+	while (x) {
+		x >>= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/* The divisor of c nearest to round(sqrt(c)), see src_factor2_lm.m */
+static int src_gen_factor(int c)
+{
+	int x = 1;
+	int a1 = 0;
+	int a2 = 0;
+	int t;
+
+	while ((x + 1) * (x + 1) <= c)
+		x++;
+
+	if (x * x + x < c)
+		x++;
+
+	for (t = x; t <= 2 * x; t++) {
+		if (c % t == 0) {
+			a1 = t;
+			break;
+		}
+	}
+
+	for (t = x; t >= MAX(x / 2, 1); t--) {
+		if (c % t == 0) {
+			a2 = t;
+			break;
+		}
+	}
+
+	if (a1 && (!a2 || a1 - x < x - a2))
+		return a1;
+
+	return a2 ? a2 : 1;
+}
+
+/* Split the conversion into two stages, see src_factor2_lm.m */
+static void src_gen_factor2(int fs1, int fs2, int *l1, int *m1, int *l2,
+			    int *m2)
+{
+	static const int special[][4] = {
+		{ 147, 640, 7, 8 },	/* 192 to 44.1 */
+		{ 147, 320, 7, 8 },	/* 96 to 44.1 */
+		{ 147, 160, 7, 8 },	/* 48 to 44.1 */
+		{ 160, 147, 8, 7 },	/* 44.1 to 48 */
+		{ 320, 147, 8, 7 },	/* 44.1 to 96 */
+		{ 4, 3, 4, 3 },		/* 24 to 32, no 2 stage */
+		{ 3, 4, 3, 4 },		/* 32 to 24, no 2 stage */
+	};
+	int64_t fs3[4];
+	int64_t delta;
+	int64_t low = MIN(fs1, fs2);
+	int k = gcd(fs1, fs2);
+	int l = fs2 / k;
+	int m = fs1 / k;
+	int l01 = src_gen_factor(l);
+	int m01 = src_gen_factor(m);
+	int l02;
+	int m02;
+	int idx = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(special); i++) {
+		if (l == special[i][0] && m == special[i][1]) {
+			l01 = special[i][2];
+			m01 = special[i][3];
+		}
+	}
+
+	l02 = l / l01;
+	m02 = m / m01;
+
+	/* The intermediate rate nearest to but not below the lower rate */
+	fs3[0] = (int64_t)fs1 * l01 / m01;
+	fs3[1] = (int64_t)fs1 * l01 / m02;
+	fs3[2] = (int64_t)fs1 * l02 / m01;
+	fs3[3] = (int64_t)fs1 * l02 / m02;
+	delta = INT64_MAX;
+	for (i = 0; i < 4; i++) {
+		if (fs3[i] >= low && fs3[i] - low < delta) {
+			delta = fs3[i] - low;
+			idx = i;
+		}
+	}
+
+	*l1 = idx < 2 ? l01 : l02;
+	*l2 = idx < 2 ? l02 : l01;
+	*m1 = idx & 1 ? m02 : m01;
+	*m2 = idx & 1 ? m01 : m02;
+
+	if (*l1 == 1 && *m1 == 1) {
+		*l1 = *l2;
+		*m1 = *m2;
+		*l2 = 1;
+		*m2 = 1;
+	}
+}
+
+/* Find idm and odm for -idm * L + odm * M = 1, see src_find_l0m0.m */
+static int src_gen_l0m0(int l, int m, int *l0, int *m0)
+{
+	int lt;
+
+	if (m == 1) {
+		*l0 = 0;
+		*m0 = 1;
+		return 0;
+	}
+
+	if (l == 1) {
+		*l0 = 1;
+		*m0 = 0;
+		return 0;
+	}
+
+	for (lt = 1; lt <= 4 * l; lt++) {
+		if ((1 + lt * l) % m == 0) {
+			*l0 = lt;
+			*m0 = (1 + lt * l) / m;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static void src_gen_passband(struct src_gen_param *p, int quality)
+{
+	int min_fs = MIN(p->fs1, p->fs2);
+
+	if (min_fs > SRC_GEN_HIGH_FS)
+		p->f_pb = SRC_GEN_HIGH_F_PB;
+	else
+		p->f_pb = (int64_t)min_fs * quality / SRC_GEN_QUALITY_ONE;
+
+	p->f_sb = min_fs >> 1;
+}
+
+/* Kaiser window times sinc for tap n, the scale is arbitrary */
+static int64_t src_gen_tap(const struct src_gen_fir *f, int n)
+{
+	int64_t term = 1LL << 30;
+	int64_t w = term;
+	int64_t z2;
+	uint32_t phase;
+	int32_t s;
+	int k = 2 * n - f->nfir; /* odd, twice the distance to center */
+	int j;
+
+	/* I0(beta * sqrt(1 - (k / nfir)^2)) as Q30 from the series
+	 * sum((z^2)^j / (j!)^2) where z is the half of the argument.
+	 */
+	z2 = SRC_GEN_BETA2_Q20 * (f->nfir2 - (int64_t)k * k) / f->nfir2;
+	for (j = 1; j < SRC_GEN_I0_MAX_TERMS && term; j++) {
+		term = ((term * z2) >> 20) / (j * j);
+		w += term;
+	}
+
+	/* sin(2 * pi * fc / fs * k / 2) / k, the phase wraps at 2 * pi */
+	phase = (uint32_t)((int64_t)f->fc4 * k);
+	s = sin_fixed(((uint64_t)phase * PI_MUL2_Q4_28) >> 32);
+
+	return (((w >> 8) * s) >> 16) / k;
+}
+
+/* Designs and allocates a polyphase filter stage, see src_get.m */
+static struct src_stage *src_gen_stage(struct src_gen_param *p)
+{
+	struct src_gen_fir fir;
+	struct src_stage *stage;
+	void *coefs;
+	int64_t sum = 0;
+	int64_t num;
+	int64_t lim;
+	int64_t h;
+	uint64_t hmax = 0;
+	uint64_t qm;
+	int k = gcd(p->fs1, p->fs2);
+	int l = p->fs2 / k;
+	int m = p->fs1 / k;
+	int fs3 = l * p->fs1;
+	int df = p->f_sb - p->f_pb;
+	int length;
+	int sub_length;
+	int idm;
+	int odm;
+	int shift;
+	int eh;
+	int es;
+	int en;
+	int r;
+	int n;
+
+	if (l > SRC_COEF_GEN_MAX_LM || m > SRC_COEF_GEN_MAX_LM || df <= 0)
+		return NULL;
+
+	if (src_gen_l0m0(l, m, &idm, &odm) < 0)
+		return NULL;
+
+	/* Kaiser order rounded up to subfilter length multiple of 4 */
+	n = ((int64_t)SRC_GEN_ORDER_Q16 * fs3 + ((int64_t)df << 16) - 1) /
+		((int64_t)df << 16);
+	length = ceil_divide(n + 1, SRC_GEN_SUBFILTER_MULT * l) *
+		SRC_GEN_SUBFILTER_MULT * l;
+	if (length > SRC_COEF_GEN_MAX_LENGTH)
+		return NULL;
+
+	sub_length = length / l;
+	fir.nfir = length - 1;
+	fir.nfir2 = (int64_t)fir.nfir * fir.nfir;
+	fir.fc4 = ((uint64_t)(p->f_pb + p->f_sb) << 32) / (4LL * fs3);
+
+	/* DC gain and peak of the prototype */
+	for (n = 0; n < length; n++) {
+		h = src_gen_tap(&fir, n);
+		sum += h;
+		hmax = MAX(hmax, (uint64_t)ABS(h));
+	}
+
+	if (sum <= 0)
+		return NULL;
+
+	/* Scale to L times the gain at 0 Hz, coef = h * qm >> r. The
+	 * taps, sum and gain are normalized to 31 bits for precision.
+	 */
+	eh = MAX(src_gen_bits(hmax) - 31, 0);
+	es = MAX(src_gen_bits(sum) - 31, 0);
+	num = (int64_t)l * db2lin_fixed(p->gain_db); /* Q20 */
+	en = 63 - src_gen_bits(num);
+	qm = ((uint64_t)num << en) / (uint64_t)(sum >> es);
+	r = en + es + DB2LIN_FIXED_OUTPUT_QY - eh - SRC_GEN_COEF_QY;
+	while (qm >= (1ULL << 31)) {
+		qm >>= 1;
+		r--;
+	}
+
+	/* Largest shift that keeps the peak below 32767/32768 */
+	h = ((hmax >> eh) * qm) >> r;
+	lim = (1LL << SRC_GEN_COEF_QY) - (1LL << (SRC_GEN_COEF_QY - 15));
+	shift = 0;
+	while (h > lim) {
+		h >>= 1;
+		shift--;
+	}
+
+	while (h && (h << 1) <= lim) {
+		h <<= 1;
+		shift++;
+	}
+
+	r -= shift;
+	if (r < 1 || r > 62)
+		return NULL;
+
+	stage = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+			sizeof(*stage) + length * SRC_GEN_COEF_SIZE);
+	if (!stage)
+		return NULL;
+
+	/* Subfilter i has taps i, i + L, i + 2L, ... of the prototype */
+	coefs = stage + 1;
+	for (n = 0; n < length; n++) {
+		h = ((src_gen_tap(&fir, n) >> eh) * (int64_t)qm +
+		     (1LL << (r - 1))) >> r;
+		k = (n % l) * sub_length + n / l;
+#if SRC_SHORT
+		((int16_t *)coefs)[k] = sat_int16(h);
+#else
+		((int32_t *)coefs)[k] = sat_int32(h);
+#endif
+	}
+
+	*stage = (struct src_stage) {
+		idm, odm, l, sub_length, length, m, l, 0, shift, coefs
+	};
+
+	return stage;
+}
+
+void src_coef_gen_free(struct src_stage *stage)
+{
+	if (stage != &src_gen_one)
+		rfree(stage);
+}
+
+int src_coef_gen_design(int fs_in, int fs_out, int quality,
+			struct src_stage **stage1, struct src_stage **stage2)
+{
+	struct src_gen_param p1;
+	struct src_gen_param p2;
+	int l1;
+	int m1;
+	int l2;
+	int m2;
+
+	if (fs_in <= 0 || fs_out <= 0 || quality <= 0 ||
+	    quality >= SRC_GEN_QUALITY_ONE / 2)
+		return -EINVAL;
+
+	if (fs_in == fs_out) {
+		*stage1 = &src_gen_one;
+		*stage2 = &src_gen_one;
+		return 0;
+	}
+
+	src_gen_factor2(fs_in, fs_out, &l1, &m1, &l2, &m2);
+	p1.fs1 = fs_in;
+	p1.fs2 = (int64_t)fs_in * l1 / m1;
+	p2.fs1 = p1.fs2;
+	p2.fs2 = fs_out;
+	src_gen_passband(&p1, quality);
+	src_gen_passband(&p2, quality);
+
+	if (l2 == 1 && m2 == 1) {
+		p1.gain_db = SRC_GEN_GAIN_DB_Q24;
+		*stage1 = src_gen_stage(&p1);
+		*stage2 = &src_gen_one;
+	} else {
+		/* The stage next to the lower rate sets the passband, the
+		 * other stage can use a wider transition band.
+		 */
+		if (fs_out < fs_in)
+			p1.f_pb = p2.f_pb;
+		else
+			p2.f_pb = p1.f_pb;
+
+		p1.gain_db = SRC_GEN_GAIN_DB_Q24 / 2;
+		p2.gain_db = SRC_GEN_GAIN_DB_Q24 / 2;
+		*stage1 = src_gen_stage(&p1);
+		*stage2 = src_gen_stage(&p2);
+	}
+
+	if (!*stage1 || !*stage2) {
+		if (*stage1)
+			src_coef_gen_free(*stage1);
+		if (*stage2)
+			src_coef_gen_free(*stage2);
+		return -EINVAL;
+	}
+
+	return 0;
+}
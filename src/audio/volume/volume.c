@@ -692,6 +692,7 @@ static int volume_copy(struct comp_dev *dev)
 	uint32_t sink_bytes;
 	uint32_t frames;
 	int64_t prev_sum = 0;
+	int i;
 
 	comp_dbg(dev, "volume_copy()");
 
@@ -722,21 +723,39 @@ static int volume_copy(struct comp_dev *dev)
 		source_bytes = frames * c.source_frame_bytes;
 		sink_bytes = frames * c.sink_frame_bytes;
 
-		/* copy and scale volume */
 		buffer_invalidate(source, source_bytes);
-		cd->scale_vol(dev, &sink->stream, &source->stream, frames);
+		if (!cd->ramp_finished && cd->ramp_vol &&
+		    pga->ramp != SOF_VOLUME_LINEAR_ZC) {
+			/* advance the ramp first and let the kernel move
+			 * gain linearly per frame from the previous value,
+			 * ZC ramps keep stepping at the zero crossings
+			 */
+			for (i = 0; i < cd->channels; i++)
+				cd->vol_ramp_start[i] = cd->volume[i];
+
+			if (cd->vol_ramp_active)
+				cd->vol_ramp_elapsed_frames += frames;
+
+			volume_ramp(dev);
+			cd->ramp_vol(dev, &sink->stream, &source->stream,
+				     frames);
+		} else {
+			/* copy and scale volume */
+			cd->scale_vol(dev, &sink->stream, &source->stream,
+				      frames);
+
+			if (cd->vol_ramp_active)
+				cd->vol_ramp_elapsed_frames += frames;
+
+			if (!cd->ramp_finished)
+				volume_ramp(dev);
+		}
 		buffer_writeback(sink, sink_bytes);
 
 		/* calculate new free and available */
 		comp_update_buffer_produce(sink, sink_bytes);
 		comp_update_buffer_consume(source, source_bytes);
 
-		if (cd->vol_ramp_active)
-			cd->vol_ramp_elapsed_frames += frames;
-
-		if (!cd->ramp_finished)
-			volume_ramp(dev);
-
 		c.frames -= frames;
 	}
 
@@ -814,6 +833,9 @@ static int volume_prepare(struct comp_dev *dev)
 		goto err;
 	}
 
+	/* optional, without it gain is stepped once per ramp chunk */
+	cd->ramp_vol = vol_get_ramp_function(dev);
+
 	cd->zc_get = vol_get_zc_function(dev);
 	if (!cd->zc_get) {
 		comp_err(dev, "volume_prepare(): invalid cd->zc_get");
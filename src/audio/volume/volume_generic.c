@@ -26,6 +26,71 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * \brief Fills gain block with channel gains repeated for VOL_BLOCK_FRAMES.
+ * \param[out] gain Gain block, VOL_BLOCK_FRAMES * nch values.
+ * \param[in] vol Channel gains.
+ * \param[in] nch Number of channels.
+ *
+ * Kernels multiply contiguous interleaved samples with the gain block so
+ * the inner loop has no channel indexing and can be vectorized.
+ */
+static void vol_fill_block(int32_t *gain, const int32_t *vol, int nch)
+{
+	int ch;
+	int f;
+
+	for (f = 0; f < VOL_BLOCK_FRAMES; f++)
+		for (ch = 0; ch < nch; ch++)
+			gain[f * nch + ch] = vol[ch];
+}
+
+/**
+ * \brief Fills gain and slope blocks for a linear ramp over frames.
+ * \param[in] cd Volume component private data.
+ * \param[out] gain Gain block for first VOL_BLOCK_FRAMES frames.
+ * \param[out] delta Per frame gain increment block.
+ * \param[in] nch Number of channels.
+ * \param[in] frames Ramp length in frames.
+ *
+ * Gain moves linearly from cd->vol_ramp_start[] to cd->volume[] with
+ * VOL_RAMP_FRAC_BITS additional fractional bits to keep small slopes.
+ */
+static void vol_ramp_fill_block(const struct comp_data *cd, int32_t *gain,
+				int32_t *delta, int nch, uint32_t frames)
+{
+	int32_t start;
+	int32_t d;
+	int ch;
+	int f;
+
+	for (ch = 0; ch < nch; ch++) {
+		start = cd->vol_ramp_start[ch] * (1 << VOL_RAMP_FRAC_BITS);
+		d = (cd->volume[ch] - cd->vol_ramp_start[ch]) *
+		    (1 << VOL_RAMP_FRAC_BITS) / (int32_t)frames;
+		for (f = 0; f < VOL_BLOCK_FRAMES; f++) {
+			gain[f * nch + ch] = start + f * d;
+			delta[f * nch + ch] = d;
+		}
+	}
+}
+
+/**
+ * \brief Advances ramp gain block by number of processed frames.
+ * \param[in,out] gain Gain block.
+ * \param[in] delta Per frame gain increment block.
+ * \param[in] n Number of samples in gain block.
+ * \param[in] frames Number of processed frames.
+ */
+static inline void vol_ramp_advance(int32_t *gain, const int32_t *delta,
+				    int n, int frames)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		gain[i] += frames * delta[i];
+}
+
 #if CONFIG_FORMAT_S24LE
 /**
  * \brief Volume s24 to s24 multiply function
@@ -55,22 +120,93 @@ static void vol_s24_to_s24(struct comp_dev *dev, struct audio_stream *sink,
 			   const struct audio_stream *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
+
+	vol_fill_block(gain, cd->volume, nch);
 
 	/* Samples are Q1.23 --> Q1.23 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < sink->channels; channel++) {
-			src = audio_stream_read_frag_s32(source, buff_frag);
-			dest = audio_stream_write_frag_s32(sink, buff_frag);
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = vol_mult_s24_to_s24(src[i], gain[i]);
+
+			samples -= m;
+			src += m;
+			dest += m;
+		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
+	}
+}
+
+/**
+ * \brief Volume ramp processing from 24/32 bit to 24/32 bit.
+ * \param[in,out] dev Volume base component device.
+ * \param[in,out] sink Destination buffer.
+ * \param[in,out] source Source buffer.
+ * \param[in] frames Number of frames to process.
+ *
+ * Copy and scale volume from 24/32 bit source buffer to 24/32 bit
+ * destination buffer with gain ramped linearly per frame.
+ */
+static void vol_ramp_s24_to_s24(struct comp_dev *dev,
+				struct audio_stream *sink,
+				const struct audio_stream *source,
+				uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int32_t delta[VOL_BLOCK_SAMPLES];
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
 
-			*dest = vol_mult_s24_to_s24(*src, cd->volume[channel]);
+	vol_ramp_fill_block(cd, gain, delta, nch, frames);
 
-			buff_frag++;
+	/* Samples are Q1.23 --> Q1.23 and ramp gain is Q8.24 */
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = q_multsr_sat_32x32_24
+					(sign_extend_s24(src[i]), gain[i],
+					 Q_SHIFT_BITS_64(23, VOL_QXY_Y +
+							 VOL_RAMP_FRAC_BITS,
+							 23));
+
+			vol_ramp_advance(gain, delta, block, m / nch);
+			samples -= m;
+			src += m;
+			dest += m;
 		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
 	}
 }
 #endif /* CONFIG_FORMAT_S24LE */
@@ -90,24 +226,95 @@ static void vol_s32_to_s32(struct comp_dev *dev, struct audio_stream *sink,
 			   const struct audio_stream *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int32_t *src;
-	int32_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
+
+	vol_fill_block(gain, cd->volume, nch);
 
 	/* Samples are Q1.31 --> Q1.31 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < sink->channels; channel++) {
-			src = audio_stream_read_frag_s32(source, buff_frag);
-			dest = audio_stream_write_frag_s32(sink, buff_frag);
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = q_multsr_sat_32x32
+					(src[i], gain[i],
+					 Q_SHIFT_BITS_64(31, 16, 31));
+
+			samples -= m;
+			src += m;
+			dest += m;
+		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
+	}
+}
+
+/**
+ * \brief Volume ramp processing from 32 bit to 32 bit.
+ * \param[in,out] dev Volume base component device.
+ * \param[in,out] sink Destination buffer.
+ * \param[in,out] source Source buffer.
+ * \param[in] frames Number of frames to process.
+ *
+ * Copy and scale volume from 32 bit source buffer to 32 bit
+ * destination buffer with gain ramped linearly per frame.
+ */
+static void vol_ramp_s32_to_s32(struct comp_dev *dev,
+				struct audio_stream *sink,
+				const struct audio_stream *source,
+				uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int32_t delta[VOL_BLOCK_SAMPLES];
+	int32_t *src = source->r_ptr;
+	int32_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
+
+	vol_ramp_fill_block(cd, gain, delta, nch, frames);
 
-			*dest = q_multsr_sat_32x32
-				(*src, cd->volume[channel],
-				 Q_SHIFT_BITS_64(31, 16, 31));
+	/* Samples are Q1.31 --> Q1.31 and ramp gain is Q8.24 */
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = q_multsr_sat_32x32
+					(src[i], gain[i],
+					 Q_SHIFT_BITS_64(31, VOL_QXY_Y +
+							 VOL_RAMP_FRAC_BITS,
+							 31));
 
-			buff_frag++;
+			vol_ramp_advance(gain, delta, block, m / nch);
+			samples -= m;
+			src += m;
+			dest += m;
 		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
 	}
 }
 #endif /* CONFIG_FORMAT_S32LE */
@@ -127,37 +334,108 @@ static void vol_s16_to_s16(struct comp_dev *dev, struct audio_stream *sink,
 			   const struct audio_stream *source, uint32_t frames)
 {
 	struct comp_data *cd = comp_get_drvdata(dev);
-	int16_t *src;
-	int16_t *dest;
-	int32_t i;
-	uint32_t channel;
-	uint32_t buff_frag = 0;
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int16_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
+
+	vol_fill_block(gain, cd->volume, nch);
 
 	/* Samples are Q1.15 --> Q1.15 and volume is Q8.16 */
-	for (i = 0; i < frames; i++) {
-		for (channel = 0; channel < sink->channels; channel++) {
-			src = audio_stream_read_frag_s16(source, buff_frag);
-			dest = audio_stream_write_frag_s16(sink, buff_frag);
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = q_multsr_sat_32x32_16
+					(src[i], gain[i],
+					 Q_SHIFT_BITS_32(15, 16, 15));
 
-			*dest = q_multsr_sat_32x32_16
-				(*src, cd->volume[channel],
-				 Q_SHIFT_BITS_32(15, 16, 15));
+			samples -= m;
+			src += m;
+			dest += m;
+		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
+	}
+}
 
-			buff_frag++;
+/**
+ * \brief Volume ramp processing from 16 bit to 16 bit.
+ * \param[in,out] dev Volume base component device.
+ * \param[in,out] sink Destination buffer.
+ * \param[in,out] source Source buffer.
+ * \param[in] frames Number of frames to process.
+ *
+ * Copy and scale volume from 16 bit source buffer to 16 bit
+ * destination buffer with gain ramped linearly per frame.
+ */
+static void vol_ramp_s16_to_s16(struct comp_dev *dev,
+				struct audio_stream *sink,
+				const struct audio_stream *source,
+				uint32_t frames)
+{
+	struct comp_data *cd = comp_get_drvdata(dev);
+	int32_t gain[VOL_BLOCK_SAMPLES];
+	int32_t delta[VOL_BLOCK_SAMPLES];
+	int16_t *src = source->r_ptr;
+	int16_t *dest = sink->w_ptr;
+	int nch = sink->channels;
+	int block = VOL_BLOCK_FRAMES * nch;
+	int samples;
+	int m;
+	int i;
+
+	vol_ramp_fill_block(cd, gain, delta, nch, frames);
+
+	/* Samples are Q1.15 --> Q1.15 and ramp gain is Q8.24 */
+	while (frames) {
+		samples = audio_stream_span_frames(source, src, sink, dest,
+						   frames);
+		if (!samples)
+			return;
+		frames -= samples;
+		samples *= nch;
+		while (samples) {
+			m = MIN(samples, block);
+			for (i = 0; i < m; i++)
+				dest[i] = q_multsr_sat_32x32_16
+					(src[i], gain[i],
+					 Q_SHIFT_BITS_64(15, VOL_QXY_Y +
+							 VOL_RAMP_FRAC_BITS,
+							 15));
+
+			vol_ramp_advance(gain, delta, block, m / nch);
+			samples -= m;
+			src += m;
+			dest += m;
 		}
+
+		src = audio_stream_wrap(source, src);
+		dest = audio_stream_wrap(sink, dest);
 	}
 }
 #endif /* CONFIG_FORMAT_S16LE */
 
 const struct comp_func_map func_map[] = {
 #if CONFIG_FORMAT_S16LE
-	{ SOF_IPC_FRAME_S16_LE, vol_s16_to_s16 },
+	{ SOF_IPC_FRAME_S16_LE, vol_s16_to_s16, vol_ramp_s16_to_s16 },
 #endif /* CONFIG_FORMAT_S16LE */
 #if CONFIG_FORMAT_S24LE
-	{ SOF_IPC_FRAME_S24_4LE, vol_s24_to_s24 },
+	{ SOF_IPC_FRAME_S24_4LE, vol_s24_to_s24, vol_ramp_s24_to_s24 },
 #endif /* CONFIG_FORMAT_S24LE */
 #if CONFIG_FORMAT_S32LE
-	{ SOF_IPC_FRAME_S32_LE, vol_s32_to_s32 },
+	{ SOF_IPC_FRAME_S32_LE, vol_s32_to_s32, vol_ramp_s32_to_s32 },
 #endif /* CONFIG_FORMAT_S32LE */
 };
 
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+/**
+ * \file include/ipc/debug.h
+ * \brief IPC debug statistics definitions
+ */
+
+#ifndef __IPC_DEBUG_H__
+#define __IPC_DEBUG_H__
+
+#include <ipc/header.h>
+#include <sof/compiler_attributes.h>
+#include <stdint.h>
+
+/**
+ * Statistics of one LL task, execution times are in ticks of the clock
+ * of the task's scheduling domain
+ */
+struct sof_ipc_dbg_ll_task {
+	uint32_t uid;		/**< Task uid */
+	uint16_t type;		/**< SOF_SCHEDULE_LL_ type */
+	uint16_t priority;	/**< Task priority */
+	uint32_t period;	/**< Task period in us */
+	uint32_t count;		/**< Number of executions */
+	uint32_t min;		/**< Shortest execution */
+	uint32_t avg;		/**< Average execution */
+	uint32_t max;		/**< Longest execution */
+	uint32_t overruns;	/**< Executions longer than the period */
+	uint32_t ticks_per_ms;	/**< Domain clock ticks per ms */
+} __packed;
+
+/**
+ * \brief Reply with statistics of LL tasks scheduled on the master core.
+ *
+ * Used as payload for IPC: SOF_IPC_DEBUG_LL_STATS.
+ */
+struct sof_ipc_dbg_ll_stats {
+	struct sof_ipc_reply rhdr;	/**< Header */
+	uint32_t num_elems;		/**< Count of elements in array */
+	struct sof_ipc_dbg_ll_task task[];	/**< Task statistics */
+} __packed;
+
+/** \name Memory statistics element types
+ *  @{
+ */
+
+#define SOF_IPC_DBG_MEM_HEAP	0	/**< struct sof_ipc_dbg_mem_heap */
+#define SOF_IPC_DBG_MEM_FAIL	1	/**< struct sof_ipc_dbg_mem_fail */
+#define SOF_IPC_DBG_MEM_COMP	2	/**< struct sof_ipc_dbg_mem_comp */
+
+/** @} */
+
+/**
+ * Usage of one heap, sizes are in bytes
+ */
+struct sof_ipc_dbg_mem_heap {
+	uint16_t zone;		/**< SOF_MEM_ZONE_ of the heap */
+	uint16_t core;		/**< Core owning a system heap */
+	uint32_t caps;		/**< SOF_MEM_CAPS_ of the heap */
+	uint32_t size;		/**< Heap size */
+	uint32_t used;		/**< Used now */
+	uint32_t free;		/**< Free now */
+	uint32_t used_max;	/**< Most used since boot */
+	uint32_t free_max;	/**< Largest contiguous free space */
+} __packed;
+
+/**
+ * Failed allocations requesting one set of capabilities
+ */
+struct sof_ipc_dbg_mem_fail {
+	uint32_t caps;		/**< Requested SOF_MEM_CAPS_ */
+	uint32_t count;		/**< Number of failed allocations */
+} __packed;
+
+/**
+ * Heap bytes taken when one component, buffer or pipeline was created.
+ * Allocations made later, e.g. in params, prepare or set_data, are not
+ * included. The figure is the heap usage delta around the create IPC,
+ * so concurrent allocations of other cores may skew it.
+ */
+struct sof_ipc_dbg_mem_comp {
+	uint32_t id;		/**< Component, buffer or pipeline id */
+	uint16_t type;		/**< COMP_TYPE_ of the object */
+	uint16_t core;		/**< Core the object runs on */
+	uint32_t bytes;		/**< Heap bytes at creation */
+} __packed;
+
+/**
+ * \brief Query of memory statistics elements of one type.
+ *
+ * Used as payload for IPC: SOF_IPC_DEBUG_MEM_STATS. The reply holds as
+ * many elements as fit in a message, the host repeats the query with
+ * a higher first element index to read the rest.
+ */
+struct sof_ipc_dbg_mem_query {
+	struct sof_ipc_cmd_hdr hdr;	/**< Header */
+	uint32_t type;			/**< SOF_IPC_DBG_MEM_ element type */
+	uint32_t first;			/**< Index of first element */
+} __packed;
+
+/**
+ * \brief Reply with memory statistics elements of one type.
+ */
+struct sof_ipc_dbg_mem_stats {
+	struct sof_ipc_reply rhdr;	/**< Header */
+	uint32_t type;			/**< SOF_IPC_DBG_MEM_ element type */
+	uint32_t first;			/**< Index of first element */
+	uint32_t total;			/**< Count of all elements of type */
+	uint32_t fail_count;		/**< All failed allocations */
+	uint32_t num_elems;		/**< Count of elements in array */
+	uint8_t elems[];		/**< Elements of type */
+} __packed;
+
+#endif /* __IPC_DEBUG_H__ */
@@ -72,6 +72,7 @@
 #define SOF_IPC_GLB_GDB_DEBUG                   SOF_GLB_TYPE(0xAU)
 #define SOF_IPC_GLB_TEST			SOF_GLB_TYPE(0xBU)
 #define SOF_IPC_GLB_PROBE			SOF_GLB_TYPE(0xCU)
+#define SOF_IPC_GLB_DEBUG			SOF_GLB_TYPE(0xDU)
 
 /** @} */
 
@@ -170,6 +171,15 @@
 
  /** @} */
 
+/** \name DSP Command: Debug statistics
+ *  @{
+ */
+
+#define SOF_IPC_DEBUG_LL_STATS			SOF_CMD_TYPE(0x001)
+#define SOF_IPC_DEBUG_MEM_STATS			SOF_CMD_TYPE(0x002)
+
+/** @} */
+
 /** \name DSP Command: Test - Debug build only
  *  @{
  */
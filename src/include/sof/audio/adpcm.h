@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+/**
+ * \file include/sof/audio/adpcm.h
+ * \brief Block IMA ADPCM codec
+ *
+ * Interleaved frames are coded in independent blocks of
+ * ADPCM_BLOCK_FRAMES. Each block starts with the predictor and step
+ * index of every channel so decoding can start at any block. Samples
+ * are coded with 16 bit precision, 24 and 32 bit samples are rounded
+ * to their 16 most significant bits.
+ */
+
+#ifndef __SOF_AUDIO_ADPCM_H__
+#define __SOF_AUDIO_ADPCM_H__
+
+#include <stdint.h>
+
+/** \brief Frames in one coded block */
+#define ADPCM_BLOCK_FRAMES	64
+
+/** \brief Bytes of the per channel block header */
+#define ADPCM_HEADER_BYTES	4
+
+/** \brief Size of one coded block in bytes */
+#define ADPCM_BLOCK_BYTES(channels) \
+	((channels) * (ADPCM_HEADER_BYTES + ADPCM_BLOCK_FRAMES / 2))
+
+/** \brief Encoder state of one channel */
+struct adpcm_state {
+	int16_t predictor;	/**< last reconstructed sample */
+	uint8_t index;		/**< step size index */
+};
+
+/**
+ * \brief Encodes ADPCM_BLOCK_FRAMES interleaved frames.
+ * \param[in,out] state Encoder states of channels, carried over blocks.
+ * \param[in] src Frames with samples in 16 or 32 bit containers.
+ * \param[in] sample_width Sample width in bits, 16, 24 or 32.
+ * \param[in] channels Number of channels.
+ * \param[out] block Coded block of ADPCM_BLOCK_BYTES(channels).
+ */
+void adpcm_encode_block(struct adpcm_state *state, const void *src,
+			int sample_width, int channels, uint8_t *block);
+
+/**
+ * \brief Decodes one block to ADPCM_BLOCK_FRAMES interleaved frames.
+ * \param[in] block Coded block of ADPCM_BLOCK_BYTES(channels).
+ * \param[in] sample_width Sample width in bits, 16, 24 or 32.
+ * \param[in] channels Number of channels.
+ * \param[out] dst Frames with samples in 16 or 32 bit containers.
+ */
+void adpcm_decode_block(const uint8_t *block, int sample_width,
+			int channels, void *dst);
+
+#endif /* __SOF_AUDIO_ADPCM_H__ */
@@ -42,10 +42,26 @@
 #define IAS_SRC_FARROW_H
 
 #include <sof/audio/component.h>
+#include <sof/audio/asrc/asrc_config.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/*
+ * @brief Number of output frames the block kernels compute at once.
+ *
+ * The ring buffers keep this many input frames of history in addition
+ * to the filter length, so the impulse responses and the filtering of
+ * the output frames can be deferred until a block is complete.
+ */
+#define ASRC_BLOCK_FRAMES	8
+
+/*
+ * @brief Number of output frames to ramp the conversion ratios to a
+ * new clock drift estimate.
+ */
+#define ASRC_DRIFT_RAMP_FRAMES	64
+
 /*
  * @brief Define whether the input and output buffers shall be
  * interleaved or not.
@@ -215,6 +231,27 @@ struct asrc_farrow {
 					/*!< secondary side during one */
 					/*!< control loop */
 
+	/* + drift ramp */
+	uint32_t fs_ratio_target;	/*!< Conversion ratio at the end of */
+					/*!< the ramp (5q27) */
+	uint32_t fs_ratio_inv_target;	/*!< Reciprocal conversion ratio */
+					/*!< at the end of the ramp (5q27) */
+	int32_t fs_ratio_step;		/*!< Ratio change per output frame */
+	int32_t fs_ratio_inv_step;	/*!< Reciprocal ratio change per */
+					/*!< output frame */
+	int ramp_frames;		/*!< Output frames left in the ramp */
+
+	/* + block processing */
+	int block_count;	/*!< Number of pending output frames */
+	int block_writes;	/*!< Input frames written after the first */
+				/*!< pending output frame */
+	int block_pos[ASRC_BLOCK_FRAMES]; /*!< Ring buffer write position */
+					  /*!< of the pending frames */
+	int block_out[ASRC_BLOCK_FRAMES]; /*!< Output index of the */
+					  /*!< pending frames */
+	int32_t block_time[ASRC_BLOCK_FRAMES]; /*!< Time value of the */
+					       /*!< pending frames (5q27) */
+
 	/* + function pointer */
 	void (*calc_ir)(struct asrc_farrow *src_obj);	/*!< Pointer */
 	/*!< to the function which calculates the impulse response */
@@ -290,6 +327,17 @@ enum asrc_error_code asrc_initialise(struct comp_dev *dev,
 				     enum asrc_control_mode control_mode,
 				     enum asrc_operation_mode operation_mode);
 
+/*
+ * @brief Releases the filter coefficients of the ias_src_farrow.
+ *
+ * This function should be called before the memory of the instance is
+ * freed. The coefficients are shared with the instances of the same
+ * conversion and freed when the last one releases them.
+ *
+ * @param[in] src_obj        Pointer to the ias_src_farrow.
+ */
+void asrc_release(struct asrc_farrow *src_obj);
+
 /*
  * @brief Process the sample rate converter for one frame; the frame
  *        consists of @p input_num_frames samples within @p num_channels
@@ -535,6 +583,44 @@ enum asrc_error_code asrc_process_pull32(struct comp_dev *dev,
 					 int write_index,
 					 int *read_index);
 
+#if ASRC_GENERIC
+/*
+ * @brief Block version of process_push16() and process_push32().
+ *
+ * The output frames are computed in blocks of ASRC_BLOCK_FRAMES. The
+ * polynomial of the Farrow filter is evaluated for all the frames of a
+ * block at once and the block is filtered for all channels at once.
+ * The output is identical to process_push16() and process_push32().
+ * The buffers are int16_t or int32_t depending on the bit depth, only
+ * the feedback control mode is supported.
+ *
+ * See process_push32() for the parameters.
+ */
+enum asrc_error_code asrc_process_push_block(struct comp_dev *dev,
+					     struct asrc_farrow *src_obj,
+					     void **__restrict input_buffers,
+					     int input_num_frames,
+					     void **__restrict output_buffers,
+					     int *output_num_frames,
+					     int *write_index,
+					     int read_index);
+
+/*
+ * @brief Block version of process_pull16() and process_pull32().
+ *
+ * See asrc_process_push_block() for the block processing and
+ * process_pull32() for the parameters.
+ */
+enum asrc_error_code asrc_process_pull_block(struct comp_dev *dev,
+					     struct asrc_farrow *src_obj,
+					     void **__restrict input_buffers,
+					     int *input_num_frames,
+					     void **__restrict output_buffers,
+					     int output_num_frames,
+					     int write_index,
+					     int *read_index);
+#endif
+
 /*
  * @brief Updates the clock drift
  *
@@ -656,4 +742,22 @@ void asrc_calc_impulse_response_n5(struct asrc_farrow *src_obj);
 void asrc_calc_impulse_response_n6(struct asrc_farrow *src_obj);
 void asrc_calc_impulse_response_n7(struct asrc_farrow *src_obj);
 
+#if ASRC_GENERIC
+/*
+ * Calculates the impulse responses of the pending block frames. The
+ * responses are stored tap by tap, impulse_response[n *
+ * ASRC_BLOCK_FRAMES + k] is tap n of the frame k.
+ */
+void asrc_calc_impulse_response_block(struct asrc_farrow *src_obj);
+
+/*
+ * Filter the ring buffer values of the pending block frames with the
+ * block impulse responses.
+ */
+void asrc_fir_filter16_block(struct asrc_farrow *src_obj,
+			     int16_t **output_buffers);
+void asrc_fir_filter32_block(struct asrc_farrow *src_obj,
+			     int32_t **output_buffers);
+#endif
+
 #endif /* IAS_SRC_FARROW_H */
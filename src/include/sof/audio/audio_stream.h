@@ -165,13 +165,23 @@ struct audio_stream {
  * @param buffer Buffer.
  * @param params Parameters (frame format, rate, number of channels).
  * @return 0 if succeeded, error code otherwise.
+ *
+ * The buffer size must be a multiple of the frame size of the new
+ * parameters, so that the wrap-free span helpers never see a partial frame
+ * before the wrap point.
  */
 static inline int audio_stream_set_params(struct audio_stream *buffer,
 					  struct sof_ipc_stream_params *params)
 {
+	uint32_t frame_bytes;
+
 	if (!params)
 		return -EINVAL;
 
+	frame_bytes = get_frame_bytes(params->frame_fmt, params->channels);
+	if (frame_bytes && buffer->size % frame_bytes)
+		return -EINVAL;
+
 	buffer->frame_fmt = params->frame_fmt;
 	buffer->rate = params->rate;
 	buffer->channels = params->channels;
@@ -272,6 +282,21 @@ audio_stream_get_avail_frames(const struct audio_stream *stream)
 		audio_stream_frame_bytes(stream);
 }
 
+/**
+ * Calculates the readable window in bytes from the read pointer for
+ * components that consume a variable amount of data per copy.
+ * @param stream Stream pointer
+ * @param frames Maximum number of frames the component reads
+ * @return bytes the component can read, limited by available data
+ */
+static inline uint32_t
+audio_stream_get_readable_bytes(const struct audio_stream *stream,
+				uint32_t frames)
+{
+	return MIN(frames * audio_stream_frame_bytes(stream),
+		   audio_stream_get_avail_bytes(stream));
+}
+
 /**
  * Calculates free space in bytes, handling overrun_permitted behaviour
  * @param stream Stream pointer
@@ -526,6 +551,103 @@ audio_stream_bytes_without_wrap(const struct audio_stream *source,
 	return to_end;
 }
 
+/**
+ * Calculates number of signed 16-bit samples to buffer wrap.
+ * @param source Stream to get information from.
+ * @param ptr Read or write pointer from source.
+ * @return Number of samples to buffer wrap.
+ */
+static inline int
+audio_stream_samples_without_wrap_s16(const struct audio_stream *source,
+				      const void *ptr)
+{
+	return audio_stream_bytes_without_wrap(source, ptr) >> 1;
+}
+
+/**
+ * Calculates number of signed 32-bit (or 24-bit in 32-bit container)
+ * samples to buffer wrap.
+ * @param source Stream to get information from.
+ * @param ptr Read or write pointer from source.
+ * @return Number of samples to buffer wrap.
+ */
+static inline int
+audio_stream_samples_without_wrap_s32(const struct audio_stream *source,
+				      const void *ptr)
+{
+	return audio_stream_bytes_without_wrap(source, ptr) >> 2;
+}
+
+/**
+ * Calculates number of whole frames to buffer wrap.
+ * @param source Stream to get information from.
+ * @param ptr Read or write pointer from source.
+ * @return Number of frames to buffer wrap.
+ *
+ * @note audio_stream_set_params() and buffer_set_size() keep the buffer size
+ *	 a multiple of frame size and the pointers move in whole frames, so a
+ *	 frame never straddles the wrap point. Loops stop on a zero span
+ *	 instead of spinning if that is ever broken.
+ */
+static inline int
+audio_stream_frames_without_wrap(const struct audio_stream *source,
+				 const void *ptr)
+{
+	return audio_stream_bytes_without_wrap(source, ptr) /
+		audio_stream_frame_bytes(source);
+}
+
+/**
+ * Calculates the largest span of samples that can be read from source and
+ * written to sink at the given positions without wrap in either buffer.
+ * @param source Source stream.
+ * @param src_ptr Position in source to start reading from.
+ * @param sink Sink stream.
+ * @param snk_ptr Position in sink to start writing to.
+ * @param samples Number of samples still to be processed.
+ * @return Number of samples in the span, not more than samples.
+ *
+ * Components call this once per span and run the inner loop over plain
+ * pointers, then advance both pointers with audio_stream_wrap().
+ */
+static inline uint32_t
+audio_stream_span_samples(const struct audio_stream *source,
+			  const void *src_ptr,
+			  const struct audio_stream *sink,
+			  const void *snk_ptr, uint32_t samples)
+{
+	uint32_t n_src = audio_stream_bytes_without_wrap(source, src_ptr) /
+		audio_stream_sample_bytes(source);
+	uint32_t n_snk = audio_stream_bytes_without_wrap(sink, snk_ptr) /
+		audio_stream_sample_bytes(sink);
+
+	return MIN(samples, MIN(n_src, n_snk));
+}
+
+/**
+ * Calculates the largest span of frames that can be read from source and
+ * written to sink at the given positions without wrap in either buffer.
+ * @param source Source stream.
+ * @param src_ptr Position in source to start reading from.
+ * @param sink Sink stream.
+ * @param snk_ptr Position in sink to start writing to.
+ * @param frames Number of frames still to be processed.
+ * @return Number of frames in the span, not more than frames.
+ *
+ * @see audio_stream_span_samples().
+ */
+static inline uint32_t
+audio_stream_span_frames(const struct audio_stream *source,
+			 const void *src_ptr,
+			 const struct audio_stream *sink,
+			 const void *snk_ptr, uint32_t frames)
+{
+	uint32_t n_src = audio_stream_frames_without_wrap(source, src_ptr);
+	uint32_t n_snk = audio_stream_frames_without_wrap(sink, snk_ptr);
+
+	return MIN(frames, MIN(n_src, n_snk));
+}
+
 /**
  * Copies data from source buffer to sink buffer.
  * @param source Source buffer.
@@ -566,6 +688,73 @@ static inline void audio_stream_copy(const struct audio_stream *source,
 	}
 }
 
+/**
+ * Copies data from source buffer to linear memory.
+ * @param source Source buffer.
+ * @param ioffset_bytes Offset (in bytes) in source buffer to start reading
+ *	from.
+ * @param linear Linear memory to write to.
+ * @param bytes Number of bytes to copy.
+ */
+static inline void
+audio_stream_copy_to_linear(const struct audio_stream *source,
+			    uint32_t ioffset_bytes, void *linear,
+			    uint32_t bytes)
+{
+	void *src = audio_stream_wrap(source,
+				      (char *)source->r_ptr + ioffset_bytes);
+	uint32_t bytes_src;
+	uint32_t bytes_copied;
+	int ret;
+
+	while (bytes) {
+		bytes_src = audio_stream_bytes_without_wrap(source, src);
+		bytes_copied = MIN(bytes, bytes_src);
+
+		ret = memcpy_s(linear, bytes_copied, src, bytes_copied);
+		assert(!ret);
+
+		bytes -= bytes_copied;
+		src = (char *)src + bytes_copied;
+		linear = (char *)linear + bytes_copied;
+
+		src = audio_stream_wrap(source, src);
+	}
+}
+
+/**
+ * Copies data from linear memory to sink buffer.
+ * @param linear Linear memory to read from.
+ * @param sink Sink buffer.
+ * @param ooffset_bytes Offset (in bytes) in sink buffer to start writing to.
+ * @param bytes Number of bytes to copy.
+ */
+static inline void audio_stream_copy_from_linear(const void *linear,
+						 struct audio_stream *sink,
+						 uint32_t ooffset_bytes,
+						 uint32_t bytes)
+{
+	void *snk = audio_stream_wrap(sink,
+				      (char *)sink->w_ptr + ooffset_bytes);
+	uint32_t bytes_snk;
+	uint32_t bytes_copied;
+	int ret;
+
+	while (bytes) {
+		bytes_snk = audio_stream_bytes_without_wrap(sink, snk);
+		bytes_copied = MIN(bytes, bytes_snk);
+
+		ret = memcpy_s(snk, bytes_snk, linear, bytes_copied);
+		assert(!ret);
+
+		bytes -= bytes_copied;
+		linear = (const char *)linear + bytes_copied;
+		snk = (char *)snk + bytes_copied;
+
+		snk = audio_stream_wrap(sink, snk);
+	}
+}
+
 #if CONFIG_FORMAT_S16LE
 
 /**
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+/**
+ * \file include/sof/audio/coef_cache.h
+ * \brief Shared read-only filter coefficients cache
+ *
+ * Sample rate converters of the same conversion use identical filter
+ * coefficients. The cache keeps one reference counted copy of them per
+ * (type, fs_in, fs_out, quality) key in the fastest available memory,
+ * the copy is pinned until the last instance releases it.
+ */
+
+#ifndef __SOF_AUDIO_COEF_CACHE_H__
+#define __SOF_AUDIO_COEF_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** \brief Users of the cache */
+enum coef_cache_type {
+	COEF_CACHE_SRC = 0,	/**< SRC polyphase filter plan */
+	COEF_CACHE_ASRC,	/**< ASRC Farrow polyphase filters */
+};
+
+/** \brief Identifies a set of coefficients */
+struct coef_cache_key {
+	uint32_t type;		/**< enum coef_cache_type */
+	int32_t fs_in;		/**< input rate in Hz */
+	int32_t fs_out;		/**< output rate in Hz */
+	int32_t quality;	/**< user specific design quality */
+};
+
+/**
+ * \brief Creates the coefficients of a key on first request.
+ * \param[in] key Key of the coefficients.
+ * \param[in] arg User data passed to coef_cache_get().
+ * \param[out] size Size of the coefficients in bytes.
+ * \return Coefficients allocated with coef_cache_alloc() or NULL.
+ */
+typedef void *(*coef_cache_create)(const struct coef_cache_key *key,
+				   void *arg, size_t *size);
+
+/** \brief Initializes the cache, can be called multiple times. */
+void coef_cache_init(void);
+
+/**
+ * \brief Gets and pins the coefficients of a key.
+ * \param[in] key Key of the coefficients.
+ * \param[in] create Called when the key is not cached yet.
+ * \param[in] arg User data for create.
+ * \return Coefficients or NULL on failure.
+ */
+void *coef_cache_get(const struct coef_cache_key *key,
+		     coef_cache_create create, void *arg);
+
+/**
+ * \brief Releases coefficients returned by coef_cache_get().
+ * \param[in] data Coefficients, other pointers are ignored.
+ */
+void coef_cache_put(const void *data);
+
+/**
+ * \brief Allocates memory for cached coefficients.
+ * \param[in] bytes Size of the allocation.
+ * \return Pointer to the memory or NULL.
+ */
+void *coef_cache_alloc(size_t bytes);
+
+#endif /* __SOF_AUDIO_COEF_CACHE_H__ */
@@ -194,6 +194,34 @@ struct dai_hw_params;
 	trace_dev_dbg(trace_comp_get_tr_ctx, trace_comp_get_id,		\
 		      trace_comp_get_subid, comp_p, __e, ##__VA_ARGS__)
 
+/** \brief Rate limited trace error message from component device */
+#define comp_err_ratelimited(comp_p, __e, ...)				\
+	trace_dev_err_ratelimited(trace_comp_get_tr_ctx,		\
+				  trace_comp_get_id,			\
+				  trace_comp_get_subid, comp_p,		\
+				  __e, ##__VA_ARGS__)
+
+/** \brief Rate limited trace warning message from component device */
+#define comp_warn_ratelimited(comp_p, __e, ...)				\
+	trace_dev_warn_ratelimited(trace_comp_get_tr_ctx,		\
+				   trace_comp_get_id,			\
+				   trace_comp_get_subid, comp_p,	\
+				   __e, ##__VA_ARGS__)
+
+/** \brief Rate limited trace info message from component device */
+#define comp_info_ratelimited(comp_p, __e, ...)				\
+	trace_dev_info_ratelimited(trace_comp_get_tr_ctx,		\
+				   trace_comp_get_id,			\
+				   trace_comp_get_subid, comp_p,	\
+				   __e, ##__VA_ARGS__)
+
+/** \brief Rate limited trace debug message from component device */
+#define comp_dbg_ratelimited(comp_p, __e, ...)				\
+	trace_dev_dbg_ratelimited(trace_comp_get_tr_ctx,		\
+				  trace_comp_get_id,			\
+				  trace_comp_get_subid, comp_p,		\
+				  __e, ##__VA_ARGS__)
+
 #define comp_perf_info(pcd, comp_p)					\
 	comp_info(comp_p, "perf comp_copy peak plat %d cpu %d",		\
 		  (uint32_t)((pcd)->plat_delta_peak),			\
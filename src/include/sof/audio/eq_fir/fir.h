@@ -20,8 +20,21 @@
 struct comp_buffer;
 struct sof_eq_fir_coef_data;
 
+/* The generic FIR processes the channels in blocks of frames. The
+ * interleaved input block is loaded once into the delay lines of all
+ * channels and the outputs of all channels are written back interleaved.
+ */
+#define FIR_BLOCK_FRAMES	16
+
+/* The delay line of a channel has the taps - 1 history samples followed by
+ * space for this many blocks. The history is moved to the beginning of the
+ * delay line once the space is used.
+ */
+#define FIR_DELAY_BLOCKS	4
+#define FIR_DELAY_SPACE		(FIR_BLOCK_FRAMES * FIR_DELAY_BLOCKS)
+
 struct fir_state_32x16 {
-	int rwi; /* Circular read and write index */
+	int rwi; /* Delay line offset of history for next block */
 	int taps; /* Number of FIR taps */
 	int length; /* Number of FIR taps */
 	int out_shift; /* Amount of right shifts at output */
@@ -53,62 +66,47 @@ void eq_fir_s32(struct fir_state_32x16 *fir, const struct audio_stream *source,
 		struct audio_stream *sink, int frames, int nch);
 #endif /* CONFIG_FORMAT_S32LE */
 
-/* The next functions are inlined to optmize execution speed */
-
-static inline int32_t fir_32x16(struct fir_state_32x16 *fir, int32_t x)
+/* Get the delay line position for a block of n input samples. The history
+ * of taps - 1 samples precedes it.
+ */
+static inline int32_t *fir_block_input(struct fir_state_32x16 *fir, int n)
 {
-	int64_t y = 0;
-	int32_t *data = &fir->delay[fir->rwi];
-	int16_t *coef = &fir->coef[0];
-	int n1;
-	int n2;
-	int n;
-
-	/* Bypass is set with length set to zero. */
-	if (!fir->length)
-		return x;
-
-	/* Write sample to delay */
-	*data = x;
-
-	/* Advance write pointer and calculate into n1 max. number of taps
-	 * to process before circular wrap.
-	 */
-	n1 = ++fir->rwi;
-	if (fir->rwi == fir->length)
-		fir->rwi = 0;
+	int i;
 
-	/* Check if no need to un-wrap FIR data. */
-	if (n1 > fir->length) {
-		/* Data is Q1.31, coef is Q1.15, product is Q2.46 */
-		for (n = 0; n < fir->length; n++) {
-			y += (int64_t)(*coef) * (*data);
-			coef++;
-			data--;
-		}
+	if (fir->rwi + n > FIR_DELAY_SPACE) {
+		for (i = 0; i < fir->length - 1; i++)
+			fir->delay[i] = fir->delay[fir->rwi + i];
 
-		/* Q2.46 -> Q2.31, saturate to Q1.31 */
-		return sat_int32(y >> (15 + fir->out_shift));
+		fir->rwi = 0;
 	}
 
-	/* Part 1, loop n1 times */
-	for (n = 0; n < n1; n++) {
-		y += (int64_t)(*coef) * (*data);
-		coef++;
-		data--;
-	}
+	return &fir->delay[fir->rwi + fir->length - 1];
+}
+
+/* Compute n outputs from the block of input samples set with
+ * fir_block_input(). The next block history starts n samples later.
+ */
+static inline void fir_32x16_block(struct fir_state_32x16 *fir, int32_t *y,
+				   int n)
+{
+	const int32_t *x = &fir->delay[fir->rwi + fir->length - 1];
+	const int16_t *coef = fir->coef;
+	const int shift = 15 + fir->out_shift;
+	int64_t acc;
+	int i;
+	int k;
+
+	for (i = 0; i < n; i++) {
+		/* Data is Q1.31, coef is Q1.15, product is Q2.46 */
+		acc = 0;
+		for (k = 0; k < fir->length; k++)
+			acc += (int64_t)coef[k] * x[i - k];
 
-	/* Part 2, un-wrap data, continue n2 times */
-	n2 = fir->length - n1;
-	data = &fir->delay[fir->length - 1];
-	for (n = 0; n < n2; n++) {
-		y += (int64_t)(*coef) * (*data);
-		coef++;
-		data--;
+		/* Q2.46 -> Q2.31, saturate to Q1.31 */
+		y[i] = sat_int32(acc >> shift);
 	}
 
-	/* Q2.46 -> Q2.31, saturate to Q1.31 */
-	return sat_int32(y >> (15 + fir->out_shift));
+	fir->rwi += n;
 }
 
 #endif
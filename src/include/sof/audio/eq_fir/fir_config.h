@@ -58,4 +58,13 @@
 #endif
 #endif
 
+/* The partitioned FFT convolution for long responses is generic C. The host
+ * library build can optionally use the floating point variant of it.
+ */
+#if CONFIG_COMP_FIR_FFT_FLOAT
+#define FIR_FFT_FLOAT	1
+#else
+#define FIR_FFT_FLOAT	0
+#endif
+
 #endif /* __SOF_AUDIO_EQ_FIR_FIR_CONFIG_H__ */
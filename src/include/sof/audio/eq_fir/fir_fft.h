@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+#ifndef __SOF_AUDIO_EQ_FIR_FIR_FFT_H__
+#define __SOF_AUDIO_EQ_FIR_FIR_FFT_H__
+
+#include <sof/audio/eq_fir/fir_config.h>
+#include <stdint.h>
+
+struct audio_stream;
+struct sof_eq_fir_coef_data;
+
+/* Uniformly partitioned overlap-save convolution. The response is split into
+ * partitions of FIR_FFT_BLOCK_SIZE taps and the input is processed in blocks
+ * of the same size with a FFT of twice the block size. The output is delayed
+ * by one block.
+ */
+#define FIR_FFT_BLOCK_SIZE_LOG2	7
+#define FIR_FFT_BLOCK_SIZE	(1 << FIR_FFT_BLOCK_SIZE_LOG2)
+#define FIR_FFT_SIZE_LOG2	(FIR_FFT_BLOCK_SIZE_LOG2 + 1)
+#define FIR_FFT_SIZE		(1 << FIR_FFT_SIZE_LOG2)
+#define FIR_FFT_BINS		(FIR_FFT_BLOCK_SIZE + 1) /* 0 .. Nyquist */
+
+#if FIR_FFT_FLOAT
+
+struct fir_fft_complex {
+	float real;
+	float imag;
+};
+
+struct fir_fft_acc {
+	float real;
+	float imag;
+};
+
+#else
+
+struct fir_fft_complex {
+	int32_t real; /* Q1.31 */
+	int32_t imag; /* Q1.31 */
+};
+
+struct fir_fft_acc {
+	int64_t real; /* Q33.31 */
+	int64_t imag; /* Q33.31 */
+};
+
+#endif /* FIR_FFT_FLOAT */
+
+/* Scratch shared by all channels of one component */
+struct fir_fft_work {
+	struct fir_fft_complex buf[FIR_FFT_SIZE];
+	struct fir_fft_acc acc[FIR_FFT_BINS];
+	struct fir_fft_complex twiddle[FIR_FFT_SIZE / 2];
+};
+
+struct fir_fft_state {
+	int pos; /* Sample position in current block */
+	int partitions; /* Number of partitions, zero for bypass */
+	int fdl_idx; /* Newest input spectrum in frequency delay line */
+#if FIR_FFT_FLOAT
+	float scale; /* Output scale to Q1.31 */
+#else
+	int shift; /* Left shifts at output to Q1.31 */
+#endif
+	int out_shift; /* Amount of right shifts at output */
+	struct sof_eq_fir_coef_data *config; /* Pointer to response */
+	struct fir_fft_complex *coef; /* Spectra of response partitions */
+	struct fir_fft_complex *fdl; /* Spectra of past input blocks */
+	int32_t *in; /* Last two input blocks, Q1.31 */
+	int32_t *out; /* Output block, Q1.31 */
+};
+
+void fir_fft_reset(struct fir_fft_state *fft);
+
+int fir_fft_coef_size(struct sof_eq_fir_coef_data *config);
+
+int fir_fft_delay_size(struct sof_eq_fir_coef_data *config);
+
+void fir_fft_init_work(struct fir_fft_work *work);
+
+void fir_fft_init_coef(struct fir_fft_state *fft, struct fir_fft_work *work,
+		       struct sof_eq_fir_coef_data *config, void **data);
+
+void fir_fft_share_coef(struct fir_fft_state *fft,
+			const struct fir_fft_state *src);
+
+void fir_fft_init_delay(struct fir_fft_state *fft, void **data);
+
+void fir_fft_block(struct fir_fft_state *fft, struct fir_fft_work *work);
+
+#if CONFIG_FORMAT_S16LE
+void eq_fir_fft_s16(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch);
+#endif /* CONFIG_FORMAT_S16LE */
+
+#if CONFIG_FORMAT_S24LE
+void eq_fir_fft_s24(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch);
+#endif /* CONFIG_FORMAT_S24LE */
+
+#if CONFIG_FORMAT_S32LE
+void eq_fir_fft_s32(struct fir_fft_state fft[], struct fir_fft_work *work,
+		    struct audio_stream *sink, int frames, int nch);
+#endif /* CONFIG_FORMAT_S32LE */
+
+/* Filter one Q1.31 sample. The output is from the previous block. */
+static inline int32_t fir_fft_32(struct fir_fft_state *fft,
+				 struct fir_fft_work *work, int32_t x)
+{
+	int32_t y = fft->out[fft->pos];
+
+	fft->in[FIR_FFT_BLOCK_SIZE + fft->pos] = x;
+	if (++fft->pos == FIR_FFT_BLOCK_SIZE) {
+		fir_fft_block(fft, work);
+		fft->pos = 0;
+	}
+
+	return y;
+}
+
+#endif /* __SOF_AUDIO_EQ_FIR_FIR_FFT_H__ */
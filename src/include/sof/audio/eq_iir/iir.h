@@ -61,8 +61,27 @@ struct iir_state_df2t {
 	int64_t *delay; /* Pointer to IIR delay line */
 };
 
+/* The batched DF2T filters the channels that share the same response
+ * together. The delays are stored per element with one value per channel
+ * (lane) so that the same coefficient is applied to all lanes in a loop.
+ */
+#define IIR_BATCH_FRAMES	16
+#define IIR_BATCH_MAX_LANES	8
+
+struct iir_batch_df2t {
+	unsigned int lanes; /* Number of channels filtered together */
+	unsigned int biquads; /* Number of IIR 2nd order sections total */
+	unsigned int biquads_in_series; /* Number of IIR 2nd order sections
+					 * in series.
+					 */
+	int32_t *coef; /* Pointer to IIR coefficients */
+	int64_t *delay; /* Pointer to IIR delay lines of all lanes */
+};
+
 int32_t iir_df2t(struct iir_state_df2t *iir, int32_t x);
 
+void iir_batch_df2t(struct iir_batch_df2t *iir, int32_t *data, int frames);
+
 int iir_init_coef_df2t(struct iir_state_df2t *iir,
 		       struct sof_eq_iir_header_df2t *config);
 
@@ -76,4 +95,9 @@ void iir_unmute_df2t(struct iir_state_df2t *iir);
 
 void iir_reset_df2t(struct iir_state_df2t *iir);
 
+int iir_batch_init_df2t(struct iir_batch_df2t *iir,
+			struct iir_state_df2t *src, int lanes);
+
+void iir_batch_init_delay_df2t(struct iir_batch_df2t *iir, int64_t **delay);
+
 #endif /* __SOF_AUDIO_EQ_IIR_IIR_H__ */
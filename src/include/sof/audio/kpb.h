@@ -8,6 +8,8 @@
 #ifndef __SOF_AUDIO_KPB_H__
 #define __SOF_AUDIO_KPB_H__
 
+#include <sof/audio/adpcm.h>
+#include <sof/platform.h>
 #include <sof/trace/trace.h>
 #include <user/trace.h>
 #include <stdint.h>
@@ -16,22 +18,19 @@ struct comp_buffer;
 
 /* KPB internal defines */
 #define KPB_MAX_BUFF_TIME 2100 /**< time of buffering in miliseconds */
-#define KPB_MAX_SUPPORTED_CHANNELS 2 /**< number of supported channels */
+/**< number of supported channels */
+#define KPB_MAX_SUPPORTED_CHANNELS PLATFORM_MAX_CHANNELS
 /**< number of samples taken each milisecond */
 #define	KPB_SAMPLES_PER_MS (KPB_SAMPLNG_FREQUENCY / 1000)
 #define	KPB_SAMPLNG_FREQUENCY 16000 /**< supported sampling frequency in Hz */
-#define KPB_NUM_OF_CHANNELS 2
 #define KPB_SAMPLE_CONTAINER_SIZE(sw) ((sw == 16) ? 16 : 32)
-#define KPB_MAX_BUFFER_SIZE(sw) ((KPB_SAMPLNG_FREQUENCY / 1000) * \
+#define KPB_MAX_BUFFER_SIZE(sw, channels) ((KPB_SAMPLNG_FREQUENCY / 1000) * \
 	(KPB_SAMPLE_CONTAINER_SIZE(sw) / 8) * KPB_MAX_BUFF_TIME * \
-	KPB_NUM_OF_CHANNELS)
+	(channels))
 #define KPB_MAX_NO_OF_CLIENTS 2
 #define KPB_NO_OF_HISTORY_BUFFERS 2 /**< no of internal buffers */
 #define KPB_ALLOCATION_STEP 0x100
 #define KPB_NO_OF_MEM_POOLS 3
-#define KPB_BYTES_TO_FRAMES(bytes, sample_width) \
-	(bytes / ((KPB_SAMPLE_CONTAINER_SIZE(sample_width) / 8) * \
-	KPB_NUM_OF_CHANNELS))
 /**< Defines how much faster draining is in comparison to pipeline copy. */
 #define KPB_DRAIN_NUM_OF_PPL_PERIODS_AT_ONCE 2
 /**< Host buffer shall be at least two times bigger than history buffer. */
@@ -128,6 +127,20 @@ struct history_data {
 	struct history_buffer *c_hb; /**< current buffer used for writing */
 };
 
+/* History buffer codec data */
+struct kpb_codec {
+	int sample_width; /**< valid bits of samples */
+	struct adpcm_state state[KPB_MAX_SUPPORTED_CHANNELS]; /**< encoder */
+	void *pcm; /**< frames staged for the next block */
+	size_t pcm_bytes; /**< amount of staged frames in bytes */
+	size_t pcm_drained; /**< staged bytes already drained to host */
+	void *pcm_out; /**< frames of the drained block */
+	uint8_t *block; /**< block coded from the real time stream */
+	uint8_t *drain_block; /**< block read by the draining task */
+	size_t frames_bytes; /**< size of one block of frames */
+	size_t block_bytes; /**< size of one coded block */
+};
+
 #ifdef UNIT_TEST
 void sys_comp_kpb_init(void);
 #endif
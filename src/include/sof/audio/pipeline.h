@@ -58,6 +58,9 @@ extern struct tr_ctx pipe_tr;
 #define pipe_cl_dbg(__e, ...)						\
 	tr_dbg(&pipe_tr, __e, ##__VA_ARGS__)
 
+#define pipe_cl_dbg_ratelimited(__e, ...)				\
+	tr_dbg_ratelimited(&pipe_tr, __e, ##__VA_ARGS__)
+
 /* device tracing */
 #define pipe_err(pipe_p, __e, ...)					\
 	trace_dev_err(trace_pipe_get_tr_ctx, trace_pipe_get_id,		\
@@ -26,21 +26,32 @@ struct src_param {
 	int idx_in;
 	int idx_out;
 	int nch;
+	struct src_stage *stage1;
+	struct src_stage *stage2;
+	struct src_plan *plan;
 };
 
 struct src_stage {
-	const int idm;
-	const int odm;
-	const int num_of_subfilters;
-	const int subfilter_length;
-	const int filter_length;
-	const int blk_in;
-	const int blk_out;
-	const int halfband;
-	const int shift;
+	int idm;
+	int odm;
+	int num_of_subfilters;
+	int subfilter_length;
+	int filter_length;
+	int blk_in;
+	int blk_out;
+	int halfband;
+	int shift;
 	const void *coefs; /* Can be int16_t or int32_t depending on config */
 };
 
+/* Stages of a conversion shared by the instances in coef_cache, the
+ * coefficients of both stages follow in the same allocation.
+ */
+struct src_plan {
+	struct src_stage stage1;
+	struct src_stage stage2;
+};
+
 struct src_state {
 	int fir_delay_size;	/* samples */
 	int out_delay_size;	/* samples */
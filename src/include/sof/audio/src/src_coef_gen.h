@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+#ifndef __SOF_AUDIO_SRC_SRC_COEF_GEN_H__
+#define __SOF_AUDIO_SRC_SRC_COEF_GEN_H__
+
+#include <sof/audio/src/src.h>
+
+/* Largest interpolation or decimation factor of a designed stage */
+#define SRC_COEF_GEN_MAX_LM		128
+
+/* Largest designed polyphase filter length */
+#define SRC_COEF_GEN_MAX_LENGTH		4096
+
+/*
+ * Designs the polyphase stages for conversion fs_in to fs_out with the
+ * same Kaiser window method as tools/tune/src uses for the precomputed
+ * coefficients. The quality is the passband as fraction of the lower
+ * rate times 1e4. The stages are released with src_coef_gen_free().
+ */
+int src_coef_gen_design(int fs_in, int fs_out, int quality,
+			struct src_stage **stage1, struct src_stage **stage2);
+
+void src_coef_gen_free(struct src_stage *stage);
+
+#endif /* __SOF_AUDIO_SRC_SRC_COEF_GEN_H__ */
@@ -51,6 +51,23 @@ struct sof_ipc_ctrl_value_chan;
  */
 #define VOL_RAMP_UPDATE_US 1000
 
+/**
+ * \brief Number of frames processed with one gain block.
+ * Generic kernels repeat channel gains for this many frames so the inner
+ * loop runs over contiguous interleaved samples.
+ */
+#define VOL_BLOCK_FRAMES 4
+
+/** \brief Gain block size in samples for maximum number of channels. */
+#define VOL_BLOCK_SAMPLES (VOL_BLOCK_FRAMES * SOF_IPC_MAX_CHANNELS)
+
+/**
+ * \brief Additional fractional bits of per frame ramped gain.
+ * Ramp gain is Q8.24 to represent slopes smaller than one Q8.16 step
+ * per frame.
+ */
+#define VOL_RAMP_FRAC_BITS 8
+
 /**
  * \brief Volume maximum value.
  * TODO: This should be 1 << (VOL_QX_BITS + VOL_QY_BITS - 1) - 1 but
@@ -89,6 +106,8 @@ struct comp_data {
 	int32_t mvolume[SOF_IPC_MAX_CHANNELS];	/**< mute volume */
 	int32_t rvolume[SOF_IPC_MAX_CHANNELS];	/**< ramp start volume */
 	int32_t ramp_coef[SOF_IPC_MAX_CHANNELS]; /**< parameter for slope */
+	/** gain at start of currently ramped chunk */
+	int32_t vol_ramp_start[SOF_IPC_MAX_CHANNELS];
 	int32_t vol_min;			/**< minimum volume */
 	int32_t vol_max;			/**< maximum volume */
 	int32_t	vol_ramp_range;			/**< max ramp transition */
@@ -101,6 +120,7 @@ struct comp_data {
 	bool vol_ramp_active;			/**< set if volume is ramped */
 	bool ramp_finished;			/**< control ramp launch */
 	vol_scale_func scale_vol;	/**< volume processing function */
+	vol_scale_func ramp_vol;	/**< volume ramp processing function */
 	vol_zc_func zc_get; /**< function getting nearest zero crossing frame */
 };
 
@@ -108,6 +128,7 @@ struct comp_data {
 struct comp_func_map {
 	uint16_t frame_fmt;	/**< frame format */
 	vol_scale_func func;	/**< volume processing function */
+	vol_scale_func ramp_func; /**< volume ramp processing function */
 };
 
 /** \brief Map of formats with dedicated processing functions. */
@@ -145,6 +166,30 @@ static inline vol_scale_func vol_get_processing_function(struct comp_dev *dev)
 	return NULL;
 }
 
+/**
+ * \brief Retrievies volume ramp processing function.
+ * \param[in,out] dev Volume base component device.
+ * \return Function ramping gain per frame from vol_ramp_start to volume,
+ *	   NULL if not available and gain is stepped per chunk instead.
+ */
+static inline vol_scale_func vol_get_ramp_function(struct comp_dev *dev)
+{
+	struct comp_buffer *sinkb;
+	int i;
+
+	sinkb = list_first_item(&dev->bsink_list, struct comp_buffer,
+				source_list);
+
+	for (i = 0; i < func_count; i++) {
+		if (sinkb->stream.frame_fmt != func_map[i].frame_fmt)
+			continue;
+
+		return func_map[i].ramp_func;
+	}
+
+	return NULL;
+}
+
 #ifdef UNIT_TEST
 void sys_comp_volume_init(void);
 #endif
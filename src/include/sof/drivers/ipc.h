@@ -62,11 +62,15 @@ extern struct tr_ctx ipc_tr;
 	tr_err(ctx, "ipc: size %d expected %d",		\
 	       (object).hdr.size, sizeof(object))
 
+/* number of hash buckets for component devices, must be a power of 2 */
+#define IPC_COMP_HASH_SIZE	32
+
 /* IPC generic component device */
 struct ipc_comp_dev {
 	uint16_t type;	/* COMP_TYPE_ */
 	uint16_t core;
 	uint32_t id;
+	uint32_t heap_bytes;	/* heap bytes at creation only */
 
 	/* component type data */
 	union {
@@ -77,6 +81,7 @@ struct ipc_comp_dev {
 
 	/* lists */
 	struct list_item list;		/* list in components */
+	struct list_item hash_list;	/* list in components hash bucket */
 };
 
 struct ipc_msg {
@@ -97,6 +102,7 @@ struct ipc {
 	bool is_notification_pending;	/* notification is being sent to host */
 
 	struct list_item comp_list;	/* list of component devices */
+	struct list_item comp_hash[IPC_COMP_HASH_SIZE];	/* devices by id */
 
 	/* processing task */
 	struct task ipc_task;
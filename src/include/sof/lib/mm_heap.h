@@ -12,6 +12,7 @@
 #include <sof/common.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/cache.h>
+#include <sof/lib/cpu.h>
 #include <sof/lib/memory.h>
 #include <sof/sof.h>
 #include <sof/spinlock.h>
@@ -21,10 +22,12 @@
 
 struct dma_copy;
 struct dma_sg_config;
+struct sof_ipc_dbg_mem_stats;
 
 struct mm_info {
 	uint32_t used;
 	uint32_t free;
+	uint32_t used_max;	/* high-water mark of used */
 };
 
 struct block_hdr {
@@ -39,6 +42,7 @@ struct block_map {
 	uint16_t free_count;	/* number of free blocks */
 	uint16_t first_free;	/* index of first free block */
 	struct block_hdr *block;	/* base block header */
+	uint32_t *free_mask;	/* free bit per block, allocated on init */
 	uint32_t base;		/* base address of space */
 };
 
@@ -55,6 +59,32 @@ struct mm_heap {
 	struct mm_info info;
 };
 
+#if CONFIG_MM_MAGAZINE
+/* number of smallest runtime heap block sizes cached per core */
+#define MM_MAGAZINE_CLASSES	4
+
+/* recently freed runtime heap blocks of one core */
+struct mm_magazine {
+	void *block[MM_MAGAZINE_CLASSES][CONFIG_MM_MAGAZINE_DEPTH];
+	uint16_t count[MM_MAGAZINE_CLASSES];	/* cached blocks per size */
+	uint32_t bytes;		/* size of cached blocks */
+	uint32_t hits;		/* allocations served from the cache */
+	uint32_t misses;	/* allocations passed on to the heap */
+	spinlock_t lock;	/* taken by other cores only to drain it */
+};
+#endif
+
+/* number of caps sets with separately counted allocation failures */
+#define MM_ALLOC_FAIL_CAPS	8
+
+struct mm_alloc_fail {
+	uint32_t caps;		/* requested caps */
+	uint32_t count;		/* failed allocations */
+};
+
+/* number of heaps that blocks can be freed to */
+#define MM_HEAP_INDEX_SIZE	(PLATFORM_HEAP_RUNTIME + PLATFORM_HEAP_BUFFER)
+
 /* heap block memory map */
 struct mm {
 	/* system heap - used during init cannot be freed */
@@ -66,6 +96,18 @@ struct mm {
 	/* general component buffer heap */
 	struct mm_heap buffer[PLATFORM_HEAP_BUFFER];
 
+	/* runtime and buffer heaps sorted by base address */
+	struct mm_heap *heap_index[MM_HEAP_INDEX_SIZE];
+
+#if CONFIG_MM_MAGAZINE
+	/* per core caches in front of the runtime heap */
+	struct mm_magazine magazine[PLATFORM_CORE_COUNT];
+#endif
+
+	/* failed allocations, all and by requested caps */
+	uint32_t alloc_fail_count;
+	struct mm_alloc_fail alloc_fail[MM_ALLOC_FAIL_CAPS];
+
 	struct mm_info total;
 	uint32_t heap_trace_updated;	/* updates that can be presented */
 	spinlock_t lock;	/* all allocs and frees are atomic */
@@ -82,10 +124,19 @@ void init_heap(struct sof *sof);
 /* frees entire heap (supported for slave core system heap atm) */
 void free_heap(enum mem_zone zone);
 
+/* returns runtime heap blocks cached by core, which must not allocate */
+void heap_magazine_drain(int core);
+
 /* status */
 void heap_trace_all(int force);
 void heap_trace(struct mm_heap *heap, int size);
 
+/* bytes used in the system runtime, runtime and buffer heaps */
+uint32_t heap_used_bytes(void);
+
+/* fills stats with the heap elements of stats->type from stats->first on */
+void heap_stats(struct sof_ipc_dbg_mem_stats *stats, uint32_t max_size);
+
 /* retrieve memory map pointer */
 static inline struct mm *memmap_get(void)
 {
@@ -20,6 +20,10 @@
 
 struct edf_task_pdata {
 	void *ctx;
+	uint64_t deadline;	/* ready queue key, sampled when queued */
+	uint32_t order;		/* queueing order among equal deadlines */
+	uint32_t heap_index;	/* position in ready queue */
+	uint32_t deadline_misses;	/* completions after deadline */
 };
 
 int scheduler_init_edf(void);
@@ -16,9 +16,11 @@
 #include <sof/schedule/task.h>
 #include <sof/trace/trace.h>
 #include <user/trace.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 struct ll_schedule_domain;
+struct sof_ipc_dbg_ll_stats;
 
 /* ll tracing */
 extern struct tr_ctx ll_tr;
@@ -30,6 +32,14 @@ extern struct tr_ctx ll_tr;
 
 struct ll_task_pdata {
 	uint64_t period;
+	bool queued;		/* task is in the scheduler queue */
+
+	/* execution statistics in platform timer ticks */
+	uint32_t exec_count;
+	uint32_t exec_min;
+	uint32_t exec_max;
+	uint64_t exec_total;
+	uint32_t overruns;	/* executions longer than period */
 };
 
 int scheduler_init_ll(struct ll_schedule_domain *domain);
@@ -39,4 +49,13 @@ int schedule_task_init_ll(struct task *task,
 			  enum task_state (*run)(void *data), void *data,
 			  uint16_t core, uint32_t flags);
 
+/**
+ * \brief Appends statistics of tasks queued by LL scheduler on this core.
+ * \param[in] type SOF_SCHEDULE_ type of the LL scheduler.
+ * \param[in,out] stats Reply to append task statistics to.
+ * \param[in] max_size Maximum number of bytes available in reply.
+ */
+void schedule_ll_stats(uint16_t type, struct sof_ipc_dbg_ll_stats *stats,
+		       uint32_t max_size);
+
 #endif /* __SOF_SCHEDULE_LL_SCHEDULE_H__ */
@@ -13,8 +13,10 @@
 #include <sof/sof.h>
 #include <sof/spinlock.h>
 #include <ipc/trace.h>
+#include <config.h>
 #include <stdint.h>
 
+struct dma_trace_ring;
 struct ipc_msg;
 struct sof;
 
@@ -43,6 +45,9 @@ struct dma_trace_data {
 				   *  copied by dma connected to host
 				   */
 	uint32_t dropped_entries; /* amount of dropped entries */
+#if CONFIG_TRACE_STAGING
+	struct dma_trace_ring *ring; /* staging rings of all cores */
+#endif
 	spinlock_t lock; /* dma trace lock */
 };
 
@@ -19,6 +19,7 @@
 #include <platform/trace/trace.h>
 #endif
 #include <sof/common.h>
+#include <sof/lib/memory.h>
 #include <sof/sof.h>
 #include <sof/trace/preproc.h>
 #include <config.h>
@@ -86,8 +87,30 @@ static inline struct trace *trace_get(void)
 #define trace_unused(class, ctx, id_1, id_2, format, ...) \
 	UNUSED(ctx, id_1, id_2, ##__VA_ARGS__)
 
+/** \brief State of one rate limited trace call site. */
+struct trace_ratelimit {
+	uint64_t window_end;	/**< end of the current window in ticks */
+	uint32_t events;	/**< traces sent in the current window */
+	uint32_t suppressed;	/**< traces dropped since the last sent */
+};
+
 #if CONFIG_TRACE
 
+/*
+ * Highest log level compiled in. A source file can lower it for itself
+ * by defining TRACE_LEVEL_LOCAL, either before including any header or
+ * as a compile definition of the file, e.g. LOG_LEVEL_WARNING to keep
+ * only warnings and errors. Trace calls above the level are removed
+ * together with their arguments and log entries.
+ */
+#if defined(TRACE_LEVEL_LOCAL) && TRACE_LEVEL_LOCAL < CONFIG_TRACE_LEVEL
+#define _TRACE_LEVEL_COMPILED	TRACE_LEVEL_LOCAL
+#else
+#define _TRACE_LEVEL_COMPILED	CONFIG_TRACE_LEVEL
+#endif
+
+#define _TRACE_LEVEL_ENABLED(lvl)	((lvl) <= _TRACE_LEVEL_COMPILED)
+
 /*
  * trace_event macro definition
  *
@@ -124,6 +147,15 @@ static inline struct trace *trace_get(void)
 				     ctx, id_1, id_2,			\
 				     format, ##__VA_ARGS__)
 
+#define trace_event_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					 ...)				\
+	_log_message_ratelimited(false, LOG_LEVEL_INFO, class, ctx,	\
+				 id_1, id_2, format, ##__VA_ARGS__)
+
+#define trace_warn_ratelimited_with_ids(class, ctx, id_1, id_2, format, ...) \
+	_log_message_ratelimited(false, LOG_LEVEL_WARNING, class, ctx,	     \
+				 id_1, id_2, format, ##__VA_ARGS__)
+
 void trace_flush(void);
 void trace_on(void);
 void trace_off(void);
@@ -131,6 +163,9 @@ void trace_init(struct sof *sof);
 void trace_log(bool send_atomic, const void *log_entry,
 	       const struct tr_ctx *ctx, uint32_t lvl, uint32_t id_1,
 	       uint32_t id_2, int arg_count, ...);
+bool trace_ratelimit_pass(struct trace_ratelimit *rl,
+			  const struct tr_ctx *ctx, uint32_t lvl,
+			  uint32_t *suppressed);
 
 #define _trace_event_with_ids(lvl, class, ctx, id_1, id_2, format, ...)	\
 	_log_message(false, lvl, class, ctx, id_1, id_2,		\
@@ -173,15 +208,41 @@ _thrown_from_macro_BASE_LOG_in_trace_h
 #define _log_message(atomic, lvl, comp_class, ctx, id_1, id_2,		\
 		     format, ...)					\
 do {									\
-	_DECLARE_LOG_ENTRY(lvl, format, comp_class,			\
-			   PP_NARG(__VA_ARGS__));			\
 	STATIC_ASSERT(							\
 		_TRACE_EVENT_MAX_ARGUMENT_COUNT >=			\
 			META_COUNT_VARAGS_BEFORE_COMPILE(__VA_ARGS__),	\
 		BASE_LOG_ASSERT_FAIL_MSG				\
 	);								\
-	trace_log(atomic, &log_entry, ctx, lvl, id_1, id_2,		\
-		  PP_NARG(__VA_ARGS__), ##__VA_ARGS__);			\
+	if (_TRACE_LEVEL_ENABLED(lvl)) {				\
+		_DECLARE_LOG_ENTRY(lvl, format, comp_class,		\
+				   PP_NARG(__VA_ARGS__));		\
+		trace_log(atomic, &log_entry, ctx, lvl, id_1, id_2,	\
+			  PP_NARG(__VA_ARGS__), ##__VA_ARGS__);		\
+	}								\
+} while (0)
+
+/*
+ * Sends at most CONFIG_TRACE_RATELIMIT_BURST traces of the call site per
+ * CONFIG_TRACE_RATELIMIT_MS window. The first trace sent after dropping
+ * some is preceded by one record with the number of dropped traces.
+ * The state is shared by all cores, so the counts are approximate.
+ */
+#define _log_message_ratelimited(atomic, lvl, comp_class, ctx, id_1,	\
+				 id_2, format, ...)			\
+do {									\
+	static SHARED_DATA struct trace_ratelimit _rl;			\
+	uint32_t _suppressed;						\
+									\
+	if (_TRACE_LEVEL_ENABLED(lvl) &&				\
+	    trace_ratelimit_pass(&_rl, ctx, lvl, &_suppressed)) {	\
+		if (_suppressed)					\
+			_log_message(atomic, lvl, comp_class, ctx,	\
+				     id_1, id_2,			\
+				     "%u repeats of next trace suppressed", \
+				     _suppressed);			\
+		_log_message(atomic, lvl, comp_class, ctx, id_1, id_2,	\
+			     format, ##__VA_ARGS__);			\
+	}								\
 } while (0)
 
 #else /* CONFIG_LIBRARY */
@@ -202,6 +263,8 @@ do {									\
 	}								\
 } while (0)
 
+#define _log_message_ratelimited(...) _log_message(__VA_ARGS__)
+
 #endif /* CONFIG_LIBRARY */
 
 #else /* CONFIG_TRACE */
@@ -216,6 +279,12 @@ do {									\
 #define trace_warn_atomic_with_ids(class, ctx, id_1, id_2, format, ...)	\
 	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 
+#define trace_event_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					 ...)				\
+	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
+#define trace_warn_ratelimited_with_ids(class, ctx, id_1, id_2, format, ...) \
+	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
+
 #define trace_point(x)  do {} while (0)
 
 static inline void trace_flush(void) { }
@@ -237,11 +306,19 @@ static inline void trace_init(struct sof *sof) { }
 				     ctx, id_1, id_2,			  \
 				     format, ##__VA_ARGS__)
 
+#define tracev_event_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					  ...)				  \
+	_log_message_ratelimited(false, LOG_LEVEL_VERBOSE, class, ctx,	  \
+				 id_1, id_2, format, ##__VA_ARGS__)
+
 #else /* CONFIG_TRACEV */
 #define tracev_event_with_ids(class, ctx, id_1, id_2, format, ...)	\
 	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 #define tracev_event_atomic_with_ids(class, ctx, id_1, id_2, format, ...) \
 	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
+#define tracev_event_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					  ...)				  \
+	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 
 #endif /* CONFIG_TRACEV */
 
@@ -253,15 +330,24 @@ static inline void trace_init(struct sof *sof) { }
 #define trace_error_with_ids(class, ctx, id_1, id_2, format, ...)	\
 	_trace_error_with_ids(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 #define trace_error_atomic_with_ids(...) trace_error_with_ids(__VA_ARGS__)
+#define trace_error_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					 ...)				 \
+	_log_message_ratelimited(true, LOG_LEVEL_CRITICAL, class, ctx,	 \
+				 id_1, id_2, format, ##__VA_ARGS__)
 #elif CONFIG_TRACE
 #define trace_error_with_ids(...) trace_event_with_ids(__VA_ARGS__)
 #define trace_error_atomic_with_ids(...) \
 	trace_event_atomic_with_ids(__VA_ARGS__)
+#define trace_error_ratelimited_with_ids(...) \
+	trace_event_ratelimited_with_ids(__VA_ARGS__)
 #else /* CONFIG_TRACEE CONFIG_TRACE */
 #define trace_error_with_ids(class, ctx, id_1, id_2, format, ...)	\
 	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 #define trace_error_atomic_with_ids(class, ctx, id_1, id_2, format, ...) \
 	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
+#define trace_error_ratelimited_with_ids(class, ctx, id_1, id_2, format, \
+					 ...)				 \
+	trace_unused(class, ctx, id_1, id_2, format, ##__VA_ARGS__)
 #endif /* CONFIG_TRACEE CONFIG_TRACE */
 
 #define _TRACE_INV_CLASS	TRACE_CLASS_DEPRECATED
@@ -327,6 +413,35 @@ struct tr_ctx {
 			      get_ctx_m(dev), get_id_m(dev),		\
 			      get_subid_m(dev), fmt, ##__VA_ARGS__)
 
+/** \brief Rate limited trace from a device on err level. */
+#define trace_dev_err_ratelimited(get_ctx_m, get_id_m, get_subid_m, dev, \
+				  fmt, ...)				 \
+	trace_error_ratelimited_with_ids(_TRACE_INV_CLASS, get_ctx_m(dev), \
+					 get_id_m(dev), get_subid_m(dev),  \
+					 fmt, ##__VA_ARGS__)
+
+/** \brief Rate limited trace from a device on warning level. */
+#define trace_dev_warn_ratelimited(get_ctx_m, get_id_m, get_subid_m, dev, \
+				   fmt, ...)				  \
+	trace_warn_ratelimited_with_ids(_TRACE_INV_CLASS, get_ctx_m(dev), \
+					get_id_m(dev), get_subid_m(dev),  \
+					fmt, ##__VA_ARGS__)
+
+/** \brief Rate limited trace from a device on info level. */
+#define trace_dev_info_ratelimited(get_ctx_m, get_id_m, get_subid_m, dev, \
+				   fmt, ...)				  \
+	trace_event_ratelimited_with_ids(_TRACE_INV_CLASS, get_ctx_m(dev), \
+					 get_id_m(dev), get_subid_m(dev),  \
+					 fmt, ##__VA_ARGS__)
+
+/** \brief Rate limited trace from a device on dbg level. */
+#define trace_dev_dbg_ratelimited(get_ctx_m, get_id_m, get_subid_m, dev, \
+				  fmt, ...)				 \
+	tracev_event_ratelimited_with_ids(_TRACE_INV_CLASS,		 \
+					  get_ctx_m(dev), get_id_m(dev), \
+					  get_subid_m(dev), fmt,	 \
+					  ##__VA_ARGS__)
+
 /* tracing from infrastructure part */
 
 #define tr_err(ctx, fmt, ...) \
@@ -365,4 +480,26 @@ struct tr_ctx {
 				     _TRACE_INV_ID, _TRACE_INV_ID, \
 				     fmt, ##__VA_ARGS__)
 
+/* rate limited tracing, see _log_message_ratelimited() */
+
+#define tr_err_ratelimited(ctx, fmt, ...) \
+	trace_error_ratelimited_with_ids(_TRACE_INV_CLASS, ctx, \
+					 _TRACE_INV_ID, _TRACE_INV_ID, \
+					 fmt, ##__VA_ARGS__)
+
+#define tr_warn_ratelimited(ctx, fmt, ...) \
+	trace_warn_ratelimited_with_ids(_TRACE_INV_CLASS, ctx, \
+					_TRACE_INV_ID, _TRACE_INV_ID, \
+					fmt, ##__VA_ARGS__)
+
+#define tr_info_ratelimited(ctx, fmt, ...) \
+	trace_event_ratelimited_with_ids(_TRACE_INV_CLASS, ctx, \
+					 _TRACE_INV_ID, _TRACE_INV_ID, \
+					 fmt, ##__VA_ARGS__)
+
+#define tr_dbg_ratelimited(ctx, fmt, ...) \
+	tracev_event_ratelimited_with_ids(_TRACE_INV_CLASS, ctx, \
+					  _TRACE_INV_ID, _TRACE_INV_ID, \
+					  fmt, ##__VA_ARGS__)
+
 #endif /* __SOF_TRACE_TRACE_H__ */
@@ -14,10 +14,15 @@
 
 #define SOF_EQ_FIR_IDX_SWITCH	0
 
-#define SOF_EQ_FIR_MAX_SIZE 4096 /* Max size allowed for coef data in bytes */
+#define SOF_EQ_FIR_MAX_SIZE 32768 /* Max size allowed for coef data in bytes */
 
 #define SOF_EQ_FIR_MAX_LENGTH 192 /* Max length for individual filter */
 
+#define SOF_EQ_FIR_MAX_LENGTH_FFT 8192 /* Max length for FFT convolution */
+
+/* Response flags */
+#define SOF_EQ_FIR_FLAG_FFT	0x1 /* Use partitioned FFT convolution */
+
 #define SOF_EQ_FIR_MAX_RESPONSES 8 /* A blob can define max 8 FIR EQs */
 
 /*
@@ -37,10 +42,14 @@
  *	       same first defined response and for to channels 4-7 the second.
  *         coef_data[]
  *             Repeated data
- *             { filter_length, output_shift, h[] }
+ *             { filter_length, output_shift, flags, h[] }
  *	       for every EQ response defined where vector h has filter_length
  *             number of coefficients. Coefficients in h[] are in Q1.15 format.
  *             E.g. 16384 (Q1.15) = 0.5. The shifts are number of right shifts.
+ *             If flags has SOF_EQ_FIR_FLAG_FFT set the response is computed
+ *             with uniformly partitioned FFT convolution and filter_length
+ *             can be up to SOF_EQ_FIR_MAX_LENGTH_FFT. Such channels have an
+ *             added latency of one partition (128 samples).
  *
  * NOTE: The channels_in_config must be even to have coef_data aligned to
  * 32 bit word in RAM. Therefore a mono EQ assign must be duplicated to 2ch
@@ -65,16 +74,17 @@ struct sof_eq_fir_config {
 struct sof_eq_fir_coef_data {
 	int16_t length; /* Number of FIR taps */
 	int16_t out_shift; /* Amount of right shifts at output */
+	uint32_t flags; /* SOF_EQ_FIR_FLAG_ bits */
 
 	/* reserved */
-	uint32_t reserved[4];
+	uint32_t reserved[3];
 
 	int16_t coef[]; /* FIR coefficients */
 } __attribute__((packed));
 
-/* In the struct above there's two 16 bit words (length, shift) and four
- * reserved 32 bit words before the actual FIR coefficients. This information
- * is used in parsing of the configuration blob.
+/* In the struct above there's two 16 bit words (length, shift), flags and
+ * three reserved 32 bit words before the actual FIR coefficients. This
+ * information is used in parsing of the configuration blob.
  */
 #define SOF_EQ_FIR_COEF_NHEADER \
 	(sizeof(struct sof_eq_fir_coef_data) / sizeof(int16_t))
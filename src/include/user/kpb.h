@@ -10,6 +10,10 @@
 
 #include <stdint.h>
 
+/** \brief History buffer codecs. */
+#define SOF_KPB_CODEC_NONE	0 /**< raw frames */
+#define SOF_KPB_CODEC_ADPCM	1 /**< 4 bit block IMA ADPCM */
+
 /** \brief kpb component configuration data. */
 struct sof_kpb_config {
 	uint32_t size; /**< kpb size in bytes */
@@ -18,6 +22,7 @@ struct sof_kpb_config {
 	uint32_t history_depth; /**< time of buffering in milliseconds */
 	uint32_t sampling_freq; /**< frequency in hertz */
 	uint32_t sampling_width; /**< number of bits */
+	uint32_t codec; /**< SOF_KPB_CODEC_, coding of history buffer */
 };
 
 #endif /* __USER_KPB_H__ */
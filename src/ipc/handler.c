@@ -30,10 +30,12 @@
 #include <sof/lib/dma.h>
 #include <sof/lib/mailbox.h>
 #include <sof/lib/memory.h>
+#include <sof/lib/mm_heap.h>
 #include <sof/lib/pm_runtime.h>
 #include <sof/list.h>
 #include <sof/math/numbers.h>
 #include <sof/platform.h>
+#include <sof/schedule/ll_schedule.h>
 #include <sof/schedule/schedule.h>
 #include <sof/schedule/task.h>
 #include <sof/spinlock.h>
@@ -42,6 +44,7 @@
 #include <sof/trace/trace.h>
 #include <ipc/control.h>
 #include <ipc/dai.h>
+#include <ipc/debug.h>
 #include <ipc/header.h>
 #include <ipc/pm.h>
 #include <ipc/stream.h>
@@ -796,6 +799,115 @@ static int ipc_glb_debug_message(uint32_t header)
 }
 #endif
 
+/*
+ * Debug statistics IPC Operations.
+ */
+static int ipc_debug_ll_stats(uint32_t header)
+{
+	struct sof_ipc_dbg_ll_stats *stats = ipc_get()->comp_data;
+	uint32_t max_size = MIN(MAILBOX_HOSTBOX_SIZE, SOF_IPC_MSG_MAX_SIZE);
+
+	stats->rhdr.hdr.cmd = header;
+	stats->rhdr.hdr.size = sizeof(*stats);
+	stats->rhdr.error = 0;
+	stats->num_elems = 0;
+
+	schedule_ll_stats(SOF_SCHEDULE_LL_TIMER, stats, max_size);
+	schedule_ll_stats(SOF_SCHEDULE_LL_DMA, stats, max_size);
+
+	mailbox_hostbox_write(0, stats, stats->rhdr.hdr.size);
+
+	return 1;
+}
+
+/* heap usage attributed to components, buffers and pipelines */
+static void ipc_debug_mem_comps(struct sof_ipc_dbg_mem_stats *stats,
+				uint32_t max_size)
+{
+	struct sof_ipc_dbg_mem_comp *elem;
+	struct ipc_comp_dev *icd;
+	struct list_item *clist;
+
+	list_for_item(clist, &ipc_get()->comp_list) {
+		if (stats->total++ < stats->first ||
+		    stats->rhdr.hdr.size + sizeof(*elem) > max_size)
+			continue;
+
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		elem = (struct sof_ipc_dbg_mem_comp *)stats->elems +
+			stats->num_elems;
+		elem->id = icd->id;
+		elem->type = icd->type;
+		elem->core = icd->core;
+		elem->bytes = icd->heap_bytes;
+
+		platform_shared_commit(icd, sizeof(*icd));
+
+		stats->num_elems++;
+		stats->rhdr.hdr.size += sizeof(*elem);
+	}
+}
+
+static int ipc_debug_mem_stats(uint32_t header)
+{
+	struct sof_ipc_cmd_hdr *hdr = ipc_get()->comp_data;
+	struct sof_ipc_dbg_mem_stats *stats = ipc_get()->comp_data;
+	uint32_t max_size = MIN(MAILBOX_HOSTBOX_SIZE, SOF_IPC_MSG_MAX_SIZE);
+	struct sof_ipc_dbg_mem_query query;
+	uint32_t type;
+	uint32_t first;
+
+	if (hdr->size < sizeof(query)) {
+		tr_err(&ipc_tr, "ipc: mem stats query size %d expected %d",
+		       hdr->size, sizeof(query));
+		return -EINVAL;
+	}
+
+	/* copy message with ABI safe method */
+	IPC_COPY_CMD(query, ipc_get()->comp_data);
+	type = query.type;
+	first = query.first;
+
+	if (type > SOF_IPC_DBG_MEM_COMP) {
+		tr_err(&ipc_tr, "ipc: unknown mem stats type %u", type);
+		return -EINVAL;
+	}
+
+	/* the reply overwrites the query */
+	stats->rhdr.hdr.cmd = header;
+	stats->rhdr.hdr.size = sizeof(*stats);
+	stats->rhdr.error = 0;
+	stats->type = type;
+	stats->first = first;
+	stats->total = 0;
+	stats->num_elems = 0;
+
+	/* heap elements and the failure count */
+	heap_stats(stats, max_size);
+
+	if (type == SOF_IPC_DBG_MEM_COMP)
+		ipc_debug_mem_comps(stats, max_size);
+
+	mailbox_hostbox_write(0, stats, stats->rhdr.hdr.size);
+
+	return 1;
+}
+
+static int ipc_glb_debug_stats(uint32_t header)
+{
+	uint32_t cmd = iCS(header);
+
+	switch (cmd) {
+	case SOF_IPC_DEBUG_LL_STATS:
+		return ipc_debug_ll_stats(header);
+	case SOF_IPC_DEBUG_MEM_STATS:
+		return ipc_debug_mem_stats(header);
+	default:
+		tr_err(&ipc_tr, "ipc: unknown debug stats cmd 0x%x", cmd);
+		return -EINVAL;
+	}
+}
+
 static int ipc_glb_gdb_debug(uint32_t header)
 {
 	/* no furher information needs to be extracted form header */
@@ -1319,6 +1431,9 @@ void ipc_cmd(struct sof_ipc_cmd_hdr *hdr)
 	case SOF_IPC_GLB_PROBE:
 		ret = ipc_glb_probe(hdr->cmd);
 		break;
+	case SOF_IPC_GLB_DEBUG:
+		ret = ipc_glb_debug_stats(hdr->cmd);
+		break;
 #if CONFIG_DEBUG
 	case SOF_IPC_GLB_TEST:
 		ret = ipc_glb_test_message(hdr->cmd);
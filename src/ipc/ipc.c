@@ -15,6 +15,7 @@
 #include <sof/lib/cache.h>
 #include <sof/lib/cpu.h>
 #include <sof/lib/mailbox.h>
+#include <sof/lib/mm_heap.h>
 #include <sof/list.h>
 #include <sof/platform.h>
 #include <sof/sof.h>
@@ -62,17 +63,42 @@ int ipc_process_on_core(uint32_t core)
 
 /*
  * Components, buffers and pipelines all use the same set of monotonic ID
- * numbers passed in by the host. They are stored in different lists, hence
- * more than 1 list may need to be searched for the corresponding component.
+ * numbers passed in by the host. They are stored in one list for iteration
+ * and hashed by their ID, so consecutive IDs land in different buckets.
  */
 
+static inline struct list_item *ipc_comp_hash(struct ipc *ipc, uint32_t id)
+{
+	return &ipc->comp_hash[id & (IPC_COMP_HASH_SIZE - 1)];
+}
+
+static void ipc_comp_dev_add(struct ipc *ipc, struct ipc_comp_dev *icd)
+{
+	list_item_append(&icd->list, &ipc->comp_list);
+	list_item_append(&icd->hash_list, ipc_comp_hash(ipc, icd->id));
+}
+
+static void ipc_comp_dev_del(struct ipc_comp_dev *icd)
+{
+	list_item_del(&icd->list);
+	list_item_del(&icd->hash_list);
+}
+
+/* heap bytes taken since used was sampled, other cores may free meanwhile */
+static uint32_t ipc_heap_taken(uint32_t used)
+{
+	uint32_t now = heap_used_bytes();
+
+	return now > used ? now - used : 0;
+}
+
 struct ipc_comp_dev *ipc_get_comp_by_id(struct ipc *ipc, uint32_t id)
 {
 	struct ipc_comp_dev *icd;
 	struct list_item *clist;
 
-	list_for_item(clist, &ipc->comp_list) {
-		icd = container_of(clist, struct ipc_comp_dev, list);
+	list_for_item(clist, ipc_comp_hash(ipc, id)) {
+		icd = container_of(clist, struct ipc_comp_dev, hash_list);
 		if (icd->id == id)
 			return icd;
 
@@ -182,6 +208,7 @@ int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
 {
 	struct comp_dev *cd;
 	struct ipc_comp_dev *icd;
+	uint32_t heap_used;
 
 	/* check whether component already exists */
 	icd = ipc_get_comp_by_id(ipc, comp->id);
@@ -190,6 +217,8 @@ int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
 		return -EINVAL;
 	}
 
+	heap_used = heap_used_bytes();
+
 	/* create component */
 	cd = comp_new(comp);
 	if (!cd) {
@@ -209,9 +238,10 @@ int ipc_comp_new(struct ipc *ipc, struct sof_ipc_comp *comp)
 	icd->type = COMP_TYPE_COMPONENT;
 	icd->core = comp->core;
 	icd->id = comp->id;
+	icd->heap_bytes = ipc_heap_taken(heap_used);
 
 	/* add new component to the list */
-	list_item_append(&icd->list, &ipc->comp_list);
+	ipc_comp_dev_add(ipc, icd);
 
 	platform_shared_commit(icd, sizeof(*icd));
 
@@ -250,7 +280,7 @@ int ipc_comp_free(struct ipc *ipc, uint32_t comp_id)
 
 	icd->cd = NULL;
 
-	list_item_del(&icd->list);
+	ipc_comp_dev_del(icd);
 	rfree(icd);
 
 	return 0;
@@ -260,6 +290,7 @@ int ipc_buffer_new(struct ipc *ipc, struct sof_ipc_buffer *desc)
 {
 	struct ipc_comp_dev *ibd;
 	struct comp_buffer *buffer;
+	uint32_t heap_used;
 	int ret = 0;
 
 	/* check whether buffer already exists */
@@ -270,6 +301,8 @@ int ipc_buffer_new(struct ipc *ipc, struct sof_ipc_buffer *desc)
 		return -EINVAL;
 	}
 
+	heap_used = heap_used_bytes();
+
 	/* register buffer with pipeline */
 	buffer = buffer_new(desc);
 	if (!buffer) {
@@ -287,9 +320,10 @@ int ipc_buffer_new(struct ipc *ipc, struct sof_ipc_buffer *desc)
 	ibd->type = COMP_TYPE_BUFFER;
 	ibd->core = desc->comp.core;
 	ibd->id = desc->comp.id;
+	ibd->heap_bytes = ipc_heap_taken(heap_used);
 
 	/* add new buffer to the list */
-	list_item_append(&ibd->list, &ipc->comp_list);
+	ipc_comp_dev_add(ipc, ibd);
 
 	platform_shared_commit(ibd, sizeof(*ibd));
 
@@ -316,7 +350,7 @@ int ipc_buffer_free(struct ipc *ipc, uint32_t buffer_id)
 
 	/* free buffer and remove from list */
 	buffer_free(ibd->cb);
-	list_item_del(&ibd->list);
+	ipc_comp_dev_del(ibd);
 	rfree(ibd);
 
 	return 0;
@@ -434,6 +468,7 @@ int ipc_pipeline_new(struct ipc *ipc,
 	struct ipc_comp_dev *ipc_pipe;
 	struct pipeline *pipe;
 	struct ipc_comp_dev *icd;
+	uint32_t heap_used;
 
 	/* check whether the pipeline already exists */
 	ipc_pipe = ipc_get_comp_by_id(ipc, pipe_desc->comp_id);
@@ -470,6 +505,8 @@ int ipc_pipeline_new(struct ipc *ipc,
 		return -EINVAL;
 	}
 
+	heap_used = heap_used_bytes();
+
 	/* create the pipeline */
 	pipe = pipeline_new(pipe_desc, icd->cd);
 	if (!pipe) {
@@ -489,9 +526,10 @@ int ipc_pipeline_new(struct ipc *ipc,
 	ipc_pipe->type = COMP_TYPE_PIPELINE;
 	ipc_pipe->core = pipe_desc->core;
 	ipc_pipe->id = pipe_desc->comp_id;
+	ipc_pipe->heap_bytes = ipc_heap_taken(heap_used);
 
 	/* add new pipeline to the list */
-	list_item_append(&ipc_pipe->list, &ipc->comp_list);
+	ipc_comp_dev_add(ipc, ipc_pipe);
 
 	platform_shared_commit(ipc_pipe, sizeof(*ipc_pipe));
 
@@ -519,7 +557,7 @@ int ipc_pipeline_free(struct ipc *ipc, uint32_t comp_id)
 		return ret;
 	}
 	ipc_pipe->pipeline = NULL;
-	list_item_del(&ipc_pipe->list);
+	ipc_comp_dev_del(ipc_pipe);
 	rfree(ipc_pipe);
 
 	return 0;
@@ -662,6 +700,8 @@ out:
 
 int ipc_init(struct sof *sof)
 {
+	int i;
+
 	tr_info(&ipc_tr, "ipc_init()");
 
 	/* init ipc data */
@@ -673,6 +713,8 @@ int ipc_init(struct sof *sof)
 	spinlock_init(&sof->ipc->lock);
 	list_init(&sof->ipc->msg_list);
 	list_init(&sof->ipc->comp_list);
+	for (i = 0; i < IPC_COMP_HASH_SIZE; i++)
+		list_init(&sof->ipc->comp_hash[i]);
 
 	return platform_ipc_init(sof->ipc);
 }
@@ -6,6 +6,7 @@
 //         Keyon Jie <yang.jie@linux.intel.com>
 
 #include <sof/debug/panic.h>
+#include <sof/drivers/interrupt.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/cache.h>
 #include <sof/lib/cpu.h>
@@ -16,6 +17,7 @@
 #include <sof/math/numbers.h>
 #include <sof/spinlock.h>
 #include <sof/string.h>
+#include <ipc/debug.h>
 #include <ipc/topology.h>
 #include <ipc/trace.h>
 #include <config.h>
@@ -72,6 +74,65 @@ static void validate_memory(void *ptr, size_t size)
 }
 #endif
 
+/* Block i of a map is free when bit (31 - i % 32) of free_mask word i / 32
+ * is set, so clz() of a word gives the lowest free block it covers.
+ */
+#define BLOCK_MASK_BITS		32
+
+static inline uint32_t block_mask_words(struct block_map *map)
+{
+	return (map->count + BLOCK_MASK_BITS - 1) / BLOCK_MASK_BITS;
+}
+
+/* finds first free (or used) block at or after start, count if none */
+static unsigned int block_mask_find(struct block_map *map, unsigned int start,
+				    bool free)
+{
+	unsigned int words = block_mask_words(map);
+	unsigned int word = start / BLOCK_MASK_BITS;
+	uint32_t bits;
+
+	if (start >= map->count)
+		return map->count;
+
+	/* bits past the last block are never set, so they read as used */
+	bits = free ? map->free_mask[word] : ~map->free_mask[word];
+	bits &= UINT32_MAX >> (start % BLOCK_MASK_BITS);
+
+	while (!bits) {
+		if (++word == words)
+			return map->count;
+
+		bits = free ? map->free_mask[word] : ~map->free_mask[word];
+	}
+
+	return MIN(word * BLOCK_MASK_BITS + clz(bits), map->count);
+}
+
+/* marks count blocks from start as free or used */
+static void block_mask_update(struct block_map *map, unsigned int start,
+			      unsigned int count, bool free)
+{
+	unsigned int offset;
+	unsigned int n;
+	uint32_t bits;
+
+	while (count) {
+		offset = start % BLOCK_MASK_BITS;
+		n = MIN(count, BLOCK_MASK_BITS - offset);
+		bits = (uint32_t)(UINT64_MAX << (BLOCK_MASK_BITS - n)) >>
+			offset;
+
+		if (free)
+			map->free_mask[start / BLOCK_MASK_BITS] |= bits;
+		else
+			map->free_mask[start / BLOCK_MASK_BITS] &= ~bits;
+
+		start += n;
+		count -= n;
+	}
+}
+
 /* total size of block */
 static inline uint32_t block_get_size(struct block_map *map)
 {
@@ -182,6 +243,8 @@ static void *rmalloc_sys(uint32_t flags, int caps, int core, size_t bytes)
 
 	cpu_heap->info.used += bytes;
 	cpu_heap->info.free -= alignment + bytes;
+	cpu_heap->info.used_max = MAX(cpu_heap->info.used_max,
+				      cpu_heap->info.used);
 
 	if (flags & SOF_MEM_FLAG_SHARED)
 		ptr = platform_shared_get(ptr, bytes);
@@ -192,6 +255,58 @@ static void *rmalloc_sys(uint32_t flags, int caps, int core, size_t bytes)
 	return ptr;
 }
 
+/* free masks are never freed so they come from the master core system heap */
+static void init_heap_mask(struct mm_heap *heap, int count)
+{
+	struct block_map *map;
+	uint32_t bytes;
+	int i;
+	int j;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < heap[i].blocks; j++) {
+			map = &heap[i].map[j];
+			bytes = block_mask_words(map) * sizeof(*map->free_mask);
+
+			map->free_mask = rmalloc_sys(SOF_MEM_FLAG_SHARED, 0,
+						     PLATFORM_MASTER_CORE_ID,
+						     bytes);
+			bzero(map->free_mask, bytes);
+			block_mask_update(map, 0, map->count, true);
+
+			platform_shared_commit(map->free_mask, bytes);
+			platform_shared_commit(map, sizeof(*map));
+		}
+
+		platform_shared_commit(&heap[i], sizeof(heap[i]));
+	}
+}
+
+/* runtime and buffer heaps sorted by base address for get_heap_from_ptr() */
+static void init_heap_index(struct mm *memmap)
+{
+	struct mm_heap **index = memmap->heap_index;
+	struct mm_heap *heap;
+	int i;
+	int j;
+
+	for (i = 0; i < PLATFORM_HEAP_RUNTIME; i++)
+		index[i] = &memmap->runtime[i];
+
+	for (i = 0; i < PLATFORM_HEAP_BUFFER; i++)
+		index[PLATFORM_HEAP_RUNTIME + i] = &memmap->buffer[i];
+
+	/* insertion sort, the table has only a few entries */
+	for (i = 1; i < MM_HEAP_INDEX_SIZE; i++) {
+		heap = index[i];
+
+		for (j = i; j > 0 && index[j - 1]->heap > heap->heap; j--)
+			index[j] = index[j - 1];
+
+		index[j] = heap;
+	}
+}
+
 /* At this point the pointer we have should be unaligned
  * (it was checked level higher) and be power of 2
  */
@@ -218,7 +333,7 @@ static void *alloc_block(struct mm_heap *heap, int level,
 	struct block_map *map = &heap->map[level];
 	struct block_hdr *hdr;
 	void *ptr;
-	int i;
+	unsigned int next;
 
 	hdr = &map->block[map->first_free];
 
@@ -231,17 +346,16 @@ static void *alloc_block(struct mm_heap *heap, int level,
 
 	heap->info.used += map->block_size;
 	heap->info.free -= map->block_size;
+	heap->info.used_max = MAX(heap->info.used_max, heap->info.used);
 
 	/* find next free */
-	for (i = map->first_free; i < map->count; ++i) {
-		hdr = &map->block[i];
-
-		if (hdr->used == 0) {
-			map->first_free = i;
-			break;
-		}
-	}
+	block_mask_update(map, map->first_free, 1, false);
+	next = block_mask_find(map, map->first_free, true);
+	if (next < map->count)
+		map->first_free = next;
 
+	platform_shared_commit(map->free_mask,
+			       sizeof(*map->free_mask) * block_mask_words(map));
 	platform_shared_commit(map->block, sizeof(*map->block) * map->count);
 	platform_shared_commit(map, sizeof(*map));
 	platform_shared_commit(heap, sizeof(*heap));
@@ -261,21 +375,20 @@ static void *alloc_cont_blocks(struct mm_heap *heap, int level,
 	unsigned int current;
 	unsigned int count = bytes / map->block_size;
 	unsigned int remaining = 0;
+	unsigned int end;
 
 	if (bytes % map->block_size)
 		count++;
 
 	/* check if we have enough consecutive blocks for requested
-	 * allocation size.
+	 * allocation size, skipping whole runs of used and free blocks.
 	 */
-	for (current = map->first_free; current < map->count &&
-	     remaining < count; current++) {
-		hdr = &map->block[current];
-
-		if (hdr->used)
-			remaining = 0;/* used, not suitable, reset */
-		else if (!remaining++)
-			start = current;/* new start */
+	for (current = block_mask_find(map, map->first_free, true);
+	     current < map->count && remaining < count;
+	     current = block_mask_find(map, end, true)) {
+		end = block_mask_find(map, current, false);
+		remaining = end - current;
+		start = current;
 	}
 
 	if (count > map->count || remaining < count) {
@@ -296,16 +409,13 @@ static void *alloc_cont_blocks(struct mm_heap *heap, int level,
 
 	heap->info.used += count * map->block_size;
 	heap->info.free -= count * map->block_size;
+	heap->info.used_max = MAX(heap->info.used_max, heap->info.used);
+	block_mask_update(map, start, count, false);
+
 	/* update first_free if needed */
 	if (map->first_free == start)
 		/* find first available free block */
-		for (map->first_free += count; map->first_free < map->count;
-			map->first_free++) {
-			hdr = &map->block[map->first_free];
-
-			if (!hdr->used)
-				break;
-		}
+		map->first_free = block_mask_find(map, start + count, true);
 
 	/* update each block */
 	for (current = start; current < start + count; current++) {
@@ -314,6 +424,9 @@ static void *alloc_cont_blocks(struct mm_heap *heap, int level,
 		hdr->unaligned_ptr = unaligned_ptr;
 	}
 
+	platform_shared_commit(map->free_mask,
+			       sizeof(*map->free_mask) * block_mask_words(map));
+
 out:
 	platform_shared_commit(map->block, sizeof(*map->block) * map->count);
 	platform_shared_commit(map, sizeof(*map));
@@ -326,7 +439,9 @@ static struct mm_heap *get_heap_from_ptr(void *ptr)
 {
 	struct mm *memmap = memmap_get();
 	struct mm_heap *heap;
-	int i;
+	int low = 0;
+	int high = MM_HEAP_INDEX_SIZE;
+	int mid;
 
 	/* find mm_heap that ptr belongs to */
 	heap = memmap->system_runtime + cpu_get_id();
@@ -336,21 +451,22 @@ static struct mm_heap *get_heap_from_ptr(void *ptr)
 
 	platform_shared_commit(heap, sizeof(*heap));
 
-	for (i = 0; i < PLATFORM_HEAP_RUNTIME; i++) {
-		heap = &memmap->runtime[i];
+	/* find last runtime or buffer heap starting at or below ptr */
+	while (low < high) {
+		mid = (low + high) / 2;
+		heap = memmap->heap_index[mid];
 
-		if ((uint32_t)ptr >= heap->heap &&
-		    (uint32_t)ptr < heap->heap + heap->size)
-			goto out;
+		if ((uint32_t)ptr < heap->heap)
+			high = mid;
+		else
+			low = mid + 1;
 
 		platform_shared_commit(heap, sizeof(*heap));
 	}
 
-	for (i = 0; i < PLATFORM_HEAP_BUFFER; i++) {
-		heap = &memmap->buffer[i];
-
-		if ((uint32_t)ptr >= heap->heap &&
-		    (uint32_t)ptr < heap->heap + heap->size)
+	if (low) {
+		heap = memmap->heap_index[low - 1];
+		if ((uint32_t)ptr < heap->heap + heap->size)
 			goto out;
 
 		platform_shared_commit(heap, sizeof(*heap));
@@ -510,6 +626,8 @@ static void free_block(void *ptr)
 		heap->info.free += block_map->block_size;
 	}
 
+	block_mask_update(block_map, block, used_blocks - block, true);
+
 	/* set first free block */
 	if (block < block_map->first_free || heap_is_full)
 		block_map->first_free = block;
@@ -525,6 +643,9 @@ static void free_block(void *ptr)
 		(i - block));
 #endif
 
+	platform_shared_commit(block_map->free_mask,
+			       sizeof(*block_map->free_mask) *
+			       block_mask_words(block_map));
 	platform_shared_commit(block_map->block, sizeof(*block_map->block) *
 			       block_map->count);
 	platform_shared_commit(block_map, sizeof(*block_map));
@@ -666,6 +787,257 @@ static void *rmalloc_runtime(uint32_t flags, uint32_t caps, size_t bytes)
 				 PLATFORM_DCACHE_ALIGN);
 }
 
+#if CONFIG_MM_MAGAZINE
+/* Recently freed single blocks of the smallest runtime heap maps are kept
+ * in a magazine of the freeing core and handed out again by that core
+ * without taking the memory map lock. Cached blocks stay used in the heap.
+ * The magazine lock is only contended when another core drains it.
+ */
+
+static inline int mm_magazine_levels(struct mm_heap *heap)
+{
+	return MIN(heap->blocks, MM_MAGAZINE_CLASSES);
+}
+
+/* map level of the single block starting at ptr, -1 if not cacheable */
+static int mm_magazine_level(struct mm_heap *heap, void *ptr)
+{
+	struct block_map *map;
+	struct block_hdr *hdr;
+	uint32_t offset;
+	int level;
+
+	if ((uint32_t)ptr < heap->heap ||
+	    (uint32_t)ptr >= heap->heap + heap->size)
+		return -1;
+
+	for (level = 0; level < mm_magazine_levels(heap); level++) {
+		map = &heap->map[level];
+
+		if ((uint32_t)ptr >= map->base + map->block_size * map->count)
+			continue;
+
+		/* block header is owned by the caller freeing it */
+		offset = (uint32_t)ptr - map->base;
+		hdr = &map->block[offset / map->block_size];
+		if (offset % map->block_size || hdr->size != 1)
+			return -1;
+
+		return level;
+	}
+
+	return -1;
+}
+
+static void *mm_magazine_get(struct mm *memmap, uint32_t flags, uint32_t caps,
+			     size_t bytes)
+{
+	struct mm_magazine *mag = &memmap->magazine[cpu_get_id()];
+	struct mm_heap *heap = &memmap->runtime[0];
+	uint32_t irq_flags;
+	void *ptr = NULL;
+	int level;
+
+	/* shared blocks need the heap to return an uncached address */
+	if (flags & SOF_MEM_FLAG_SHARED || (heap->caps & caps) != caps)
+		return NULL;
+
+	/* same block size as the heap would pick */
+	for (level = 0; level < mm_magazine_levels(heap); level++)
+		if (heap->map[level].block_size >= bytes)
+			break;
+
+	if (level == mm_magazine_levels(heap))
+		return NULL;
+
+	spin_lock_irq(&mag->lock, irq_flags);
+
+	if (mag->count[level]) {
+		ptr = mag->block[level][--mag->count[level]];
+		mag->bytes -= heap->map[level].block_size;
+		mag->hits++;
+	} else {
+		mag->misses++;
+	}
+
+	spin_unlock_irq(&mag->lock, irq_flags);
+
+	return ptr;
+}
+
+static bool mm_magazine_put(struct mm *memmap, void *ptr)
+{
+	struct mm_magazine *mag = &memmap->magazine[cpu_get_id()];
+	struct mm_heap *heap = &memmap->runtime[0];
+	uint32_t irq_flags;
+	bool cached = false;
+	int level;
+	int i;
+
+	ptr = platform_rfree_prepare(ptr);
+
+	level = mm_magazine_level(heap, ptr);
+	if (level < 0)
+		return false;
+
+	spin_lock_irq(&mag->lock, irq_flags);
+
+	/* a block freed twice is cached only once */
+	for (i = 0; i < mag->count[level]; i++)
+		if (mag->block[level][i] == ptr)
+			cached = true;
+
+	if (!cached && mag->count[level] < CONFIG_MM_MAGAZINE_DEPTH) {
+		mag->block[level][mag->count[level]++] = ptr;
+		mag->bytes += heap->map[level].block_size;
+		cached = true;
+	}
+
+	spin_unlock_irq(&mag->lock, irq_flags);
+
+	return cached;
+}
+
+/* returns blocks cached by core to the heap, memory map lock held */
+static bool mm_magazine_drain(struct mm *memmap, int core)
+{
+	struct mm_magazine *mag = &memmap->magazine[core];
+	bool drained = false;
+	int level;
+
+	spin_lock(&mag->lock);
+
+	for (level = 0; level < MM_MAGAZINE_CLASSES; level++) {
+		while (mag->count[level]) {
+			free_block(mag->block[level][--mag->count[level]]);
+			drained = true;
+		}
+	}
+
+	mag->bytes = 0;
+
+	spin_unlock(&mag->lock);
+
+	return drained;
+}
+
+/* returns blocks cached by all cores to the heap, memory map lock held */
+static bool mm_magazine_drain_all(struct mm *memmap)
+{
+	bool drained = false;
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		if (mm_magazine_drain(memmap, i))
+			drained = true;
+
+	return drained;
+}
+
+static inline uint32_t mm_magazine_bytes(struct mm *memmap)
+{
+	uint32_t bytes = 0;
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		bytes += memmap->magazine[i].bytes;
+
+	return bytes;
+}
+
+/* size of the largest block cached by any core */
+static uint32_t mm_magazine_block_max(struct mm *memmap)
+{
+	struct mm_heap *heap = &memmap->runtime[0];
+	uint32_t block_max = 0;
+	int level;
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		for (level = 0; level < mm_magazine_levels(heap); level++)
+			if (memmap->magazine[i].count[level])
+				block_max = MAX(block_max,
+						heap->map[level].block_size);
+
+	return block_max;
+}
+
+static void mm_magazine_init(struct mm *memmap)
+{
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		spinlock_init(&memmap->magazine[i].lock);
+}
+
+static inline void mm_magazine_trace(struct mm *memmap)
+{
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		tr_info(&mem_tr, "heap: core %d magazine hits %u misses %u",
+			i, memmap->magazine[i].hits,
+			memmap->magazine[i].misses);
+}
+#else
+static inline void *mm_magazine_get(struct mm *memmap, uint32_t flags,
+				    uint32_t caps, size_t bytes)
+{
+	return NULL;
+}
+
+static inline bool mm_magazine_put(struct mm *memmap, void *ptr)
+{
+	return false;
+}
+
+static inline bool mm_magazine_drain(struct mm *memmap, int core)
+{
+	return false;
+}
+
+static inline bool mm_magazine_drain_all(struct mm *memmap)
+{
+	return false;
+}
+
+static inline uint32_t mm_magazine_bytes(struct mm *memmap)
+{
+	return 0;
+}
+
+static inline uint32_t mm_magazine_block_max(struct mm *memmap)
+{
+	return 0;
+}
+
+static inline void mm_magazine_init(struct mm *memmap) { }
+
+static inline void mm_magazine_trace(struct mm *memmap) { }
+#endif
+
+/* counts failed allocation, memory map lock held */
+static void alloc_fail_count(struct mm *memmap, uint32_t caps)
+{
+	struct mm_alloc_fail *fail;
+	int i;
+
+	memmap->alloc_fail_count++;
+
+	/* a full table only counts the total */
+	for (i = 0; i < MM_ALLOC_FAIL_CAPS; i++) {
+		fail = &memmap->alloc_fail[i];
+
+		if (!fail->count)
+			fail->caps = caps;
+
+		if (fail->caps == caps) {
+			fail->count++;
+			break;
+		}
+	}
+}
+
 static void *_malloc_unlocked(enum mem_zone zone, uint32_t flags, uint32_t caps,
 			      size_t bytes)
 {
@@ -706,10 +1078,24 @@ void *rmalloc(enum mem_zone zone, uint32_t flags, uint32_t caps, size_t bytes)
 	uint32_t lock_flags;
 	void *ptr = NULL;
 
+	if (zone == SOF_MEM_ZONE_RUNTIME) {
+		ptr = mm_magazine_get(memmap, flags, caps, bytes);
+		if (ptr)
+			return ptr;
+	}
+
 	spin_lock_irq(&memmap->lock, lock_flags);
 
 	ptr = _malloc_unlocked(zone, flags, caps, bytes);
 
+	/* blocks cached by any core may be all that is left */
+	if (!ptr && zone == SOF_MEM_ZONE_RUNTIME &&
+	    mm_magazine_drain_all(memmap))
+		ptr = _malloc_unlocked(zone, flags, caps, bytes);
+
+	if (!ptr)
+		alloc_fail_count(memmap, caps);
+
 	spin_unlock_irq(&memmap->lock, lock_flags);
 
 	DEBUG_TRACE_PTR(ptr, bytes, zone, caps, flags);
@@ -864,6 +1250,8 @@ void *rballoc_align(uint32_t flags, uint32_t caps, size_t bytes,
 	spin_lock_irq(&memmap->lock, lock_flags);
 
 	ptr = _balloc_unlocked(flags, caps, bytes, alignment);
+	if (!ptr)
+		alloc_fail_count(memmap, caps);
 
 	spin_unlock_irq(&memmap->lock, lock_flags);
 
@@ -907,6 +1295,9 @@ void rfree(void *ptr)
 	struct mm *memmap = memmap_get();
 	uint32_t flags;
 
+	if (mm_magazine_put(memmap, ptr))
+		return;
+
 	spin_lock_irq(&memmap->lock, flags);
 	_rfree_unlocked(ptr);
 	spin_unlock_irq(&memmap->lock, flags);
@@ -932,6 +1323,8 @@ void *rbrealloc_align(void *ptr, uint32_t flags, uint32_t caps, size_t bytes,
 
 	if (new_ptr)
 		_rfree_unlocked(ptr);
+	else
+		alloc_fail_count(memmap, caps);
 
 	spin_unlock_irq(&memmap->lock, lock_flags);
 
@@ -978,6 +1371,9 @@ void free_heap(enum mem_zone zone)
 		panic(SOF_IPC_PANIC_MEM);
 	}
 
+	/* blocks cached by a disabled core would never be used again */
+	heap_magazine_drain(cpu_get_id());
+
 	cpu_heap = memmap->system + cpu_get_id();
 	cpu_heap->info.used = 0;
 	cpu_heap->info.free = cpu_heap->size;
@@ -986,6 +1382,20 @@ void free_heap(enum mem_zone zone)
 	platform_shared_commit(memmap, sizeof(*memmap));
 }
 
+void heap_magazine_drain(int core)
+{
+	struct mm *memmap = memmap_get();
+	uint32_t flags;
+
+	spin_lock_irq(&memmap->lock, flags);
+
+	mm_magazine_drain(memmap, core);
+
+	platform_shared_commit(memmap, sizeof(*memmap));
+
+	spin_unlock_irq(&memmap->lock, flags);
+}
+
 #if CONFIG_TRACE
 void heap_trace(struct mm_heap *heap, int size)
 {
@@ -1031,6 +1441,7 @@ void heap_trace_all(int force)
 		heap_trace(memmap->buffer, PLATFORM_HEAP_BUFFER);
 		tr_info(&mem_tr, "heap: runtime status");
 		heap_trace(memmap->runtime, PLATFORM_HEAP_RUNTIME);
+		mm_magazine_trace(memmap);
 	}
 
 	memmap->heap_trace_updated = 0;
@@ -1042,6 +1453,149 @@ void heap_trace_all(int force) { }
 void heap_trace(struct mm_heap *heap, int size) { }
 #endif
 
+uint32_t heap_used_bytes(void)
+{
+	struct mm *memmap = memmap_get();
+	uint32_t used = 0;
+	int i;
+
+	for (i = 0; i < PLATFORM_HEAP_SYSTEM_RUNTIME; i++)
+		used += memmap->system_runtime[i].info.used;
+
+	for (i = 0; i < PLATFORM_HEAP_RUNTIME; i++)
+		used += memmap->runtime[i].info.used;
+
+	for (i = 0; i < PLATFORM_HEAP_BUFFER; i++)
+		used += memmap->buffer[i].info.used;
+
+	/* cached blocks are free for the owning core */
+	used -= mm_magazine_bytes(memmap);
+
+	platform_shared_commit(memmap, sizeof(*memmap));
+
+	return used;
+}
+
+/* largest run of free blocks in bytes, system heaps have a single run */
+static uint32_t heap_free_max(struct mm_heap *heap)
+{
+	struct block_map *map;
+	uint32_t free_max = 0;
+	unsigned int start;
+	unsigned int end;
+	int i;
+
+	if (!heap->blocks)
+		return heap->info.free;
+
+	for (i = 0; i < heap->blocks; i++) {
+		map = &heap->map[i];
+
+		for (start = block_mask_find(map, 0, true); start < map->count;
+		     start = block_mask_find(map, end, true)) {
+			end = block_mask_find(map, start, false);
+			free_max = MAX(free_max, (end - start) *
+				       map->block_size);
+		}
+
+		platform_shared_commit(map, sizeof(*map));
+	}
+
+	return free_max;
+}
+
+/* appends elem to stats if it is past first and fits in max_size */
+static void heap_stats_append(struct sof_ipc_dbg_mem_stats *stats,
+			      uint32_t max_size, const void *elem,
+			      uint32_t elem_size)
+{
+	if (stats->total++ < stats->first ||
+	    stats->rhdr.hdr.size + elem_size > max_size)
+		return;
+
+	memcpy_s(stats->elems + stats->num_elems * elem_size, elem_size,
+		 elem, elem_size);
+	stats->num_elems++;
+	stats->rhdr.hdr.size += elem_size;
+}
+
+static void heap_stats_heaps(struct sof_ipc_dbg_mem_stats *stats,
+			     uint32_t max_size, struct mm *memmap,
+			     struct mm_heap *heap, int count,
+			     enum mem_zone zone)
+{
+	struct sof_ipc_dbg_mem_heap elem;
+	uint32_t cached;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		/* cached blocks are free, as in heap_used_bytes() */
+		cached = &heap[i] == &memmap->runtime[0] ?
+			mm_magazine_bytes(memmap) : 0;
+
+		elem.zone = zone;
+		elem.core = zone == SOF_MEM_ZONE_SYS ||
+			zone == SOF_MEM_ZONE_SYS_RUNTIME ? i : 0;
+		elem.caps = heap[i].caps;
+		elem.size = heap[i].size;
+		elem.used = heap[i].info.used - cached;
+		elem.free = heap[i].info.free + cached;
+		elem.used_max = heap[i].info.used_max;
+		elem.free_max = heap_free_max(&heap[i]);
+		if (cached)
+			elem.free_max = MAX(elem.free_max,
+					    mm_magazine_block_max(memmap));
+
+		platform_shared_commit(&heap[i], sizeof(heap[i]));
+
+		heap_stats_append(stats, max_size, &elem, sizeof(elem));
+	}
+}
+
+void heap_stats(struct sof_ipc_dbg_mem_stats *stats, uint32_t max_size)
+{
+	struct mm *memmap = memmap_get();
+	struct sof_ipc_dbg_mem_fail elem;
+	uint32_t flags;
+	int i;
+
+	spin_lock_irq(&memmap->lock, flags);
+
+	stats->fail_count = memmap->alloc_fail_count;
+
+	switch (stats->type) {
+	case SOF_IPC_DBG_MEM_HEAP:
+		heap_stats_heaps(stats, max_size, memmap, memmap->system,
+				 PLATFORM_HEAP_SYSTEM, SOF_MEM_ZONE_SYS);
+		heap_stats_heaps(stats, max_size, memmap,
+				 memmap->system_runtime,
+				 PLATFORM_HEAP_SYSTEM_RUNTIME,
+				 SOF_MEM_ZONE_SYS_RUNTIME);
+		heap_stats_heaps(stats, max_size, memmap, memmap->runtime,
+				 PLATFORM_HEAP_RUNTIME, SOF_MEM_ZONE_RUNTIME);
+		heap_stats_heaps(stats, max_size, memmap, memmap->buffer,
+				 PLATFORM_HEAP_BUFFER, SOF_MEM_ZONE_BUFFER);
+		break;
+	case SOF_IPC_DBG_MEM_FAIL:
+		for (i = 0; i < MM_ALLOC_FAIL_CAPS; i++) {
+			if (!memmap->alloc_fail[i].count)
+				break;
+
+			elem.caps = memmap->alloc_fail[i].caps;
+			elem.count = memmap->alloc_fail[i].count;
+			heap_stats_append(stats, max_size, &elem,
+					  sizeof(elem));
+		}
+		break;
+	default:
+		break;
+	}
+
+	platform_shared_commit(memmap, sizeof(*memmap));
+
+	spin_unlock_irq(&memmap->lock, flags);
+}
+
 /* initialise map */
 void init_heap(struct sof *sof)
 {
@@ -1058,6 +1612,14 @@ void init_heap(struct sof *sof)
 
 	init_heap_map(memmap->buffer, PLATFORM_HEAP_BUFFER);
 
+	init_heap_mask(memmap->system_runtime, PLATFORM_HEAP_SYSTEM_RUNTIME);
+
+	init_heap_mask(memmap->runtime, PLATFORM_HEAP_RUNTIME);
+
+	init_heap_mask(memmap->buffer, PLATFORM_HEAP_BUFFER);
+
+	init_heap_index(memmap);
+
 #if CONFIG_DEBUG_BLOCK_FREE
 	write_pattern((struct mm_heap *)&memmap->buffer, PLATFORM_HEAP_BUFFER,
 		      DEBUG_BLOCK_FREE_VALUE_8BIT);
@@ -1066,6 +1628,7 @@ void init_heap(struct sof *sof)
 #endif
 
 	spinlock_init(&memmap->lock);
+	mm_magazine_init(memmap);
 
 	platform_shared_commit(memmap, sizeof(*memmap));
 }
@@ -68,7 +68,11 @@ struct probe_pdata {
 	struct probe_dma_ext ext_dma;				  /**< extraction DMA */
 	struct probe_dma_ext inject_dma[CONFIG_PROBE_DMA_MAX];	  /**< injection DMA */
 	struct probe_point probe_points[CONFIG_PROBE_POINTS_MAX]; /**< probe points */
+	/** injection DMA of each probe point */
+	struct probe_dma_ext *point_dma[CONFIG_PROBE_POINTS_MAX];
 	struct probe_data_packet header;			  /**< data packet header */
+	struct probe_point *ext_point;	/**< point of open data packet */
+	uintptr_t header_ptr;		/**< open data packet header */
 	struct task dmap_work;					  /**< probe task */
 };
 
@@ -190,6 +194,8 @@ static int probe_dma_deinit(struct probe_dma_ext *dma)
 	return 0;
 }
 
+static void probe_packet_close(struct probe_pdata *_probe);
+
 /*
  * \brief Probe task for extraction.
  *
@@ -201,6 +207,9 @@ static enum task_state probe_task(void *data)
 	struct probe_pdata *_probe = probe_get();
 	int err;
 
+	/* the header of the open packet must be complete before sending */
+	probe_packet_close(_probe);
+
 	if (_probe->ext_dma.dmapb.avail > 0)
 		err = dma_copy_to_host_nowait(&_probe->ext_dma.dc,
 					      &_probe->ext_dma.config, 0,
@@ -490,14 +499,15 @@ int probe_dma_remove(uint32_t count, uint32_t *stream_tag)
 }
 
 /**
- * \brief Copy data to probe buffer and update buffer pointers.
- * \param[out] probe DMA buffer.
+ * \brief Copy data to probe buffer at given position.
+ * \param[in] probe DMA buffer.
+ * \param[in,out] write position, advanced by size.
  * \param[in] data pointer.
  * \param[in] size.
  * \return 0 on success, error code otherwise.
  */
-static int copy_to_pbuffer(struct probe_dma_buf *pbuf, void *data,
-			   uint32_t bytes)
+static int copy_to_pbuffer_at(struct probe_dma_buf *pbuf, uintptr_t *ptr,
+			      void *data, uint32_t bytes)
 {
 	uint32_t head;
 	uint32_t tail;
@@ -506,8 +516,8 @@ static int copy_to_pbuffer(struct probe_dma_buf *pbuf, void *data,
 		return 0;
 
 	/* check if it will not exceed end_addr */
-	if ((char *)pbuf->end_addr - (char *)pbuf->w_ptr < bytes) {
-		head = (char *)pbuf->end_addr - (char *)pbuf->w_ptr;
+	if ((char *)pbuf->end_addr - (char *)*ptr < bytes) {
+		head = (char *)pbuf->end_addr - (char *)*ptr;
 		tail = bytes - head;
 	} else {
 		head = bytes;
@@ -515,26 +525,45 @@ static int copy_to_pbuffer(struct probe_dma_buf *pbuf, void *data,
 	}
 
 	/* copy data to probe buffer */
-	if (memcpy_s((void *)pbuf->w_ptr, pbuf->end_addr - pbuf->w_ptr, data, head)) {
+	if (memcpy_s((void *)*ptr, pbuf->end_addr - *ptr, data, head)) {
 		tr_err(&pr_tr, "copy_to_pbuffer(): memcpy_s() failed");
 		return -EINVAL;
 	}
-	dcache_writeback_region((void *)pbuf->w_ptr, head);
+	dcache_writeback_region((void *)*ptr, head);
 
 	/* buffer ended so needs to do a second copy */
 	if (tail) {
-		pbuf->w_ptr = pbuf->addr;
-		if (memcpy_s((void *)pbuf->w_ptr, (char *)pbuf->end_addr - (char *)pbuf->w_ptr,
+		*ptr = pbuf->addr;
+		if (memcpy_s((void *)*ptr, pbuf->end_addr - *ptr,
 			     (char *)data + head, tail)) {
 			tr_err(&pr_tr, "copy_to_pbuffer(): memcpy_s() failed");
 			return -EINVAL;
 		}
-		dcache_writeback_region((void *)pbuf->w_ptr, tail);
-		pbuf->w_ptr = pbuf->w_ptr + tail;
+		dcache_writeback_region((void *)*ptr, tail);
+		*ptr = *ptr + tail;
 	} else {
-		pbuf->w_ptr = pbuf->w_ptr + head;
+		*ptr = *ptr + head;
 	}
 
+	return 0;
+}
+
+/**
+ * \brief Copy data to probe buffer and update buffer pointers.
+ * \param[out] probe DMA buffer.
+ * \param[in] data pointer.
+ * \param[in] size.
+ * \return 0 on success, error code otherwise.
+ */
+static int copy_to_pbuffer(struct probe_dma_buf *pbuf, void *data,
+			   uint32_t bytes)
+{
+	int ret;
+
+	ret = copy_to_pbuffer_at(pbuf, &pbuf->w_ptr, data, bytes);
+	if (ret < 0)
+		return ret;
+
 	pbuf->avail = (uintptr_t)pbuf->avail + bytes;
 
 	return 0;
@@ -598,20 +627,22 @@ static int copy_from_pbuffer(struct probe_dma_buf *pbuf, void *data,
 }
 
 /**
- * \brief Generate probe data packet header, update timestamp, calc crc
- *	  and copy data to probe buffer.
+ * \brief Open data packet for extraction probe point, update timestamp
+ *	  and reserve space for the header in probe buffer.
+ *
+ * Data of following produce events of the same buffer is appended to the
+ * packet until it is closed, so the header is completed only then.
+ * \param[in] probe point.
  * \param[in] component buffer pointer.
- * \param[in] data size.
  * \param[in] audio format.
  * \return 0 on success, error code otherwise.
  */
-static int probe_gen_header(struct comp_buffer *buffer, uint32_t size,
-			    uint32_t format)
+static int probe_packet_open(struct probe_point *point,
+			     struct comp_buffer *buffer, uint32_t format)
 {
 	struct probe_pdata *_probe = probe_get();
 	struct probe_data_packet *header;
 	uint64_t timestamp;
-	uint32_t crc;
 
 	header = &_probe->header;
 	timestamp = platform_timer_get(timer_get());
@@ -622,18 +653,39 @@ static int probe_gen_header(struct comp_buffer *buffer, uint32_t size,
 	header->timestamp_low = (uint32_t)timestamp;
 	header->timestamp_high = (uint32_t)(timestamp >> 32);
 	header->checksum = 0;
-	header->data_size_bytes = size;
-
-	/* calc crc to check validation by probe parse app */
-	crc = crc32(0, header, sizeof(*header));
-	header->checksum = crc;
+	header->data_size_bytes = 0;
 
-	dcache_writeback_region(header, sizeof(*header));
+	_probe->ext_point = point;
+	_probe->header_ptr = _probe->ext_dma.dmapb.w_ptr;
 
 	return copy_to_pbuffer(&_probe->ext_dma.dmapb, header,
 			       sizeof(struct probe_data_packet));
 }
 
+/**
+ * \brief Close open data packet, calc crc and write its final header
+ *	  to probe buffer.
+ * \param[in] probes main struct.
+ */
+static void probe_packet_close(struct probe_pdata *_probe)
+{
+	struct probe_data_packet *header = &_probe->header;
+	uintptr_t ptr = _probe->header_ptr;
+
+	if (!_probe->ext_point)
+		return;
+
+	_probe->ext_point = NULL;
+
+	/* calc crc to check validation by probe parse app */
+	header->checksum = 0;
+	header->checksum = crc32(0, header, sizeof(*header));
+
+	if (copy_to_pbuffer_at(&_probe->ext_dma.dmapb, &ptr, header,
+			       sizeof(*header)) < 0)
+		tr_err(&pr_tr, "probe_packet_close(): header write failed");
+}
+
 /**
  * \brief Generate description of audio format for extraction probes.
  * \param[in] frame_fmt.
@@ -737,49 +789,43 @@ static uint32_t probe_gen_format(uint32_t frame_fmt, uint32_t rate,
 
 /**
  * \brief General extraction probe callback, called from buffer produce.
- *	  It will search for probe point connected to this buffer.
- *	  Extraction probe: generate format, header and copy data to probe buffer.
- *	  Injection probe: find corresponding DMA, check avail data, copy data,
+ *	  Probe point is registered as the receiver of the notification,
+ *	  so no search is needed.
+ *	  Extraction probe: open data packet unless the last one belongs to
+ *	  this probe point and copy data to probe buffer.
+ *	  Injection probe: check avail data of the point DMA, copy data,
  *	  update pointers and request more data from host if needed.
- * \param[in] arg pointer (not used).
+ * \param[in] arg probe point.
  * \param[in] type of notify.
  * \param[in] data pointer.
  */
 static void probe_cb_produce(void *arg, enum notify_id type, void *data)
 {
 	struct probe_pdata *_probe = probe_get();
+	struct probe_point *point = arg;
 	struct buffer_cb_transact *cb_data = data;
 	struct comp_buffer *buffer = cb_data->buffer;
 	struct probe_dma_ext *dma;
-	uint32_t buffer_id;
 	uint32_t head, tail;
 	uint32_t free_bytes = 0;
 	int32_t copy_bytes = 0;
-	uint32_t ret, i, j;
+	uint32_t ret;
 	uint32_t format;
 
-	buffer_id = buffer->id;
-
-	/* search for probe point connected to this buffer */
-	for (i = 0; i < CONFIG_PROBE_POINTS_MAX; i++)
-		if (_probe->probe_points[i].buffer_id == buffer_id)
-			break;
+	if (point->purpose == PROBE_PURPOSE_EXTRACTION) {
+		/* small transactions coalesce into the open packet */
+		if (_probe->ext_point != point) {
+			probe_packet_close(_probe);
 
-	if (i == CONFIG_PROBE_POINTS_MAX) {
-		tr_err(&pr_tr, "probe_cb_produce(): probe not found for buffer id: %d",
-		       buffer_id);
-		return;
-	}
+			format = probe_gen_format(buffer->stream.frame_fmt,
+						  buffer->stream.rate,
+						  buffer->stream.channels);
+			ret = probe_packet_open(point, buffer, format);
+			if (ret < 0)
+				goto err;
+		}
 
-	if (_probe->probe_points[i].purpose == PROBE_PURPOSE_EXTRACTION) {
-		format = probe_gen_format(buffer->stream.frame_fmt,
-					  buffer->stream.rate,
-					  buffer->stream.channels);
-		ret = probe_gen_header(buffer,
-				       cb_data->transaction_amount,
-				       format);
-		if (ret < 0)
-			goto err;
+		_probe->header.data_size_bytes += cb_data->transaction_amount;
 
 		/* check if transaction amount exceeds component buffer end addr */
 		/* if yes: divide copying into two stages, head and tail */
@@ -810,20 +856,7 @@ static void probe_cb_produce(void *arg, enum notify_id type, void *data)
 		    _probe->ext_dma.dmapb.size >> 2)
 			probe_task(NULL);
 	} else {
-		/* search for DMA used by this probe point */
-		for (j = 0; j < CONFIG_PROBE_DMA_MAX; j++) {
-			if (_probe->inject_dma[j].stream_tag !=
-			    PROBE_DMA_INVALID &&
-			    _probe->inject_dma[j].stream_tag ==
-			    _probe->probe_points[i].stream_tag) {
-				break;
-			}
-		}
-		if (j == CONFIG_PROBE_DMA_MAX) {
-			tr_err(&pr_tr, "probe_cb_produce(): dma not found");
-			return;
-		}
-		dma = &_probe->inject_dma[j];
+		dma = _probe->point_dma[point - _probe->probe_points];
 		/* get avail data info */
 		ret = dma_get_data_size(dma->dc.chan,
 					&dma->dmapb.avail,
@@ -887,23 +920,59 @@ err:
 	tr_err(&pr_tr, "probe_cb_produce(): failed to generate probe data");
 }
 
+/**
+ * \brief Disconnect probe point from its buffer and mark it invalid.
+ * \param[in] probes main struct.
+ * \param[in] probe point.
+ */
+static void probe_point_release(struct probe_pdata *_probe,
+				struct probe_point *point)
+{
+	if (_probe->ext_point == point)
+		probe_packet_close(_probe);
+
+	/* the point is the receiver of its own callbacks only */
+	notifier_unregister(point, NULL, NOTIFIER_ID_BUFFER_PRODUCE);
+	notifier_unregister(point, NULL, NOTIFIER_ID_BUFFER_FREE);
+
+	_probe->point_dma[point - _probe->probe_points] = NULL;
+	point->stream_tag = PROBE_POINT_INVALID;
+}
+
+/**
+ * \brief Cancel probe task if no extraction probe point is left.
+ * \param[in] probes main struct.
+ */
+static void probe_task_update(struct probe_pdata *_probe)
+{
+	uint32_t j;
+
+	for (j = 0; j < CONFIG_PROBE_POINTS_MAX; j++) {
+		if (_probe->probe_points[j].stream_tag != PROBE_DMA_INVALID &&
+		    _probe->probe_points[j].purpose == PROBE_PURPOSE_EXTRACTION)
+			return;
+	}
+
+	tr_dbg(&pr_tr, "probe_task_update(): cancel probe task");
+	schedule_task_cancel(&_probe->dmap_work);
+}
+
 /**
  * \brief Callback for buffer free, it will remove probe point.
- * \param[in] arg pointer (not used).
+ * \param[in] arg probe point.
  * \param[in] type of notify.
  * \param[in] data pointer.
  */
 static void probe_cb_free(void *arg, enum notify_id type, void *data)
 {
+	struct probe_pdata *_probe = probe_get();
 	struct buffer_cb_free *cb_data = data;
-	uint32_t buffer_id = cb_data->buffer->id;
-	uint32_t ret;
 
-	tr_dbg(&pr_tr, "probe_cb_free() buffer_id = %u", buffer_id);
+	tr_dbg(&pr_tr, "probe_cb_free() buffer_id = %u", cb_data->buffer->id);
 
-	ret = probe_point_remove(1, &buffer_id);
-	if (ret < 0)
-		tr_err(&pr_tr, "probe_cb_free(): probe_point_remove() failed");
+	/* other points of this buffer are removed by their own callbacks */
+	probe_point_release(_probe, arg);
+	probe_task_update(_probe);
 }
 
 int probe_point_add(uint32_t count, struct probe_point *probe)
@@ -1018,6 +1087,8 @@ int probe_point_add(uint32_t count, struct probe_point *probe)
 
 				return -EBUSY;
 			}
+
+			_probe->point_dma[first_free] = &_probe->inject_dma[j];
 		} else if (probe[i].purpose == PROBE_PURPOSE_EXTRACTION) {
 			for (j = 0; j < CONFIG_PROBE_POINTS_MAX; j++) {
 				if (_probe->probe_points[j].stream_tag != PROBE_DMA_INVALID &&
@@ -1038,10 +1109,12 @@ int probe_point_add(uint32_t count, struct probe_point *probe)
 		_probe->probe_points[first_free].stream_tag =
 			probe[i].stream_tag;
 
-		notifier_register(_probe, dev->cb, NOTIFIER_ID_BUFFER_PRODUCE,
-				  &probe_cb_produce, 0);
-		notifier_register(_probe, dev->cb, NOTIFIER_ID_BUFFER_FREE,
-				  &probe_cb_free, 0);
+		/* the point itself is passed to callbacks */
+		notifier_register(&_probe->probe_points[first_free], dev->cb,
+				  NOTIFIER_ID_BUFFER_PRODUCE, &probe_cb_produce,
+				  0);
+		notifier_register(&_probe->probe_points[first_free], dev->cb,
+				  NOTIFIER_ID_BUFFER_FREE, &probe_cb_free, 0);
 	}
 
 	return 0;
@@ -1087,7 +1160,6 @@ int probe_point_info(struct sof_ipc_probe_info_params *data, uint32_t max_size)
 int probe_point_remove(uint32_t count, uint32_t *buffer_id)
 {
 	struct probe_pdata *_probe = probe_get();
-	struct ipc_comp_dev *dev;
 	uint32_t i;
 	uint32_t j;
 
@@ -1103,29 +1175,13 @@ int probe_point_remove(uint32_t count, uint32_t *buffer_id)
 
 		for (j = 0; j < CONFIG_PROBE_POINTS_MAX; j++) {
 			if (_probe->probe_points[j].stream_tag != PROBE_POINT_INVALID &&
-			    _probe->probe_points[j].buffer_id == buffer_id[i]) {
-				dev = ipc_get_comp_by_id(ipc_get(), buffer_id[i]);
-				if (dev) {
-					notifier_unregister(_probe, dev->cb,
-							    NOTIFIER_ID_BUFFER_PRODUCE);
-					notifier_unregister(_probe, dev->cb,
-							    NOTIFIER_ID_BUFFER_FREE);
-				}
-
-				_probe->probe_points[j].stream_tag =
-					PROBE_POINT_INVALID;
-			}
+			    _probe->probe_points[j].buffer_id == buffer_id[i])
+				probe_point_release(_probe,
+						    &_probe->probe_points[j]);
 		}
 	}
-	for (j = 0; j < CONFIG_PROBE_POINTS_MAX; j++) {
-		if (_probe->probe_points[j].stream_tag != PROBE_DMA_INVALID &&
-		    _probe->probe_points[j].purpose == PROBE_PURPOSE_EXTRACTION)
-			break;
-	}
-	if (j == CONFIG_PROBE_POINTS_MAX) {
-		tr_dbg(&pr_tr, "probe_point_remove(): cancel probe task");
-		schedule_task_cancel(&_probe->dmap_work);
-	}
+
+	probe_task_update(_probe);
 
 	return 0;
 }
@@ -12,14 +12,15 @@
 #include <sof/lib/alloc.h>
 #include <sof/lib/clk.h>
 #include <sof/lib/uuid.h>
-#include <sof/list.h>
 #include <sof/platform.h>
 #include <sof/schedule/edf_schedule.h>
 #include <sof/schedule/schedule.h>
 #include <sof/schedule/task.h>
 #include <sof/sof.h>
+#include <sof/string.h>
 #include <ipc/topology.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -29,8 +30,18 @@ DECLARE_SOF_UUID("edf-schedule", edf_sched_uuid, 0x77de2074, 0x828c, 0x4044,
 
 DECLARE_TR_CTX(edf_tr, SOF_UUID(edf_sched_uuid), LOG_LEVEL_INFO);
 
+/* task is not in the ready queue */
+#define EDF_HEAP_INVALID	UINT32_MAX
+
+/* ready queue entries added at once */
+#define EDF_HEAP_GROW		8
+
 struct edf_schedule_data {
-	struct list_item list;	/* list of tasks in priority queue */
+	struct task **heap;	/* ready queue, binary heap of deadlines */
+	uint32_t heap_size;	/* queued and running tasks */
+	uint32_t heap_capacity;	/* allocated heap entries */
+	uint32_t task_count;	/* initialized tasks */
+	uint32_t order;		/* queueing order of the next task */
 	uint32_t clock;
 	int irq;
 };
@@ -41,10 +52,141 @@ static int schedule_edf_task_complete(void *data, struct task *task);
 static int schedule_edf_task_running(void *data, struct task *task);
 static void schedule_edf(void *data);
 
+/* earlier deadline first, equal deadlines in queueing order */
+static bool edf_task_before(struct task *a, struct task *b)
+{
+	struct edf_task_pdata *pa = edf_sch_get_pdata(a);
+	struct edf_task_pdata *pb = edf_sch_get_pdata(b);
+
+	if (pa->deadline != pb->deadline)
+		return pa->deadline < pb->deadline;
+
+	return (int32_t)(pa->order - pb->order) < 0;
+}
+
+static void edf_heap_set(struct edf_schedule_data *edf_sch, uint32_t i,
+			 struct task *task)
+{
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+
+	edf_sch->heap[i] = task;
+	edf_pdata->heap_index = i;
+}
+
+static void edf_heap_sift_up(struct edf_schedule_data *edf_sch, uint32_t i,
+			     struct task *task)
+{
+	uint32_t parent;
+
+	while (i) {
+		parent = (i - 1) >> 1;
+		if (!edf_task_before(task, edf_sch->heap[parent]))
+			break;
+
+		edf_heap_set(edf_sch, i, edf_sch->heap[parent]);
+		i = parent;
+	}
+
+	edf_heap_set(edf_sch, i, task);
+}
+
+static void edf_heap_sift_down(struct edf_schedule_data *edf_sch, uint32_t i,
+			       struct task *task)
+{
+	uint32_t child;
+
+	while ((child = 2 * i + 1) < edf_sch->heap_size) {
+		if (child + 1 < edf_sch->heap_size &&
+		    edf_task_before(edf_sch->heap[child + 1],
+				    edf_sch->heap[child]))
+			child++;
+
+		if (!edf_task_before(edf_sch->heap[child], task))
+			break;
+
+		edf_heap_set(edf_sch, i, edf_sch->heap[child]);
+		i = child;
+	}
+
+	edf_heap_set(edf_sch, i, task);
+}
+
+/* deadlines of EDF tasks are fixed, so the key is sampled only once here */
+static void edf_heap_insert(struct edf_schedule_data *edf_sch,
+			    struct task *task)
+{
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+
+	edf_pdata->deadline = task_get_deadline(task);
+	edf_pdata->order = edf_sch->order++;
+
+	edf_heap_sift_up(edf_sch, edf_sch->heap_size++, task);
+}
+
+static void edf_heap_remove(struct edf_schedule_data *edf_sch,
+			    struct task *task)
+{
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+	uint32_t i = edf_pdata->heap_index;
+	struct task *last;
+
+	if (i == EDF_HEAP_INVALID)
+		return;
+
+	edf_pdata->heap_index = EDF_HEAP_INVALID;
+
+	last = edf_sch->heap[--edf_sch->heap_size];
+	if (i == edf_sch->heap_size)
+		return;
+
+	/* move the last task into the hole */
+	if (i && edf_task_before(last, edf_sch->heap[(i - 1) >> 1]))
+		edf_heap_sift_up(edf_sch, i, last);
+	else
+		edf_heap_sift_down(edf_sch, i, last);
+}
+
+/* makes sure every initialized task fits into the ready queue */
+static int edf_heap_reserve(struct edf_schedule_data *edf_sch)
+{
+	struct task **heap;
+	struct task **old;
+	uint32_t capacity;
+	uint32_t flags;
+
+	if (edf_sch->task_count < edf_sch->heap_capacity) {
+		edf_sch->task_count++;
+		return 0;
+	}
+
+	capacity = edf_sch->heap_capacity + EDF_HEAP_GROW;
+	heap = rzalloc(SOF_MEM_ZONE_SYS_RUNTIME, 0, SOF_MEM_CAPS_RAM,
+		       capacity * sizeof(*heap));
+	if (!heap)
+		return -ENOMEM;
+
+	irq_local_disable(flags);
+
+	if (edf_sch->heap_size)
+		memcpy_s(heap, capacity * sizeof(*heap), edf_sch->heap,
+			 edf_sch->heap_size * sizeof(*heap));
+
+	old = edf_sch->heap;
+	edf_sch->heap = heap;
+	edf_sch->heap_capacity = capacity;
+	edf_sch->task_count++;
+
+	irq_local_enable(flags);
+
+	rfree(old);
+
+	return 0;
+}
+
 static void schedule_edf_task_run(struct task *task, void *data)
 {
 	while (1) {
-		/* execute task run function and remove task from the list
+		/* execute task run function and remove task from the queue
 		 * only if completed
 		 */
 		if (task_run(task) == SOF_TASK_STATE_COMPLETED)
@@ -58,39 +200,16 @@ static void schedule_edf_task_run(struct task *task, void *data)
 static void edf_scheduler_run(void *data)
 {
 	struct edf_schedule_data *edf_sch = data;
-	uint64_t deadline_next = SOF_TASK_DEADLINE_IDLE;
 	struct task *task_next = NULL;
-	struct list_item *tlist;
-	struct task *task;
-	uint64_t deadline;
 	uint32_t flags;
 
 	tr_dbg(&edf_tr, "edf_scheduler_run()");
 
 	irq_local_disable(flags);
 
-	/* find next task to run */
-	list_for_item(tlist, &edf_sch->list) {
-		task = container_of(tlist, struct task, list);
-
-		if (task->state != SOF_TASK_STATE_QUEUED &&
-		    task->state != SOF_TASK_STATE_RUNNING)
-			continue;
-
-		deadline = task_get_deadline(task);
-
-		if (deadline == SOF_TASK_DEADLINE_NOW) {
-			/* task needs to be scheduled ASAP */
-			task_next = task;
-			break;
-		}
-
-		/* get earliest deadline */
-		if (deadline <= deadline_next) {
-			deadline_next = deadline;
-			task_next = task;
-		}
-	}
+	/* only queued and running tasks are kept in the heap */
+	if (edf_sch->heap_size)
+		task_next = edf_sch->heap[0];
 
 	irq_local_enable(flags);
 
@@ -119,6 +238,12 @@ static int schedule_edf_task(void *data, struct task *task, uint64_t start,
 		return -EALREADY;
 	}
 
+	if (edf_sch->heap_size == edf_sch->heap_capacity) {
+		tr_err(&edf_tr, "schedule_edf_task(), task not initialized on this core");
+		irq_local_enable(flags);
+		return -ENOMEM;
+	}
+
 	/* get current time */
 	current = platform_timer_get(timer_get());
 
@@ -128,8 +253,8 @@ static int schedule_edf_task(void *data, struct task *task, uint64_t start,
 	task->start = start ? task->start + ticks_per_ms * start / 1000 :
 		current;
 
-	/* add task to the list */
-	list_item_append(&task->list, &edf_sch->list);
+	/* add task to the ready queue */
+	edf_heap_insert(edf_sch, task);
 
 	task->state = SOF_TASK_STATE_QUEUED;
 
@@ -162,6 +287,7 @@ int schedule_task_init_edf(struct task *task, uint32_t uid,
 		return -ENOMEM;
 	}
 
+	edf_pdata->heap_index = EDF_HEAP_INVALID;
 	edf_sch_set_pdata(task, edf_pdata);
 
 	task->ops.complete = ops->complete;
@@ -173,6 +299,8 @@ int schedule_task_init_edf(struct task *task, uint32_t uid,
 			      task, scheduler_get_data(SOF_SCHEDULE_EDF),
 			      task->core, NULL, 0) < 0)
 		goto error;
+	if (edf_heap_reserve(scheduler_get_data(SOF_SCHEDULE_EDF)) < 0)
+		goto error;
 
 	/* flush for slave core */
 	if (cpu_is_slave(task->core))
@@ -208,6 +336,9 @@ static int schedule_edf_task_running(void *data, struct task *task)
 
 static int schedule_edf_task_complete(void *data, struct task *task)
 {
+	struct edf_schedule_data *edf_sch = data;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
+	uint64_t current;
 	uint32_t flags;
 
 	tr_dbg(&edf_tr, "schedule_edf_task_complete()");
@@ -217,15 +348,29 @@ static int schedule_edf_task_complete(void *data, struct task *task)
 	task_complete(task);
 
 	task->state = SOF_TASK_STATE_COMPLETED;
-	list_item_del(&task->list);
+	edf_heap_remove(edf_sch, task);
 
 	irq_local_enable(flags);
 
+	current = platform_timer_get(timer_get());
+
+	/* NOW and the idle deadlines are priorities, not points in time */
+	if (edf_pdata->deadline != SOF_TASK_DEADLINE_NOW &&
+	    edf_pdata->deadline < SOF_TASK_DEADLINE_ALMOST_IDLE &&
+	    current > edf_pdata->deadline) {
+		edf_pdata->deadline_misses++;
+		tr_warn_ratelimited(&edf_tr, "schedule_edf_task_complete(), task 0x%08x missed deadline by %u ticks, misses %u",
+				    task->uid,
+				    (uint32_t)(current - edf_pdata->deadline),
+				    edf_pdata->deadline_misses);
+	}
+
 	return 0;
 }
 
 static int schedule_edf_task_cancel(void *data, struct task *task)
 {
+	struct edf_schedule_data *edf_sch = data;
 	uint32_t flags;
 
 	tr_dbg(&edf_tr, "schedule_edf_task_cancel()");
@@ -235,7 +380,7 @@ static int schedule_edf_task_cancel(void *data, struct task *task)
 	/* cancel and delete only if queued */
 	if (task->state == SOF_TASK_STATE_QUEUED) {
 		task->state = SOF_TASK_STATE_CANCEL;
-		list_item_del(&task->list);
+		edf_heap_remove(edf_sch, task);
 	}
 
 	irq_local_enable(flags);
@@ -245,12 +390,19 @@ static int schedule_edf_task_cancel(void *data, struct task *task)
 
 static int schedule_edf_task_free(void *data, struct task *task)
 {
+	struct edf_schedule_data *edf_sch = data;
 	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(task);
 	uint32_t flags;
 
+	if (edf_pdata->deadline_misses)
+		tr_info(&edf_tr, "schedule_edf_task_free(), task 0x%08x missed %u deadlines",
+			task->uid, edf_pdata->deadline_misses);
+
 	irq_local_disable(flags);
 
 	task->state = SOF_TASK_STATE_FREE;
+	edf_heap_remove(edf_sch, task);
+	edf_sch->task_count--;
 
 	task_context_free(edf_pdata->ctx);
 	edf_pdata->ctx = NULL;
@@ -270,7 +422,6 @@ int scheduler_init_edf(void)
 
 	edf_sch = rzalloc(SOF_MEM_ZONE_SYS, 0, SOF_MEM_CAPS_RAM,
 			  sizeof(*edf_sch));
-	list_init(&edf_sch->list);
 	edf_sch->clock = PLATFORM_DEFAULT_CLOCK;
 
 	scheduler_init(SOF_SCHEDULE_EDF, &schedule_edf_ops, edf_sch);
@@ -304,8 +455,6 @@ static void scheduler_free_edf(void *data)
 	/* free main task context */
 	task_main_free();
 
-	list_item_del(&edf_sch->list);
-
 	irq_local_enable(flags);
 }
 
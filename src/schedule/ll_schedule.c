@@ -24,6 +24,7 @@
 #include <sof/schedule/schedule.h>
 #include <sof/schedule/task.h>
 #include <sof/spinlock.h>
+#include <ipc/debug.h>
 #include <ipc/topology.h>
 #include <config.h>
 #include <errno.h>
@@ -39,7 +40,7 @@ DECLARE_TR_CTX(ll_tr, SOF_UUID(ll_sched_uuid), LOG_LEVEL_INFO);
 
 /* one instance of data allocated per core */
 struct ll_schedule_data {
-	struct list_item tasks;			/* list of ll tasks */
+	struct list_item tasks;			/* ll tasks ordered by start */
 	atomic_t num_tasks;			/* number of ll tasks */
 #if CONFIG_PERFORMANCE_COUNTERS
 	struct perf_cnt_data pcd;
@@ -54,23 +55,76 @@ const struct scheduler_ops schedule_ll_ops;
 		(uint32_t)((pcd)->plat_delta_peak),		\
 		(uint32_t)((pcd)->cpu_delta_peak))
 
-static bool schedule_ll_is_pending(struct ll_schedule_data *sch)
+static void schedule_ll_task_insert(struct task *task, struct list_item *tasks)
+{
+	struct list_item *tlist;
+	struct task *curr_task;
+
+	/* tasks are kept in the list ordered by start time and tasks with
+	 * the same start are kept in order of insertion, search from the end
+	 * as a rescheduled task usually starts the latest
+	 */
+	list_for_item_prev(tlist, tasks) {
+		curr_task = container_of(tlist, struct task, list);
+		if (curr_task->start <= task->start) {
+			list_item_prepend(&task->list, &curr_task->list);
+			return;
+		}
+	}
+
+	/* if task has not been added, means that it starts the earliest */
+	list_item_prepend(&task->list, tasks);
+}
+
+static void schedule_ll_task_insert_run(struct task *task,
+					struct list_item *tasks)
+{
+	struct list_item *tlist;
+	struct task *curr_task;
+
+	/* tasks are added into the list from highest to lowest priority
+	 * and tasks with the same priority should be served on
+	 * a first-come-first-serve basis
+	 */
+	list_for_item(tlist, tasks) {
+		curr_task = container_of(tlist, struct task, list);
+		if (task->priority < curr_task->priority) {
+			list_item_append(&task->list, &curr_task->list);
+			return;
+		}
+	}
+
+	/* if task has not been added, means that it has the lowest
+	 * priority and should be added at the end of the list
+	 */
+	list_item_append(&task->list, tasks);
+}
+
+static bool schedule_ll_is_pending(struct ll_schedule_data *sch,
+				   struct list_item *run)
 {
+	struct list_item *wlist;
 	struct list_item *tlist;
 	struct task *task;
-	uint32_t pending_count = 0;
 
-	/* mark each valid task as pending */
-	list_for_item(tlist, &sch->tasks) {
-		task = container_of(tlist, struct task, list);
+	/* move each pending task to the run list */
+	list_for_item_safe(wlist, tlist, &sch->tasks) {
+		task = container_of(wlist, struct task, list);
+
+		if (!domain_is_pending(sch->domain, task)) {
+			/* none of the later starting tasks is pending */
+			if (sch->domain->start_ordered)
+				break;
 
-		if (domain_is_pending(sch->domain, task)) {
-			task->state = SOF_TASK_STATE_PENDING;
-			pending_count++;
+			continue;
 		}
+
+		task->state = SOF_TASK_STATE_PENDING;
+		list_item_del(&task->list);
+		schedule_ll_task_insert_run(task, run);
 	}
 
-	return pending_count > 0;
+	return !list_is_empty(run);
 }
 
 static void schedule_ll_task_update_start(struct ll_schedule_data *sch,
@@ -87,27 +141,50 @@ static void schedule_ll_task_update_start(struct ll_schedule_data *sch,
 		task->start = next + last_tick;
 }
 
+static void schedule_ll_task_stats(struct ll_schedule_data *sch,
+				   struct ll_task_pdata *pdata, uint32_t ticks)
+{
+	if (!pdata->exec_count || ticks < pdata->exec_min)
+		pdata->exec_min = ticks;
+	if (ticks > pdata->exec_max)
+		pdata->exec_max = ticks;
+
+	pdata->exec_total += ticks;
+	pdata->exec_count++;
+
+	/* period is the budget of the task */
+	if (pdata->period &&
+	    ticks > sch->domain->ticks_per_ms * pdata->period / 1000)
+		pdata->overruns++;
+}
+
 static void schedule_ll_tasks_execute(struct ll_schedule_data *sch,
+				      struct list_item *run,
 				      uint64_t last_tick)
 {
-	struct list_item *wlist;
-	struct list_item *tlist;
+	struct ll_task_pdata *pdata;
 	struct task *task;
+	uint64_t begin;
 	int cpu = cpu_get_id();
 
-	/* check each task in the list for pending */
-	list_for_item_safe(wlist, tlist, &sch->tasks) {
-		task = container_of(wlist, struct task, list);
+	/* run pending tasks in priority order, a task canceled by
+	 * a previous one is already removed from the run list
+	 */
+	while (!list_is_empty(run)) {
+		task = list_first_item(run, struct task, list);
+		list_item_del(&task->list);
+		pdata = ll_sch_get_pdata(task);
 
-		/* run task if its pending and remove from the list */
-		if (task->state != SOF_TASK_STATE_PENDING)
-			continue;
+		begin = platform_timer_get(timer_get());
 
 		task->state = task_run(task);
 
+		schedule_ll_task_stats(sch, pdata,
+				       platform_timer_get(timer_get()) - begin);
+
 		/* do we need to reschedule this task */
 		if (task->state == SOF_TASK_STATE_COMPLETED) {
-			list_item_del(&task->list);
+			pdata->queued = false;
 			atomic_sub(&sch->domain->total_num_tasks, 1);
 
 			/* don't enable irq, if no more tasks to do */
@@ -118,9 +195,10 @@ static void schedule_ll_tasks_execute(struct ll_schedule_data *sch,
 			tr_info(&ll_tr, "num_tasks %d total_num_tasks %d",
 				atomic_read(&sch->num_tasks),
 				atomic_read(&sch->domain->total_num_tasks));
-		} else {
-			/* update task's start time */
+		} else if (pdata->queued) {
+			/* update task's start time and queue it again */
 			schedule_ll_task_update_start(sch, task, last_tick);
+			schedule_ll_task_insert(task, &sch->tasks);
 		}
 	}
 
@@ -154,6 +232,7 @@ static void schedule_ll_clients_reschedule(struct ll_schedule_data *sch)
 static void schedule_ll_tasks_run(void *data)
 {
 	struct ll_schedule_data *sch = data;
+	struct list_item run;
 	uint32_t num_clients;
 	uint64_t last_tick;
 	uint32_t flags;
@@ -186,8 +265,9 @@ static void schedule_ll_tasks_run(void *data)
 		       NOTIFIER_TARGET_CORE_LOCAL, NULL, 0);
 
 	/* run tasks if there are any pending */
-	if (schedule_ll_is_pending(sch))
-		schedule_ll_tasks_execute(sch, last_tick);
+	list_init(&run);
+	if (schedule_ll_is_pending(sch, &run))
+		schedule_ll_tasks_execute(sch, &run, last_tick);
 
 	notifier_event(sch, NOTIFIER_ID_LL_POST_RUN,
 		       NOTIFIER_TARGET_CORE_LOCAL, NULL, 0);
@@ -283,51 +363,19 @@ static void schedule_ll_domain_clear(struct ll_schedule_data *sch,
 	domain_unregister(sch->domain, task, atomic_read(&sch->num_tasks));
 }
 
-static void schedule_ll_task_insert(struct task *task, struct list_item *tasks)
-{
-	struct list_item *tlist;
-	struct task *curr_task;
-
-	/* tasks are added into the list from highest to lowest priority
-	 * and tasks with the same priority should be served on
-	 * a first-come-first-serve basis
-	 */
-	list_for_item(tlist, tasks) {
-		curr_task = container_of(tlist, struct task, list);
-		if (task->priority < curr_task->priority) {
-			list_item_append(&task->list, &curr_task->list);
-			return;
-		}
-	}
-
-	/* if task has not been added, means that it has the lowest
-	 * priority and should be added at the end of the list
-	 */
-	list_item_append(&task->list, tasks);
-}
-
 static int schedule_ll_task(void *data, struct task *task, uint64_t start,
 			    uint64_t period)
 {
 	struct ll_schedule_data *sch = data;
-	struct ll_task_pdata *pdata;
-	struct list_item *tlist;
-	struct task *curr_task;
+	struct ll_task_pdata *pdata = ll_sch_get_pdata(task);
 	uint32_t flags;
 	int ret = 0;
 
 	irq_local_disable(flags);
 
-	/* check if task is already scheduled */
-	list_for_item(tlist, &sch->tasks) {
-		curr_task = container_of(tlist, struct task, list);
-
-		/* keep original start */
-		if (curr_task == task)
-			goto out;
-	}
-
-	pdata = ll_sch_get_pdata(task);
+	/* keep original start if task is already scheduled */
+	if (pdata->queued)
+		goto out;
 
 	tr_info(&ll_tr, "task add %p %s", (uintptr_t)task, task->uid);
 	tr_info(&ll_tr, "task params pri %d flags %d start %u period %u",
@@ -335,15 +383,10 @@ static int schedule_ll_task(void *data, struct task *task, uint64_t start,
 
 	pdata->period = period;
 
-	/* insert task into the list */
-	schedule_ll_task_insert(task, &sch->tasks);
-
 	/* set schedule domain */
 	ret = schedule_ll_domain_set(sch, task, period);
-	if (ret < 0) {
-		list_item_del(&task->list);
+	if (ret < 0)
 		goto out;
-	}
 
 	task->start = sch->domain->ticks_per_ms * start / 1000;
 
@@ -352,6 +395,10 @@ static int schedule_ll_task(void *data, struct task *task, uint64_t start,
 	else
 		task->start += sch->domain->last_tick;
 
+	/* insert task into the list */
+	schedule_ll_task_insert(task, &sch->tasks);
+	pdata->queued = true;
+
 	platform_shared_commit(sch->domain, sizeof(*sch->domain));
 
 out:
@@ -410,8 +457,7 @@ static int schedule_ll_task_free(void *data, struct task *task)
 static int schedule_ll_task_cancel(void *data, struct task *task)
 {
 	struct ll_schedule_data *sch = data;
-	struct list_item *tlist;
-	struct task *curr_task;
+	struct ll_task_pdata *pdata = ll_sch_get_pdata(task);
 	uint32_t flags;
 
 	irq_local_disable(flags);
@@ -419,14 +465,9 @@ static int schedule_ll_task_cancel(void *data, struct task *task)
 	tr_info(&ll_tr, "task cancel %p %s", (uintptr_t)task, task->uid);
 
 	/* check to see if we are scheduled */
-	list_for_item(tlist, &sch->tasks) {
-		curr_task = container_of(tlist, struct task, list);
-
-		/* found it */
-		if (curr_task == task) {
-			schedule_ll_domain_clear(sch, task);
-			break;
-		}
+	if (pdata->queued) {
+		schedule_ll_domain_clear(sch, task);
+		pdata->queued = false;
 	}
 
 	/* remove work from list */
@@ -441,8 +482,7 @@ static int schedule_ll_task_cancel(void *data, struct task *task)
 static int reschedule_ll_task(void *data, struct task *task, uint64_t start)
 {
 	struct ll_schedule_data *sch = data;
-	struct list_item *tlist;
-	struct task *curr_task;
+	struct ll_task_pdata *pdata = ll_sch_get_pdata(task);
 	uint32_t flags;
 	uint64_t time;
 
@@ -456,14 +496,17 @@ static int reschedule_ll_task(void *data, struct task *task, uint64_t start)
 	irq_local_disable(flags);
 
 	/* check to see if we are already scheduled */
-	list_for_item(tlist, &sch->tasks) {
-		curr_task = container_of(tlist, struct task, list);
-		/* found it */
-		if (curr_task == task) {
-			/* set start time */
-			task->start = time;
-			goto out;
+	if (pdata->queued) {
+		/* set start time */
+		task->start = time;
+
+		/* pending task is queued again after execution */
+		if (task->state != SOF_TASK_STATE_PENDING) {
+			list_item_del(&task->list);
+			schedule_ll_task_insert(task, &sch->tasks);
 		}
+
+		goto out;
 	}
 
 	tr_err(&ll_tr, "reschedule_ll_task(): task not found");
@@ -497,18 +540,32 @@ static void ll_scheduler_recalculate_tasks(struct ll_schedule_data *sch,
 					   struct clock_notify_data *clk_data)
 {
 	uint64_t current = platform_timer_get(timer_get());
+	struct list_item *wlist;
 	struct list_item *tlist;
+	struct list_item tasks;
 	struct task *task;
 	uint64_t delta_ms;
 
-	list_for_item(tlist, &sch->tasks) {
-		task = container_of(tlist, struct task, list);
+	list_init(&tasks);
+
+	list_for_item_safe(wlist, tlist, &sch->tasks) {
+		task = container_of(wlist, struct task, list);
 		delta_ms = (task->start - current) /
 			clk_data->old_ticks_per_msec;
 
 		task->start = delta_ms ?
 			current + sch->domain->ticks_per_ms * delta_ms :
 			current + (sch->domain->ticks_per_ms >> 3);
+
+		list_item_del(&task->list);
+		list_item_append(&task->list, &tasks);
+	}
+
+	/* queue tasks again in order of their new start */
+	list_for_item_safe(wlist, tlist, &tasks) {
+		task = container_of(wlist, struct task, list);
+		list_item_del(&task->list);
+		schedule_ll_task_insert(task, &sch->tasks);
 	}
 }
 
@@ -552,6 +609,52 @@ int scheduler_init_ll(struct ll_schedule_domain *domain)
 	return 0;
 }
 
+static void schedule_ll_task_stats_get(struct ll_schedule_data *sch,
+				       struct task *task,
+				       struct sof_ipc_dbg_ll_task *stats)
+{
+	struct ll_task_pdata *pdata = ll_sch_get_pdata(task);
+
+	stats->uid = task->uid;
+	stats->type = task->type;
+	stats->priority = task->priority;
+	stats->period = pdata->period;
+	stats->count = pdata->exec_count;
+	stats->min = pdata->exec_min;
+	stats->avg = pdata->exec_count ?
+		pdata->exec_total / pdata->exec_count : 0;
+	stats->max = pdata->exec_max;
+	stats->overruns = pdata->overruns;
+	stats->ticks_per_ms = sch->domain->ticks_per_ms;
+}
+
+void schedule_ll_stats(uint16_t type, struct sof_ipc_dbg_ll_stats *stats,
+		       uint32_t max_size)
+{
+	struct ll_schedule_data *sch = scheduler_get_data(type);
+	struct list_item *tlist;
+	struct task *task;
+	uint32_t flags;
+
+	if (!sch)
+		return;
+
+	irq_local_disable(flags);
+
+	list_for_item(tlist, &sch->tasks) {
+		if (stats->rhdr.hdr.size + sizeof(stats->task[0]) > max_size)
+			break;
+
+		task = container_of(tlist, struct task, list);
+		schedule_ll_task_stats_get(sch, task,
+					   &stats->task[stats->num_elems]);
+		stats->num_elems++;
+		stats->rhdr.hdr.size += sizeof(stats->task[0]);
+	}
+
+	irq_local_enable(flags);
+}
+
 const struct scheduler_ops schedule_ll_ops = {
 	.schedule_task		= schedule_ll_task,
 	.schedule_task_free	= schedule_ll_task_free,
@@ -153,6 +153,9 @@ struct ll_schedule_domain *timer_domain_init(struct timer *timer, int clk,
 	domain = domain_init(SOF_SCHEDULE_LL_TIMER, clk, false,
 			     &timer_domain_ops);
 
+	/* pending state depends only on start time */
+	domain->start_ordered = true;
+
 	timer_domain = rzalloc(SOF_MEM_ZONE_SYS, SOF_MEM_FLAG_SHARED,
 			       SOF_MEM_CAPS_RAM, sizeof(*timer_domain));
 	timer_domain->timer = timer;
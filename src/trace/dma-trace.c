@@ -7,6 +7,7 @@
 #include <sof/audio/buffer.h>
 #include <sof/common.h>
 #include <sof/debug/panic.h>
+#include <sof/drivers/interrupt.h>
 #include <sof/drivers/ipc.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/cache.h>
@@ -22,8 +23,10 @@
 #include <sof/spinlock.h>
 #include <sof/string.h>
 #include <sof/trace/dma-trace.h>
+#include <sof/trace/trace.h>
 #include <ipc/topology.h>
 #include <ipc/trace.h>
+#include <user/trace.h>
 #include <config.h>
 #include <errno.h>
 #include <stddef.h>
@@ -42,6 +45,223 @@ DECLARE_SOF_UUID("dma-trace-task", dma_trace_task_uuid, 0x2b972272, 0xc5b1,
 static int dma_trace_get_avail_data(struct dma_trace_data *d,
 				    struct dma_trace_buf *buffer,
 				    int avail);
+static int dtrace_calc_buf_overflow(struct dma_trace_buf *buffer,
+				    uint32_t length);
+
+#if CONFIG_TRACE_STAGING
+
+/* largest entry made by trace_log(), header and all arguments */
+#define DMA_TRACE_SLOT_SIZE \
+	(sizeof(struct log_entry_header) + \
+	 _TRACE_EVENT_MAX_ARGUMENT_COUNT * sizeof(uint32_t))
+
+#define DMA_TRACE_RING_ENTRIES	CONFIG_TRACE_STAGING_ENTRIES
+#define DMA_TRACE_RING_MASK	(DMA_TRACE_RING_ENTRIES - 1)
+
+STATIC_ASSERT(!(DMA_TRACE_RING_ENTRIES & DMA_TRACE_RING_MASK),
+	      trace_staging_entries_not_power_of_two);
+
+struct dma_trace_slot {
+	uint32_t length;
+	uint32_t data[DMA_TRACE_SLOT_SIZE / sizeof(uint32_t)];
+};
+
+/*
+ * Staging ring of one core. Only the owning core writes entries and
+ * w_pos, only the trace work advances r_pos, so neither side locks.
+ * The rings are allocated shared, so they need no cache maintenance.
+ */
+struct dma_trace_ring {
+	uint32_t w_pos;		/* free running write index */
+	uint32_t r_pos;		/* free running read index */
+	uint32_t dropped;	/* entries dropped by the owner */
+	uint32_t dropped_seen;	/* dropped entries already reported */
+	struct dma_trace_slot slot[DMA_TRACE_RING_ENTRIES];
+};
+
+static int dtrace_ring_init(struct dma_trace_data *d)
+{
+	size_t size = sizeof(*d->ring) * PLATFORM_CORE_COUNT;
+
+	if (d->ring)
+		return 0;
+
+	d->ring = rballoc(SOF_MEM_FLAG_SHARED, SOF_MEM_CAPS_RAM, size);
+	if (!d->ring)
+		return -ENOMEM;
+
+	bzero(d->ring, size);
+
+	return 0;
+}
+
+static inline uint32_t dtrace_ring_used(struct dma_trace_ring *ring)
+{
+	return ring->w_pos - ring->r_pos;
+}
+
+/* any core may fill its ring while only the master core traces rarely */
+static bool dtrace_ring_half_full(struct dma_trace_data *d)
+{
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		if (dtrace_ring_used(&d->ring[i]) >=
+		    DMA_TRACE_RING_ENTRIES / 2)
+			return true;
+
+	return false;
+}
+
+static void dtrace_ring_add(struct dma_trace_data *d, const char *e,
+			    uint32_t length)
+{
+	struct dma_trace_ring *ring = &d->ring[cpu_get_id()];
+	struct dma_trace_slot *slot;
+	uint32_t flags;
+	uint32_t w_pos;
+	int ret;
+
+	/* only interrupts on this core can race with the writer */
+	irq_local_disable(flags);
+
+	w_pos = ring->w_pos;
+
+	if (length > sizeof(ring->slot[0].data) ||
+	    dtrace_ring_used(ring) >= DMA_TRACE_RING_ENTRIES) {
+		ring->dropped++;
+		platform_shared_commit(ring, sizeof(*ring));
+		irq_local_enable(flags);
+		return;
+	}
+
+	slot = &ring->slot[w_pos & DMA_TRACE_RING_MASK];
+	slot->length = length;
+	ret = memcpy_s(slot->data, sizeof(slot->data), e, length);
+	assert(!ret);
+	platform_shared_commit(slot, sizeof(*slot));
+
+	/* publish the entry only after its content is written */
+	ring->w_pos = w_pos + 1;
+	platform_shared_commit(ring, sizeof(*ring));
+
+	irq_local_enable(flags);
+}
+
+/* copies one entry to the local buffer, cache is written back later */
+static void dtrace_buf_put(struct dma_trace_data *d, const void *e,
+			   uint32_t length)
+{
+	struct dma_trace_buf *buffer = &d->dmatb;
+	uint32_t margin = dtrace_calc_buf_margin(buffer);
+	int ret;
+
+	if (margin > length) {
+		ret = memcpy_s(buffer->w_ptr, margin, e, length);
+		assert(!ret);
+		buffer->w_ptr = (char *)buffer->w_ptr + length;
+	} else {
+		ret = memcpy_s(buffer->w_ptr, margin, e, margin);
+		assert(!ret);
+		ret = memcpy_s(buffer->addr, buffer->size,
+			       (const char *)e + margin, length - margin);
+		assert(!ret);
+		buffer->w_ptr = (char *)buffer->addr + length - margin;
+	}
+
+	buffer->avail += length;
+	d->posn.messages++;
+}
+
+static void dtrace_buf_writeback(struct dma_trace_buf *buffer, void *start,
+				 uint32_t size)
+{
+	uint32_t margin = (char *)buffer->end_addr - (char *)start;
+
+	if (size <= margin) {
+		dcache_writeback_region(start, size);
+	} else {
+		dcache_writeback_region(start, margin);
+		dcache_writeback_region(buffer->addr, size - margin);
+	}
+}
+
+/* ring holding the oldest entry below the w_pos snapshot, if any */
+static struct dma_trace_ring *dtrace_ring_oldest(struct dma_trace_data *d,
+						 const uint32_t *w_pos)
+{
+	struct dma_trace_ring *oldest = NULL;
+	struct dma_trace_ring *ring;
+	struct log_entry_header *hdr;
+	uint64_t timestamp = 0;
+	int i;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++) {
+		ring = &d->ring[i];
+		if (ring->r_pos == w_pos[i])
+			continue;
+
+		hdr = (struct log_entry_header *)
+			ring->slot[ring->r_pos & DMA_TRACE_RING_MASK].data;
+		if (!oldest || hdr->timestamp < timestamp) {
+			oldest = ring;
+			timestamp = hdr->timestamp;
+		}
+	}
+
+	return oldest;
+}
+
+static void dtrace_ring_merge(struct dma_trace_data *d)
+{
+	struct dma_trace_buf *buffer = &d->dmatb;
+	struct dma_trace_ring *ring;
+	struct dma_trace_slot *slot;
+	uint32_t w_pos[PLATFORM_CORE_COUNT];
+	void *start = buffer->w_ptr;
+	uint32_t copied = 0;
+	uint32_t dropped;
+	uint32_t count;
+	int i;
+
+	/* entries written after the snapshot wait for the next merge */
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++)
+		w_pos[i] = d->ring[i].w_pos;
+
+	while ((ring = dtrace_ring_oldest(d, w_pos))) {
+		slot = &ring->slot[ring->r_pos & DMA_TRACE_RING_MASK];
+
+		if (dtrace_calc_buf_overflow(buffer, slot->length)) {
+			d->dropped_entries++;
+		} else {
+			dtrace_buf_put(d, slot->data, slot->length);
+			copied += slot->length;
+		}
+
+		ring->r_pos++;
+	}
+
+	/* one writeback for everything merged in this pass */
+	if (copied)
+		dtrace_buf_writeback(buffer, start, copied);
+
+	dropped = d->dropped_entries;
+	d->dropped_entries = 0;
+
+	for (i = 0; i < PLATFORM_CORE_COUNT; i++) {
+		ring = &d->ring[i];
+		count = ring->dropped;
+		dropped += count - ring->dropped_seen;
+		ring->dropped_seen = count;
+	}
+
+	/* reported through the ring, so it shows up in the next merge */
+	if (dropped)
+		tr_err(&dt_tr, "dtrace_ring_merge(): number of dropped logs = %u",
+		       dropped);
+}
+
+#endif /* CONFIG_TRACE_STAGING */
 
 static enum task_state trace_work(void *data)
 {
@@ -49,10 +269,16 @@ static enum task_state trace_work(void *data)
 	struct dma_trace_buf *buffer = &d->dmatb;
 	struct dma_sg_config *config = &d->config;
 	unsigned long flags;
-	uint32_t avail = buffer->avail;
+	uint32_t avail;
 	int32_t size;
 	uint32_t overflow;
 
+#if CONFIG_TRACE_STAGING
+	dtrace_ring_merge(d);
+#endif
+
+	avail = buffer->avail;
+
 	/* make sure we don't write more than buffer */
 	if (avail > DMA_TRACE_LOCAL_SIZE) {
 		overflow = avail - DMA_TRACE_LOCAL_SIZE;
@@ -187,6 +413,13 @@ static int dma_trace_buffer_init(struct dma_trace_data *d)
 	void *buf;
 	unsigned int flags;
 
+#if CONFIG_TRACE_STAGING
+	if (dtrace_ring_init(d) < 0) {
+		tr_err(&dt_tr, "dma_trace_buffer_init(): ring alloc failed");
+		return -ENOMEM;
+	}
+#endif
+
 	/* allocate new buffer */
 	buf = rballoc(0, SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_DMA,
 		      DMA_TRACE_LOCAL_SIZE);
@@ -356,6 +589,12 @@ void dma_trace_flush(void *t)
 	}
 
 	buffer = &trace_data->dmatb;
+
+#if CONFIG_TRACE_STAGING
+	/* best effort, the trace work may be stopped by the panic */
+	dtrace_ring_merge(trace_data);
+#endif
+
 	avail = buffer->avail;
 
 	/* number of bytes to flush */
@@ -450,6 +689,52 @@ static int dtrace_calc_buf_overflow(struct dma_trace_buf *buffer,
 	return overflow;
 }
 
+#if CONFIG_TRACE_STAGING
+
+void dtrace_event(const char *e, uint32_t length)
+{
+	struct dma_trace_data *trace_data = dma_trace_data_get();
+
+	if (!trace_data || !trace_data->dmatb.addr ||
+	    length > DMA_TRACE_LOCAL_SIZE / 8 || length == 0) {
+		platform_shared_commit(trace_data, sizeof(*trace_data));
+		return;
+	}
+
+	dtrace_ring_add(trace_data, e, length);
+
+	/* only the master core may kick the trace work, for all rings */
+	if (trace_data->copy_in_progress ||
+	    cpu_get_id() != PLATFORM_MASTER_CORE_ID) {
+		platform_shared_commit(trace_data, sizeof(*trace_data));
+		return;
+	}
+
+	/* schedule copy now if any ring is half full */
+	if (trace_data->enabled && dtrace_ring_half_full(trace_data)) {
+		reschedule_task(&trace_data->dmat_work,
+				DMA_TRACE_RESCHEDULE_TIME);
+		trace_data->copy_in_progress = 1;
+	}
+
+	platform_shared_commit(trace_data, sizeof(*trace_data));
+}
+
+void dtrace_event_atomic(const char *e, uint32_t length)
+{
+	struct dma_trace_data *trace_data = dma_trace_data_get();
+
+	if (!trace_data || !trace_data->dmatb.addr ||
+	    length > DMA_TRACE_LOCAL_SIZE / 8 || length == 0) {
+		platform_shared_commit(trace_data, sizeof(*trace_data));
+		return;
+	}
+
+	dtrace_ring_add(trace_data, e, length);
+}
+
+#else
+
 static void dtrace_add_event(const char *e, uint32_t length)
 {
 	struct dma_trace_data *trace_data = dma_trace_data_get();
@@ -576,3 +861,5 @@ void dtrace_event_atomic(const char *e, uint32_t length)
 
 	dtrace_add_event(e, length);
 }
+
+#endif /* CONFIG_TRACE_STAGING */
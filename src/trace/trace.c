@@ -9,6 +9,7 @@
 #include <sof/drivers/timer.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/cache.h>
+#include <sof/lib/clk.h>
 #include <sof/lib/cpu.h>
 #include <sof/lib/mailbox.h>
 #include <sof/lib/memory.h>
@@ -153,6 +154,56 @@ void trace_log(bool send_atomic, const void *log_entry,
 #endif /* CONFIG_TRACEM */
 }
 
+bool trace_ratelimit_pass(struct trace_ratelimit *rl,
+			  const struct tr_ctx *ctx, uint32_t lvl,
+			  uint32_t *suppressed)
+{
+	struct trace *trace = trace_get();
+	uint32_t flags;
+	uint64_t now;
+	bool pass;
+
+	/* filtered traces are not counted as suppressed */
+	if (!trace->enable || !trace_filter_pass(lvl, ctx)) {
+		platform_shared_commit(trace, sizeof(*trace));
+		return false;
+	}
+
+	now = platform_timer_get(timer_get());
+
+	/* the state of a call site is SHARED_DATA, so all cores have to
+	 * use its shared alias and not their own cached copy
+	 */
+	rl = platform_shared_get(rl, sizeof(*rl));
+
+	spin_lock_irq(&trace->lock, flags);
+
+	/* start a new window once the current one has elapsed */
+	if (now >= rl->window_end) {
+		rl->window_end = now +
+			clock_ms_to_ticks(PLATFORM_DEFAULT_CLOCK,
+					  CONFIG_TRACE_RATELIMIT_MS);
+		rl->events = 0;
+	}
+
+	if (rl->events >= CONFIG_TRACE_RATELIMIT_BURST) {
+		rl->suppressed++;
+		pass = false;
+	} else {
+		rl->events++;
+		*suppressed = rl->suppressed;
+		rl->suppressed = 0;
+		pass = true;
+	}
+
+	platform_shared_commit(rl, sizeof(*rl));
+	platform_shared_commit(trace, sizeof(*trace));
+
+	spin_unlock_irq(&trace->lock, flags);
+
+	return pass;
+}
+
 void trace_flush(void)
 {
 	struct trace *trace = trace_get();
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/audio/adpcm.h>
+#include <sof/common.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#define TEST_BLOCKS		32
+#define TEST_FRAMES		(TEST_BLOCKS * ADPCM_BLOCK_FRAMES)
+#define TEST_MAX_CHANNELS	2
+
+/* 2 * cos(2 * pi * 1000 / 16000) and sin(2 * pi * 1000 / 16000) */
+#define TEST_OSC_COEF		1.8477590650225735
+#define TEST_OSC_INIT		0.3826834323650898
+
+/* Minimum signal to coding error energy ratio, about 25 dB */
+#define TEST_MIN_SNR		300.0
+
+struct adpcm_test_case {
+	int sample_width;
+	int channels;
+	const char *name;
+};
+
+#define TEST_CASE(_width, _ch) \
+	{ \
+		.sample_width = (_width), \
+		.channels = (_ch), \
+		.name = "test_adpcm_" #_width "_" #_ch "ch", \
+	}
+
+static struct adpcm_test_case adpcm_test_cases[] = {
+	TEST_CASE(16, 1),
+	TEST_CASE(16, 2),
+	TEST_CASE(24, 2),
+	TEST_CASE(32, 1),
+};
+
+static double adpcm_test_scale(int sample_width)
+{
+	return (double)(1U << (sample_width - 1)) - 1;
+}
+
+static double adpcm_test_get(const void *buf, int sample_width, int i)
+{
+	if (sample_width == 16)
+		return ((const int16_t *)buf)[i];
+
+	return ((const int32_t *)buf)[i];
+}
+
+static void adpcm_test_put(void *buf, int sample_width, int i, double x)
+{
+	if (sample_width == 16)
+		((int16_t *)buf)[i] = x;
+	else
+		((int32_t *)buf)[i] = x;
+}
+
+/* Half scale 1 kHz tone at 16 kHz, sine for first and cosine for second
+ * channel.
+ */
+static void *adpcm_test_tone(struct adpcm_test_case *tc)
+{
+	double scale = 0.5 * adpcm_test_scale(tc->sample_width);
+	double y[TEST_MAX_CHANNELS][2];
+	double x;
+	void *buf;
+	int ch;
+	int i;
+
+	buf = calloc(TEST_FRAMES * tc->channels, sizeof(int32_t));
+	assert_non_null(buf);
+
+	for (ch = 0; ch < tc->channels; ch++) {
+		y[ch][0] = ch ? 1 : 0;
+		y[ch][1] = ch ? TEST_OSC_COEF / 2 : TEST_OSC_INIT;
+	}
+
+	for (i = 0; i < TEST_FRAMES; i++) {
+		for (ch = 0; ch < tc->channels; ch++) {
+			adpcm_test_put(buf, tc->sample_width,
+				       i * tc->channels + ch,
+				       scale * y[ch][0]);
+			x = TEST_OSC_COEF * y[ch][1] - y[ch][0];
+			y[ch][0] = y[ch][1];
+			y[ch][1] = x;
+		}
+	}
+
+	return buf;
+}
+
+static void test_adpcm_tone(void **state)
+{
+	struct adpcm_test_case *tc = *state;
+	struct adpcm_state enc[TEST_MAX_CHANNELS];
+	int sample_bytes = tc->sample_width == 16 ? 2 : 4;
+	int frame_bytes = tc->channels * sample_bytes;
+	int block_bytes = ADPCM_BLOCK_BYTES(tc->channels);
+	uint8_t *block;
+	void *out;
+	void *in;
+	double signal = 0;
+	double noise = 0;
+	double x;
+	double e;
+	int i;
+
+	in = adpcm_test_tone(tc);
+	out = calloc(TEST_FRAMES * tc->channels, sizeof(int32_t));
+	block = malloc(TEST_BLOCKS * block_bytes);
+	assert_non_null(out);
+	assert_non_null(block);
+
+	memset(enc, 0, sizeof(enc));
+	for (i = 0; i < TEST_BLOCKS; i++)
+		adpcm_encode_block(enc, (char *)in +
+				   i * ADPCM_BLOCK_FRAMES * frame_bytes,
+				   tc->sample_width, tc->channels,
+				   block + i * block_bytes);
+
+	/* Blocks are decoded in reverse order since each one must be
+	 * decodable on its own.
+	 */
+	for (i = TEST_BLOCKS - 1; i >= 0; i--)
+		adpcm_decode_block(block + i * block_bytes, tc->sample_width,
+				   tc->channels, (char *)out +
+				   i * ADPCM_BLOCK_FRAMES * frame_bytes);
+
+	/* Skip the adaptation of the step size in the first block */
+	for (i = ADPCM_BLOCK_FRAMES * tc->channels;
+	     i < TEST_FRAMES * tc->channels; i++) {
+		x = adpcm_test_get(in, tc->sample_width, i);
+		e = x - adpcm_test_get(out, tc->sample_width, i);
+		signal += x * x;
+		noise += e * e;
+	}
+
+	assert_true(signal > TEST_MIN_SNR * noise);
+
+	free(block);
+	free(out);
+	free(in);
+}
+
+static void test_adpcm_full_scale(void **state)
+{
+	struct adpcm_state enc = { 0 };
+	int16_t in[ADPCM_BLOCK_FRAMES];
+	int16_t out[ADPCM_BLOCK_FRAMES];
+	uint8_t block[ADPCM_BLOCK_BYTES(1)];
+	int i;
+
+	(void)state;
+
+	/* Square wave at full scale, decoded samples must not wrap */
+	for (i = 0; i < ADPCM_BLOCK_FRAMES; i++)
+		in[i] = (i / 8) & 1 ? INT16_MIN : INT16_MAX;
+
+	for (i = 0; i < 4; i++)
+		adpcm_encode_block(&enc, in, 16, 1, block);
+
+	adpcm_decode_block(block, 16, 1, out);
+
+	for (i = 0; i < ADPCM_BLOCK_FRAMES; i++) {
+		if (in[i] > 0)
+			assert_true(out[i] > -INT16_MAX / 2);
+		else
+			assert_true(out[i] < INT16_MAX / 2);
+	}
+
+	/* The encoder state is the last decoded sample */
+	assert_int_equal(enc.predictor, out[ADPCM_BLOCK_FRAMES - 1]);
+}
+
+int main(void)
+{
+	struct CMUnitTest tests[ARRAY_SIZE(adpcm_test_cases) + 1];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(adpcm_test_cases); i++) {
+		tests[i].test_func = test_adpcm_tone;
+		tests[i].initial_state = &adpcm_test_cases[i];
+		tests[i].setup_func = NULL;
+		tests[i].teardown_func = NULL;
+		tests[i].name = adpcm_test_cases[i].name;
+	}
+
+	tests[i].test_func = test_adpcm_full_scale;
+	tests[i].initial_state = NULL;
+	tests[i].setup_func = NULL;
+	tests[i].teardown_func = NULL;
+	tests[i].name = "test_adpcm_full_scale";
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <sof/audio/asrc/asrc_config.h>
+#include <sof/audio/asrc/asrc_farrow.h>
+#include <sof/audio/coef_cache.h>
+#include <sof/audio/component.h>
+#include <sof/common.h>
+#include <sof/math/numbers.h>
+
+#if ASRC_GENERIC
+
+#define TEST_FRAMES		2000
+#define TEST_MAX_CHUNK		64
+#define TEST_MAX_CHANNELS	4
+#define TEST_OUT_FRAMES		(8 * TEST_MAX_CHUNK)
+
+/* Clock skew of 1.0005 in Q2.30 applied at half of the test */
+#define TEST_SKEW		1074278197
+
+struct asrc_block_test_case {
+	int bit_depth;
+	enum asrc_operation_mode mode;
+	int fs_in;
+	int fs_out;
+	int channels;
+	const char *name;
+};
+
+#define TEST_CASE(_bits, _mode, _fs_in, _fs_out, _ch) \
+	{ \
+		.bit_depth = (_bits), \
+		.mode = ASRC_OM_ ## _mode, \
+		.fs_in = (_fs_in), \
+		.fs_out = (_fs_out), \
+		.channels = (_ch), \
+		.name = "test_asrc_block_" #_bits "_" #_mode "_" #_fs_in \
+			"_" #_fs_out "_" #_ch "ch", \
+	}
+
+static struct asrc_block_test_case asrc_block_test_cases[] = {
+	TEST_CASE(32, PUSH, 44100, 48000, 2),
+	TEST_CASE(32, PUSH, 8000, 48000, 1),
+	TEST_CASE(16, PUSH, 32000, 44100, 2),
+	TEST_CASE(32, PULL, 44100, 48000, 2),
+	TEST_CASE(16, PULL, 16000, 48000, 4),
+	TEST_CASE(32, PULL, 48000, 48000, 3),
+};
+
+/* The constant filter tables are used */
+void *coef_cache_get(const struct coef_cache_key *key,
+		     coef_cache_create create, void *arg)
+{
+	return NULL;
+}
+
+void coef_cache_put(const void *data)
+{
+}
+
+void *coef_cache_alloc(size_t bytes)
+{
+	return NULL;
+}
+
+static struct comp_dev dev;
+
+static struct asrc_farrow *asrc_block_new(struct asrc_block_test_case *tc)
+{
+	struct asrc_farrow *src_obj;
+	int fs_prim;
+	int fs_sec;
+	int size;
+	int ret;
+
+	ret = asrc_get_required_size(&dev, &size, tc->channels,
+				     tc->bit_depth);
+	assert_int_equal(ret, ASRC_EC_OK);
+	src_obj = calloc(1, size);
+	assert_non_null(src_obj);
+
+	if (tc->mode == ASRC_OM_PUSH) {
+		fs_prim = tc->fs_in;
+		fs_sec = tc->fs_out;
+	} else {
+		fs_prim = tc->fs_out;
+		fs_sec = tc->fs_in;
+	}
+
+	ret = asrc_initialise(&dev, src_obj, tc->channels, fs_prim, fs_sec,
+			      ASRC_IOF_INTERLEAVED, ASRC_IOF_INTERLEAVED,
+			      ASRC_BM_LINEAR, TEST_OUT_FRAMES,
+			      tc->bit_depth, ASRC_CM_FEEDBACK, tc->mode);
+	assert_int_equal(ret, ASRC_EC_OK);
+	return src_obj;
+}
+
+/* Runs the reference frame by frame version */
+static int asrc_block_ref(struct asrc_block_test_case *tc,
+			  struct asrc_farrow *src_obj, void **in,
+			  int *in_frames, void **out, int *out_frames,
+			  int avail)
+{
+	int idx = 0;
+
+	if (tc->mode == ASRC_OM_PUSH && tc->bit_depth == 32)
+		return asrc_process_push32(&dev, src_obj, (int32_t **)in,
+					   *in_frames, (int32_t **)out,
+					   out_frames, &idx, 0);
+
+	if (tc->mode == ASRC_OM_PUSH)
+		return asrc_process_push16(&dev, src_obj, (int16_t **)in,
+					   *in_frames, (int16_t **)out,
+					   out_frames, &idx, 0);
+
+	if (tc->bit_depth == 32)
+		return asrc_process_pull32(&dev, src_obj, (int32_t **)in,
+					   in_frames, (int32_t **)out,
+					   *out_frames, avail, &idx);
+
+	return asrc_process_pull16(&dev, src_obj, (int16_t **)in, in_frames,
+				   (int16_t **)out, *out_frames, avail, &idx);
+}
+
+static int asrc_block_run(struct asrc_block_test_case *tc,
+			  struct asrc_farrow *src_obj, void **in,
+			  int *in_frames, void **out, int *out_frames,
+			  int avail)
+{
+	int idx = 0;
+
+	if (tc->mode == ASRC_OM_PUSH)
+		return asrc_process_push_block(&dev, src_obj, in, *in_frames,
+					       out, out_frames, &idx, 0);
+
+	return asrc_process_pull_block(&dev, src_obj, in, in_frames, out,
+				       *out_frames, avail, &idx);
+}
+
+static void test_asrc_block(void **state)
+{
+	struct asrc_block_test_case *tc = *state;
+	struct asrc_farrow *ref = asrc_block_new(tc);
+	struct asrc_farrow *blk = asrc_block_new(tc);
+	void *in[TEST_MAX_CHANNELS];
+	void *out_ref[TEST_MAX_CHANNELS];
+	void *out_blk[TEST_MAX_CHANNELS];
+	int sample_bytes = tc->bit_depth / 8;
+	int frame_bytes = tc->channels * sample_bytes;
+	int8_t *x;
+	int8_t *y_ref;
+	int8_t *y_blk;
+	int in_frames_ref;
+	int in_frames_blk;
+	int out_frames_ref;
+	int out_frames_blk;
+	int avail;
+	int read = 0;
+	bool drift = false;
+	int ch;
+	int i;
+
+	x = malloc(TEST_FRAMES * frame_bytes);
+	y_ref = calloc(TEST_OUT_FRAMES, frame_bytes);
+	y_blk = calloc(TEST_OUT_FRAMES, frame_bytes);
+	assert_non_null(x);
+	assert_non_null(y_ref);
+	assert_non_null(y_blk);
+
+	/* Full scale noise */
+	for (i = 0; i < TEST_FRAMES * frame_bytes; i++)
+		x[i] = rand();
+
+	for (ch = 0; ch < tc->channels; ch++) {
+		out_ref[ch] = y_ref + ch * sample_bytes;
+		out_blk[ch] = y_blk + ch * sample_bytes;
+	}
+
+	while (read + 2 * TEST_MAX_CHUNK < TEST_FRAMES) {
+		if (!drift && read > TEST_FRAMES / 2) {
+			assert_int_equal(asrc_update_drift(&dev, ref,
+							   TEST_SKEW),
+					 ASRC_EC_OK);
+			assert_int_equal(asrc_update_drift(&dev, blk,
+							   TEST_SKEW),
+					 ASRC_EC_OK);
+			drift = true;
+		}
+
+		for (ch = 0; ch < tc->channels; ch++)
+			in[ch] = x + read * frame_bytes + ch * sample_bytes;
+
+		/* Push consumes a chunk, pull produces a chunk from the
+		 * available input.
+		 */
+		in_frames_ref = 1 + rand() % TEST_MAX_CHUNK;
+		in_frames_blk = in_frames_ref;
+		out_frames_ref = in_frames_ref;
+		out_frames_blk = in_frames_ref;
+		avail = 2 * TEST_MAX_CHUNK;
+
+		assert_int_equal(asrc_block_ref(tc, ref, in, &in_frames_ref,
+						out_ref, &out_frames_ref,
+						avail),
+				 ASRC_EC_OK);
+		assert_int_equal(asrc_block_run(tc, blk, in, &in_frames_blk,
+						out_blk, &out_frames_blk,
+						avail),
+				 ASRC_EC_OK);
+
+		assert_int_equal(in_frames_ref, in_frames_blk);
+		assert_int_equal(out_frames_ref, out_frames_blk);
+		assert_memory_equal(y_ref, y_blk, out_frames_ref * frame_bytes);
+		read += in_frames_ref;
+	}
+
+	/* The drift update was ramped in */
+	assert_true(drift);
+	assert_int_equal(ref->fs_ratio, ref->fs_ratio_target);
+	assert_int_equal(blk->fs_ratio, ref->fs_ratio);
+
+	free(y_blk);
+	free(y_ref);
+	free(x);
+	free(blk);
+	free(ref);
+}
+
+static void test_asrc_block_fixed_mode(void **state)
+{
+	struct asrc_block_test_case *tc = &asrc_block_test_cases[0];
+	struct asrc_farrow *src_obj = asrc_block_new(tc);
+	void *buf[1] = { NULL };
+	int frames = 0;
+	int idx = 0;
+
+	(void)state;
+
+	/* The block kernels are for the feedback control mode only */
+	src_obj->control_mode = ASRC_CM_FIXED;
+	assert_int_equal(asrc_process_push_block(&dev, src_obj, buf, 1, buf,
+						 &frames, &idx, 0),
+			 ASRC_EC_INVALID_CONTROL_MODE);
+
+	free(src_obj);
+}
+
+#endif /* ASRC_GENERIC */
+
+int main(void)
+{
+#if ASRC_GENERIC
+	struct CMUnitTest tests[ARRAY_SIZE(asrc_block_test_cases) + 1];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(asrc_block_test_cases); i++) {
+		tests[i].test_func = test_asrc_block;
+		tests[i].initial_state = &asrc_block_test_cases[i];
+		tests[i].setup_func = NULL;
+		tests[i].teardown_func = NULL;
+		tests[i].name = asrc_block_test_cases[i].name;
+	}
+
+	tests[i].test_func = test_asrc_block_fixed_mode;
+	tests[i].initial_state = NULL;
+	tests[i].setup_func = NULL;
+	tests[i].teardown_func = NULL;
+	tests[i].name = "test_asrc_block_fixed_mode";
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+#else
+	/* The block kernels are generic C only */
+	return 0;
+#endif
+}
@@ -152,6 +152,33 @@ static void test_audio_buffer_copy_fit_no_space_constraint(void **state)
 	buffer_free(snk);
 }
 
+static void test_audio_buffer_readable_bytes(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 256
+	};
+
+	struct comp_buffer *src = buffer_new(&test_buf_desc);
+
+	assert_non_null(src);
+
+	src->stream.channels = 2;
+	src->stream.frame_fmt = SOF_IPC_FRAME_S32_LE;
+	comp_update_buffer_produce(src, 80);
+
+	/* limited by the frames the component reads */
+	assert_int_equal(audio_stream_get_readable_bytes(&src->stream, 4),
+			 32);
+
+	/* limited by the available data */
+	assert_int_equal(audio_stream_get_readable_bytes(&src->stream, 16),
+			 80);
+
+	buffer_free(src);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -159,6 +186,7 @@ int main(void)
 		cmocka_unit_test(test_audio_buffer_copy_overrun),
 		cmocka_unit_test(test_audio_buffer_copy_success),
 		cmocka_unit_test(test_audio_buffer_copy_fit_space_constraint),
+		cmocka_unit_test(test_audio_buffer_readable_bytes),
 		cmocka_unit_test(test_audio_buffer_copy_fit_no_space_constraint)
 	};
 
@@ -58,11 +58,50 @@ static void test_audio_buffer_write_fill_10_bytes_and_write_5(void **state)
 	buffer_free(buf);
 }
 
+static void test_audio_buffer_copy_linear_wrap(void **state)
+{
+	(void)state;
+
+	struct sof_ipc_buffer test_buf_desc = {
+		.size = 10
+	};
+
+	struct comp_buffer *buf = buffer_new(&test_buf_desc);
+
+	assert_non_null(buf);
+
+	/* move the pointers close to the end of the buffer */
+	comp_update_buffer_produce(buf, 7);
+	comp_update_buffer_consume(buf, 7);
+
+	uint8_t bytes[6] = {0, 1, 2, 3, 4, 5};
+	uint8_t ref_1[3] = {0, 1, 2};
+	uint8_t ref_2[3] = {3, 4, 5};
+	uint8_t linear[6] = {0};
+
+	audio_stream_copy_from_linear(&bytes, &buf->stream, 0, 6);
+	comp_update_buffer_produce(buf, 6);
+
+	assert_int_equal(buf->stream.avail, 6);
+	assert_int_equal(memcmp(buf->stream.r_ptr, &ref_1, 3), 0);
+	assert_int_equal(memcmp(buf->stream.addr, &ref_2, 3), 0);
+
+	audio_stream_copy_to_linear(&buf->stream, 0, &linear, 6);
+	assert_int_equal(memcmp(&linear, &bytes, 6), 0);
+
+	/* read with an offset across the wrap */
+	audio_stream_copy_to_linear(&buf->stream, 2, &linear, 2);
+	assert_int_equal(memcmp(&linear, &bytes[2], 2), 0);
+
+	buffer_free(buf);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test
-			(test_audio_buffer_write_fill_10_bytes_and_write_5)
+			(test_audio_buffer_write_fill_10_bytes_and_write_5),
+		cmocka_unit_test(test_audio_buffer_copy_linear_wrap)
 	};
 
 	cmocka_set_message_output(CM_OUTPUT_TAP);
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <sof/audio/eq_fir/fir_fft.h>
+#include <sof/common.h>
+#include <user/eq.h>
+
+#define TEST_SAMPLES		4096
+#define TEST_MIN_SNR_DB		85.0
+
+struct fir_fft_test_case {
+	int length;
+	int out_shift;
+	const char *name;
+};
+
+#define TEST_CASE(_length, _out_shift) \
+	{ \
+		.length = (_length), \
+		.out_shift = (_out_shift), \
+		.name = "test_fir_fft_" #_length "_taps", \
+	}
+
+static struct fir_fft_test_case fir_fft_test_cases[] = {
+	TEST_CASE(4, 0),
+	TEST_CASE(128, 0),
+	TEST_CASE(300, 1),
+	TEST_CASE(1024, 2),
+	TEST_CASE(2048, 3),
+};
+
+/* Decaying noise-like response and input signal */
+static void fill_coef(struct sof_eq_fir_coef_data *config)
+{
+	int i;
+
+	for (i = 0; i < config->length; i++)
+		config->coef[i] = 32767.0 * exp(-6.0 * i / config->length) *
+			(i ? sin(0.37 * i * i) : 1.0);
+}
+
+static void fill_input(int32_t *x, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		x[i] = INT32_MAX * (0.3 * sin(0.05 * i) +
+				    0.2 * ((double)rand() / RAND_MAX - 0.5));
+}
+
+static void test_fir_fft(void **state)
+{
+	struct fir_fft_test_case *tc = *((struct fir_fft_test_case **)state);
+	struct sof_eq_fir_coef_data *config;
+	struct fir_fft_work *work;
+	struct fir_fft_state fft;
+	void *data;
+	void *p;
+	int32_t *x;
+	int32_t y;
+	double ref;
+	double err = 0;
+	double sig = 0;
+	int size;
+	int i;
+	int k;
+	int n;
+
+	config = calloc(1, sizeof(*config) + tc->length * sizeof(int16_t));
+	assert_non_null(config);
+	config->length = tc->length;
+	config->out_shift = tc->out_shift;
+	config->flags = SOF_EQ_FIR_FLAG_FFT;
+	fill_coef(config);
+
+	size = fir_fft_coef_size(config) + fir_fft_delay_size(config);
+	work = calloc(1, sizeof(*work));
+	data = calloc(1, size);
+	x = malloc(TEST_SAMPLES * sizeof(int32_t));
+	assert_non_null(work);
+	assert_non_null(data);
+	assert_non_null(x);
+	fill_input(x, TEST_SAMPLES);
+
+	p = data;
+	fir_fft_reset(&fft);
+	fir_fft_init_work(work);
+	fir_fft_init_coef(&fft, work, config, &p);
+	fir_fft_init_delay(&fft, &p);
+	assert_ptr_equal(p, (char *)data + size);
+
+	/* Output is delayed by one block, compare to direct convolution */
+	for (i = 0; i < TEST_SAMPLES; i++) {
+		y = fir_fft_32(&fft, work, x[i]);
+		n = i - FIR_FFT_BLOCK_SIZE;
+		if (n < 0) {
+			assert_int_equal(y, 0);
+			continue;
+		}
+
+		ref = 0;
+		for (k = 0; k < config->length && k <= n; k++)
+			ref += (double)x[n - k] * config->coef[k] / 32768.0;
+
+		ref = ref / (1 << config->out_shift);
+		ref = fmin(fmax(ref, INT32_MIN), INT32_MAX);
+		err += (y - ref) * (y - ref);
+		sig += ref * ref;
+	}
+
+	assert_true(10 * log10(sig / err) > TEST_MIN_SNR_DB);
+
+	free(x);
+	free(data);
+	free(work);
+	free(config);
+}
+
+int main(void)
+{
+	struct CMUnitTest tests[ARRAY_SIZE(fir_fft_test_cases)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fir_fft_test_cases); i++) {
+		tests[i].test_func = test_fir_fft;
+		tests[i].initial_state = &fir_fft_test_cases[i];
+		tests[i].setup_func = NULL;
+		tests[i].teardown_func = NULL;
+		tests[i].name = fir_fft_test_cases[i].name;
+	}
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <sof/audio/eq_iir/iir.h>
+#include <sof/common.h>
+#include <sof/math/numbers.h>
+#include <user/eq.h>
+
+#if IIR_GENERIC
+
+#define TEST_FRAMES		1000
+
+struct iir_batch_test_case {
+	int lanes;
+	int biquads;
+	int biquads_in_series;
+	int gain; /* Biquad output gain, Q2.14 */
+	const char *name;
+};
+
+#define TEST_CASE(_lanes, _biquads, _in_series, _gain) \
+	{ \
+		.lanes = (_lanes), \
+		.biquads = (_biquads), \
+		.biquads_in_series = (_in_series), \
+		.gain = (_gain), \
+		.name = "test_iir_batch_" #_lanes "ch_" #_biquads "_" \
+			#_in_series "_biquads", \
+	}
+
+static struct iir_batch_test_case iir_batch_test_cases[] = {
+	TEST_CASE(1, 1, 1, 16384),
+	TEST_CASE(2, 4, 4, 16384),
+	TEST_CASE(3, 2, 2, 32767),
+	TEST_CASE(4, 6, 3, 16384),
+	TEST_CASE(6, 8, 8, 12000),
+	TEST_CASE(8, 8, 2, 32767),
+};
+
+/* Stable resonators with random pole angle and zeros */
+static void fill_biquads(struct sof_eq_iir_header_df2t *config, int gain)
+{
+	struct sof_eq_iir_biquad_df2t *bq;
+	int i;
+
+	for (i = 0; i < config->num_sections; i++) {
+		bq = (struct sof_eq_iir_biquad_df2t *)
+			&config->biquads[i * SOF_EQ_IIR_NBIQUAD_DF2T];
+		bq->a2 = -(rand() % (1 << 29)) - (1 << 28);
+		bq->a1 = rand() % (1 << 30) - (1 << 29);
+		bq->b2 = rand() % (1 << 29) - (1 << 28);
+		bq->b1 = rand() % (1 << 30) - (1 << 29);
+		bq->b0 = rand() % (1 << 29) + (1 << 28);
+		bq->output_shift = rand() % 3;
+		bq->output_gain = gain;
+	}
+}
+
+static void test_iir_batch(void **state)
+{
+	struct iir_batch_test_case *tc = *state;
+	struct iir_state_df2t iir[IIR_BATCH_MAX_LANES];
+	struct sof_eq_iir_header_df2t *config;
+	struct iir_batch_df2t batch;
+	int64_t *delay;
+	int64_t *p;
+	int32_t *x;
+	int32_t *y;
+	int size;
+	int ret;
+	int i;
+	int l;
+	int n;
+
+	config = calloc(1, sizeof(*config) + tc->biquads *
+			SOF_EQ_IIR_NBIQUAD_DF2T * sizeof(int32_t));
+	assert_non_null(config);
+	config->num_sections = tc->biquads;
+	config->num_sections_in_series = tc->biquads_in_series;
+	fill_biquads(config, tc->gain);
+
+	size = iir_delay_size_df2t(config);
+	assert_true(size > 0);
+	delay = calloc(2 * tc->lanes, size);
+	x = malloc(TEST_FRAMES * tc->lanes * sizeof(int32_t));
+	y = malloc(TEST_FRAMES * tc->lanes * sizeof(int32_t));
+	assert_non_null(delay);
+	assert_non_null(x);
+	assert_non_null(y);
+
+	/* Full scale noise to exercise also the saturation */
+	for (i = 0; i < TEST_FRAMES * tc->lanes; i++) {
+		x[i] = (int32_t)((uint32_t)rand() << 1) ^ rand();
+		y[i] = x[i];
+	}
+
+	/* Reference is filtered channel by channel with iir_df2t() */
+	p = delay;
+	for (l = 0; l < tc->lanes; l++) {
+		iir_init_coef_df2t(&iir[l], config);
+		iir_init_delay_df2t(&iir[l], &p);
+	}
+
+	ret = iir_batch_init_df2t(&batch, &iir[0], tc->lanes);
+	assert_int_equal(ret, 0);
+	iir_batch_init_delay_df2t(&batch, &p);
+	assert_ptr_equal(p, delay + 4 * tc->biquads * tc->lanes);
+
+	/* Process in blocks of varying size to check the state update */
+	for (i = 0; i < TEST_FRAMES; i += n) {
+		n = MIN(1 + rand() % IIR_BATCH_FRAMES, TEST_FRAMES - i);
+		iir_batch_df2t(&batch, &y[i * tc->lanes], n);
+	}
+
+	for (i = 0; i < TEST_FRAMES * tc->lanes; i++) {
+		l = i % tc->lanes;
+		assert_int_equal(y[i], iir_df2t(&iir[l], x[i]));
+	}
+
+	free(y);
+	free(x);
+	free(delay);
+	free(config);
+}
+
+#endif /* IIR_GENERIC */
+
+static void test_iir_batch_invalid_lanes(void **state)
+{
+	struct iir_state_df2t iir = { .biquads = 1, .biquads_in_series = 1 };
+	struct iir_batch_df2t batch;
+
+	(void)state;
+
+	assert_int_equal(iir_batch_init_df2t(&batch, &iir, 0), -EINVAL);
+	assert_int_equal(iir_batch_init_df2t(&batch, &iir,
+					     IIR_BATCH_MAX_LANES + 1),
+			 -EINVAL);
+}
+
+int main(void)
+{
+#if IIR_GENERIC
+	struct CMUnitTest tests[ARRAY_SIZE(iir_batch_test_cases) + 1];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(iir_batch_test_cases); i++) {
+		tests[i].test_func = test_iir_batch;
+		tests[i].initial_state = &iir_batch_test_cases[i];
+		tests[i].setup_func = NULL;
+		tests[i].teardown_func = NULL;
+		tests[i].name = iir_batch_test_cases[i].name;
+	}
+#else
+	/* The batch kernel is generic C only */
+	struct CMUnitTest tests[1];
+	int i = 0;
+#endif
+
+	tests[i].test_func = test_iir_batch_invalid_lanes;
+	tests[i].initial_state = NULL;
+	tests[i].setup_func = NULL;
+	tests[i].teardown_func = NULL;
+	tests[i].name = "test_iir_batch_invalid_lanes";
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
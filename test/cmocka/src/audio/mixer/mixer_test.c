@@ -17,11 +17,15 @@
 #include <sof/audio/component.h>
 #include <sof/audio/format.h>
 #include <sof/audio/mixer.h>
+#include <ipc/control.h>
 
 #include "comp_mock.h"
 
 #define MIX_TEST_SAMPLES 32
 
+/* Q1.16 per-source gain used by the gain test, 0.5 */
+#define MIX_TEST_GAIN 0x8000
+
 struct comp_driver drv_mock;
 
 struct comp_driver mixer_drv_mock;
@@ -90,6 +94,13 @@ static struct mix_test_case mix_test_cases[] = {
 	TEST_CASE(8, 2)
 };
 
+static struct mix_test_case mix_gain_test_case = {
+	.num_sources = 4,
+	.num_chans = 2,
+	.name = "test_audio_mixer_copy_gain_4_srcs_2ch",
+	.sources = NULL
+};
+
 static struct sof_ipc_comp mock_comp = {
 	.type = SOF_COMP_MOCK
 };
@@ -297,9 +308,64 @@ static void test_audio_mixer_copy(void **state)
 	}
 }
 
+static void test_audio_mixer_copy_gain(void **state)
+{
+	struct sof_ipc_ctrl_data *cdata;
+	int src_idx;
+	int smp;
+	struct mix_test_case *tc = *((struct mix_test_case **)state);
+
+	cdata = calloc(1, sizeof(*cdata) +
+		       tc->num_sources * sizeof(cdata->chanv[0]));
+	assert_non_null(cdata);
+
+	cdata->cmd = SOF_CTRL_CMD_VOLUME;
+	cdata->num_elems = tc->num_sources;
+	for (src_idx = 0; src_idx < tc->num_sources; ++src_idx) {
+		cdata->chanv[src_idx].channel = src_idx;
+		cdata->chanv[src_idx].value = MIX_TEST_GAIN;
+	}
+
+	assert_int_equal(mixer_drv_mock.ops.cmd(mixer_dev_mock,
+						COMP_CMD_SET_VALUE, cdata, 0),
+			 0);
+	free(cdata);
+
+	for (src_idx = 0; src_idx < tc->num_sources; ++src_idx) {
+		int32_t *samples = tc->sources[src_idx].buf->stream.addr;
+
+		for (smp = 0; smp < MIX_TEST_SAMPLES; ++smp) {
+			double rad = M_PI / (180.0 / (smp * (src_idx + 1)));
+
+			samples[smp] = sin(rad) * INT32_MAX;
+		}
+
+		tc->sources[src_idx].buf->stream.avail =
+			tc->sources[src_idx].buf->stream.size;
+	}
+
+	mixer_drv_mock.ops.copy(mixer_dev_mock);
+
+	for (smp = 0; smp < MIX_TEST_SAMPLES; ++smp) {
+		int64_t sum = 0;
+
+		for (src_idx = 0; src_idx < tc->num_sources; ++src_idx) {
+			int32_t *samples =
+				tc->sources[src_idx].buf->stream.addr;
+
+			sum += Q_SHIFT_RND((int64_t)samples[smp] *
+					   MIX_TEST_GAIN, 47, 31);
+		}
+
+		int32_t *out_samples = post_mixer_buf->stream.addr;
+
+		assert_int_equal(out_samples[smp], sat_int32(sum));
+	}
+}
+
 int main(void)
 {
-	struct CMUnitTest tests[ARRAY_SIZE(mix_test_cases) + 2];
+	struct CMUnitTest tests[ARRAY_SIZE(mix_test_cases) + 3];
 
 	int i;
 	int cur_test_case = 0;
@@ -316,7 +382,13 @@ int main(void)
 	tests[1].teardown_func = test_teardown;
 	tests[1].name = "test_audio_mixer_prepare_no_sources";
 
-	for (i = 2; i < ARRAY_SIZE(tests); (++i, ++cur_test_case)) {
+	tests[2].test_func = test_audio_mixer_copy_gain;
+	tests[2].initial_state = &mix_gain_test_case;
+	tests[2].setup_func = test_setup;
+	tests[2].teardown_func = test_teardown;
+	tests[2].name = mix_gain_test_case.name;
+
+	for (i = 3; i < ARRAY_SIZE(tests); (++i, ++cur_test_case)) {
 		tests[i].test_func = test_audio_mixer_copy;
 		tests[i].initial_state = &mix_test_cases[cur_test_case];
 		tests[i].setup_func = test_setup;
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <sof/audio/src/src.h>
+#include <sof/audio/src/src_coef_gen.h>
+#include <sof/audio/src/src_config.h>
+#include <sof/common.h>
+#include <sof/math/numbers.h>
+
+/* Passband of the std coefficient set, 0.4535 of the lower rate */
+#define TEST_QUALITY		4535
+
+/* Total gain at 0 Hz and in the passband */
+#define TEST_GAIN_DB		-1.0
+#define TEST_MAX_RIPPLE_DB	0.05
+
+/* Stopband attenuation of the precomputed coefficients */
+#define TEST_MAX_STOPBAND_DB	-68.0
+
+/* Designed filters may be up to 20 % longer than the tabulated ones */
+#define TEST_MAX_LENGTH_PCT	120
+
+/* Frequency points per filter length to catch the stopband ripple peaks */
+#define TEST_POINTS		8
+
+/* Stage parameters, subfilter_length is 0 if there is no table stage */
+struct src_test_stage {
+	int idm;
+	int odm;
+	int num_of_subfilters;
+	int subfilter_length;
+	int blk_in;
+	int blk_out;
+};
+
+struct src_test_case {
+	int fs_in;
+	int fs_out;
+	struct src_test_stage stage1;
+	struct src_test_stage stage2;
+	const char *name;
+};
+
+#define TEST_CASE(_fs_in, _fs_out, _stage1, _stage2) \
+	{ \
+		.fs_in = (_fs_in), \
+		.fs_out = (_fs_out), \
+		.stage1 = _stage1, \
+		.stage2 = _stage2, \
+		.name = "test_src_coef_gen_" #_fs_in "_" #_fs_out, \
+	}
+
+#define TEST_STAGE(_idm, _odm, _l, _sub, _m) \
+	{ _idm, _odm, _l, _sub, _m, _l }
+
+/* Reference stages are from the std int32 tables, the 4:1 stage of
+ * 8 to 96 kHz has no table and the rates pair is designed only.
+ */
+static struct src_test_case src_test_cases[] = {
+	/* src_std_int32_8_7_4535_5000.h and src_std_int32_20_21_4167_5000.h */
+	TEST_CASE(44100, 48000, TEST_STAGE(6, 7, 8, 80, 7),
+		  TEST_STAGE(1, 1, 20, 56, 21)),
+	/* src_std_int32_1_3_4535_5000.h and src_int32_1_1_0_0 */
+	TEST_CASE(48000, 16000, TEST_STAGE(1, 0, 1, 268, 3),
+		  TEST_STAGE(0, 0, 1, 1, 1)),
+	/* src_std_int32_3_1_4535_5000.h */
+	TEST_CASE(8000, 96000, TEST_STAGE(0, 1, 3, 92, 1),
+		  TEST_STAGE(0, 1, 4, 0, 1)),
+};
+
+/* Magnitude response of the prototype filter of a stage in dB */
+static double stage_gain_db(const struct src_stage *stage, double f,
+			    double fs)
+{
+	double re = 0;
+	double im = 0;
+	double c;
+	int l = stage->num_of_subfilters;
+	int n;
+
+	for (n = 0; n < stage->filter_length; n++) {
+		/* Subfilter i has taps i, i + L, i + 2L, ... */
+#if SRC_SHORT
+		c = ((const int16_t *)stage->coefs)
+			[(n % l) * stage->subfilter_length + n / l] / 32768.0;
+#else
+		c = ((const int32_t *)stage->coefs)
+			[(n % l) * stage->subfilter_length + n / l] /
+			2147483648.0;
+#endif
+		re += c * cos(2 * M_PI * f / fs * n);
+		im -= c * sin(2 * M_PI * f / fs * n);
+	}
+
+	return 20 * log10(sqrt(re * re + im * im) / l) -
+		20 * log10(2) * stage->shift;
+}
+
+static void check_stage(const struct src_stage *stage,
+			const struct src_test_stage *ref)
+{
+	assert_int_equal(stage->idm, ref->idm);
+	assert_int_equal(stage->odm, ref->odm);
+	assert_int_equal(stage->num_of_subfilters, ref->num_of_subfilters);
+	assert_int_equal(stage->blk_in, ref->blk_in);
+	assert_int_equal(stage->blk_out, ref->blk_out);
+	assert_int_equal(stage->halfband, 0);
+	assert_int_equal(stage->filter_length,
+			 stage->num_of_subfilters * stage->subfilter_length);
+
+	/* 1:1 stage is a single tap */
+	if (stage->filter_length == 1)
+		return;
+
+	assert_int_equal(stage->subfilter_length % 4, 0);
+	if (ref->subfilter_length) {
+		assert_true(stage->subfilter_length >= ref->subfilter_length);
+		assert_true(stage->subfilter_length * 100 <=
+			    ref->subfilter_length * TEST_MAX_LENGTH_PCT);
+	}
+}
+
+/* Worst gain from the stopband edge at the lower rate / 2 to fs / 2 */
+static double stage_stopband_db(const struct src_stage *stage, int fs1,
+				int fs2)
+{
+	double fs = (double)fs1 * stage->num_of_subfilters;
+	double df = fs / (TEST_POINTS * stage->filter_length);
+	double f;
+	double max = -200;
+
+	if (stage->filter_length == 1)
+		return max;
+
+	for (f = MIN(fs1, fs2) / 2.0; f <= fs / 2; f += df)
+		max = fmax(max, stage_gain_db(stage, f, fs));
+
+	return max;
+}
+
+static void test_src_coef_gen(void **state)
+{
+	struct src_test_case *tc = *((struct src_test_case **)state);
+	struct src_stage *stage1;
+	struct src_stage *stage2;
+	double fs_s1;
+	double fs_s2;
+	double f_pb;
+	double df;
+	double gain;
+	double f;
+	int fs_mid;
+
+	assert_int_equal(src_coef_gen_design(tc->fs_in, tc->fs_out,
+					     TEST_QUALITY, &stage1, &stage2),
+			 0);
+
+	check_stage(stage1, &tc->stage1);
+	check_stage(stage2, &tc->stage2);
+
+	/* Rates at the stage boundary and at the stage filter inputs */
+	fs_mid = (int64_t)tc->fs_in * stage1->blk_out / stage1->blk_in;
+	fs_s1 = (double)tc->fs_in * stage1->num_of_subfilters;
+	fs_s2 = (double)fs_mid * stage2->num_of_subfilters;
+
+	/* Both stages together are at -1 dB over the passband */
+	f_pb = MIN(tc->fs_in, tc->fs_out) * TEST_QUALITY / 10000.0;
+	df = fs_s1 / (TEST_POINTS * stage1->filter_length);
+	for (f = 0; f <= f_pb; f += df) {
+		gain = stage_gain_db(stage1, f, fs_s1) +
+			stage_gain_db(stage2, f, fs_s2);
+		assert_true(fabs(gain - TEST_GAIN_DB) < TEST_MAX_RIPPLE_DB);
+	}
+
+	/* Each stage attenuates the images and aliases of its own rates */
+	assert_true(stage_stopband_db(stage1, tc->fs_in, fs_mid) <
+		    TEST_MAX_STOPBAND_DB);
+	assert_true(stage_stopband_db(stage2, fs_mid, tc->fs_out) <
+		    TEST_MAX_STOPBAND_DB);
+
+	src_coef_gen_free(stage1);
+	src_coef_gen_free(stage2);
+}
+
+int main(void)
+{
+	struct CMUnitTest tests[ARRAY_SIZE(src_test_cases)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(src_test_cases); i++) {
+		tests[i].test_func = test_src_coef_gen;
+		tests[i].initial_state = &src_test_cases[i];
+		tests[i].setup_func = NULL;
+		tests[i].teardown_func = NULL;
+		tests[i].name = src_test_cases[i].name;
+	}
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -88,6 +88,19 @@ void WEAK trace_log(bool send_atomic, const void *log_entry,
 	(void) arg_count;
 }
 
+bool WEAK trace_ratelimit_pass(struct trace_ratelimit *rl,
+			       const struct tr_ctx *ctx, uint32_t lvl,
+			       uint32_t *suppressed)
+{
+	(void) rl;
+	(void) ctx;
+	(void) lvl;
+
+	*suppressed = 0;
+
+	return true;
+}
+
 uint32_t WEAK _spin_lock_irq(spinlock_t *lock)
 {
 	(void)lock;
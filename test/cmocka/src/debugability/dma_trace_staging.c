@@ -0,0 +1,306 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+/* the staging rings and their merge are private to dma-trace.c */
+#include "../../../../src/trace/dma-trace.c"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmocka.h>
+
+/* entries written by each core in the merge order test */
+#define TEST_CORE_ENTRIES	3
+
+struct test_entry {
+	struct log_entry_header hdr;
+	uint32_t seq;
+} __packed;
+
+/* local buffer holds all entries of the merge order test and one more */
+#define TEST_BUF_SIZE \
+	((PLATFORM_CORE_COUNT * TEST_CORE_ENTRIES + 2) * \
+	 sizeof(struct test_entry))
+
+static struct sof sof;
+static struct schedulers *schedulers;
+static struct dma_trace_data test_data;
+static uint8_t test_buf[TEST_BUF_SIZE];
+
+/* drop count last reported by dtrace_ring_merge() */
+static uint32_t test_dropped;
+
+struct sof *sof_get(void)
+{
+	return &sof;
+}
+
+struct schedulers **arch_schedulers_get(void)
+{
+	return &schedulers;
+}
+
+int dma_copy_new(struct dma_copy *dc)
+{
+	(void)dc;
+
+	return 0;
+}
+
+int dma_copy_set_stream_tag(struct dma_copy *dc, uint32_t stream_tag)
+{
+	(void)dc;
+	(void)stream_tag;
+
+	return 0;
+}
+
+int dma_copy_to_host_nowait(struct dma_copy *dc, struct dma_sg_config *host_sg,
+			    int32_t host_offset, void *local_ptr, int32_t size)
+{
+	(void)dc;
+	(void)host_sg;
+	(void)host_offset;
+	(void)local_ptr;
+
+	return size;
+}
+
+int dma_sg_alloc(struct dma_sg_elem_array *ea, enum mem_zone zone,
+		 uint32_t direction, uint32_t buffer_count,
+		 uint32_t buffer_bytes, uintptr_t dma_buffer_addr,
+		 uintptr_t external_addr)
+{
+	(void)ea;
+	(void)zone;
+	(void)direction;
+	(void)buffer_count;
+	(void)buffer_bytes;
+	(void)dma_buffer_addr;
+	(void)external_addr;
+
+	return 0;
+}
+
+int schedule_task_init_ll(struct task *task,
+			  uint32_t uid, uint16_t type, uint16_t priority,
+			  enum task_state (*run)(void *data), void *data,
+			  uint16_t core, uint32_t flags)
+{
+	(void)task;
+	(void)uid;
+	(void)type;
+	(void)priority;
+	(void)run;
+	(void)data;
+	(void)core;
+	(void)flags;
+
+	return 0;
+}
+
+void ipc_msg_send(struct ipc_msg *msg, void *data, bool high_priority)
+{
+	(void)msg;
+	(void)data;
+	(void)high_priority;
+}
+
+void trace_log(bool send_atomic, const void *log_entry,
+	       const struct tr_ctx *ctx, uint32_t lvl, uint32_t id_1,
+	       uint32_t id_2, int arg_count, ...)
+{
+	va_list vl;
+
+	(void)send_atomic;
+	(void)log_entry;
+	(void)lvl;
+	(void)id_1;
+	(void)id_2;
+
+	/* only the drop report of the merge has a single argument */
+	if (ctx != &dt_tr || arg_count != 1)
+		return;
+
+	va_start(vl, arg_count);
+	test_dropped = va_arg(vl, uint32_t);
+	va_end(vl);
+}
+
+static int setup(void **state)
+{
+	struct dma_trace_data *d = &test_data;
+	struct dma_trace_buf *buffer = &d->dmatb;
+
+	(void)state;
+
+	assert_int_equal(dtrace_ring_init(d), 0);
+
+	buffer->addr = test_buf;
+	buffer->size = TEST_BUF_SIZE;
+	buffer->w_ptr = buffer->addr;
+	buffer->r_ptr = buffer->addr;
+	buffer->end_addr = (char *)buffer->addr + buffer->size;
+	buffer->avail = 0;
+
+	d->posn.messages = 0;
+	d->dropped_entries = 0;
+	sof.dmat = d;
+	test_dropped = 0;
+
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	(void)state;
+
+	rfree(test_data.ring);
+	test_data.ring = NULL;
+
+	return 0;
+}
+
+/* adds an entry to the ring of core as dtrace_ring_add() does there */
+static void test_ring_add(struct dma_trace_data *d, int core,
+			  uint64_t timestamp)
+{
+	struct dma_trace_ring *ring = &d->ring[core];
+	struct dma_trace_slot *slot;
+	struct test_entry e = {
+		.hdr.core_id = core,
+		.hdr.timestamp = timestamp,
+		.seq = timestamp,
+	};
+
+	if (core == cpu_get_id()) {
+		dtrace_ring_add(d, (const char *)&e, sizeof(e));
+		return;
+	}
+
+	slot = &ring->slot[ring->w_pos & DMA_TRACE_RING_MASK];
+	slot->length = sizeof(e);
+	memcpy(slot->data, &e, sizeof(e));
+	ring->w_pos++;
+}
+
+static void test_dma_trace_staging_order(void **state)
+{
+	struct dma_trace_data *d = &test_data;
+	struct test_entry *e = (struct test_entry *)test_buf;
+	int count = PLATFORM_CORE_COUNT * TEST_CORE_ENTRIES;
+	int core;
+	int i;
+
+	(void)state;
+
+	/* core c stamps c, c + cores, ..., rings are filled one by one */
+	for (core = PLATFORM_CORE_COUNT - 1; core >= 0; core--)
+		for (i = 0; i < TEST_CORE_ENTRIES; i++)
+			test_ring_add(d, core, i * PLATFORM_CORE_COUNT + core);
+
+	dtrace_ring_merge(d);
+
+	assert_int_equal(d->dmatb.avail, count * sizeof(*e));
+	assert_int_equal(d->posn.messages, count);
+	assert_int_equal(test_dropped, 0);
+
+	for (i = 0; i < count; i++) {
+		assert_int_equal(e[i].hdr.timestamp, i);
+		assert_int_equal(e[i].hdr.core_id, i % PLATFORM_CORE_COUNT);
+		assert_int_equal(e[i].seq, i);
+	}
+
+	for (core = 0; core < PLATFORM_CORE_COUNT; core++)
+		assert_int_equal(dtrace_ring_used(&d->ring[core]), 0);
+}
+
+static void test_dma_trace_staging_drops(void **state)
+{
+	struct dma_trace_data *d = &test_data;
+	struct dma_trace_ring *ring = &d->ring[cpu_get_id()];
+	char big[sizeof(ring->slot[0].data) + 1] = { 0 };
+	uint32_t fit = (TEST_BUF_SIZE - 1) / sizeof(struct test_entry);
+	uint32_t ring_dropped = 3;
+	uint32_t buf_dropped;
+	int i;
+
+	(void)state;
+
+	/* full ring and oversized entries are dropped by the writer */
+	for (i = 0; i < DMA_TRACE_RING_ENTRIES + 2; i++)
+		test_ring_add(d, cpu_get_id(), i);
+	dtrace_ring_add(d, big, sizeof(big));
+
+	assert_int_equal(dtrace_ring_used(ring), DMA_TRACE_RING_ENTRIES);
+	assert_int_equal(ring->dropped, ring_dropped);
+
+	/* entries not fitting the local buffer are dropped by the merge */
+	buf_dropped = DMA_TRACE_RING_ENTRIES > fit ?
+		DMA_TRACE_RING_ENTRIES - fit : 0;
+
+	dtrace_ring_merge(d);
+
+	assert_int_equal(dtrace_ring_used(ring), 0);
+	assert_int_equal(d->posn.messages,
+			 DMA_TRACE_RING_ENTRIES - buf_dropped);
+	assert_int_equal(ring->dropped_seen, ring_dropped);
+	assert_int_equal(d->dropped_entries, 0);
+	assert_int_equal(test_dropped, ring_dropped + buf_dropped);
+
+	/* drops are reported once */
+	test_dropped = 0;
+	dtrace_ring_merge(d);
+	assert_int_equal(test_dropped, 0);
+}
+
+static void test_dma_trace_staging_wrap(void **state)
+{
+	struct dma_trace_data *d = &test_data;
+	struct dma_trace_buf *buffer = &d->dmatb;
+	struct test_entry e[2];
+	uint32_t margin = sizeof(e[0]) / 2;
+	char *end = (char *)buffer->end_addr;
+
+	(void)state;
+
+	/* the first entry is split over the end of the local buffer */
+	buffer->w_ptr = end - margin;
+	buffer->r_ptr = buffer->w_ptr;
+
+	test_ring_add(d, cpu_get_id(), 1);
+	test_ring_add(d, cpu_get_id(), 2);
+
+	dtrace_ring_merge(d);
+
+	assert_int_equal(buffer->avail, sizeof(e));
+	assert_ptr_equal(buffer->w_ptr,
+			 (char *)buffer->addr + sizeof(e) - margin);
+
+	memcpy(e, end - margin, margin);
+	memcpy((char *)e + margin, buffer->addr, sizeof(e) - margin);
+
+	assert_int_equal(e[0].hdr.timestamp, 1);
+	assert_int_equal(e[0].seq, 1);
+	assert_int_equal(e[1].hdr.timestamp, 2);
+	assert_int_equal(e[1].seq, 2);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_dma_trace_staging_order,
+						setup, teardown),
+		cmocka_unit_test_setup_teardown(test_dma_trace_staging_drops,
+						setup, teardown),
+		cmocka_unit_test_setup_teardown(test_dma_trace_staging_wrap,
+						setup, teardown),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/drivers/timer.h>
+#include <sof/lib/clk.h>
+#include <sof/sof.h>
+#include <sof/trace/dma-trace.h>
+#include <sof/trace/trace.h>
+#include <user/trace.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+#define TEST_TICKS_PER_MS	1000
+#define TEST_WINDOW_TICKS	(CONFIG_TRACE_RATELIMIT_MS * TEST_TICKS_PER_MS)
+
+static struct sof sof;
+static uint64_t test_now;
+
+/* struct trace is private to trace.c, large enough backing store for it */
+static uint32_t trace_mem[16];
+
+static struct tr_ctx test_tr = {
+	.level = LOG_LEVEL_INFO,
+};
+
+struct sof *sof_get(void)
+{
+	return &sof;
+}
+
+uint64_t platform_timer_get(struct timer *timer)
+{
+	(void)timer;
+
+	return test_now;
+}
+
+uint64_t clock_ms_to_ticks(int clock, uint64_t ms)
+{
+	(void)clock;
+
+	return ms * TEST_TICKS_PER_MS;
+}
+
+void dtrace_event(const char *e, uint32_t size)
+{
+	(void)e;
+	(void)size;
+}
+
+void dtrace_event_atomic(const char *e, uint32_t length)
+{
+	(void)e;
+	(void)length;
+}
+
+void dma_trace_flush(void *destination)
+{
+	(void)destination;
+}
+
+void dma_trace_on(void)
+{
+}
+
+void dma_trace_off(void)
+{
+}
+
+int dma_trace_init_early(struct sof *sof)
+{
+	(void)sof;
+
+	return 0;
+}
+
+static int setup(void **state)
+{
+	(void)state;
+
+	sof.trace = (struct trace *)trace_mem;
+	trace_on();
+
+	return 0;
+}
+
+static int setup_window(void **state)
+{
+	struct trace_ratelimit *rl = test_calloc(1, sizeof(*rl));
+
+	/* every case starts in a fresh window of a fresh call site */
+	test_now += 2 * TEST_WINDOW_TICKS;
+	*state = rl;
+
+	return 0;
+}
+
+static int teardown_window(void **state)
+{
+	test_free(*state);
+
+	return 0;
+}
+
+static void test_debugability_ratelimit_burst(void **state)
+{
+	struct trace_ratelimit *rl = *state;
+	uint32_t suppressed;
+	int i;
+
+	for (i = 0; i < CONFIG_TRACE_RATELIMIT_BURST; i++) {
+		suppressed = UINT32_MAX;
+		assert_true(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+						 &suppressed));
+		assert_int_equal(suppressed, 0);
+	}
+
+	/* the rest of the window is suppressed, even at its last tick */
+	assert_false(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+					  &suppressed));
+	test_now += TEST_WINDOW_TICKS - 1;
+	assert_false(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+					  &suppressed));
+	assert_int_equal(rl->suppressed, 2);
+}
+
+static void test_debugability_ratelimit_rollover(void **state)
+{
+	struct trace_ratelimit *rl = *state;
+	uint32_t suppressed;
+	int i;
+
+	for (i = 0; i < CONFIG_TRACE_RATELIMIT_BURST + 3; i++)
+		trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+				     &suppressed);
+
+	/* first trace of the next window reports the suppressed ones */
+	test_now += TEST_WINDOW_TICKS;
+	assert_true(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+					 &suppressed));
+	assert_int_equal(suppressed, 3);
+
+	assert_true(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_INFO,
+					 &suppressed));
+	assert_int_equal(suppressed, 0);
+	assert_int_equal(rl->events, 2);
+}
+
+static void test_debugability_ratelimit_filtered(void **state)
+{
+	struct trace_ratelimit *rl = *state;
+	uint32_t suppressed;
+
+	/* traces filtered by level neither pass nor count as suppressed */
+	assert_false(trace_ratelimit_pass(rl, &test_tr, LOG_LEVEL_DEBUG,
+					  &suppressed));
+	assert_int_equal(rl->events, 0);
+	assert_int_equal(rl->suppressed, 0);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown
+			(test_debugability_ratelimit_burst,
+			 setup_window, teardown_window),
+		cmocka_unit_test_setup_teardown
+			(test_debugability_ratelimit_rollover,
+			 setup_window, teardown_window),
+		cmocka_unit_test_setup_teardown
+			(test_debugability_ratelimit_filtered,
+			 setup_window, teardown_window),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, setup, NULL);
+}
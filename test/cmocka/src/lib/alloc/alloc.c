@@ -9,20 +9,26 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <time.h>
 #include <cmocka.h>
 
 #include <sof/sof.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/mm_heap.h>
+#include <ipc/debug.h>
 #include <ipc/header.h>
 #include <ipc/topology.h>
 
 enum test_type {
 	TEST_BULK = 0,
 	TEST_ZERO,
-	TEST_IMMEDIATE_FREE
+	TEST_IMMEDIATE_FREE,
+	TEST_BENCH
 };
 
+/* alloc and free rounds of one benchmark test case */
+#define TEST_BENCH_ROUNDS	64
+
 struct test_case {
 	size_t alloc_size;
 	int alloc_zone;
@@ -209,13 +215,34 @@ static struct test_case test_cases[] = {
 		  2, TEST_BULK, "rballoc_dma"),
 	TEST_CASE(2048, SOF_MEM_ZONE_BUFFER, SOF_MEM_CAPS_RAM |
 		  SOF_MEM_CAPS_DMA, 100, TEST_IMMEDIATE_FREE, "rballoc_dma"),
+
+	/*
+	 * benchmarks
+	 */
+
+	TEST_CASE(64,  SOF_MEM_ZONE_RUNTIME, SOF_MEM_CAPS_RAM, 64, TEST_BENCH,
+		  "rmalloc_bench"),
+	TEST_CASE(4,   SOF_MEM_ZONE_BUFFER, SOF_MEM_CAPS_RAM, 64, TEST_BENCH,
+		  "rballoc_bench"),
+	TEST_CASE(2048, SOF_MEM_ZONE_BUFFER, SOF_MEM_CAPS_RAM, 16, TEST_BENCH,
+		  "rballoc_bench"),
 };
 
+/* system heap usage after init, holds the block free masks */
+static struct mm_info sys_info[PLATFORM_HEAP_SYSTEM];
+
 static int setup(void **state)
 {
+	struct mm *memmap;
+	int i;
+
 	platform_init_memmap(sof_get());
 	init_heap(sof_get());
 
+	memmap = memmap_get();
+	for (i = 0; i < ARRAY_SIZE(memmap->system); ++i)
+		sys_info[i] = memmap->system[i].info;
+
 	return 0;
 }
 
@@ -232,8 +259,7 @@ static int clear_sys(void **state)
 	for (; sysheap_idx < ARRAY_SIZE(memmap->system); ++sysheap_idx) {
 		struct mm_heap *cpu_heap = &memmap->system[sysheap_idx];
 
-		cpu_heap->info.used = 0;
-		cpu_heap->info.free = cpu_heap->size;
+		cpu_heap->info = sys_info[sysheap_idx];
 	}
 
 	return 0;
@@ -313,6 +339,113 @@ static void test_lib_alloc_zero(struct test_case *tc)
 	free(all_mem);
 }
 
+/* runtime or buffer heap and its block map holding ptr */
+static struct mm_heap *bench_heap_get(void *ptr, struct block_map **map)
+{
+	struct mm *memmap = memmap_get();
+	struct mm_heap *heaps[] = { memmap->runtime, memmap->buffer };
+	int counts[] = { ARRAY_SIZE(memmap->runtime),
+			 ARRAY_SIZE(memmap->buffer) };
+	struct mm_heap *heap;
+	struct block_map *m;
+	uintptr_t p = (uintptr_t)ptr;
+	int i;
+	int j;
+	int k;
+
+	for (i = 0; i < ARRAY_SIZE(heaps); ++i) {
+		for (j = 0; j < counts[i]; ++j) {
+			heap = &heaps[i][j];
+			for (k = 0; k < heap->blocks; ++k) {
+				m = &heap->map[k];
+				if (p >= m->base &&
+				    p < m->base + m->count * m->block_size) {
+					*map = m;
+					return heap;
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* first_free must be the lowest free block of the map */
+static void bench_check_first_free(struct block_map *map)
+{
+	int i;
+
+	for (i = 0; i < map->count && map->block[i].used; ++i)
+		;
+
+	assert_int_equal(map->first_free, i);
+}
+
+/* freed blocks must be back in their heap for the checks */
+static void bench_drain(void)
+{
+#if CONFIG_MM_MAGAZINE
+	heap_magazine_drain(cpu_get_id());
+#endif
+}
+
+static void test_lib_alloc_bench(struct test_case *tc)
+{
+	void **all_mem = malloc(sizeof(void *) * tc->alloc_num);
+	struct block_map *map;
+	struct mm_heap *heap;
+	uint32_t heap_used;
+	uint16_t free_count;
+	clock_t start;
+	clock_t ticks;
+	int round;
+	int i;
+
+	/* find the heap of this test case with one allocation */
+	all_mem[0] = alloc(tc);
+	assert_non_null(all_mem[0]);
+	rfree(all_mem[0]);
+	bench_drain();
+	heap = bench_heap_get(all_mem[0], &map);
+	assert_non_null(heap);
+	heap_used = heap->info.used;
+	free_count = map->free_count;
+
+	start = clock();
+
+	for (round = 0; round < TEST_BENCH_ROUNDS; ++round) {
+		for (i = 0; i < tc->alloc_num; ++i) {
+			all_mem[i] = alloc(tc);
+			assert_non_null(all_mem[i]);
+		}
+
+		/* free every other block first to fragment the maps */
+		for (i = 0; i < tc->alloc_num; i += 2)
+			rfree(all_mem[i]);
+
+		bench_drain();
+		bench_check_first_free(map);
+
+		for (i = 1; i < tc->alloc_num; i += 2)
+			rfree(all_mem[i]);
+
+		bench_drain();
+		bench_check_first_free(map);
+
+		/* every round leaves the heap as it found it */
+		assert_int_equal(heap->info.used, heap_used);
+		assert_int_equal(map->free_count, free_count);
+	}
+
+	ticks = clock() - start;
+
+	print_message("%s: %lu clock ticks for %d allocs and frees\n",
+		      tc->name, (unsigned long)ticks,
+		      TEST_BENCH_ROUNDS * tc->alloc_num);
+
+	free(all_mem);
+}
+
 static void test_lib_alloc(void **state)
 {
 	struct test_case *tc = *((struct test_case **)state);
@@ -329,12 +462,132 @@ static void test_lib_alloc(void **state)
 	case TEST_IMMEDIATE_FREE:
 		test_lib_alloc_immediate_free(tc);
 		break;
+
+	case TEST_BENCH:
+		test_lib_alloc_bench(tc);
+		break;
 	}
 }
 
+#if CONFIG_MM_MAGAZINE
+/* a freed small runtime block is handed out again by the same core */
+static void test_lib_alloc_magazine_reuse(void **state)
+{
+	uint32_t used;
+	void *mem;
+
+	(void)state;
+
+	heap_magazine_drain(cpu_get_id());
+	used = heap_used_bytes();
+
+	mem = rmalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, 4);
+	assert_non_null(mem);
+	assert_true(heap_used_bytes() > used);
+
+	/* cached blocks are not reported as used */
+	rfree(mem);
+	assert_int_equal(heap_used_bytes(), used);
+
+	assert_ptr_equal(rmalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, 4),
+			 mem);
+
+	rfree(mem);
+}
+
+/* draining returns every cached block to the runtime heap */
+static void test_lib_alloc_magazine_drain(void **state)
+{
+	struct mm *memmap = memmap_get();
+	struct mm_heap *heap = &memmap->runtime[0];
+	void *mem[CONFIG_MM_MAGAZINE_DEPTH];
+	uint32_t heap_used;
+	uint32_t used;
+	int i;
+
+	(void)state;
+
+	heap_magazine_drain(cpu_get_id());
+	heap_used = heap->info.used;
+	used = heap_used_bytes();
+
+	for (i = 0; i < ARRAY_SIZE(mem); ++i) {
+		mem[i] = rmalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, 4);
+		assert_non_null(mem[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(mem); ++i)
+		rfree(mem[i]);
+
+	assert_int_equal(memmap->magazine[cpu_get_id()].count[0],
+			 ARRAY_SIZE(mem));
+	assert_true(heap->info.used > heap_used);
+	assert_int_equal(heap_used_bytes(), used);
+
+	heap_magazine_drain(cpu_get_id());
+
+	assert_int_equal(memmap->magazine[cpu_get_id()].count[0], 0);
+	assert_int_equal(memmap->magazine[cpu_get_id()].bytes, 0);
+	assert_int_equal(heap->info.used, heap_used);
+	assert_int_equal(heap_used_bytes(), used);
+}
+
+/* heap stats report cached blocks as free, as heap_used_bytes() does */
+static void test_lib_alloc_magazine_stats(void **state)
+{
+	struct mm *memmap = memmap_get();
+	struct mm_heap *heap = &memmap->runtime[0];
+	struct sof_ipc_dbg_mem_heap *elem;
+	struct sof_ipc_dbg_mem_stats *stats;
+	uint32_t max_size = sizeof(*stats) + sizeof(*elem) *
+		(PLATFORM_HEAP_SYSTEM + PLATFORM_HEAP_SYSTEM_RUNTIME +
+		 PLATFORM_HEAP_RUNTIME + PLATFORM_HEAP_BUFFER);
+	uint32_t used;
+	uint32_t heap_free;
+	void *mem;
+
+	(void)state;
+
+	heap_magazine_drain(cpu_get_id());
+	used = heap->info.used;
+	heap_free = heap->info.free;
+
+	mem = rmalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, 4);
+	assert_non_null(mem);
+	rfree(mem);
+	assert_true(heap->info.used > used);
+
+	stats = test_calloc(1, max_size);
+	stats->rhdr.hdr.size = sizeof(*stats);
+	stats->type = SOF_IPC_DBG_MEM_HEAP;
+	heap_stats(stats, max_size);
+
+	/* first runtime heap follows the system and system runtime heaps */
+	elem = (struct sof_ipc_dbg_mem_heap *)stats->elems +
+		PLATFORM_HEAP_SYSTEM + PLATFORM_HEAP_SYSTEM_RUNTIME;
+	assert_int_equal(elem->zone, SOF_MEM_ZONE_RUNTIME);
+	assert_int_equal(elem->used, used);
+	assert_int_equal(elem->free, heap_free);
+	assert_true(elem->free_max >= heap->map[0].block_size);
+
+	test_free(stats);
+	heap_magazine_drain(cpu_get_id());
+}
+
+static const struct CMUnitTest magazine_tests[] = {
+	cmocka_unit_test_setup(test_lib_alloc_magazine_reuse, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_magazine_drain, clear_sys),
+	cmocka_unit_test_setup(test_lib_alloc_magazine_stats, clear_sys),
+};
+
+#define MAGAZINE_TESTS	ARRAY_SIZE(magazine_tests)
+#else
+#define MAGAZINE_TESTS	0
+#endif
+
 int main(void)
 {
-	struct CMUnitTest tests[ARRAY_SIZE(test_cases)];
+	struct CMUnitTest tests[ARRAY_SIZE(test_cases) + MAGAZINE_TESTS];
 
 	int i;
 
@@ -348,6 +601,11 @@ int main(void)
 		t->teardown_func = NULL;
 	}
 
+#if CONFIG_MM_MAGAZINE
+	for (i = 0; i < MAGAZINE_TESTS; ++i)
+		tests[ARRAY_SIZE(test_cases) + i] = magazine_tests[i];
+#endif
+
 	cmocka_set_message_output(CM_OUTPUT_TAP);
 
 	return cmocka_run_group_tests(tests, setup, teardown);
@@ -0,0 +1,309 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+#include <sof/drivers/interrupt.h>
+#include <sof/drivers/timer.h>
+#include <sof/lib/clk.h>
+#include <sof/schedule/edf_schedule.h>
+#include <sof/schedule/schedule.h>
+#include <sof/schedule/task.h>
+#include <sof/sof.h>
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+/* one tick per microsecond */
+#define TEST_TICKS_PER_MS	1000
+#define TEST_BUDGET		100
+#define TEST_TASKS		4
+
+struct test_task {
+	struct task task;
+	uint64_t deadline;
+};
+
+static struct sof sof;
+static struct schedulers *schedulers;
+static uint64_t test_now;
+static int task_ctx;
+
+/* EDF scheduler interrupt handler, run by the test instead */
+static void (*edf_irq_handler)(void *arg);
+static void *edf_irq_arg;
+
+struct sof *sof_get(void)
+{
+	return &sof;
+}
+
+struct schedulers **arch_schedulers_get(void)
+{
+	return &schedulers;
+}
+
+uint64_t platform_timer_get(struct timer *timer)
+{
+	(void)timer;
+
+	return test_now;
+}
+
+uint64_t clock_ms_to_ticks(int clock, uint64_t ms)
+{
+	(void)clock;
+
+	return ms * TEST_TICKS_PER_MS;
+}
+
+int task_context_alloc(void **task_ctx_ptr)
+{
+	*task_ctx_ptr = &task_ctx;
+
+	return 0;
+}
+
+int task_context_init(void *task_ctx_ptr, void *entry, void *arg0,
+		      void *arg1, int task_core, void *stack, int stack_size)
+{
+	(void)task_ctx_ptr;
+	(void)entry;
+	(void)arg0;
+	(void)arg1;
+	(void)task_core;
+	(void)stack;
+	(void)stack_size;
+
+	return 0;
+}
+
+void task_context_free(void *task_ctx_ptr)
+{
+	(void)task_ctx_ptr;
+}
+
+void task_context_set(void *task_ctx_ptr)
+{
+	(void)task_ctx_ptr;
+}
+
+void task_main_init(void)
+{
+}
+
+void task_main_free(void)
+{
+}
+
+int interrupt_get_irq(unsigned int irq, const char *cascade)
+{
+	(void)cascade;
+
+	return irq;
+}
+
+int interrupt_register(uint32_t irq, void(*handler)(void *arg), void *arg)
+{
+	(void)irq;
+
+	edf_irq_handler = handler;
+	edf_irq_arg = arg;
+
+	return 0;
+}
+
+void interrupt_unregister(uint32_t irq, const void *arg)
+{
+	(void)irq;
+	(void)arg;
+}
+
+uint32_t interrupt_enable(uint32_t irq, void *arg)
+{
+	(void)irq;
+	(void)arg;
+
+	return 0;
+}
+
+uint32_t interrupt_disable(uint32_t irq, void *arg)
+{
+	(void)irq;
+	(void)arg;
+
+	return 0;
+}
+
+void platform_interrupt_set(uint32_t irq)
+{
+	(void)irq;
+}
+
+static enum task_state test_task_run(void *data)
+{
+	(void)data;
+
+	return SOF_TASK_STATE_COMPLETED;
+}
+
+static uint64_t test_task_deadline(void *data)
+{
+	struct test_task *tt = data;
+
+	return tt->deadline;
+}
+
+static int setup(void **state)
+{
+	(void)state;
+
+	return scheduler_init_edf();
+}
+
+static struct test_task *test_task_new(void)
+{
+	struct task_ops ops = {
+		.run = test_task_run,
+		.get_deadline = test_task_deadline,
+	};
+	struct test_task *tt = test_calloc(1, sizeof(*tt));
+
+	assert_int_equal(schedule_task_init_edf(&tt->task, 0, &ops, tt, 0, 0),
+			 0);
+
+	return tt;
+}
+
+static void test_task_free(struct test_task *tt)
+{
+	schedule_task_free(&tt->task);
+	test_free(tt);
+}
+
+static int setup_task(void **state)
+{
+	*state = test_task_new();
+
+	return 0;
+}
+
+static int teardown_task(void **state)
+{
+	test_task_free(*state);
+
+	return 0;
+}
+
+/* runs the task once, taking the given time to complete */
+static void test_run_task(struct test_task *tt, uint64_t deadline,
+			  uint64_t run_ticks)
+{
+	tt->deadline = deadline;
+	assert_int_equal(schedule_task(&tt->task, 0, 0), 0);
+	schedule_task_running(&tt->task);
+	test_now += run_ticks;
+	schedule_task_complete(&tt->task);
+}
+
+static void test_edf_deadline_met(void **state)
+{
+	struct test_task *tt = *state;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(&tt->task);
+
+	test_run_task(tt, test_now + TEST_BUDGET, TEST_BUDGET);
+	assert_int_equal(edf_pdata->deadline_misses, 0);
+}
+
+static void test_edf_deadline_missed(void **state)
+{
+	struct test_task *tt = *state;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(&tt->task);
+
+	test_run_task(tt, test_now + TEST_BUDGET, TEST_BUDGET + 1);
+	assert_int_equal(edf_pdata->deadline_misses, 1);
+
+	/* every late completion is counted */
+	test_run_task(tt, test_now + TEST_BUDGET, 2 * TEST_BUDGET);
+	test_run_task(tt, test_now + TEST_BUDGET, TEST_BUDGET / 2);
+	assert_int_equal(edf_pdata->deadline_misses, 2);
+}
+
+static void test_edf_deadline_priority(void **state)
+{
+	struct test_task *tt = *state;
+	struct edf_task_pdata *edf_pdata = edf_sch_get_pdata(&tt->task);
+
+	/* NOW and idle deadlines are priorities that cannot be missed */
+	test_run_task(tt, SOF_TASK_DEADLINE_NOW, 10 * TEST_BUDGET);
+	test_run_task(tt, SOF_TASK_DEADLINE_ALMOST_IDLE, 10 * TEST_BUDGET);
+	test_run_task(tt, SOF_TASK_DEADLINE_IDLE, 10 * TEST_BUDGET);
+	assert_int_equal(edf_pdata->deadline_misses, 0);
+}
+
+/* runs the scheduler interrupt and returns the task it switched to */
+static struct test_task *test_run_next(struct test_task **tt, int count)
+{
+	struct test_task *running = NULL;
+	int i;
+
+	edf_irq_handler(edf_irq_arg);
+
+	for (i = 0; i < count; i++) {
+		if (tt[i]->task.state != SOF_TASK_STATE_RUNNING)
+			continue;
+
+		assert_null(running);
+		running = tt[i];
+	}
+
+	assert_non_null(running);
+
+	return running;
+}
+
+static void test_edf_heap_order(void **state)
+{
+	static const uint64_t deadlines[TEST_TASKS] = { 300, 100, 200, 100 };
+	static const int order[TEST_TASKS] = { 1, 3, 2, 0 };
+	struct test_task *tt[TEST_TASKS];
+	struct test_task *running;
+	int i;
+
+	(void)state;
+
+	for (i = 0; i < TEST_TASKS; i++) {
+		tt[i] = test_task_new();
+		tt[i]->deadline = test_now + deadlines[i];
+		assert_int_equal(schedule_task(&tt[i]->task, 0, 0), 0);
+	}
+
+	/* earliest deadline first, equal deadlines in queueing order */
+	for (i = 0; i < TEST_TASKS; i++) {
+		running = test_run_next(tt, TEST_TASKS);
+		assert_ptr_equal(running, tt[order[i]]);
+		schedule_task_complete(&running->task);
+	}
+
+	for (i = 0; i < TEST_TASKS; i++)
+		test_task_free(tt[i]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_edf_deadline_met,
+						setup_task, teardown_task),
+		cmocka_unit_test_setup_teardown(test_edf_deadline_missed,
+						setup_task, teardown_task),
+		cmocka_unit_test_setup_teardown(test_edf_deadline_priority,
+						setup_task, teardown_task),
+		cmocka_unit_test(test_edf_heap_order),
+	};
+
+	cmocka_set_message_output(CM_OUTPUT_TAP);
+
+	return cmocka_run_group_tests(tests, setup, NULL);
+}
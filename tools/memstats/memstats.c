@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+/*
+ * Decodes the replies of SOF_IPC_DEBUG_MEM_STATS queries. Every file may
+ * hold several replies back to back, as many as were needed to read all
+ * elements of each type.
+ *
+ * Usage to decode replies: ./sof-memstats replies.bin
+ *
+ */
+
+#include <ipc/debug.h>
+#include <ipc/header.h>
+#include <ipc/topology.h>
+#include <sof/common.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define APP_NAME "sof-memstats"
+
+/* same order as enum mem_zone of the firmware */
+static const char * const zone_names[] = {
+	"system", "sys-runtime", "runtime", "buffer"
+};
+
+/* same values as COMP_TYPE_ of the firmware */
+static const char * const comp_type_names[] = {
+	"?", "component", "buffer", "pipeline"
+};
+
+static const char * const caps_names[] = {
+	"ram", "rom", "ext", "lp", "hp", "dma", "cache", "exec"
+};
+
+static void usage(void)
+{
+	fprintf(stdout, "Usage %s <option(s)> <file(s)>\n\n", APP_NAME);
+	fprintf(stdout, "%s:\t file\t\tDecode memory statistics replies\n",
+		APP_NAME);
+	fprintf(stdout, "%s:\t -h \t\tHelp, usage info\n", APP_NAME);
+	exit(0);
+}
+
+static const char *caps_str(uint32_t caps, char *str, size_t size)
+{
+	size_t len = 0;
+	int i;
+
+	str[0] = '\0';
+	for (i = 0; i < ARRAY_SIZE(caps_names); i++) {
+		if (caps & (1 << i))
+			len += snprintf(str + len, size - len, "%s%s",
+					len ? "," : "", caps_names[i]);
+		if (len >= size)
+			break;
+	}
+
+	return str;
+}
+
+static uint32_t elem_size(uint32_t type)
+{
+	switch (type) {
+	case SOF_IPC_DBG_MEM_HEAP:
+		return sizeof(struct sof_ipc_dbg_mem_heap);
+	case SOF_IPC_DBG_MEM_FAIL:
+		return sizeof(struct sof_ipc_dbg_mem_fail);
+	case SOF_IPC_DBG_MEM_COMP:
+		return sizeof(struct sof_ipc_dbg_mem_comp);
+	default:
+		return 0;
+	}
+}
+
+static void print_heap(struct sof_ipc_dbg_mem_heap *heap)
+{
+	char caps[64];
+	int frag;
+
+	/* fragmentation is the part of free space not in the largest run */
+	frag = heap->free ? 100 - 100ULL * heap->free_max / heap->free : 0;
+
+	fprintf(stdout, "%-12s %4u %-24s %8u %8u %8u %8u %8u %6d\n",
+		heap->zone < ARRAY_SIZE(zone_names) ?
+		zone_names[heap->zone] : "?", heap->core,
+		caps_str(heap->caps, caps, sizeof(caps)), heap->size,
+		heap->used, heap->free, heap->used_max, heap->free_max, frag);
+}
+
+static void print_fail(struct sof_ipc_dbg_mem_fail *fail)
+{
+	char caps[64];
+
+	fprintf(stdout, "%-24s %8u\n",
+		caps_str(fail->caps, caps, sizeof(caps)), fail->count);
+}
+
+static void print_comp(struct sof_ipc_dbg_mem_comp *comp)
+{
+	fprintf(stdout, "%8u %-10s %4u %12u\n", comp->id,
+		comp->type < ARRAY_SIZE(comp_type_names) ?
+		comp_type_names[comp->type] : "?",
+		comp->core, comp->bytes);
+}
+
+static void print_title(uint32_t type)
+{
+	switch (type) {
+	case SOF_IPC_DBG_MEM_HEAP:
+		fprintf(stdout, "\n%-12s %4s %-24s %8s %8s %8s %8s %8s %6s\n",
+			"heap", "core", "caps", "size", "used", "free",
+			"used max", "free max", "frag %");
+		break;
+	case SOF_IPC_DBG_MEM_FAIL:
+		fprintf(stdout, "\n%-24s %8s\n", "failed caps", "count");
+		break;
+	case SOF_IPC_DBG_MEM_COMP:
+		fprintf(stdout, "\n%8s %-10s %4s %12s\n", "id", "type", "core",
+			"create bytes");
+		break;
+	}
+}
+
+static int decode_reply(struct sof_ipc_dbg_mem_stats *stats, size_t avail)
+{
+	uint32_t size = elem_size(stats->type);
+	uint8_t *elem = stats->elems;
+	int i;
+
+	if (stats->rhdr.hdr.cmd !=
+	    (SOF_IPC_GLB_DEBUG | SOF_IPC_DEBUG_MEM_STATS) ||
+	    stats->rhdr.hdr.size > avail || !size ||
+	    stats->rhdr.hdr.size != sizeof(*stats) + stats->num_elems * size) {
+		fprintf(stderr, "error: invalid reply cmd 0x%x size %u\n",
+			stats->rhdr.hdr.cmd, stats->rhdr.hdr.size);
+		return -EINVAL;
+	}
+
+	if (stats->rhdr.error) {
+		fprintf(stderr, "error: reply error %d\n", stats->rhdr.error);
+		return stats->rhdr.error;
+	}
+
+	if (!stats->first) {
+		if (stats->type == SOF_IPC_DBG_MEM_HEAP)
+			fprintf(stdout, "\nfailed allocations: %u\n",
+				stats->fail_count);
+		print_title(stats->type);
+	}
+
+	for (i = 0; i < stats->num_elems; i++, elem += size) {
+		switch (stats->type) {
+		case SOF_IPC_DBG_MEM_HEAP:
+			print_heap((struct sof_ipc_dbg_mem_heap *)elem);
+			break;
+		case SOF_IPC_DBG_MEM_FAIL:
+			print_fail((struct sof_ipc_dbg_mem_fail *)elem);
+			break;
+		case SOF_IPC_DBG_MEM_COMP:
+			print_comp((struct sof_ipc_dbg_mem_comp *)elem);
+			break;
+		}
+	}
+
+	if (stats->first + stats->num_elems < stats->total)
+		fprintf(stdout, "... %u more, query again from %u\n",
+			stats->total - stats->first - stats->num_elems,
+			stats->first + stats->num_elems);
+
+	return 0;
+}
+
+static int decode_file(const char *name)
+{
+	struct sof_ipc_dbg_mem_stats *stats;
+	uint8_t *data;
+	size_t offset = 0;
+	size_t size;
+	FILE *fd;
+	int ret = 0;
+
+	fd = fopen(name, "rb");
+	if (!fd) {
+		fprintf(stderr, "error: unable to open file %s, error %d\n",
+			name, errno);
+		return -errno;
+	}
+
+	fseek(fd, 0, SEEK_END);
+	size = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	data = malloc(size);
+	if (!data || fread(data, 1, size, fd) != size) {
+		fprintf(stderr, "error: unable to read file %s\n", name);
+		ret = -EIO;
+		goto out;
+	}
+
+	while (size - offset >= sizeof(*stats)) {
+		stats = (struct sof_ipc_dbg_mem_stats *)(data + offset);
+
+		ret = decode_reply(stats, size - offset);
+		if (ret < 0)
+			break;
+
+		offset += stats->rhdr.hdr.size;
+	}
+
+out:
+	free(data);
+	fclose(fd);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	int ret = 0;
+
+	while ((opt = getopt(argc, argv, "h")) != -1) {
+		switch (opt) {
+		case 'h':
+		default:
+			usage();
+		}
+	}
+
+	if (optind >= argc)
+		usage();
+
+	for (; optind < argc; optind++) {
+		if (decode_file(argv[optind]) < 0)
+			ret = 1;
+	}
+
+	return ret;
+}
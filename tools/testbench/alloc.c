@@ -10,46 +10,442 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <malloc.h>
+#include <string.h>
 #include <sof/lib/alloc.h>
 #include <sof/lib/mm_heap.h>
+#include <sof/list.h>
+#include <sof/math/numbers.h>
+#include <ipc/topology.h>
 #include "testbench/common_test.h"
 
-/* testbench mem alloc definition */
+/*
+ * testbench mem alloc definition
+ *
+ * Memory is allocated from pools per zone with the caps of the firmware
+ * heaps, a zone allocation fails if no pool of the zone has the requested
+ * caps. Runtime zone falls back to buffer pools like in firmware. Each pool
+ * is a list of arenas with first fit blocks. The block header precedes
+ * the data and a pointer to the header is stored just before the aligned
+ * data, so alignment costs at most alignment bytes per block.
+ */
+
+/* minimum alignment, same as malloc() on the host */
+#define TB_HEAP_ALIGN		16
+
+/* default arena size, bigger allocations get an arena of their own */
+#define TB_HEAP_ARENA_SIZE	(256 * 1024)
+
+/* smallest free block left when splitting a block */
+#define TB_HEAP_MIN_SPLIT	64
+
+#define TB_HEAP_MAGIC		0x50454548 /* "HEEP" */
+
+struct tb_heap;
+
+struct tb_heap_arena {
+	struct list_item list;
+	struct tb_heap *heap;
+	uint8_t *end;
+	size_t size;
+};
+
+/* block header, blocks in arena are contiguous */
+struct tb_heap_block {
+	struct tb_heap_block *prev; /* previous block in arena */
+	struct tb_heap_arena *arena;
+	size_t size; /* block size including header */
+	size_t bytes; /* requested bytes of used block */
+	uint32_t magic;
+	uint32_t used;
+} __aligned(TB_HEAP_ALIGN);
+
+struct tb_heap {
+	const char *name;
+	enum mem_zone zone;
+	uint32_t caps;
+	struct list_item arenas;
+	size_t size; /* total size of arenas */
+	size_t used; /* requested bytes in use */
+	size_t peak;
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t fails;
+	uint32_t misaligned; /* requests with invalid alignment */
+};
+
+#define TB_HEAP(_name, _zone, _caps) \
+	{ .name = _name, .zone = _zone, .caps = _caps }
+
+/* caps of the heaps of cAVS platforms */
+static struct tb_heap tb_heaps[] = {
+	TB_HEAP("system", SOF_MEM_ZONE_SYS,
+		SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_EXT | SOF_MEM_CAPS_CACHE),
+	TB_HEAP("sys-runtime", SOF_MEM_ZONE_SYS_RUNTIME,
+		SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_EXT | SOF_MEM_CAPS_CACHE |
+		SOF_MEM_CAPS_DMA),
+	TB_HEAP("runtime", SOF_MEM_ZONE_RUNTIME,
+		SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_EXT | SOF_MEM_CAPS_CACHE),
+	TB_HEAP("buffer", SOF_MEM_ZONE_BUFFER,
+		SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_HP | SOF_MEM_CAPS_CACHE |
+		SOF_MEM_CAPS_DMA),
+	TB_HEAP("lp-buffer", SOF_MEM_ZONE_BUFFER,
+		SOF_MEM_CAPS_RAM | SOF_MEM_CAPS_LP | SOF_MEM_CAPS_CACHE |
+		SOF_MEM_CAPS_DMA),
+};
+
+static int tb_heap_updated;
+static int tb_heap_ready;
+
+static void tb_heap_init(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tb_heaps); i++)
+		list_init(&tb_heaps[i].arenas);
+
+	tb_heap_ready = 1;
+}
+
+static struct tb_heap_block *block_next(struct tb_heap_block *b)
+{
+	uint8_t *next = (uint8_t *)b + b->size;
+
+	return next < b->arena->end ? (struct tb_heap_block *)next : NULL;
+}
+
+static struct tb_heap_block *arena_first(struct tb_heap_arena *arena)
+{
+	return (struct tb_heap_block *)ALIGN_UP((uintptr_t)(arena + 1),
+						TB_HEAP_ALIGN);
+}
+
+static struct tb_heap_arena *arena_new(struct tb_heap *heap, size_t bytes,
+				       uint32_t alignment)
+{
+	struct tb_heap_arena *arena;
+	struct tb_heap_block *b;
+	size_t size;
+
+	/* room for arena and block headers, alignment and data pointer */
+	size = ALIGN_UP(sizeof(*arena), TB_HEAP_ALIGN) + sizeof(*b) +
+		sizeof(void *) + alignment + bytes;
+	size = MAX(ALIGN_UP(size, TB_HEAP_ALIGN), TB_HEAP_ARENA_SIZE);
+
+	arena = malloc(size);
+	if (!arena)
+		return NULL;
+
+	arena->heap = heap;
+	arena->size = size;
+	arena->end = (uint8_t *)arena + size;
+
+	b = arena_first(arena);
+	b->prev = NULL;
+	b->arena = arena;
+	b->size = arena->end - (uint8_t *)b;
+	b->bytes = 0;
+	b->magic = TB_HEAP_MAGIC;
+	b->used = 0;
+
+	list_item_append(&arena->list, &heap->arenas);
+	heap->size += size;
+	return arena;
+}
+
+/* aligned data pointer if the block has room for bytes, otherwise NULL */
+static void *block_fit(struct tb_heap_block *b, size_t bytes,
+		       uint32_t alignment)
+{
+	uintptr_t data = ALIGN_UP((uintptr_t)(b + 1) + sizeof(void *),
+				  alignment);
+
+	if (b->used || data + bytes > (uintptr_t)b + b->size)
+		return NULL;
+
+	return (void *)data;
+}
+
+/* use block for data, the unused tail is split to a new free block */
+static void block_use(struct tb_heap_block *b, void *data, size_t bytes)
+{
+	struct tb_heap_block *next = block_next(b);
+	struct tb_heap_block *split;
+	size_t size = ALIGN_UP((uintptr_t)data + bytes - (uintptr_t)b,
+			       TB_HEAP_ALIGN);
+
+	if (b->size - size >= sizeof(*b) + TB_HEAP_MIN_SPLIT) {
+		split = (struct tb_heap_block *)((uint8_t *)b + size);
+		split->prev = b;
+		split->arena = b->arena;
+		split->size = b->size - size;
+		split->bytes = 0;
+		split->magic = TB_HEAP_MAGIC;
+		split->used = 0;
+		if (next)
+			next->prev = split;
+		b->size = size;
+	}
+
+	b->used = 1;
+	b->bytes = bytes;
+	((struct tb_heap_block **)data)[-1] = b;
+}
+
+/* merge free block b with the following free block */
+static void block_merge(struct tb_heap_block *b)
+{
+	struct tb_heap_block *next = block_next(b);
+	struct tb_heap_block *after;
+
+	if (!next || next->used)
+		return;
+
+	after = block_next(next);
+	if (after)
+		after->prev = b;
+
+	b->size += next->size;
+	next->magic = 0;
+}
+
+static void heap_free_space(struct tb_heap *heap, size_t *free_bytes,
+			    size_t *largest)
+{
+	struct tb_heap_arena *arena;
+	struct tb_heap_block *b;
+	struct list_item *alist;
+
+	*free_bytes = 0;
+	*largest = 0;
+	list_for_item(alist, &heap->arenas) {
+		arena = container_of(alist, struct tb_heap_arena, list);
+		for (b = arena_first(arena); b; b = block_next(b)) {
+			if (b->used)
+				continue;
+
+			*free_bytes += b->size;
+			*largest = MAX(*largest, b->size);
+		}
+	}
+}
+
+static void *heap_alloc(struct tb_heap *heap, size_t bytes,
+			uint32_t alignment)
+{
+	struct tb_heap_arena *arena;
+	struct tb_heap_block *b;
+	struct list_item *alist;
+	void *data = NULL;
+
+	/* alignment must be a power of two */
+	if (alignment & (alignment - 1)) {
+		heap->misaligned++;
+		alignment = TB_HEAP_ALIGN;
+	}
+
+	alignment = MAX(alignment, TB_HEAP_ALIGN);
+
+	list_for_item(alist, &heap->arenas) {
+		arena = container_of(alist, struct tb_heap_arena, list);
+		for (b = arena_first(arena); b; b = block_next(b)) {
+			data = block_fit(b, bytes, alignment);
+			if (data)
+				goto found;
+		}
+	}
+
+	/* no room in pool, add an arena */
+	arena = arena_new(heap, bytes, alignment);
+	if (!arena) {
+		heap->fails++;
+		return NULL;
+	}
+
+	b = arena_first(arena);
+	data = block_fit(b, bytes, alignment);
+
+found:
+	block_use(b, data, bytes);
+	heap->allocs++;
+	heap->used += bytes;
+	heap->peak = MAX(heap->peak, heap->used);
+
+	tb_heap_updated = 1;
+	return data;
+}
+
+static struct tb_heap *heap_get(enum mem_zone zone, uint32_t caps)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tb_heaps); i++) {
+		if (tb_heaps[i].zone == zone &&
+		    (tb_heaps[i].caps & caps) == caps)
+			return &tb_heaps[i];
+	}
+
+	return NULL;
+}
+
+static void *tb_alloc(enum mem_zone zone, uint32_t caps, size_t bytes,
+		      uint32_t alignment)
+{
+	struct tb_heap *heap = heap_get(zone, caps);
+
+	/* runtime allocations can use buffer heaps */
+	if (!heap && zone == SOF_MEM_ZONE_RUNTIME)
+		heap = heap_get(SOF_MEM_ZONE_BUFFER, caps);
+
+	if (!heap) {
+		fprintf(stderr, "error: no heap for zone %d caps 0x%x\n", zone,
+			caps);
+		return NULL;
+	}
+
+	if (!tb_heap_ready)
+		tb_heap_init();
+
+	return heap_alloc(heap, bytes, alignment);
+}
 
 void *rmalloc(enum mem_zone zone, uint32_t flags, uint32_t caps, size_t bytes)
 {
-	return malloc(bytes);
+	return tb_alloc(zone, caps, bytes, TB_HEAP_ALIGN);
 }
 
 void *rzalloc(enum mem_zone zone, uint32_t flags, uint32_t caps, size_t bytes)
 {
-	return calloc(bytes, 1);
+	void *ptr = rmalloc(zone, flags, caps, bytes);
+
+	if (ptr)
+		memset(ptr, 0, bytes);
+
+	return ptr;
 }
 
 void rfree(void *ptr)
 {
-	free(ptr);
+	struct tb_heap_block *b;
+	struct tb_heap *heap;
+
+	if (!ptr)
+		return;
+
+	b = ((struct tb_heap_block **)ptr)[-1];
+	if (b->magic != TB_HEAP_MAGIC || !b->used) {
+		fprintf(stderr, "error: rfree() invalid pointer %p\n", ptr);
+		return;
+	}
+
+	heap = b->arena->heap;
+	heap->used -= b->bytes;
+	heap->frees++;
+	tb_heap_updated = 1;
+
+	b->used = 0;
+	b->bytes = 0;
+	block_merge(b);
+	if (b->prev && !b->prev->used)
+		block_merge(b->prev);
 }
 
 void *rballoc_align(uint32_t flags, uint32_t caps, size_t bytes,
 		    uint32_t alignment)
 {
-	return malloc(bytes);
+	return tb_alloc(SOF_MEM_ZONE_BUFFER, caps, bytes, alignment);
 }
 
 void *rbrealloc_align(void *ptr, uint32_t flags, uint32_t caps, size_t bytes,
 		      size_t old_bytes, uint32_t alignment)
 {
-	return realloc(ptr, bytes);
+	struct tb_heap_block *b;
+	struct tb_heap *heap;
+	void *new_ptr;
+
+	if (!bytes)
+		return NULL;
+
+	/* keep the block if it already has room and the alignment */
+	b = ptr ? ((struct tb_heap_block **)ptr)[-1] : NULL;
+	if (b && b->magic == TB_HEAP_MAGIC && b->used) {
+		heap = b->arena->heap;
+		if ((heap->caps & caps) == caps &&
+		    !(alignment & (alignment - 1)) &&
+		    IS_ALIGNED((uintptr_t)ptr, MAX(alignment, 1)) &&
+		    (uint8_t *)ptr + bytes <= (uint8_t *)b + b->size) {
+			heap->used += bytes - b->bytes;
+			heap->peak = MAX(heap->peak, heap->used);
+			b->bytes = bytes;
+			tb_heap_updated = 1;
+			return ptr;
+		}
+	}
+
+	new_ptr = rballoc_align(flags, caps, bytes, alignment);
+	if (new_ptr && ptr && !(flags & SOF_MEM_FLAG_NO_COPY))
+		memcpy_s(new_ptr, bytes, ptr, MIN(bytes, old_bytes));
+
+	if (new_ptr)
+		rfree(ptr);
+
+	return new_ptr;
+}
+
+/* requested bytes in use in all but the system heap */
+uint32_t heap_used_bytes(void)
+{
+	uint32_t used = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tb_heaps); i++) {
+		if (tb_heaps[i].zone != SOF_MEM_ZONE_SYS)
+			used += tb_heaps[i].used;
+	}
+
+	return used;
+}
+
+static void tb_heap_trace(struct tb_heap *heap)
+{
+	size_t free_bytes;
+	size_t largest;
+	int frag;
+
+	/* fragmentation is the part of free space not in the largest block,
+	 * taken when the report is printed
+	 */
+	heap_free_space(heap, &free_bytes, &largest);
+	frag = free_bytes ? 100 - 100 * largest / free_bytes : 0;
+
+	printf("%-12s 0x%04x %9zu %9zu %9zu %9zu %7u %7u %5u %6d\n",
+	       heap->name, heap->caps, heap->size, heap->peak, heap->used,
+	       largest, heap->allocs, heap->frees, heap->fails, frag);
+
+	if (heap->misaligned)
+		printf("%-12s %u allocations with invalid alignment\n",
+		       heap->name, heap->misaligned);
 }
 
+/* the heap argument is not used, all heaps are traced */
 void heap_trace(struct mm_heap *heap, int size)
 {
-	malloc_info(0, stdout);
+	int i;
+
+	if (!tb_heap_ready)
+		tb_heap_init();
+
+	printf("%-12s %6s %9s %9s %9s %9s %7s %7s %5s %6s\n", "heap", "caps",
+	       "size", "peak", "used", "largest", "allocs", "frees", "fails",
+	       "frag %");
+	for (i = 0; i < ARRAY_SIZE(tb_heaps); i++)
+		tb_heap_trace(&tb_heaps[i]);
 }
 
+/* pipeline changes trace the heaps in debug mode */
 void heap_trace_all(int force)
 {
-	heap_trace(NULL, 0);
+	if (force || (debug && tb_heap_updated))
+		heap_trace(NULL, 0);
+
+	tb_heap_updated = 0;
 }
@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Copyright(c) 2020 Intel Corporation. All rights reserved.
+
+/* benchmark mode: per component execution time of copy() */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sof/sof.h>
+#include <sof/list.h>
+#include <sof/drivers/ipc.h>
+#include <sof/audio/component.h>
+#include "testbench/common_test.h"
+#include "testbench/bench.h"
+
+/* initial size of per call time arrays, grown by doubling */
+#define TB_BENCH_INIT_SIZE	1024
+
+static struct list_item bench_list;
+static struct tb_bench_stats bench_pipeline = { .name = "pipeline" };
+
+/* per item results computed for the report */
+struct tb_bench_result {
+	uint64_t min;
+	uint64_t max;
+	uint64_t p99;
+	double avg;
+	double mcps;
+};
+
+uint64_t tb_bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int tb_bench_record(struct tb_bench_stats *stats, uint64_t ns)
+{
+	uint64_t *ns_new;
+	int size;
+
+	if (stats->count == stats->size) {
+		size = stats->size ? 2 * stats->size : TB_BENCH_INIT_SIZE;
+		ns_new = realloc(stats->ns, size * sizeof(uint64_t));
+		if (!ns_new)
+			return -ENOMEM;
+
+		stats->ns = ns_new;
+		stats->size = size;
+	}
+
+	if (!stats->count || ns < stats->min)
+		stats->min = ns;
+
+	if (ns > stats->max)
+		stats->max = ns;
+
+	stats->sum += ns;
+	stats->ns[stats->count++] = ns;
+	return 0;
+}
+
+struct tb_bench_stats *tb_bench_pipeline(void)
+{
+	return &bench_pipeline;
+}
+
+/* timed copy(), the driver copy is embedded in tb_bench_comp */
+static int tb_bench_copy(struct comp_dev *dev)
+{
+	struct tb_bench_comp *bc = container_of(dev->drv, struct tb_bench_comp,
+						drv);
+	uint64_t t0;
+	int ret;
+
+	t0 = tb_bench_now_ns();
+	ret = bc->orig->ops.copy(dev);
+	tb_bench_record(&bc->stats, tb_bench_now_ns() - t0);
+
+	return ret;
+}
+
+static const char *tb_bench_comp_name(struct comp_dev *dev,
+				      struct shared_lib_table *lib_table)
+{
+	int index;
+
+	/* file read and write use the host and dai types */
+	if (dev->drv->type == SOF_COMP_DAI)
+		return lib_table[0].comp_name;
+
+	index = get_index_by_type(dev->drv->type, lib_table);
+	if (index < 0)
+		return "comp";
+
+	return lib_table[index].comp_name;
+}
+
+/* replace the driver of every component with a copy that times copy() */
+int tb_bench_attach(struct sof *sof, struct shared_lib_table *lib_table)
+{
+	struct ipc_comp_dev *icd;
+	struct tb_bench_comp *bc;
+	struct list_item *clist;
+
+	list_init(&bench_list);
+	list_for_item(clist, &sof->ipc->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		if (icd->type != COMP_TYPE_COMPONENT)
+			continue;
+
+		bc = calloc(1, sizeof(*bc));
+		if (!bc)
+			return -ENOMEM;
+
+		bc->dev = icd->cd;
+		bc->orig = icd->cd->drv;
+		bc->drv = *bc->orig;
+		bc->drv.ops.copy = tb_bench_copy;
+		bc->stats.id = icd->id;
+		strncpy(bc->stats.name, tb_bench_comp_name(icd->cd, lib_table),
+			TB_BENCH_NAME_LEN - 1);
+		icd->cd->drv = &bc->drv;
+		list_item_append(&bc->list, &bench_list);
+	}
+
+	return 0;
+}
+
+/* restore the original drivers, the results are kept for the report */
+void tb_bench_detach(void)
+{
+	struct tb_bench_comp *bc;
+	struct list_item *clist;
+
+	list_for_item(clist, &bench_list) {
+		bc = container_of(clist, struct tb_bench_comp, list);
+		bc->dev->drv = bc->orig;
+		bc->dev = NULL;
+	}
+}
+
+void tb_bench_free(void)
+{
+	struct tb_bench_comp *bc;
+	struct list_item *clist;
+	struct list_item *temp;
+
+	list_for_item_safe(clist, temp, &bench_list) {
+		bc = container_of(clist, struct tb_bench_comp, list);
+		list_item_del(&bc->list);
+		free(bc->stats.ns);
+		free(bc);
+	}
+
+	free(bench_pipeline.ns);
+	bench_pipeline.ns = NULL;
+	bench_pipeline.count = 0;
+	bench_pipeline.size = 0;
+}
+
+/* replace the file handle with a handle to a copy of the file in memory */
+int tb_bench_load_input(FILE **fh)
+{
+	FILE *mfh;
+	char *data;
+	long size;
+
+	if (fseek(*fh, 0, SEEK_END) < 0)
+		return -errno;
+
+	size = ftell(*fh);
+	if (size <= 0)
+		return -EINVAL;
+
+	data = malloc(size);
+	if (!data)
+		return -ENOMEM;
+
+	rewind(*fh);
+	if (fread(data, 1, size, *fh) != (size_t)size) {
+		free(data);
+		return -EIO;
+	}
+
+	/* the data is not freed, it is used until exit */
+	mfh = fmemopen(data, size, "r");
+	if (!mfh) {
+		free(data);
+		return -errno;
+	}
+
+	fclose(*fh);
+	*fh = mfh;
+	return 0;
+}
+
+static int tb_bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void tb_bench_result(struct tb_bench_stats *stats, double audio_s,
+			    double clk_mhz, struct tb_bench_result *r)
+{
+	memset(r, 0, sizeof(*r));
+	if (!stats->count)
+		return;
+
+	/* p99 is the smallest time that 99% of the calls do not exceed */
+	qsort(stats->ns, stats->count, sizeof(uint64_t), tb_bench_cmp);
+	r->p99 = stats->ns[(99 * stats->count + 99) / 100 - 1];
+	r->min = stats->min;
+	r->max = stats->max;
+	r->avg = (double)stats->sum / stats->count;
+
+	/* cycles per second of audio at the reference clock */
+	r->mcps = stats->sum * 1e-9 / audio_s * clk_mhz;
+}
+
+static void tb_bench_print(FILE *fh, struct tb_bench_stats *stats,
+			   struct tb_bench_result *r, int csv)
+{
+	if (csv)
+		fprintf(fh, "%s,%u,%d,%" PRIu64 ",%.1f,%" PRIu64 ",%" PRIu64
+			",%.3f\n", stats->name, stats->id, stats->count,
+			r->min, r->avg, r->max, r->p99, r->mcps);
+	else
+		fprintf(fh, "%-10s %4u %8d %10" PRIu64 " %10.1f %10" PRIu64
+			" %10" PRIu64 " %8.3f\n", stats->name, stats->id,
+			stats->count, r->min, r->avg, r->max, r->p99, r->mcps);
+}
+
+static void tb_bench_print_json(FILE *fh, struct tb_bench_stats *stats,
+				struct tb_bench_result *r, const char *indent)
+{
+	fprintf(fh, "%s{\"name\": \"%s\", \"id\": %u, \"calls\": %d, ",
+		indent, stats->name, stats->id, stats->count);
+	fprintf(fh, "\"min_ns\": %" PRIu64 ", \"avg_ns\": %.1f, ",
+		r->min, r->avg);
+	fprintf(fh, "\"max_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 ", ",
+		r->max, r->p99);
+	fprintf(fh, "\"mcps\": %.3f}", r->mcps);
+}
+
+static int tb_bench_write(struct testbench_prm *tp, double period_us,
+			  double audio_s)
+{
+	struct tb_bench_comp *bc;
+	struct tb_bench_result r;
+	struct list_item *clist;
+	const char *ext = strrchr(tp->bench_file, '.');
+	int json = ext && !strcmp(ext, ".json");
+	FILE *fh;
+
+	fh = fopen(tp->bench_file, "w");
+	if (!fh) {
+		fprintf(stderr, "error: opening file %s\n", tp->bench_file);
+		return -EINVAL;
+	}
+
+	if (json) {
+		fprintf(fh, "{\n\t\"duration_s\": %.3f,\n", audio_s);
+		fprintf(fh, "\t\"period_us\": %.1f,\n", period_us);
+		fprintf(fh, "\t\"clock_mhz\": %.1f,\n", tp->bench_clk_mhz);
+		fprintf(fh, "\t\"components\": [\n");
+	} else {
+		fprintf(fh, "name,id,calls,min_ns,avg_ns,max_ns,p99_ns,mcps\n");
+	}
+
+	list_for_item(clist, &bench_list) {
+		bc = container_of(clist, struct tb_bench_comp, list);
+		tb_bench_result(&bc->stats, audio_s, tp->bench_clk_mhz, &r);
+		if (json) {
+			tb_bench_print_json(fh, &bc->stats, &r, "\t\t");
+			fprintf(fh, "%s\n",
+				clist->next != &bench_list ? "," : "");
+		} else {
+			tb_bench_print(fh, &bc->stats, &r, 1);
+		}
+	}
+
+	tb_bench_result(&bench_pipeline, audio_s, tp->bench_clk_mhz, &r);
+	if (json) {
+		fprintf(fh, "\t],\n");
+		tb_bench_print_json(fh, &bench_pipeline, &r,
+				    "\t\"pipeline\": ");
+		fprintf(fh, "\n}\n");
+	} else {
+		tb_bench_print(fh, &bench_pipeline, &r, 1);
+	}
+
+	fclose(fh);
+	return 0;
+}
+
+void tb_bench_report(struct testbench_prm *tp, double period_us)
+{
+	struct tb_bench_comp *bc;
+	struct tb_bench_result r;
+	struct list_item *clist;
+	double audio_s = bench_pipeline.count * period_us * 1e-6;
+
+	if (!bench_pipeline.count)
+		return;
+
+	printf("==========================================================\n");
+	printf("		           Benchmark\n");
+	printf("==========================================================\n");
+	printf("Processed %.3f s in %d periods of %.1f us\n", audio_s,
+	       bench_pipeline.count, period_us);
+	printf("MCPS for reference clock of %.1f MHz\n", tp->bench_clk_mhz);
+	printf("%-10s %4s %8s %10s %10s %10s %10s %8s\n", "comp", "id",
+	       "calls", "min ns", "avg ns", "max ns", "p99 ns", "MCPS");
+
+	list_for_item(clist, &bench_list) {
+		bc = container_of(clist, struct tb_bench_comp, list);
+		tb_bench_result(&bc->stats, audio_s, tp->bench_clk_mhz, &r);
+		tb_bench_print(stdout, &bc->stats, &r, 0);
+	}
+
+	tb_bench_result(&bench_pipeline, audio_s, tp->bench_clk_mhz, &r);
+	tb_bench_print(stdout, &bench_pipeline, &r, 0);
+
+	if (tp->bench_file && !tb_bench_write(tp, period_us, audio_s))
+		printf("Benchmark report written to file: \"%s\"\n",
+		       tp->bench_file);
+}
@@ -16,13 +16,21 @@
 #include <sof/drivers/ipc.h>
 #include <sof/lib/dai.h>
 #include <sof/lib/dma.h>
+#include <sof/lib/agent.h>
 #include <sof/schedule/edf_schedule.h>
 #include <sof/schedule/schedule.h>
 #include <sof/lib/wait.h>
 #include <sof/audio/pipeline.h>
 #include "testbench/common_test.h"
+#include "testbench/bench.h"
 #include <tplg_parser/topology.h>
 
+/* LL tick until the pipeline periods are known from topology */
+#define TB_LL_TICK_US	1000
+
+/* system agent is not run, it is only referenced by DMA pipelines */
+static struct sa tb_sa;
+
 /* testbench helper functions for pipeline setup and trigger */
 
 int tb_pipeline_setup(struct sof *sof)
@@ -40,12 +48,19 @@ int tb_pipeline_setup(struct sof *sof)
 		return -EINVAL;
 	}
 
-	/* init scheduler */
+	/* init schedulers */
 	if (scheduler_init_edf() < 0) {
 		fprintf(stderr, "error: edf scheduler init\n");
 		return -EINVAL;
 	}
 
+	if (tb_schedule_ll_init(TB_LL_TICK_US) < 0) {
+		fprintf(stderr, "error: ll scheduler init\n");
+		return -EINVAL;
+	}
+
+	sof->sa = &tb_sa;
+
 	debug_print("ipc and scheduler initialized\n");
 
 	return 0;
@@ -53,7 +68,7 @@ int tb_pipeline_setup(struct sof *sof)
 
 /* set up pcm params, prepare and trigger pipeline */
 int tb_pipeline_start(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
-		      struct testbench_prm *tp)
+		      struct tb_file *in)
 {
 	struct ipc_comp_dev *pcm_dev;
 	struct pipeline *p;
@@ -61,7 +76,7 @@ int tb_pipeline_start(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
 	int ret;
 
 	/* set up pipeline params */
-	ret = tb_pipeline_params(ipc, ipc_pipe, tp);
+	ret = tb_pipeline_params(ipc, ipc_pipe, in);
 	if (ret < 0) {
 		fprintf(stderr, "error: pipeline params\n");
 		return -EINVAL;
@@ -91,7 +106,7 @@ int tb_pipeline_start(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
 
 /* pipeline pcm params */
 int tb_pipeline_params(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
-		       struct testbench_prm *tp)
+		       struct tb_file *in)
 {
 	struct ipc_comp_dev *pcm_dev;
 	struct pipeline *p;
@@ -103,34 +118,34 @@ int tb_pipeline_params(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
 	int ret = 0;
 
 	/* Compute period from sample rates */
-	fs_period = (int)(0.9999 + tp->fs_in * period / 1e6);
+	fs_period = (int)(0.9999 + in->rate * period / 1e6);
 	sprintf(message, "period sample count %d\n", fs_period);
 	debug_print(message);
 
 	/* set pcm params */
 	params.comp_id = ipc_pipe->comp_id;
 	params.params.buffer_fmt = SOF_IPC_BUFFER_INTERLEAVED;
-	params.params.frame_fmt = tp->frame_fmt;
+	params.params.frame_fmt = in->frame_fmt;
 	params.params.direction = SOF_IPC_STREAM_PLAYBACK;
-	params.params.rate = tp->fs_in;
-	params.params.channels = tp->channels;
+	params.params.rate = in->rate;
+	params.params.channels = in->channels;
 	switch (params.params.frame_fmt) {
 	case(SOF_IPC_FRAME_S16_LE):
 		params.params.sample_container_bytes = 2;
 		params.params.sample_valid_bytes = 2;
-		params.params.host_period_bytes = fs_period * tp->channels *
+		params.params.host_period_bytes = fs_period * in->channels *
 			params.params.sample_container_bytes;
 		break;
 	case(SOF_IPC_FRAME_S24_4LE):
 		params.params.sample_container_bytes = 4;
 		params.params.sample_valid_bytes = 3;
-		params.params.host_period_bytes = fs_period * tp->channels *
+		params.params.host_period_bytes = fs_period * in->channels *
 			params.params.sample_container_bytes;
 		break;
 	case(SOF_IPC_FRAME_S32_LE):
 		params.params.sample_container_bytes = 4;
 		params.params.sample_valid_bytes = 4;
-		params.params.host_period_bytes = fs_period * tp->channels *
+		params.params.host_period_bytes = fs_period * in->channels *
 			params.params.sample_container_bytes;
 		break;
 	default:
@@ -161,6 +176,64 @@ int tb_pipeline_params(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
 	return ret;
 }
 
+/* timed pipeline task, the task data points to the pipeline stats */
+static enum task_state tb_pipeline_task(void *data)
+{
+	struct tb_pipeline_stats *stats = data;
+	enum task_state state;
+	uint64_t t0;
+
+	t0 = tb_bench_now_ns();
+	state = stats->run(stats->data);
+	stats->ns += tb_bench_now_ns() - t0;
+	stats->runs++;
+
+	return state;
+}
+
+/* measure the scheduled task of each pipeline, returns number of tasks */
+int tb_pipeline_stats_attach(struct ipc *ipc, struct tb_pipeline_stats *stats,
+			     int max)
+{
+	struct ipc_comp_dev *icd;
+	struct list_item *clist;
+	struct task *task;
+	int num = 0;
+
+	list_for_item(clist, &ipc->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		if (icd->type != COMP_TYPE_PIPELINE)
+			continue;
+
+		task = icd->pipeline->pipe_task;
+		if (!task || num == max)
+			continue;
+
+		stats[num].p = icd->pipeline;
+		stats[num].run = task->ops.run;
+		stats[num].data = task->data;
+		stats[num].ns = 0;
+		stats[num].runs = 0;
+		task->ops.run = tb_pipeline_task;
+		task->data = &stats[num];
+		num++;
+	}
+
+	return num;
+}
+
+void tb_pipeline_stats_detach(struct tb_pipeline_stats *stats, int num)
+{
+	struct task *task;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		task = stats[i].p->pipe_task;
+		task->ops.run = stats[i].run;
+		task->data = stats[i].data;
+	}
+}
+
 /* getindex of shared library from table */
 int get_index_by_name(char *comp_type, struct shared_lib_table *lib_table)
 {
@@ -9,6 +9,8 @@
 #include <stddef.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sof/sof.h>
 #include <sof/list.h>
 #include <sof/audio/stream.h>
@@ -17,6 +19,7 @@
 #include <sof/audio/component.h>
 #include <sof/audio/format.h>
 #include <sof/audio/pipeline.h>
+#include <sof/math/numbers.h>
 #include <ipc/stream.h>
 #include "testbench/common_test.h"
 #include "testbench/file.h"
@@ -43,10 +46,381 @@ static inline void buffer_check_wrap_16(int16_t **ptr, int16_t *end,
 		*ptr = (int16_t *)((size_t)*ptr - size);
 }
 
+static inline uint16_t get_le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+	return get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+static inline void put_le16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+	put_le16(p, v);
+	put_le16(p + 2, v >> 16);
+}
+
+/* write four character chunk id */
+static inline void put_id(uint8_t *p, const char *id)
+{
+	assert(!memcpy_s(p, 4, id, 4));
+}
+
+/* get PCM format from WAV fmt chunk, only formats of the pipeline */
+static int file_wav_format(struct file_wav_info *wav, uint16_t tag,
+			   uint16_t bits, uint16_t valid, uint16_t block_align)
+{
+	if (tag != FILE_WAV_FORMAT_PCM || !wav->channels || !wav->rate ||
+	    block_align != wav->channels * bits / 8)
+		return -EINVAL;
+
+	if (bits == 16 && valid == 16)
+		wav->frame_fmt = SOF_IPC_FRAME_S16_LE;
+	else if (bits == 32 && valid == 24)
+		wav->frame_fmt = SOF_IPC_FRAME_S24_4LE;
+	else if (bits == 32 && valid == 32)
+		wav->frame_fmt = SOF_IPC_FRAME_S32_LE;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+
+/* parse RIFF chunks up to the data chunk, file is left at the samples */
+static int file_wav_parse(FILE *fh, struct file_wav_info *wav)
+{
+	uint8_t fmt[FILE_WAV_FMT_MAX];
+	uint8_t hdr[FILE_WAV_RIFF_SIZE];
+	uint16_t block_align = 0;
+	uint16_t valid = 0;
+	uint16_t bits = 0;
+	uint16_t tag = 0;
+	uint32_t padded;
+	uint32_t size;
+	long pos;
+
+	if (fread(hdr, 1, FILE_WAV_RIFF_SIZE, fh) != FILE_WAV_RIFF_SIZE ||
+	    strncmp((char *)hdr, "RIFF", 4) ||
+	    strncmp((char *)hdr + 8, "WAVE", 4))
+		return -EINVAL;
+
+	while (fread(hdr, 1, FILE_WAV_CHUNK_SIZE, fh) == FILE_WAV_CHUNK_SIZE) {
+		size = get_le32(hdr + 4);
+		padded = size + (size & 1);
+
+		if (!strncmp((char *)hdr, "data", 4)) {
+			if (!tag)
+				return -EINVAL;
+
+			pos = ftell(fh);
+			if (pos < 0)
+				return -errno;
+
+			wav->data_offset = pos;
+			wav->data_size = size;
+			return file_wav_format(wav, tag, bits, valid,
+					       block_align);
+		}
+
+		if (strncmp((char *)hdr, "fmt ", 4)) {
+			/* skip other chunks, chunks are word aligned */
+			if (fseek(fh, padded, SEEK_CUR) < 0)
+				return -errno;
+			continue;
+		}
+
+		if (size < FILE_WAV_FMT_PCM_SIZE || padded > FILE_WAV_FMT_MAX ||
+		    fread(fmt, 1, padded, fh) != padded)
+			return -EINVAL;
+
+		tag = get_le16(fmt);
+		wav->channels = get_le16(fmt + 2);
+		wav->rate = get_le32(fmt + 4);
+		block_align = get_le16(fmt + 12);
+		bits = get_le16(fmt + 14);
+		valid = bits;
+
+		/* valid bits and the real format tag in extensible format */
+		if (tag == FILE_WAV_FORMAT_EXTENSIBLE &&
+		    size >= FILE_WAV_FMT_EXT_SIZE) {
+			valid = get_le16(fmt + 18);
+			tag = get_le16(fmt + 24);
+		}
+	}
+
+	return -EINVAL;
+}
+
+int file_wav_probe(const char *fn, struct file_wav_info *wav)
+{
+	FILE *fh;
+	int ret;
+
+	fh = fopen(fn, "rb");
+	if (!fh)
+		return -errno;
+
+	ret = file_wav_parse(fh, wav);
+	fclose(fh);
+	return ret;
+}
+
 /*
- * Read 32-bit samples from file
- * currently only supports txt files
+ * Write WAV header for the stream format, the sizes are updated when the
+ * file is closed. S24_4LE is written as 24 valid bits in 32-bit container.
  */
+static int file_wav_write_header(struct file_comp_data *cd,
+				 struct audio_stream *stream)
+{
+	static const uint8_t pcm_guid[] = {
+		0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+		0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71,
+	};
+	uint8_t hdr[FILE_WAV_HEADER_MAX] = { 0 };
+	uint32_t bytes = audio_stream_sample_bytes(stream);
+	int ext = stream->frame_fmt == SOF_IPC_FRAME_S24_4LE;
+	int fmt_size = ext ? FILE_WAV_FMT_EXT_SIZE : FILE_WAV_FMT_PCM_SIZE;
+	int size = FILE_WAV_RIFF_SIZE + 2 * FILE_WAV_CHUNK_SIZE + fmt_size;
+	uint8_t *fmt = hdr + FILE_WAV_RIFF_SIZE + FILE_WAV_CHUNK_SIZE;
+
+	put_id(hdr, "RIFF");
+	put_id(hdr + 8, "WAVE");
+	put_id(hdr + 12, "fmt ");
+	put_le32(hdr + 16, fmt_size);
+
+	put_le16(fmt, ext ? FILE_WAV_FORMAT_EXTENSIBLE : FILE_WAV_FORMAT_PCM);
+	put_le16(fmt + 2, stream->channels);
+	put_le32(fmt + 4, stream->rate);
+	put_le32(fmt + 8, stream->rate * stream->channels * bytes);
+	put_le16(fmt + 12, stream->channels * bytes);
+	put_le16(fmt + 14, bytes * 8);
+	if (ext) {
+		put_le16(fmt + 16, FILE_WAV_FMT_EXT_SIZE -
+			 FILE_WAV_FMT_PCM_SIZE - 2);
+		put_le16(fmt + 18, 24);
+		assert(!memcpy_s(fmt + 24, sizeof(pcm_guid), pcm_guid,
+				 sizeof(pcm_guid)));
+	}
+
+	put_id(fmt + fmt_size, "data");
+
+	cd->fs.wav.data_offset = size;
+	cd->fs.wav.data_size = 0;
+	if (fseek(cd->fs.wfh, 0, SEEK_SET) < 0 ||
+	    fwrite(hdr, 1, size, cd->fs.wfh) != size)
+		return -EIO;
+
+	return 0;
+}
+
+/* update RIFF and data chunk sizes of written WAV file */
+static void file_wav_update_sizes(struct file_comp_data *cd)
+{
+	uint8_t size[4];
+
+	put_le32(size, cd->fs.wav.data_offset - 8 + cd->fs.wav.data_size);
+	if (fseek(cd->fs.wfh, 4, SEEK_SET) < 0 ||
+	    fwrite(size, 1, 4, cd->fs.wfh) != 4)
+		goto err;
+
+	put_le32(size, cd->fs.wav.data_size);
+	if (fseek(cd->fs.wfh, cd->fs.wav.data_offset - 4, SEEK_SET) < 0 ||
+	    fwrite(size, 1, 4, cd->fs.wfh) != 4)
+		goto err;
+
+	return;
+
+err:
+	fprintf(stderr, "error: updating WAV header of %s\n", cd->fs.fn);
+}
+
+/*
+ * Map binary input file to memory. If mapping fails the file is read with
+ * fread(), still one call per block of samples.
+ */
+static int file_map_input(struct file_comp_data *cd)
+{
+	struct stat st;
+	size_t size;
+	void *map;
+	int ret;
+
+	if (fstat(fileno(cd->fs.rfh), &st) < 0)
+		return -errno;
+
+	/* size of pipe or other stream is not known */
+	size = S_ISREG(st.st_mode) ? st.st_size : SIZE_MAX;
+
+	cd->fs.wav.data_offset = 0;
+	cd->fs.wav.data_size = size;
+	if (cd->fs.f_format == FILE_WAV) {
+		ret = file_wav_parse(cd->fs.rfh, &cd->fs.wav);
+		if (ret < 0) {
+			fprintf(stderr, "error: unsupported WAV file %s\n",
+				cd->fs.fn);
+			return ret;
+		}
+
+		cd->rate = cd->fs.wav.rate;
+		cd->channels = cd->fs.wav.channels;
+		cd->frame_fmt = cd->fs.wav.frame_fmt;
+	}
+
+	/* data size in header may be unset or too large in streamed WAV */
+	cd->fs.pos = cd->fs.wav.data_offset;
+	cd->fs.end = cd->fs.wav.data_offset +
+		MIN(cd->fs.wav.data_size, size - cd->fs.wav.data_offset);
+
+	if (!S_ISREG(st.st_mode) || !size)
+		return 0;
+
+	map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(cd->fs.rfh), 0);
+	if (map == MAP_FAILED)
+		return 0;
+
+	madvise(map, size, MADV_SEQUENTIAL);
+	cd->fs.map = map;
+	cd->fs.map_size = size;
+	return 0;
+}
+
+/* restart reading from the first sample of input file */
+void file_rewind(struct file_comp_data *cd)
+{
+	cd->fs.reached_eof = 0;
+	cd->fs.pos = cd->fs.wav.data_offset;
+	if (!cd->fs.map)
+		fseek(cd->fs.rfh, cd->fs.pos, SEEK_SET);
+}
+
+/* read up to n samples of binary input, returns samples read */
+static int file_read_block(struct file_comp_data *cd, void *dest, int n,
+			   int bytes)
+{
+	size_t size = MIN((size_t)n * bytes, cd->fs.end - cd->fs.pos);
+
+	/* only whole samples */
+	size -= size % bytes;
+	if (cd->fs.map)
+		assert(!memcpy_s(dest, size, cd->fs.map + cd->fs.pos, size));
+	else
+		size = fread(dest, bytes, size / bytes, cd->fs.rfh) * bytes;
+
+	cd->fs.pos += size;
+	return size / bytes;
+}
+
+/*
+ * Read binary samples from file with one transfer per span of sink buffer
+ * without wrap. Returns number of samples read, only whole frames.
+ */
+static int read_binary(struct comp_dev *dev, const struct audio_stream *sink,
+		       int n, int fmt, int nch)
+{
+	struct file_comp_data *cd = comp_get_drvdata(dev);
+	int bytes = audio_stream_sample_bytes(sink);
+	void *dest = sink->w_ptr;
+	int32_t *s32;
+	int n_samples = 0;
+	int n_read;
+	int n_min;
+	int i;
+
+	/* truncate input to whole frames */
+	n = MIN(n, (cd->fs.end - cd->fs.pos) / (bytes * nch) * nch);
+	if (!n) {
+		cd->fs.reached_eof = 1;
+		return 0;
+	}
+
+	while (n > 0) {
+		n_min = MIN(n, audio_stream_bytes_without_wrap(sink, dest) /
+			    bytes);
+		n_read = file_read_block(cd, dest, n_min, bytes);
+
+		/* mask bits if 24-bit samples, WAV has data in MSBs */
+		if (fmt == SOF_IPC_FRAME_S24_4LE) {
+			s32 = dest;
+			if (cd->fs.f_format == FILE_WAV)
+				for (i = 0; i < n_read; i++)
+					s32[i] = (s32[i] >> 8) & 0x00ffffff;
+			else
+				for (i = 0; i < n_read; i++)
+					s32[i] &= 0x00ffffff;
+		}
+
+		n_samples += n_read;
+		if (n_read < n_min) {
+			cd->fs.reached_eof = 1;
+			break;
+		}
+
+		n -= n_min;
+		dest = audio_stream_wrap(sink, (char *)dest + n_min * bytes);
+	}
+
+	return n_samples - n_samples % nch;
+}
+
+/*
+ * Write binary samples to file with one fwrite() per span of source buffer
+ * without wrap. 24-bit samples are converted in blocks. Returns number of
+ * samples written.
+ */
+static int write_binary(struct comp_dev *dev, struct audio_stream *source,
+			int n, int fmt)
+{
+	struct file_comp_data *cd = comp_get_drvdata(dev);
+	int bytes = audio_stream_sample_bytes(source);
+	int32_t block[FILE_BLOCK_SAMPLES];
+	void *src = source->r_ptr;
+	int32_t *s32;
+	int n_samples = 0;
+	int n_written;
+	int n_min;
+	int i;
+
+	while (n > 0) {
+		n_min = MIN(n, audio_stream_bytes_without_wrap(source, src) /
+			    bytes);
+
+		if (fmt == SOF_IPC_FRAME_S24_4LE) {
+			/* sign extend 24-bit samples, WAV has data in MSBs */
+			n_min = MIN(n_min, FILE_BLOCK_SAMPLES);
+			s32 = src;
+			if (cd->fs.f_format == FILE_WAV)
+				for (i = 0; i < n_min; i++)
+					block[i] = s32[i] << 8;
+			else
+				for (i = 0; i < n_min; i++)
+					block[i] = (s32[i] << 8) >> 8;
+
+			n_written = fwrite(block, bytes, n_min, cd->fs.wfh);
+		} else {
+			n_written = fwrite(src, bytes, n_min, cd->fs.wfh);
+		}
+
+		n_samples += n_written;
+		if (n_written < n_min)
+			break;
+
+		n -= n_min;
+		src = audio_stream_wrap(source, (char *)src + n_min * bytes);
+	}
+
+	cd->fs.wav.data_size += n_samples * bytes;
+	return n_samples;
+}
+
+/* Read 32-bit samples from text file */
 static int read_samples_32(struct comp_dev *dev,
 			   const struct audio_stream *sink,
 			   int n, int fmt, int nch)
@@ -72,46 +446,19 @@ static int read_samples_32(struct comp_dev *dev,
 			/* copy sample per channel */
 			for (i = 0; i < nch; i++) {
 				/* read sample from file */
-				switch (cd->fs.f_format) {
-				/* text input file */
-				case FILE_TEXT:
-					if (fmt == SOF_IPC_FRAME_S32_LE)
-						ret = fscanf(cd->fs.rfh, "%d",
-							     dest);
-
-					/* mask bits if 24-bit samples */
-					if (fmt == SOF_IPC_FRAME_S24_4LE) {
-						ret = fscanf(cd->fs.rfh, "%d",
-							     &sample);
-						*dest = sample & 0x00ffffff;
-					}
-					/* quit if eof is reached */
-					if (ret == EOF) {
-						cd->fs.reached_eof = 1;
-						goto quit;
-					}
-					break;
-
-				/* raw input file */
-				default:
-					if (fmt == SOF_IPC_FRAME_S32_LE)
-						ret = fread(dest,
-							    sizeof(int32_t),
-							    1, cd->fs.rfh);
-
-					/* mask bits if 24-bit samples */
-					if (fmt == SOF_IPC_FRAME_S24_4LE) {
-						ret = fread(&sample,
-							    sizeof(int32_t),
-							    1, cd->fs.rfh);
-						*dest = sample & 0x00ffffff;
-					}
-					/* quit if eof is reached */
-					if (ret != 1) {
-						cd->fs.reached_eof = 1;
-						goto quit;
-					}
-					break;
+				if (fmt == SOF_IPC_FRAME_S32_LE)
+					ret = fscanf(cd->fs.rfh, "%d", dest);
+
+				/* mask bits if 24-bit samples */
+				if (fmt == SOF_IPC_FRAME_S24_4LE) {
+					ret = fscanf(cd->fs.rfh, "%d",
+						     &sample);
+					*dest = sample & 0x00ffffff;
+				}
+				/* quit if eof is reached */
+				if (ret == EOF) {
+					cd->fs.reached_eof = 1;
+					goto quit;
 				}
 				dest++;
 				n_samples++;
@@ -125,10 +472,7 @@ quit:
 	return n_samples;
 }
 
-/*
- * Read 16-bit samples from file
- * currently only supports txt files
- */
+/* Read 16-bit samples from text file */
 static int read_samples_16(struct comp_dev *dev,
 			   const struct audio_stream *sink,
 			   int n, int nch)
@@ -150,25 +494,10 @@ static int read_samples_16(struct comp_dev *dev,
 
 			/* copy sample per channel */
 			for (i = 0; i < nch; i++) {
-				switch (cd->fs.f_format) {
-				/* text input file */
-				case FILE_TEXT:
-					ret = fscanf(cd->fs.rfh, "%hd", dest);
-					if (ret == EOF) {
-						cd->fs.reached_eof = 1;
-						goto quit;
-					}
-					break;
-
-				/* rw pcm input file */
-				default:
-					ret = fread(dest, sizeof(int16_t), 1,
-						    cd->fs.rfh);
-					if (ret != 1) {
-						cd->fs.reached_eof = 1;
-						goto quit;
-					}
-					break;
+				ret = fscanf(cd->fs.rfh, "%hd", dest);
+				if (ret == EOF) {
+					cd->fs.reached_eof = 1;
+					goto quit;
 				}
 
 				dest++;
@@ -184,10 +513,7 @@ quit:
 	return n_samples;
 }
 
-/*
- * Write 16-bit samples from file
- * currently only supports txt files
- */
+/* Write 16-bit samples to text file */
 static int write_samples_16(struct comp_dev *dev, struct audio_stream *source,
 			    int n, int nch)
 {
@@ -208,24 +534,9 @@ static int write_samples_16(struct comp_dev *dev, struct audio_stream *source,
 
 			/* copy sample per channel */
 			for (i = 0; i < nch; i++) {
-				switch (cd->fs.f_format) {
-				/* text output file */
-				case FILE_TEXT:
-					ret = fprintf(cd->fs.wfh,
-						      "%d\n", *src);
-					if (ret < 0)
-						goto quit;
-					break;
-
-				/* raw pcm output file */
-				default:
-					ret = fwrite(src,
-						     sizeof(int16_t),
-						     1, cd->fs.wfh);
-					if (ret != 1)
-						goto quit;
-					break;
-				}
+				ret = fprintf(cd->fs.wfh, "%d\n", *src);
+				if (ret < 0)
+					goto quit;
 
 				src++;
 				n_samples++;
@@ -239,10 +550,7 @@ quit:
 	return n_samples;
 }
 
-/*
- * Write 32-bit samples from file
- * currently only supports txt files
- */
+/* Write 32-bit samples to text file */
 static int write_samples_32(struct comp_dev *dev, struct audio_stream *source,
 			    int n, int fmt, int nch)
 {
@@ -264,39 +572,16 @@ static int write_samples_32(struct comp_dev *dev, struct audio_stream *source,
 
 			/* copy sample per channel */
 			for (i = 0; i < nch; i++) {
-				switch (cd->fs.f_format) {
-				/* text output file */
-				case FILE_TEXT:
-					if (fmt == SOF_IPC_FRAME_S32_LE)
-						ret = fprintf(cd->fs.wfh,
-							      "%d\n", *src);
-					if (fmt == SOF_IPC_FRAME_S24_4LE) {
-						sample = *src << 8;
-						ret = fprintf(cd->fs.wfh,
-							      "%d\n",
-							      sample >> 8);
-					}
-					if (ret < 0)
-						goto quit;
-					break;
-
-				/* raw pcm output file */
-				default:
-					if (fmt == SOF_IPC_FRAME_S32_LE)
-						ret = fwrite(src,
-							     sizeof(int32_t),
-							     1, cd->fs.wfh);
-					if (fmt == SOF_IPC_FRAME_S24_4LE) {
-						sample = *src << 8;
-						sample >>= 8;
-						ret = fwrite(&sample,
-							     sizeof(int32_t),
-							     1, cd->fs.wfh);
-					}
-					if (ret != 1)
-						goto quit;
-					break;
+				if (fmt == SOF_IPC_FRAME_S32_LE)
+					ret = fprintf(cd->fs.wfh, "%d\n",
+						      *src);
+				if (fmt == SOF_IPC_FRAME_S24_4LE) {
+					sample = *src << 8;
+					ret = fprintf(cd->fs.wfh, "%d\n",
+						      sample >> 8);
 				}
+				if (ret < 0)
+					goto quit;
 
 				/* increment read pointer */
 				src++;
@@ -325,14 +610,22 @@ static int file_s32_default(struct comp_dev *dev, struct audio_stream *sink,
 	case FILE_READ:
 		/* read samples */
 		nch = sink->channels;
-		n_samples = read_samples_32(dev, sink, frames * nch,
-					    SOF_IPC_FRAME_S32_LE, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = read_samples_32(dev, sink, frames * nch,
+						    SOF_IPC_FRAME_S32_LE, nch);
+		else
+			n_samples = read_binary(dev, sink, frames * nch,
+						SOF_IPC_FRAME_S32_LE, nch);
 		break;
 	case FILE_WRITE:
 		/* write samples */
 		nch = source->channels;
-		n_samples = write_samples_32(dev, source, frames * nch,
-					     SOF_IPC_FRAME_S32_LE, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = write_samples_32(dev, source, frames * nch,
+						     SOF_IPC_FRAME_S32_LE, nch);
+		else
+			n_samples = write_binary(dev, source, frames * nch,
+						 SOF_IPC_FRAME_S32_LE);
 		break;
 	default:
 		/* TODO: duplex mode */
@@ -355,12 +648,22 @@ static int file_s16(struct comp_dev *dev, struct audio_stream *sink,
 	case FILE_READ:
 		/* read samples */
 		nch = sink->channels;
-		n_samples = read_samples_16(dev, sink, frames * nch, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = read_samples_16(dev, sink, frames * nch,
+						    nch);
+		else
+			n_samples = read_binary(dev, sink, frames * nch,
+						SOF_IPC_FRAME_S16_LE, nch);
 		break;
 	case FILE_WRITE:
 		/* write samples */
 		nch = source->channels;
-		n_samples = write_samples_16(dev, source, frames * nch, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = write_samples_16(dev, source, frames * nch,
+						     nch);
+		else
+			n_samples = write_binary(dev, source, frames * nch,
+						 SOF_IPC_FRAME_S16_LE);
 		break;
 	default:
 		/* TODO: duplex mode */
@@ -383,14 +686,23 @@ static int file_s24(struct comp_dev *dev, struct audio_stream *sink,
 	case FILE_READ:
 		/* read samples */
 		nch = sink->channels;
-		n_samples = read_samples_32(dev, sink, frames * nch,
-					    SOF_IPC_FRAME_S24_4LE, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = read_samples_32(dev, sink, frames * nch,
+						    SOF_IPC_FRAME_S24_4LE, nch);
+		else
+			n_samples = read_binary(dev, sink, frames * nch,
+						SOF_IPC_FRAME_S24_4LE, nch);
 		break;
 	case FILE_WRITE:
 		/* write samples */
 		nch = source->channels;
-		n_samples = write_samples_32(dev, source, frames * nch,
-					     SOF_IPC_FRAME_S24_4LE, nch);
+		if (cd->fs.f_format == FILE_TEXT)
+			n_samples = write_samples_32(dev, source, frames * nch,
+						     SOF_IPC_FRAME_S24_4LE,
+						     nch);
+		else
+			n_samples = write_binary(dev, source, frames * nch,
+						 SOF_IPC_FRAME_S24_4LE);
 		break;
 	default:
 		/* TODO: duplex mode */
@@ -405,9 +717,12 @@ static enum file_format get_file_format(char *filename)
 {
 	char *ext = strrchr(filename, '.');
 
-	if (!strcmp(ext, ".txt"))
+	if (ext && !strcmp(ext, ".txt"))
 		return FILE_TEXT;
 
+	if (ext && !strcmp(ext, ".wav"))
+		return FILE_WAV;
+
 	return FILE_RAW;
 }
 
@@ -438,7 +753,7 @@ static struct comp_dev *file_new(const struct comp_driver *drv,
 	/* allocate  memory for file comp data */
 	cd = rzalloc(SOF_MEM_ZONE_RUNTIME, 0, SOF_MEM_CAPS_RAM, sizeof(*cd));
 	if (!cd) {
-		free(dev);
+		rfree(dev);
 		return NULL;
 	}
 
@@ -466,8 +781,16 @@ static struct comp_dev *file_new(const struct comp_driver *drv,
 		cd->fs.rfh = fopen(cd->fs.fn, "r");
 		if (!cd->fs.rfh) {
 			fprintf(stderr, "error: opening file %s\n", cd->fs.fn);
-			free(cd);
-			free(dev);
+			rfree(cd);
+			rfree(dev);
+			return NULL;
+		}
+
+		if (cd->fs.f_format != FILE_TEXT &&
+		    file_map_input(cd) < 0) {
+			fclose(cd->fs.rfh);
+			rfree(cd);
+			rfree(dev);
 			return NULL;
 		}
 		break;
@@ -475,8 +798,8 @@ static struct comp_dev *file_new(const struct comp_driver *drv,
 		cd->fs.wfh = fopen(cd->fs.fn, "w");
 		if (!cd->fs.wfh) {
 			fprintf(stderr, "error: opening file %s\n", cd->fs.fn);
-			free(cd);
-			free(dev);
+			rfree(cd);
+			rfree(dev);
 			return NULL;
 		}
 		break;
@@ -499,14 +822,19 @@ static void file_free(struct comp_dev *dev)
 
 	comp_dbg(dev, "file_free()");
 
-	if (cd->fs.mode == FILE_READ)
+	if (cd->fs.mode == FILE_READ) {
+		if (cd->fs.map)
+			munmap(cd->fs.map, cd->fs.map_size);
 		fclose(cd->fs.rfh);
-	else
+	} else {
+		if (cd->fs.f_format == FILE_WAV)
+			file_wav_update_sizes(cd);
 		fclose(cd->fs.wfh);
+	}
 
 	free(cd->fs.fn);
-	free(cd);
-	free(dev);
+	rfree(cd);
+	rfree(dev);
 }
 
 static int file_verify_params(struct comp_dev *dev,
@@ -671,6 +999,16 @@ static int file_prepare(struct comp_dev *dev)
 	else
 		cd->sample_container_bytes = 4;
 
+	/* WAV output format is known only after params */
+	if (cd->fs.mode == FILE_WRITE && cd->fs.f_format == FILE_WAV) {
+		ret = file_wav_write_header(cd, stream);
+		if (ret < 0) {
+			fprintf(stderr, "error: writing WAV header to %s\n",
+				cd->fs.fn);
+			return ret;
+		}
+	}
+
 	/* calculate period size based on config */
 	cd->period_bytes = dev->frames * cd->sample_container_bytes *
 		stream->channels;
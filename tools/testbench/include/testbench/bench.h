@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ *
+ * Copyright(c) 2020 Intel Corporation. All rights reserved.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sof/list.h>
+#include <sof/audio/component.h>
+#include "testbench/common_test.h"
+
+#define TB_BENCH_NAME_LEN	16
+
+/* default reference clock for MCPS conversion */
+#define TB_BENCH_CLK_MHZ	400
+
+/* execution times of one measured item, one sample per period */
+struct tb_bench_stats {
+	char name[TB_BENCH_NAME_LEN];
+	uint32_t id;
+	uint64_t *ns; /* time of each call */
+	int count;
+	int size; /* allocated ns[] entries */
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+};
+
+/* component with copy() replaced by a timed wrapper */
+struct tb_bench_comp {
+	struct comp_driver drv; /* copy of driver with timed copy() */
+	const struct comp_driver *orig; /* original driver */
+	struct comp_dev *dev;
+	struct tb_bench_stats stats;
+	struct list_item list;
+};
+
+uint64_t tb_bench_now_ns(void);
+
+int tb_bench_attach(struct sof *sof, struct shared_lib_table *lib_table);
+
+void tb_bench_detach(void);
+
+void tb_bench_free(void);
+
+int tb_bench_record(struct tb_bench_stats *stats, uint64_t ns);
+
+struct tb_bench_stats *tb_bench_pipeline(void);
+
+int tb_bench_load_input(FILE **fh);
+
+void tb_bench_report(struct testbench_prm *tp, double period_us);
+
+#endif
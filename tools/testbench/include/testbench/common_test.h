@@ -13,6 +13,8 @@
 #include <sof/sof.h>
 #include <sof/audio/component_ext.h>
 #include <sof/audio/format.h>
+#include <sof/audio/pipeline.h>
+#include <sof/schedule/task.h>
 
 #define DEBUG_MSG_LEN		256
 #define MAX_LIB_NAME_LEN	256
@@ -20,10 +22,39 @@
 /* number of widgets types supported in testbench */
 #define NUM_WIDGETS_SUPPORTED	7
 
+/* max number of input or output files, one per fileread or filewrite */
+#define TB_MAX_FILES		8
+
+/* max number of pipelines with scheduled task */
+#define TB_MAX_PIPELINES	16
+
+/* input or output file of a fileread or filewrite component */
+struct tb_file {
+	char *name;
+	int id; /* fileread or filewrite component id */
+	uint32_t rate;
+	uint32_t channels;
+	enum sof_ipc_frame frame_fmt;
+	int samples; /* samples read or written */
+};
+
+/* time spent in the scheduled task of a pipeline */
+struct tb_pipeline_stats {
+	struct pipeline *p;
+	enum task_state (*run)(void *data); /* original task function */
+	void *data;
+	uint64_t ns;
+	uint32_t runs;
+};
+
 struct testbench_prm {
 	char *tplg_file; /* topology file to use */
-	char *input_file; /* input file name */
-	char *output_file; /* output file name */
+	struct tb_file input[TB_MAX_FILES]; /* in topology order */
+	struct tb_file output[TB_MAX_FILES];
+	int input_num;
+	int output_num;
+	int fr_num; /* number of filereads loaded from topology */
+	int fw_num;
 	char *bits_in; /* input bit format */
 	/*
 	 * input and output sample rate parameters
@@ -33,11 +64,14 @@ struct testbench_prm {
 	 */
 	uint32_t fs_in;
 	uint32_t fs_out;
-	uint32_t channels;
-	int fr_id;
-	int fw_id;
+	uint32_t channels; /* input channels of non-WAV files */
+	uint32_t channels_out; /* output channels, same as input if 0 */
 	int sched_id;
+	int sched_pipeline_id; /* pipeline of sched_id */
 	enum sof_ipc_frame frame_fmt;
+	double bench_time; /* benchmark duration in seconds, 0 if disabled */
+	double bench_clk_mhz; /* reference clock for MCPS in benchmark */
+	char *bench_file; /* benchmark report file */
 };
 
 struct shared_lib_table {
@@ -59,10 +93,21 @@ void sys_comp_filewrite_init(void);
 int tb_pipeline_setup(struct sof *sof);
 
 int tb_pipeline_start(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
-		      struct testbench_prm *tp);
+		      struct tb_file *in);
 
 int tb_pipeline_params(struct ipc *ipc, struct sof_ipc_pipe_new *ipc_pipe,
-		       struct testbench_prm *tp);
+		       struct tb_file *in);
+
+int tb_pipeline_stats_attach(struct ipc *ipc, struct tb_pipeline_stats *stats,
+			     int max);
+
+void tb_pipeline_stats_detach(struct tb_pipeline_stats *stats, int num);
+
+int tb_schedule_ll_init(uint32_t tick_us);
+
+void tb_schedule_ll_set_tick(uint32_t tick_us);
+
+int tb_schedule_ll_run(void);
 
 void debug_print(char *message);
 
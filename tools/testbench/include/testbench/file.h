@@ -21,12 +21,42 @@ enum file_mode {
 enum file_format {
 	FILE_TEXT = 0,
 	FILE_RAW,
+	FILE_WAV,
+};
+
+/* samples converted per fwrite() for 24-bit binary output */
+#define FILE_BLOCK_SAMPLES		1024
+
+/* WAV (RIFF) header layout */
+#define FILE_WAV_RIFF_SIZE		12
+#define FILE_WAV_CHUNK_SIZE		8
+#define FILE_WAV_FMT_PCM_SIZE		16
+#define FILE_WAV_FMT_EXT_SIZE		40
+#define FILE_WAV_FMT_MAX		64
+#define FILE_WAV_HEADER_MAX		(FILE_WAV_RIFF_SIZE + \
+					 2 * FILE_WAV_CHUNK_SIZE + \
+					 FILE_WAV_FMT_EXT_SIZE)
+#define FILE_WAV_FORMAT_PCM		0x0001
+#define FILE_WAV_FORMAT_EXTENSIBLE	0xfffe
+
+/* PCM format and sample data position of WAV file */
+struct file_wav_info {
+	uint32_t rate;
+	uint32_t channels;
+	enum sof_ipc_frame frame_fmt;
+	size_t data_offset;
+	size_t data_size;
 };
 
 /* file component state */
 struct file_state {
 	char *fn;
 	FILE *rfh, *wfh; /* read/write file handle */
+	uint8_t *map; /* binary input file mapped to memory */
+	size_t map_size;
+	size_t pos; /* read position in binary input file */
+	size_t end; /* end of samples in binary input file */
+	struct file_wav_info wav; /* also data position of raw files */
 	int reached_eof;
 	int n;
 	enum file_mode mode;
@@ -57,4 +87,8 @@ struct sof_ipc_comp_file {
 	enum file_mode mode;
 	enum sof_ipc_frame frame_fmt;
 } __attribute__((packed));
+
+int file_wav_probe(const char *fn, struct file_wav_info *wav);
+
+void file_rewind(struct file_comp_data *cd);
 #endif
@@ -10,6 +10,10 @@
 
 #include <sof/audio/component.h>
 #include <ipc/stream.h>
+#include <stdint.h>
+
+/* testbench timer ticks are microseconds of simulated time */
+#define TB_TIMER_TICKS_PER_MS	1000
 
 /* get timestamp for host stream DMA position */
 void platform_host_timestamp(struct comp_dev *host,
@@ -19,4 +23,7 @@ void platform_host_timestamp(struct comp_dev *host,
 void platform_dai_timestamp(struct comp_dev *dai,
 			    struct sof_ipc_stream_posn *posn);
 
+/* advance simulated time, called by the testbench LL domain */
+void tb_timer_set(uint64_t ticks);
+
 #endif /* _INCLUDE_HOST_TIMER_H_ */
@@ -4,14 +4,161 @@
 //
 // Author: Tomasz Lauda <tomasz.lauda@linux.intel.com>
 
+/*
+ * Testbench LL scheduling domain. The LL scheduler from src/schedule is
+ * used as such, the timer interrupt is replaced by tb_schedule_ll_run()
+ * that advances the simulated time to the next tick of the domain.
+ */
+
+#include <sof/drivers/timer.h>
+#include <sof/lib/alloc.h>
 #include <sof/schedule/ll_schedule.h>
+#include <sof/schedule/ll_schedule_domain.h>
 #include <sof/schedule/schedule.h>
+#include <sof/schedule/task.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "testbench/common_test.h"
+#include "testbench/timer.h"
+
+/* one domain for timer and one for DMA driven pipelines */
+#define TB_LL_DOMAINS		2
+
+struct tb_ll_domain {
+	void (*handler)(void *arg); /* LL scheduler run of the domain */
+	void *arg;
+	bool enabled;
+	uint64_t tick; /* tick period in timer ticks */
+};
+
+static struct ll_schedule_domain *tb_domains[TB_LL_DOMAINS];
+
+static int tb_domain_register(struct ll_schedule_domain *domain,
+			      uint64_t period, struct task *task,
+			      void (*handler)(void *arg), void *arg)
+{
+	struct tb_ll_domain *tb = ll_sch_domain_get_pdata(domain);
+
+	tb->handler = handler;
+	tb->arg = arg;
+	return 0;
+}
+
+static void tb_domain_unregister(struct ll_schedule_domain *domain,
+				 struct task *task, uint32_t num_tasks)
+{
+	struct tb_ll_domain *tb = ll_sch_domain_get_pdata(domain);
+
+	if (!num_tasks) {
+		tb->handler = NULL;
+		tb->arg = NULL;
+	}
+}
+
+static void tb_domain_enable(struct ll_schedule_domain *domain, int core)
+{
+	struct tb_ll_domain *tb = ll_sch_domain_get_pdata(domain);
 
-int schedule_task_init_ll(struct task *task, uint32_t uid, uint16_t type,
-			  uint16_t priority,
-			  enum task_state (*run)(void *data), void *data,
-			  uint16_t core, uint32_t flags)
+	tb->enabled = true;
+}
+
+static void tb_domain_disable(struct ll_schedule_domain *domain, int core)
 {
-	return schedule_task_init(task, uid, type, priority, run, data, core,
-				  flags);
+	struct tb_ll_domain *tb = ll_sch_domain_get_pdata(domain);
+
+	tb->enabled = false;
+}
+
+static void tb_domain_set(struct ll_schedule_domain *domain, uint64_t start)
+{
+	struct tb_ll_domain *tb = ll_sch_domain_get_pdata(domain);
+
+	domain->last_tick = start + tb->tick;
+}
+
+static bool tb_domain_is_pending(struct ll_schedule_domain *domain,
+				 struct task *task)
+{
+	return task->start <= platform_timer_get(timer_get());
+}
+
+static const struct ll_schedule_domain_ops tb_domain_ops = {
+	.domain_register	= tb_domain_register,
+	.domain_unregister	= tb_domain_unregister,
+	.domain_enable		= tb_domain_enable,
+	.domain_disable		= tb_domain_disable,
+	.domain_set		= tb_domain_set,
+	.domain_is_pending	= tb_domain_is_pending,
+};
+
+/* create the LL domains and schedulers with the given tick in us */
+int tb_schedule_ll_init(uint32_t tick_us)
+{
+	struct ll_schedule_domain *domain;
+	struct tb_ll_domain *tb;
+	int type[TB_LL_DOMAINS] = {
+		SOF_SCHEDULE_LL_TIMER, SOF_SCHEDULE_LL_DMA
+	};
+	int i;
+
+	for (i = 0; i < TB_LL_DOMAINS; i++) {
+		tb = rzalloc(SOF_MEM_ZONE_SYS, 0, SOF_MEM_CAPS_RAM,
+			     sizeof(*tb));
+		if (!tb)
+			return -ENOMEM;
+
+		domain = domain_init(type[i], 0, false, &tb_domain_ops);
+		ll_sch_domain_set_pdata(domain, tb);
+		tb_domains[i] = domain;
+		scheduler_init_ll(domain);
+	}
+
+	tb_schedule_ll_set_tick(tick_us);
+	return 0;
+}
+
+void tb_schedule_ll_set_tick(uint32_t tick_us)
+{
+	struct tb_ll_domain *tb;
+	int i;
+
+	for (i = 0; i < TB_LL_DOMAINS; i++) {
+		tb = ll_sch_domain_get_pdata(tb_domains[i]);
+		tb->tick = (uint64_t)TB_TIMER_TICKS_PER_MS * tick_us / 1000;
+	}
+}
+
+/*
+ * Advance the simulated time to the earliest next tick of the enabled
+ * domains and run their schedulers. Returns -ENODATA if no LL task is
+ * scheduled.
+ */
+int tb_schedule_ll_run(void)
+{
+	struct ll_schedule_domain *domain;
+	struct tb_ll_domain *tb;
+	uint64_t next = UINT64_MAX;
+	int i;
+
+	for (i = 0; i < TB_LL_DOMAINS; i++) {
+		domain = tb_domains[i];
+		tb = ll_sch_domain_get_pdata(domain);
+		if (tb->enabled && tb->handler && domain->last_tick < next)
+			next = domain->last_tick;
+	}
+
+	if (next == UINT64_MAX)
+		return -ENODATA;
+
+	tb_timer_set(next);
+
+	for (i = 0; i < TB_LL_DOMAINS; i++) {
+		domain = tb_domains[i];
+		tb = ll_sch_domain_get_pdata(domain);
+		if (tb->enabled && tb->handler && domain->last_tick <= next)
+			tb->handler(tb->arg);
+	}
+
+	return 0;
 }
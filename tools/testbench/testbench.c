@@ -6,13 +6,18 @@
 //         Ranjani Sridharan <ranjani.sridharan@linux.intel.com>
 
 #include <sof/drivers/ipc.h>
+#include <sof/drivers/timer.h>
+#include <sof/lib/mm_heap.h>
 #include <sof/list.h>
+#include <sof/math/numbers.h>
 #include <getopt.h>
 #include <dlfcn.h>
+#include <math.h>
 #include "testbench/common_test.h"
 #include <tplg_parser/topology.h>
 #include "testbench/trace.h"
 #include "testbench/file.h"
+#include "testbench/bench.h"
 
 #define TESTBENCH_NCH 2 /* Stereo */
 
@@ -89,10 +94,24 @@ static void print_usage(char *executable)
 	printf("-t <tplg_file> -b <input_format> ");
 	printf("-a <comp1=comp1_library,comp2=comp2_library>\n");
 	printf("input_format should be S16_LE, S32_LE, S24_LE or FLOAT_LE\n");
+	printf("Files with .txt extension are text, .wav files are WAV and ");
+	printf("other files are raw binary. The format, rate and channels ");
+	printf("of WAV input are taken from the file.\n");
+	printf("Topologies with several pipelines take comma separated ");
+	printf("lists of files, -i in1.raw,in2.raw -o out1.raw,out2.raw, ");
+	printf("in the order of fileread and filewrite widgets. ");
+	printf("-c <channels> sets the channels of input files ");
+	printf("(default %d), -n <channels> of output files ", TESTBENCH_NCH);
+	printf("(default same as input).\n");
 	printf("Example Usage:\n");
 	printf("%s -i in.txt -o out.txt -t test.tplg ", executable);
 	printf("-r 48000 -R 96000 ");
 	printf("-b S16_LE -a vol=libsof_volume.so\n");
+	printf("Benchmark mode: -B <seconds> loops the input from memory for ");
+	printf("the given duration and reports the copy() time per ");
+	printf("component, -p <report.json|report.csv> writes the ");
+	printf("results to file, -C <MHz> sets the reference clock for ");
+	printf("MCPS (default %d)\n", TB_BENCH_CLK_MHZ);
 }
 
 /* free components */
@@ -108,38 +127,61 @@ static void free_comps(void)
 		case COMP_TYPE_COMPONENT:
 			comp_free(icd->cd);
 			list_item_del(&icd->list);
+			list_item_del(&icd->hash_list);
 			rfree(icd);
 			break;
 		case COMP_TYPE_BUFFER:
 			rfree(icd->cb->stream.addr);
 			rfree(icd->cb);
 			list_item_del(&icd->list);
+			list_item_del(&icd->hash_list);
 			rfree(icd);
 			break;
 		default:
 			rfree(icd->pipeline);
 			list_item_del(&icd->list);
+			list_item_del(&icd->hash_list);
 			rfree(icd);
 			break;
 		}
 	}
 }
 
+/* parse comma separated list of file names */
+static int parse_files(char *names, struct tb_file *files, int *num)
+{
+	char *token = NULL;
+	char *name = strtok_r(names, ",", &token);
+
+	while (name) {
+		if (*num == TB_MAX_FILES) {
+			fprintf(stderr, "error: max %d files\n", TB_MAX_FILES);
+			return -EINVAL;
+		}
+
+		files[(*num)++].name = strdup(name);
+		name = strtok_r(NULL, ",", &token);
+	}
+
+	return 0;
+}
+
 static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 {
 	int option = 0;
 	int ret = 0;
 
-	while ((option = getopt(argc, argv, "hdi:o:t:b:a:r:R:")) != -1) {
+	while ((option = getopt(argc, argv,
+				"hdi:o:t:b:a:r:R:c:n:B:p:C:")) != -1) {
 		switch (option) {
-		/* input sample file */
+		/* input sample files */
 		case 'i':
-			tp->input_file = strdup(optarg);
+			ret = parse_files(optarg, tp->input, &tp->input_num);
 			break;
 
-		/* output sample file */
+		/* output sample files */
 		case 'o':
-			tp->output_file = strdup(optarg);
+			ret = parse_files(optarg, tp->output, &tp->output_num);
 			break;
 
 		/* topology file */
@@ -168,6 +210,31 @@ static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 			tp->fs_out = atoi(optarg);
 			break;
 
+		/* input channels */
+		case 'c':
+			tp->channels = atoi(optarg);
+			break;
+
+		/* output channels */
+		case 'n':
+			tp->channels_out = atoi(optarg);
+			break;
+
+		/* benchmark duration in seconds */
+		case 'B':
+			tp->bench_time = atof(optarg);
+			break;
+
+		/* benchmark report file */
+		case 'p':
+			tp->bench_file = strdup(optarg);
+			break;
+
+		/* benchmark reference clock in MHz */
+		case 'C':
+			tp->bench_clk_mhz = atof(optarg);
+			break;
+
 		/* enable debug prints */
 		case 'd':
 			debug = 1;
@@ -185,33 +252,253 @@ static void parse_input_args(int argc, char **argv, struct testbench_prm *tp)
 	}
 }
 
+/* get sample rate, channels and format from WAV input file */
+static int parse_wav_input(struct tb_file *in)
+{
+	struct file_wav_info wav;
+	int ret;
+
+	ret = file_wav_probe(in->name, &wav);
+	if (ret < 0) {
+		fprintf(stderr, "error: unsupported WAV file %s\n", in->name);
+		return ret;
+	}
+
+	in->frame_fmt = wav.frame_fmt;
+	in->channels = wav.channels;
+	in->rate = wav.rate;
+	return 0;
+}
+
+/* set format of the files from WAV headers and command line */
+static int parse_file_formats(struct testbench_prm *tp)
+{
+	struct tb_file *in;
+	struct tb_file *out;
+	char *ext;
+	int i;
+	int j;
+
+	for (i = 0; i < tp->input_num; i++) {
+		in = &tp->input[i];
+		ext = strrchr(in->name, '.');
+		if (!ext || strcmp(ext, ".wav")) {
+			in->frame_fmt = tp->frame_fmt;
+			in->channels = tp->channels;
+			in->rate = tp->fs_in;
+			continue;
+		}
+
+		if (parse_wav_input(in) < 0)
+			return -EINVAL;
+
+		/* first WAV input overrides the input format arguments */
+		if (i)
+			continue;
+
+		/* ALSA format names follow the component names in sof_frames */
+		for (j = ARRAY_SIZE(sof_frames) - 1; j >= 0; j--)
+			if (sof_frames[j].frame == in->frame_fmt)
+				break;
+
+		free(tp->bits_in);
+		tp->bits_in = strdup(sof_frames[j].name);
+		tp->frame_fmt = in->frame_fmt;
+		tp->channels = in->channels;
+		tp->fs_in = in->rate;
+	}
+
+	/* output follows the input of the same index */
+	for (i = 0; i < tp->output_num; i++) {
+		out = &tp->output[i];
+		in = &tp->input[MIN(i, tp->input_num - 1)];
+		out->frame_fmt = in->frame_fmt;
+		out->channels = tp->channels_out ? tp->channels_out :
+			in->channels;
+		out->rate = tp->fs_out;
+	}
+
+	return 0;
+}
+
+static struct pipeline *file_pipeline(struct tb_file *f)
+{
+	return ipc_get_comp_by_id(sof.ipc, f->id)->cd->pipeline;
+}
+
+static struct file_comp_data *file_data(struct tb_file *f)
+{
+	return comp_get_drvdata(ipc_get_comp_by_id(sof.ipc, f->id)->cd);
+}
+
+/*
+ * Rates that are not set from command line, WAV header or topology
+ * default to the pipeline rate of the file component.
+ */
+static void set_file_rates(struct testbench_prm *tp)
+{
+	struct sof_ipc_pipe_new *ipc_pipe;
+	struct tb_file *f;
+	int i;
+
+	for (i = 0; i < tp->input_num + tp->output_num; i++) {
+		if (i < tp->input_num) {
+			f = &tp->input[i];
+			if (!f->rate)
+				f->rate = tp->fs_in;
+		} else {
+			f = &tp->output[i - tp->input_num];
+			if (!f->rate)
+				f->rate = tp->fs_out;
+		}
+
+		ipc_pipe = &file_pipeline(f)->ipc_pipe;
+		if (!f->rate)
+			f->rate = ipc_pipe->period * ipc_pipe->frames_per_sched;
+
+		file_data(f)->rate = f->rate;
+	}
+}
+
+/* LL tick is the shortest period of the pipelines */
+static uint32_t get_ll_tick(void)
+{
+	struct ipc_comp_dev *icd;
+	struct list_item *clist;
+	uint32_t tick = UINT32_MAX;
+
+	list_for_item(clist, &sof.ipc->comp_list) {
+		icd = container_of(clist, struct ipc_comp_dev, list);
+		if (icd->type == COMP_TYPE_PIPELINE)
+			tick = MIN(tick, icd->pipeline->ipc_pipe.period);
+	}
+
+	return tick;
+}
+
+static int inputs_eof(struct testbench_prm *tp)
+{
+	int i;
+
+	for (i = 0; i < tp->input_num; i++)
+		if (!file_data(&tp->input[i])->fs.reached_eof)
+			return 0;
+
+	return 1;
+}
+
+/* run the pipelines for the benchmark duration, inputs are looped */
+static int run_bench(struct testbench_prm *tp, uint32_t tick)
+{
+	struct tb_bench_stats *stats = tb_bench_pipeline();
+	struct file_comp_data *frcd;
+	uint64_t t0;
+	int periods;
+	int ret;
+	int i;
+	int j;
+
+	/* binary input is already mapped to memory */
+	for (i = 0; i < tp->input_num; i++) {
+		frcd = file_data(&tp->input[i]);
+		if (frcd->fs.f_format != FILE_TEXT)
+			continue;
+
+		ret = tb_bench_load_input(&frcd->fs.rfh);
+		if (ret < 0) {
+			fprintf(stderr, "error: loading input to memory\n");
+			return ret;
+		}
+	}
+
+	ret = tb_bench_attach(&sof, lib_table);
+	if (ret < 0) {
+		fprintf(stderr, "error: benchmark setup\n");
+		return ret;
+	}
+
+	periods = ceil(tp->bench_time * 1e6 / tick);
+	for (i = 0; i < periods; i++) {
+		for (j = 0; j < tp->input_num; j++) {
+			frcd = file_data(&tp->input[j]);
+			if (frcd->fs.reached_eof)
+				file_rewind(frcd);
+		}
+
+		t0 = tb_bench_now_ns();
+		ret = tb_schedule_ll_run();
+		if (ret < 0)
+			break;
+
+		ret = tb_bench_record(stats, tb_bench_now_ns() - t0);
+		if (ret < 0)
+			break;
+	}
+
+	tb_bench_detach();
+	return ret;
+}
+
+static void print_pipeline_stats(struct tb_pipeline_stats *stats, int num)
+{
+	struct tb_pipeline_stats *s;
+	double period;
+	double t;
+	int i;
+
+	printf("%-8s %10s %8s %10s %10s %8s %10s\n", "pipeline", "period us",
+	       "runs", "time ms", "avg us", "load %", "x realtime");
+	for (i = 0; i < num; i++) {
+		s = &stats[i];
+		if (!s->runs)
+			continue;
+
+		period = s->p->ipc_pipe.period;
+		t = s->ns * 1e-3; /* us */
+		printf("%-8u %10.0f %8u %10.2f %10.2f %8.2f %10.2f\n",
+		       s->p->ipc_pipe.pipeline_id, period, s->runs, t * 1e-3,
+		       t / s->runs, 100 * t / s->runs / period,
+		       s->runs * period / t);
+	}
+}
+
 int main(int argc, char **argv)
 {
-	struct testbench_prm tp;
+	struct testbench_prm tp = { 0 };
+	struct tb_pipeline_stats stats[TB_MAX_PIPELINES];
+	struct pipeline *started[TB_MAX_FILES];
 	struct ipc_comp_dev *pcm_dev;
 	struct pipeline *p;
-	struct sof_ipc_pipe_new *ipc_pipe;
-	struct comp_dev *cd;
-	struct file_comp_data *frcd, *fwcd;
+	struct tb_file *f;
 	char pipeline[DEBUG_MSG_LEN];
 	clock_t tic, toc;
 	double c_realtime, t_exec;
-	int n_in, n_out, ret;
+	uint32_t tick;
+	int num_started = 0;
+	int num_stats;
+	int ret;
 	int i;
+	int j;
 
 	/* initialize input and output sample rates, files, etc. */
-	tp.fs_in = 0;
-	tp.fs_out = 0;
-	tp.bits_in = 0;
-	tp.input_file = NULL;
-	tp.output_file = NULL;
 	tp.channels = TESTBENCH_NCH;
+	tp.sched_pipeline_id = -1;
+	tp.bench_clk_mhz = TB_BENCH_CLK_MHZ;
 
 	/* command line arguments*/
 	parse_input_args(argc, argv, &tp);
 
 	/* check args */
-	if (!tp.tplg_file || !tp.input_file || !tp.output_file || !tp.bits_in) {
+	if (!tp.tplg_file || !tp.input_num || !tp.output_num) {
+		print_usage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	/* WAV input overrides the input format arguments */
+	if (parse_file_formats(&tp) < 0)
+		exit(EXIT_FAILURE);
+
+	if (!tp.bits_in) {
 		print_usage(argv[0]);
 		exit(EXIT_FAILURE);
 	}
@@ -228,57 +515,84 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
-	/* Get pointers to fileread and filewrite */
-	pcm_dev = ipc_get_comp_by_id(sof.ipc, tp.fw_id);
-	fwcd = comp_get_drvdata(pcm_dev->cd);
-	pcm_dev = ipc_get_comp_by_id(sof.ipc, tp.fr_id);
-	frcd = comp_get_drvdata(pcm_dev->cd);
+	if (tp.fr_num != tp.input_num || tp.fw_num != tp.output_num) {
+		fprintf(stderr, "error: %d input and %d output files for ",
+			tp.input_num, tp.output_num);
+		fprintf(stderr, "%d filereads and %d filewrites\n",
+			tp.fr_num, tp.fw_num);
+		exit(EXIT_FAILURE);
+	}
 
-	/* Run pipeline until EOF from fileread */
-	pcm_dev = ipc_get_comp_by_id(sof.ipc, tp.sched_id);
-	p = pcm_dev->cd->pipeline;
-	ipc_pipe = &p->ipc_pipe;
+	/* input and output sample rates */
+	set_file_rates(&tp);
 
-	/* input and output sample rate */
-	if (!tp.fs_in)
-		tp.fs_in = ipc_pipe->period * ipc_pipe->frames_per_sched;
+	/* LL scheduler ticks at the shortest pipeline period */
+	tick = get_ll_tick();
+	tb_schedule_ll_set_tick(tick);
 
-	if (!tp.fs_out)
-		tp.fs_out = ipc_pipe->period * ipc_pipe->frames_per_sched;
+	/* set params and trigger start of the pipelines from fileread */
+	for (i = 0; i < tp.input_num; i++) {
+		p = file_pipeline(&tp.input[i]);
+		for (j = 0; j < num_started; j++)
+			if (started[j] == p)
+				break;
 
-	/* set pipeline params and trigger start */
-	if (tb_pipeline_start(sof.ipc, ipc_pipe, &tp) < 0) {
-		fprintf(stderr, "error: pipeline params\n");
-		exit(EXIT_FAILURE);
+		if (j < num_started)
+			continue;
+
+		if (tb_pipeline_start(sof.ipc, &p->ipc_pipe,
+				      &tp.input[i]) < 0) {
+			fprintf(stderr, "error: pipeline params\n");
+			exit(EXIT_FAILURE);
+		}
+
+		started[num_started++] = p;
 	}
 
-	cd = pcm_dev->cd;
+	num_stats = tb_pipeline_stats_attach(sof.ipc, stats, TB_MAX_PIPELINES);
+
 	tb_enable_trace(false); /* reduce trace output */
 	tic = clock();
 
-	while (frcd->fs.reached_eof == 0)
-		pipeline_schedule_copy(p, 0);
-
-	if (!frcd->fs.reached_eof)
-		printf("warning: possible pipeline xrun\n");
+	if (tp.bench_time > 0) {
+		if (run_bench(&tp, tick) < 0) {
+			fprintf(stderr, "error: benchmark\n");
+			exit(EXIT_FAILURE);
+		}
+	} else {
+		/* Run pipelines until EOF from all filereads */
+		while (!inputs_eof(&tp)) {
+			if (tb_schedule_ll_run() < 0) {
+				printf("warning: no scheduled pipelines\n");
+				break;
+			}
+		}
+	}
 
-	/* reset and free pipeline */
+	/* reset and free pipelines */
 	toc = clock();
 	tb_enable_trace(true);
-	pipeline_trigger(p, cd, COMP_TRIGGER_STOP);
-	ret = pipeline_reset(p, cd);
-	if (ret < 0) {
-		fprintf(stderr, "error: pipeline reset\n");
-		exit(EXIT_FAILURE);
+	tb_pipeline_stats_detach(stats, num_stats);
+	for (i = 0; i < num_started; i++) {
+		p = started[i];
+		pcm_dev = ipc_get_comp_by_id(sof.ipc, p->ipc_pipe.sched_id);
+		pipeline_trigger(p, pcm_dev->cd, COMP_TRIGGER_STOP);
+		ret = pipeline_reset(p, pcm_dev->cd);
+		if (ret < 0) {
+			fprintf(stderr, "error: pipeline reset\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 
-	n_in = frcd->fs.n;
-	n_out = fwcd->fs.n;
-	t_exec = (double)(toc - tic) / CLOCKS_PER_SEC;
-	c_realtime = (double)n_out / TESTBENCH_NCH / tp.fs_out / t_exec;
+	for (i = 0; i < tp.input_num + tp.output_num; i++) {
+		f = i < tp.input_num ? &tp.input[i] :
+			&tp.output[i - tp.input_num];
+		f->samples = file_data(f)->fs.n;
+	}
 
-	/* free all components/buffers in pipeline */
-	free_comps();
+	/* simulated audio time per execution time */
+	t_exec = (double)(toc - tic) / CLOCKS_PER_SEC;
+	c_realtime = platform_timer_get(NULL) * 1e-6 / t_exec;
 
 	/* print test summary */
 	printf("==========================================================\n");
@@ -287,19 +601,44 @@ int main(int argc, char **argv)
 	printf("Test Pipeline:\n");
 	printf("%s\n", pipeline);
 	printf("Input bit format: %s\n", tp.bits_in);
-	printf("Input sample rate: %d\n", tp.fs_in);
-	printf("Output sample rate: %d\n", tp.fs_out);
-	printf("Output written to file: \"%s\"\n", tp.output_file);
-	printf("Input sample count: %d\n", n_in);
-	printf("Output sample count: %d\n", n_out);
+	for (i = 0; i < tp.input_num; i++) {
+		f = &tp.input[i];
+		printf("Input \"%s\": %u Hz, %u channels, %d samples\n",
+		       f->name, f->rate, f->channels, f->samples);
+	}
+
+	for (i = 0; i < tp.output_num; i++) {
+		f = &tp.output[i];
+		printf("Output written to file \"%s\": %u Hz, %d samples\n",
+		       f->name, f->rate, f->samples);
+	}
+
 	printf("Total execution time: %.2f us, %.2f x realtime\n",
 	       1e3 * t_exec, c_realtime);
+	print_pipeline_stats(stats, num_stats);
+
+	if (tp.bench_time > 0) {
+		tb_bench_report(&tp, tick);
+		tb_bench_free();
+	}
+
+	/* free all components/buffers in pipeline */
+	free_comps();
+
+	/* heap peak and fragmentation of the run */
+	printf("Heap usage in bytes, fragmentation at peak:\n");
+	heap_trace_all(1);
 
 	/* free all other data */
+	for (i = 0; i < tp.input_num; i++)
+		free(tp.input[i].name);
+
+	for (i = 0; i < tp.output_num; i++)
+		free(tp.output[i].name);
+
 	free(tp.bits_in);
-	free(tp.input_file);
 	free(tp.tplg_file);
-	free(tp.output_file);
+	free(tp.bench_file);
 
 	/* close shared library objects */
 	for (i = 0; i < NUM_WIDGETS_SUPPORTED; i++) {
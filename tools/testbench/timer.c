@@ -7,8 +7,29 @@
 //         Rander Wang <rander.wang@intel.com>
 //         Janusz Jankowski <janusz.jankowski@linux.intel.com>
 
+#include <sof/drivers/timer.h>
+#include <sof/lib/clk.h>
 #include "testbench/timer.h"
 
+/* simulated time, there is no relation to the host clock */
+static uint64_t tb_timer_ticks;
+
+void tb_timer_set(uint64_t ticks)
+{
+	tb_timer_ticks = ticks;
+}
+
+uint64_t platform_timer_get(struct timer *timer)
+{
+	return tb_timer_ticks;
+}
+
+uint64_t clock_ms_to_ticks(int clock, uint64_t ms)
+{
+	return ms * TB_TIMER_TICKS_PER_MS;
+}
+
+/* get timestamp for host stream DMA position */
 void platform_host_timestamp(struct comp_dev *host,
 			     struct sof_ipc_stream_posn *posn)
 {
@@ -21,7 +21,7 @@
 
 FILE *file;
 char pipeline_string[DEBUG_MSG_LEN];
-struct shared_lib_table *lib_table;
+static struct shared_lib_table *lib_table;
 
 const struct sof_dai_types sof_dais[] = {
 	{"SSP", SOF_DAI_INTEL_SSP},
@@ -273,10 +273,19 @@ static int load_fileread(void *dev, int comp_id, int pipeline_id,
 {
 	struct sof *sof = (struct sof *)dev;
 	struct sof_ipc_comp_file fileread;
+	struct tb_file *in;
 	int size = widget->priv.size;
 	int ret;
 
-	fileread.config.frame_fmt = find_format(tp->bits_in);
+	/* input files are used in the order of filereads in topology */
+	if (tp->fr_num == tp->input_num) {
+		fprintf(stderr, "error: no input file for fileread %d\n",
+			comp_id);
+		return -EINVAL;
+	}
+
+	in = &tp->input[tp->fr_num++];
+	fileread.config.frame_fmt = in->frame_fmt;
 
 	ret = tplg_load_fileread(comp_id, pipeline_id, size, &fileread);
 	if (ret < 0)
@@ -288,16 +297,17 @@ static int load_fileread(void *dev, int comp_id, int pipeline_id,
 	}
 
 	/* configure fileread */
-	fileread.fn = strdup(tp->input_file);
+	fileread.fn = strdup(in->name);
 
 	/* use fileread comp as scheduling comp */
-	tp->fr_id = comp_id;
+	in->id = comp_id;
 	tp->sched_id = comp_id;
+	tp->sched_pipeline_id = pipeline_id;
 
-	/* Set format from testbench command line*/
-	fileread.rate = tp->fs_in;
-	fileread.channels = tp->channels;
-	fileread.frame_fmt = tp->frame_fmt;
+	/* Set format from testbench command line or WAV file */
+	fileread.rate = in->rate;
+	fileread.channels = in->channels;
+	fileread.frame_fmt = in->frame_fmt;
 
 	/* Set type depending on direction */
 	fileread.comp.type = (dir == SOF_IPC_STREAM_PLAYBACK) ?
@@ -320,9 +330,18 @@ static int load_filewrite(struct sof *sof, int comp_id, int pipeline_id,
 			  struct testbench_prm *tp)
 {
 	struct sof_ipc_comp_file filewrite;
+	struct tb_file *out;
 	int size = widget->priv.size;
 	int ret;
 
+	if (tp->fw_num == tp->output_num) {
+		fprintf(stderr, "error: no output file for filewrite %d\n",
+			comp_id);
+		return -EINVAL;
+	}
+
+	out = &tp->output[tp->fw_num++];
+
 	ret = tplg_load_filewrite(comp_id, pipeline_id, size, &filewrite);
 	if (ret < 0)
 		return ret;
@@ -333,13 +352,19 @@ static int load_filewrite(struct sof *sof, int comp_id, int pipeline_id,
 	}
 
 	/* configure filewrite */
-	filewrite.fn = strdup(tp->output_file);
-	tp->fw_id = comp_id;
+	filewrite.fn = strdup(out->name);
+	out->id = comp_id;
+
+	/* schedule pipelines without fileread from filewrite */
+	if (tp->sched_pipeline_id != pipeline_id) {
+		tp->sched_id = comp_id;
+		tp->sched_pipeline_id = pipeline_id;
+	}
 
-	/* Set format from testbench command line*/
-	filewrite.rate = tp->fs_out;
-	filewrite.channels = tp->channels;
-	filewrite.frame_fmt = tp->frame_fmt;
+	/* Set format from testbench command line */
+	filewrite.rate = out->rate;
+	filewrite.channels = out->channels;
+	filewrite.frame_fmt = out->frame_fmt;
 
 	/* Set type depending on direction */
 	filewrite.comp.type = (dir == SOF_IPC_STREAM_PLAYBACK) ?
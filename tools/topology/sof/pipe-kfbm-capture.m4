@@ -24,15 +24,19 @@ define(`N_STS', `Sound Trigger Capture '$1)
 # Controls
 #
 
+# kpbm history buffer codec, 0x00 raw frames or 0x01 ADPCM
+ifdef(`KPB_HISTORY_CODEC',,`define(`KPB_HISTORY_CODEC', `0x00')')
+
 # kpbm initial parameters, aligned with struct sof_kpb_config
 CONTROLBYTES_PRIV(KPB_priv,
 `       bytes "0x53,0x4f,0x46,0x00,0x00,0x00,0x00,0x00,'
-`       0x18,0x00,0x00,0x00,0x00,0x10,0x00,0x03,'
+`       0x1c,0x00,0x00,0x00,0x00,0x10,0x00,0x03,'
 `       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,'
 `       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,'
 `       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,'
 `       0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,'
-`       0x80,0x3e,0x00,0x00,0x10,0x00,0x00,0x00"'
+`       0x80,0x3e,0x00,0x00,0x10,0x00,0x00,0x00,'
+`       'KPB_HISTORY_CODEC`,0x00,0x00,0x00"'
 )
 
 # KPB Bytes control with max value of 255
@@ -15,6 +15,7 @@ function eq = eq_fir_blob_decode(blob, resp_n)
 % channels_in_config - numbers of channels in blob
 % assign_response    - vector of EQ indexes assigned to channels
 % size               - length in bytes
+% fft                - true if response uses FFT convolution
 
 % SPDX-License-Identifier: BSD-3-Clause
 %
@@ -38,6 +39,7 @@ eq.a = [];
 eq.channels_in_config = 0;
 eq.number_of_responses = 0;
 eq.assign_response = [];
+eq.fft = false;
 
 %% Convert to 16 bits
 blob16 = zeros(1, length(blob)*2);
@@ -99,9 +101,11 @@ j = 1;
 for i=1:eq.number_of_responses
         filter_length = b16(j);
         output_shift = double(b16(j+1));
+        flags = b16(j+2) + 65536*b16(j+3);
         if i-1 == resp_n
                 bi = b16(j+n_fir_header:j+n_fir_header+filter_length-1);
                 eq.b = 2^(-output_shift)*bi/32768;
+                eq.fft = bitand(flags, 1) > 0;
         end
         j = j+filter_length+n_fir_header;
 end
@@ -85,6 +85,11 @@ blob16(nh16+1:nh16+nc16) = int16(bs.all_coefficients);
 %% Pack as 8 bits
 nbytes_data = nb16 * 2;
 
+%% Check size, see SOF_EQ_FIR_MAX_SIZE
+if nbytes_data > 32768
+	error("Blob data size %d exceeds 32768 bytes", nbytes_data);
+end
+
 %% Get ABI information
 [abi_bytes, nbytes_abi] = eq_get_abi(nbytes_data);
 
@@ -1,13 +1,15 @@
-function fbr = eq_fir_blob_quant(b, bits)
+function fbr = eq_fir_blob_quant(b, bits, fft)
 
 %% Quantize FIR coefficients and return vector with length,
-%  out shift, and coefficients to be used in the setup blob.
+%  out shift, flags, and coefficients to be used in the setup blob.
 %
-%  fbr = eq_fir_blob_resp(b, bits)
+%  fbr = eq_fir_blob_resp(b, bits, fft)
 %  b - FIR coefficients
 %  bits - optional number of bits, defaults to 16
+%  fft - optional, set to 1 to use FFT convolution in firmware, defaults
+%        to 1 for filters longer than the direct form FIR max length 192
 %
-%  fbr - vector with length, in shift, out shift, and quantized coefficients
+%  fbr - vector with length, out shift, flags, and quantized coefficients
 %
 
 %%
@@ -44,6 +46,13 @@ if nargin < 2
 	bits = 16;
 end
 
+%% Max lengths, see SOF_EQ_FIR_MAX_LENGTH and SOF_EQ_FIR_MAX_LENGTH_FFT
+max_length = 192;
+max_length_fft = 8192;
+if nargin < 3
+	fft = length(b) > max_length;
+end
+
 %% Quantize
 [bq, shift] = eq_fir_quantize(b, bits);
 
@@ -76,12 +85,29 @@ else
 	bqp = bq;
 end
 
+%% Check length for the selected convolution method
+if fft
+	if nnew > max_length_fft
+		error('FFT convolution filter length %d exceeds %d', ...
+		      nnew, max_length_fft);
+	end
+	fprintf(1, 'Note: Filter uses FFT convolution.\n');
+	flags = 1; % SOF_EQ_FIR_FLAG_FFT
+else
+	if nnew > max_length
+		error('Filter length %d exceeds %d, use FFT convolution', ...
+		      nnew, max_length);
+	end
+	flags = 0;
+end
+
 %% Pack data into FIR coefficient format
 %	int16_t length
 %	int16_t out_shift
-%	uint32_t reserved[4]
+%	uint32_t flags
+%	uint32_t reserved[3]
 %	int16_t coef[]
-fbr = [nnew shift 0 0 0 0 0 0 0 0 bqp];
+fbr = [nnew shift flags 0 0 0 0 0 0 0 bqp];
 
 end
 